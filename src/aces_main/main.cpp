@@ -14,6 +14,16 @@
 #include "tracer.h"
 #include "timer.h"
 #include "aces_log.h"
+#include "block_allocator.h"
+#include "block_kernels.h"
+#include "threaded_pardo.h"
+#include "pardo_prefetch.h"
+#include "where_clause_cache.h"
+#include "cached_block_map.h"
+#ifdef HAVE_MPI
+#include "put_accumulate_combiner.h"
+#include "rma_arrays.h"
+#endif //HAVE_MPI
 
 #include <vector>
 #include <sstream>
@@ -32,6 +42,7 @@
 #include "mpi.h"
 #include "sip_mpi_attr.h"
 #include "sip_server.h"
+#include "data_distribution.h"
 #include "sip_mpi_utils.h"
 #include "server_persistent_array_manager.h"
 #endif
@@ -128,6 +139,15 @@ struct Aces4Parameters{
     int num_workers;
     int num_servers;
     std::string restart_job_id;
+    sip::BlockAllocator::Mode block_allocator_mode;
+    int pardo_threads;
+    std::size_t prefetch_megabytes;
+    std::size_t where_cache_megabytes;
+    std::size_t combine_megabytes;
+    int server_helper_threads;
+    std::size_t rma_megabytes;
+    std::string distribution;
+    std::string cache_trace_prefix;
     Aces4Parameters(){
         init_binary_file = "data.dat";  // Default initialization file is data.dat
         sialx_file_dir = ".";           // Default directory for compiled sialx files is "."
@@ -144,6 +164,15 @@ struct Aces4Parameters{
         num_workers = -1;
         num_servers = -1;
         restart_job_id = "";
+        block_allocator_mode = sip::BlockAllocator::system_mode;
+        pardo_threads = 1;
+        prefetch_megabytes = sip::PardoPrefetch::DEFAULT_MAX_BYTES / (1024 * 1024);
+        where_cache_megabytes = sip::WhereClauseCache::DEFAULT_MAX_BYTES / (1024 * 1024);
+        combine_megabytes = 32;
+        server_helper_threads = 0;
+        rma_megabytes = 0;
+        distribution = "cyclic";
+        cache_trace_prefix = "";
     }
 };
 
@@ -163,7 +192,16 @@ static void print_usage(const std::string& program_name) {
     std::cerr << "\t -q : number of workers  " << std::endl;
     std::cerr << "\t -r : number of servers  " << std::endl;
     std::cerr << "\t -b : job id of job to restart " << std::endl;
-    std::cerr << "\tDefaults: data file - \"data.dat\", sialx directory - \".\", Memory : 2GB" << std::endl;
+    std::cerr << "\t -a : block data allocator: system (new/delete), pool (aligned size class pools), huge (pools with transparent huge pages).  Memory kept in the pools is not counted against -m" << std::endl;
+    std::cerr << "\t -t : number of threads per worker for eligible pardo loops and large element-wise block operations. Requires build with OpenMP" << std::endl;
+    std::cerr << "\t -p : megabytes of blocks a worker may prefetch for the next pardo iteration, 0 to disable" << std::endl;
+    std::cerr << "\t -l : megabytes a worker may use for the iterations of pardo loops satisfying their where clauses, kept for later executions, 0 to disable" << std::endl;
+    std::cerr << "\t -c : megabytes a worker may use to combine put_accumulates to the same block before sending them, part of the worker memory, 0 to disable" << std::endl;
+    std::cerr << "\t -e : number of helper threads per server that accumulate put_accumulate data, 0 to do it in the communication thread. Requires build with OpenMP. With MPI_THREAD_MULTIPLE, they also send the acks and write blocks backed up to disk" << std::endl;
+    std::cerr << "\t -o : megabytes per server for distributed arrays accessed with one-sided MPI operations, 0 to disable. Only these arrays are copied directly from servers on the same node" << std::endl;
+    std::cerr << "\t -g : distribution of blocks of distributed arrays to servers: cyclic, balanced (by bytes), or profiled (by bytes and GETs in the previous program)" << std::endl;
+    std::cerr << "\t -k : file name prefix for traces of the block cache of each worker, read by cache_policy_benchmark" << std::endl;
+    std::cerr << "\tDefaults: data file - \"data.dat\", sialx directory - \".\", Memory : 2GB, allocator : system, threads : 1, prefetch : 64, where clause cache : 64, combine : 32, server helper threads : 0, one-sided : 0, distribution : cyclic" << std::endl;
     std::cerr << "\tm is the approximate memory to use. Actual usage will be more." << std::endl;
     std::cerr << "\tworkers & servers are distributed in a 2:1 ratio for an MPI build" << std::endl;
     std::cerr << "\t-? or -h to display this usage dialogue" << std::endl;
@@ -190,8 +228,17 @@ Aces4Parameters parse_command_line_parameters(int argc, char* argv[]) {
     // q: number of workers
     // r: number of servers
     // b: job id of job to restart
+    // a: block data allocator (system, pool or huge)
+    // t: threads per worker for eligible pardo loops
+    // p: megabytes of blocks to prefetch for pardo iterations
+    // l: megabytes for cached pardo iterations
+    // c: megabytes for combining put_accumulates
+    // e: helper threads per server
+    // o: megabytes per server for one-sided distributed arrays
+    // g: distribution of blocks to servers (cyclic, balanced or profiled)
+    // k: file name prefix for block cache traces
     // h & ? are for help. They require no arguments
-    const char* optString = "d:j:s:m:w:v:q:r:b:h?";
+    const char* optString = "d:j:s:m:w:v:q:r:b:a:t:p:l:c:e:o:g:k:h?";
     int c;
     while ((c = getopt(argc, argv, optString)) != -1) {
         switch (c) {
@@ -239,6 +286,47 @@ Aces4Parameters parse_command_line_parameters(int argc, char* argv[]) {
         	parameters.restart_job_id = optarg;
         }
             break;
+        case 'a' : {
+        	if (!sip::BlockAllocator::parse_mode(optarg, parameters.block_allocator_mode)) {
+        		std::cerr << "Unknown block allocator " << optarg << std::endl;
+        		std::string program_name = argv[0];
+        		print_usage(program_name);
+        		exit(1);
+        	}
+        }
+            break;
+        case 't' : {
+        	parameters.pardo_threads = read_from_optarg<int>();
+        }
+            break;
+        case 'p' : {
+        	parameters.prefetch_megabytes = read_from_optarg<std::size_t>();
+        }
+            break;
+        case 'l' : {
+        	parameters.where_cache_megabytes = read_from_optarg<std::size_t>();
+        }
+            break;
+        case 'c' : {
+        	parameters.combine_megabytes = read_from_optarg<std::size_t>();
+        }
+            break;
+        case 'e' : {
+        	parameters.server_helper_threads = read_from_optarg<int>();
+        }
+            break;
+        case 'o' : {
+        	parameters.rma_megabytes = read_from_optarg<std::size_t>();
+        }
+            break;
+        case 'g' : {
+        	parameters.distribution = optarg;
+        }
+            break;
+        case 'k' : {
+        	parameters.cache_trace_prefix = optarg;
+        }
+            break;
         case 'h':
         case '?':
         default:
@@ -360,8 +448,11 @@ int main(int argc, char* argv[]) {
     setup_signal_and_exception_handlers();
 
 #ifdef HAVE_MPI
-	/* MPI Initialization */
-	MPI_Init(&argc, &argv);
+	/* MPI Initialization.  Workers only make MPI calls from one thread.  Servers need
+	 * MPI_THREAD_MULTIPLE for their helper threads to make MPI calls, and otherwise only
+	 * make them from one thread too. */
+	int mpi_thread_support;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_support);
 #endif // HAVE_MPI
 //    {
 //        int i = 0;
@@ -396,11 +487,51 @@ int main(int argc, char* argv[]) {
     		parameters.worker_memory,
     		parameters.server_memory));
     sip::MemoryTracker::set_global_memory_tracker(new sip::MemoryTracker());
+    sip::BlockAllocator::set_global_block_allocator(new sip::BlockAllocator(parameters.block_allocator_mode));
+#ifdef HAVE_MPI
+    //the threads of a threaded pardo make no MPI calls, but are only safe with FUNNELED
+    sip::ThreadedPardo::set_num_threads(
+    		mpi_thread_support >= MPI_THREAD_FUNNELED ? parameters.pardo_threads : 1);
+#else
+    sip::ThreadedPardo::set_num_threads(parameters.pardo_threads);
+#endif //HAVE_MPI
+    //outside threaded pardos, large element-wise block operations use the same threads
+    sip::block_kernels::set_num_threads(sip::ThreadedPardo::num_threads());
+    sip::PardoPrefetch::set_max_bytes(parameters.prefetch_megabytes * 1024 * 1024);
+    sip::WhereClauseCache::set_max_bytes(parameters.where_cache_megabytes * 1024 * 1024);
+    sip::CachedBlockMap::set_trace_file_prefix(parameters.cache_trace_prefix);
+#ifdef HAVE_MPI
+    sip::PutAccumulateCombiner::set_max_bytes(parameters.combine_megabytes * 1024 * 1024);
+    sip::SIPServer::set_num_helper_threads(
+    		mpi_thread_support >= MPI_THREAD_FUNNELED ? parameters.server_helper_threads : 0);
+    sip::SIPServer::set_helpers_call_mpi(mpi_thread_support >= MPI_THREAD_MULTIPLE);
+    sip::RmaArrays::set_max_bytes(parameters.rma_megabytes * 1024 * 1024);
+    sip::DataDistribution::Mode distribution_mode;
+    if (!sip::DataDistribution::parse_mode(parameters.distribution, distribution_mode)) {
+    	std::cerr << "Unknown distribution " << parameters.distribution << std::endl;
+    	print_usage(argv[0]);
+    	exit(1);
+    }
+    sip::DataDistribution::set_mode(distribution_mode);
+#endif //HAVE_MPI
 
 	sip::SIPMPIAttr &sip_mpi_attr = sip::SIPMPIAttr::get_instance(); // singleton instance.
 	std::cerr<<sip_mpi_attr<<std::endl;
 
     if (sip_mpi_attr.is_company_master()) {std::cout << "Running with job_id: " << job_id << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Block allocator: " << sip::BlockAllocator::mode_name(parameters.block_allocator_mode) << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Block kernels: " << sip::block_kernels::isa_name(sip::block_kernels::isa())
+    		<< ", threads " << sip::block_kernels::num_threads() << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Pardo threads per worker: " << sip::ThreadedPardo::num_threads() << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Pardo prefetch bytes per worker: " << sip::PardoPrefetch::max_bytes() << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Where clause cache bytes per worker: " << sip::WhereClauseCache::max_bytes() << std::endl;}
+#ifdef HAVE_MPI
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Put_accumulate combining bytes per worker: " << sip::PutAccumulateCombiner::max_bytes() << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Helper threads per server: " << sip::SIPServer::num_helper_threads()
+    		<< (sip::SIPServer::helpers_call_mpi() ? " (ack accumulates and write backed up chunks)" : "") << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "One-sided array bytes per server: " << sip::RmaArrays::max_bytes() << std::endl;}
+    if (sip_mpi_attr.is_company_master()) {std::cout << "Block distribution: " << sip::DataDistribution::mode_name(sip::DataDistribution::mode()) << std::endl;}
+#endif //HAVE_MPI
 
     //create log for current job
     sip::AcesLog current_log(sip::JobControl::global->get_job_id(), false);
@@ -478,6 +609,7 @@ int main(int argc, char* argv[]) {
 //		const std::vector<std::string> lno2name = sipTables.line_num_to_name();
 #ifdef HAVE_MPI
 		sip::DataDistribution data_distribution(sipTables, sip_mpi_attr);
+		long server_gets = 0; //for the profile of the distribution
 
 		// TODO Broadcast from worker master to all servers & workers.
 	if (sip_mpi_attr.is_server()){
@@ -489,6 +621,7 @@ int main(int argc, char* argv[]) {
 		//			sip::ServerTimer server_timer(sipTables.op_table_size());
 		sip::SIPServer server(sipTables, data_distribution, sip_mpi_attr, &persistent_server);
 		server.run();
+		server_gets = server.num_gets();
 		SIP_LOG(std::cout<<"PBM after program at Server "<< sip_mpi_attr.global_rank()<< " : " << sialfpath << " :"<<std::endl<<persistent_server;);
 
 			sip::MPITimer save_persistent_timer(sip_mpi_attr.company_communicator());
@@ -543,6 +676,7 @@ int main(int argc, char* argv[]) {
 
 #ifdef HAVE_MPI
 		sip::SIPMPIUtils::check_err(MPI_Barrier(MPI_COMM_WORLD));
+		sip::DataDistribution::update_profile(server_gets);
 #endif
 		//update program number and write to log
 		sip::JobControl::global->increment_program();
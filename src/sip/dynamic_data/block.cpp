@@ -12,6 +12,8 @@
 #include "sip.h"
 #include "tensor_ops_c_prototypes.h"
 #include "sip_tables.h"
+#include "block_kernels.h"
+#include "block_allocator.h"
 
 #ifdef HAVE_MPI
 #include "sip_mpi_utils.h"
@@ -34,7 +36,7 @@ Block::Block(BlockShape shape) :
 	// but is also expensive. This is being removed and the block is being zeroed out
 	// wherever it needs to be.
 	try{
-	data_ = new double[size_];
+	data_ = BlockAllocator::allocate(size_);
 	MemoryTracker::global->inc_allocated(size_);
 
 	gpu_data_ = NULL;
@@ -99,7 +101,7 @@ Block::~Block() {
 	//if (data_ != NULL && size_ >1) {
 
 	if (data_ != NULL) {
-		delete[] data_;
+		BlockAllocator::deallocate(data_);
 		MemoryTracker::global->dec_allocated(shape_.num_elems());
 		data_ = NULL;
 	}
@@ -149,7 +151,6 @@ Block::dataPtr Block::get_data() {
 }
 
 
-//TODO compare with std::fill
 Block::dataPtr Block::fill(double value) {
 	int ierr = 0;
 //	dataPtr data = get_data();
@@ -171,17 +172,13 @@ Block::dataPtr Block::fill(double value) {
 //	tensor_block_init__(nthreads, data_, rank, shape_.segment_sizes_, value,
 //			ierr);
 //	sip::CHECK(ierr == 0, "error returned from tensor_block_init_");
-	std::fill(data_+0, data_+size(), value);
+	block_kernels::fill(data_, size(), value);
 	return data_;
 }
 
-// TODO use Dmitry's??
 Block::dataPtr Block::scale(double factor) {
 	dataPtr ptr = get_data();
-	int n = size();
-	for (int i = 0; i < n; ++i) {
-		ptr[i] *= factor;
-	}
+	block_kernels::scale(ptr, size(), factor);
 	return ptr;
 }
 
@@ -195,9 +192,7 @@ Block::dataPtr Block::scale_and_copy(BlockPtr source_block, double factor){
 					//the caller needs to calculate and pass in the offset.
 	CHECK_WITH_LINE(target != NULL, "Cannot copy data, target is NULL", current_line());
 	CHECK_WITH_LINE(source != NULL, "Cannot copy data, source is NULL", current_line());
-	for (int i = 0; i < n; ++i){
-		target[i] = source[i]*factor;
-	}
+	block_kernels::scale_and_copy(target, source, n, factor);
 	return target;
 }
 
@@ -205,10 +200,7 @@ Block::dataPtr Block::scale_and_copy(BlockPtr source_block, double factor){
 
 Block::dataPtr Block::increment_elements(double delta){
 	dataPtr ptr = get_data();
-	int n = size();
-	for (int i = 0; i < n; ++i) {
-		ptr[i] += delta;
-	}
+	block_kernels::increment(ptr, size(), delta);
 	return ptr;
 }
 
@@ -259,11 +251,7 @@ Block::dataPtr Block::transpose_copy(BlockPtr source, int rank,
 Block::dataPtr Block::accumulate_data(BlockPtr source) {
 	CHECK(this->shape_ == source->shape_,
 			" += applied to blocks with different shapes");
-	dataPtr source_data =  source->data_;
-	int n = size();
-	for (int i = 0; i < n; ++i) {
-		data_[i] += source_data[i];
-	}
+	block_kernels::accumulate(data_, source->data_, size());
 	return data_;
 }
 
@@ -353,7 +341,7 @@ bool Block::operator==(const Block& rhs) const{
 
 void Block::free_host_data(){
 	if (data_){
-		delete [] data_;
+		BlockAllocator::deallocate(data_);
 		MemoryTracker::global->dec_allocated(size_);
 	}
 	data_ = NULL;
@@ -363,7 +351,8 @@ void Block::free_host_data(){
 
 void Block::allocate_host_data(){
 	WARN(data_ == NULL, "Potentially causing a memory leak on host");
-	data_ = new double[size_]();
+	data_ = BlockAllocator::allocate(size_);
+	block_kernels::fill(data_, size_, 0.0);
 	MemoryTracker::global->inc_allocated(size_);
 	status_[Block::onHost] = true;
 	status_[Block::dirtyOnHost] = false;
@@ -223,6 +223,7 @@ private:
 	friend class DataManager;	// So that data_ of blocks wrapping
 								// Scalars can be set to NULL before destroying them.
 	friend class SialOpsParallel; //To get MPIState object's MPI_Request field
+	friend class CachedBlockMap; //To take the data_ of deleted blocks for reuse
 	DISALLOW_COPY_AND_ASSIGN(Block);
 };
 
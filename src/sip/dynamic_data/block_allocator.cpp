@@ -0,0 +1,234 @@
+/*
+ * block_allocator.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "block_allocator.h"
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+namespace sip {
+
+BlockAllocator* BlockAllocator::global = NULL;
+
+namespace {
+
+/** Rounds n up to a multiple of m */
+inline std::size_t round_up(std::size_t n, std::size_t m) {
+	return (n + m - 1) / m * m;
+}
+
+void advise_huge_pages(char* p, std::size_t bytes) {
+#ifdef MADV_HUGEPAGE
+	madvise(p, bytes, MADV_HUGEPAGE);  //advisory only, failure is harmless
+#endif //MADV_HUGEPAGE
+}
+
+#ifdef _OPENMP
+/** Holds the lock until the end of the enclosing scope */
+class ScopedLock {
+public:
+	explicit ScopedLock(omp_lock_t* lock) : lock_(lock) { omp_set_lock(lock_); }
+	~ScopedLock() { omp_unset_lock(lock_); }
+private:
+	omp_lock_t* lock_;
+};
+#endif //_OPENMP
+
+}  //anonymous namespace
+
+BlockAllocator::BlockAllocator(Mode mode, std::size_t max_pooled_bytes) :
+		mode_(mode),
+		max_pooled_bytes_(max_pooled_bytes),
+		pooled_bytes_(0),
+		arena_next_(NULL),
+		arena_remaining_(0),
+		num_live_(0),
+		num_allocations_(0),
+		num_reused_(0),
+		num_foreign_frees_(0),
+		max_pooled_bytes_seen_(0) {
+#ifdef _OPENMP
+	omp_init_lock(&lock_);
+#endif //_OPENMP
+}
+
+BlockAllocator::~BlockAllocator() {
+	WARN(num_live_ == 0, "BlockAllocator deleted while block data is still allocated");
+	release_pooled();
+	if (num_live_ == 0) {
+		for (std::vector<char*>::iterator it = arenas_.begin(); it != arenas_.end(); ++it) {
+			free(*it);
+		}
+	}
+#ifdef _OPENMP
+	omp_destroy_lock(&lock_);
+#endif //_OPENMP
+}
+
+/** Four size classes per power of two, so at most 25% of a buffer is unused. */
+std::size_t BlockAllocator::size_class(std::size_t bytes) const {
+	if (bytes <= ALIGNMENT) return ALIGNMENT;
+	std::size_t power = ALIGNMENT;
+	while (power * 2 <= bytes) power *= 2;   //power <= bytes < 2 * power
+	std::size_t step = power / 4 >= ALIGNMENT ? power / 4 : ALIGNMENT;
+	return round_up(bytes, step);
+}
+
+char* BlockAllocator::arena_buffer(std::size_t class_bytes) {
+	if (arena_remaining_ < class_bytes) {
+		//the remainder of the current arena is abandoned
+		char* arena = system_buffer(HUGE_PAGE_BYTES, ARENA_BYTES);
+		advise_huge_pages(arena, ARENA_BYTES);
+		arenas_.push_back(arena);
+		arena_next_ = arena;
+		arena_remaining_ = ARENA_BYTES;
+	}
+	char* buffer = arena_next_;
+	arena_next_ += class_bytes;
+	arena_remaining_ -= class_bytes;
+	return buffer;
+}
+
+/** Returns a buffer of class_bytes, plus its header, without initializing the header */
+char* BlockAllocator::new_buffer(std::size_t class_bytes, bool& from_arena) {
+	from_arena = false;
+	std::size_t bytes = class_bytes + ALIGNMENT;
+	if (mode_ == huge_page_mode) {
+		if (class_bytes < HUGE_PAGE_BYTES) {
+			from_arena = true;
+			return arena_buffer(bytes);
+		}
+		bytes = round_up(bytes, HUGE_PAGE_BYTES);
+		char* buffer = system_buffer(HUGE_PAGE_BYTES, bytes);
+		advise_huge_pages(buffer, bytes);
+		return buffer;
+	}
+	return system_buffer(ALIGNMENT, bytes);
+}
+
+char* BlockAllocator::system_buffer(std::size_t alignment, std::size_t bytes) {
+	void* p = NULL;
+	if (posix_memalign(&p, alignment, bytes) != 0) throw std::bad_alloc();
+	char* buffer = static_cast<char*>(p);
+	regions_.insert(std::make_pair(buffer, bytes));
+	return buffer;
+}
+
+/** True if p points into a buffer obtained from the system by this allocator */
+bool BlockAllocator::owns(const char* p) const {
+	Regions::const_iterator it = regions_.upper_bound(p);
+	if (it == regions_.begin()) return false;
+	--it;
+	return p < it->first + it->second;
+}
+
+double* BlockAllocator::allocate_data(std::size_t num_doubles) {
+	if (mode_ == system_mode) return new double[num_doubles];
+#ifdef _OPENMP
+	ScopedLock guard(&lock_);
+#endif //_OPENMP
+	++num_allocations_;
+	std::size_t class_bytes = size_class(num_doubles * sizeof(double));
+	char* buffer = NULL;
+	FreeLists::iterator it = free_lists_.find(class_bytes);
+	if (it != free_lists_.end() && !it->second.empty()) {
+		buffer = it->second.back();
+		it->second.pop_back();
+		pooled_bytes_ -= class_bytes;
+		++num_reused_;
+	} else {
+		bool from_arena;
+		buffer = new_buffer(class_bytes, from_arena);
+		header(buffer)->class_bytes = class_bytes;
+		header(buffer)->from_arena = from_arena;
+	}
+	++num_live_;
+	return reinterpret_cast<double*>(buffer + ALIGNMENT);
+}
+
+void BlockAllocator::free_data(double* data) {
+	if (data == NULL) return;
+	if (mode_ == system_mode) {
+		delete[] data;
+		return;
+	}
+#ifdef _OPENMP
+	ScopedLock guard(&lock_);
+#endif //_OPENMP
+	if (!owns(reinterpret_cast<char*>(data))) {
+		//not allocated here, for example data read during setup
+		++num_foreign_frees_;
+		delete[] data;
+		return;
+	}
+	char* buffer = reinterpret_cast<char*>(data) - ALIGNMENT;
+	std::size_t class_bytes = header(buffer)->class_bytes;
+	bool from_arena = header(buffer)->from_arena;
+	--num_live_;
+	if (from_arena || pooled_bytes_ + class_bytes <= max_pooled_bytes_) {
+		free_lists_[class_bytes].push_back(buffer);
+		pooled_bytes_ += class_bytes;
+		if (pooled_bytes_ > max_pooled_bytes_seen_) max_pooled_bytes_seen_ = pooled_bytes_;
+	} else {
+		release_buffer(buffer);
+	}
+}
+
+void BlockAllocator::release_buffer(char* buffer) {
+	regions_.erase(buffer);
+	free(buffer);
+}
+
+std::size_t BlockAllocator::release_pooled() {
+#ifdef _OPENMP
+	ScopedLock guard(&lock_);
+#endif //_OPENMP
+	std::size_t released = 0;
+	for (FreeLists::iterator it = free_lists_.begin(); it != free_lists_.end(); ++it) {
+		std::size_t class_bytes = it->first;
+		if (mode_ == huge_page_mode && class_bytes < HUGE_PAGE_BYTES) continue;  //arena buffers
+		for (std::vector<char*>::iterator b = it->second.begin(); b != it->second.end(); ++b) {
+			release_buffer(*b);
+			released += class_bytes;
+		}
+		it->second.clear();
+	}
+	pooled_bytes_ -= released;
+	return released;
+}
+
+bool BlockAllocator::parse_mode(const std::string& name, Mode& mode) {
+	if (name == "system") mode = system_mode;
+	else if (name == "pool") mode = pool_mode;
+	else if (name == "huge") mode = huge_page_mode;
+	else return false;
+	return true;
+}
+
+const char* BlockAllocator::mode_name(Mode mode) {
+	switch (mode) {
+	case system_mode: return "system";
+	case pool_mode: return "pool";
+	case huge_page_mode: return "huge";
+	}
+	return "unknown";
+}
+
+std::ostream& operator<<(std::ostream& os, const BlockAllocator& obj) {
+	os << "BlockAllocator mode_: " << BlockAllocator::mode_name(obj.mode_) << std::endl;
+	os << "num_allocations_: " << obj.num_allocations_ << std::endl;
+	os << "num_reused_: " << obj.num_reused_ << std::endl;
+	os << "num_foreign_frees_: " << obj.num_foreign_frees_ << std::endl;
+	os << "live buffers: " << obj.num_live_ << std::endl;
+	os << "pooled_bytes_: " << obj.pooled_bytes_ << std::endl;
+	os << "max_pooled_bytes_seen_: " << obj.max_pooled_bytes_seen_ << std::endl;
+	os << "huge page arenas: " << obj.arenas_.size() << std::endl;
+	return os;
+}
+
+} /* namespace sip */
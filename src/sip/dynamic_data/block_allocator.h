@@ -0,0 +1,157 @@
+/*
+ * block_allocator.h
+ *
+ * Allocator for block and chunk data.
+ *
+ * In pool_mode, requests are rounded up to a size class (four classes per power of two,
+ * each a multiple of 64 bytes), and the memory is 64 byte aligned.  Freed buffers are
+ * kept on a free list for their class and reused by later requests of the same class, up to
+ * max_pooled_bytes.  huge_page_mode additionally requests transparent huge pages: buffers of
+ * at least HUGE_PAGE_BYTES, and the arenas that smaller buffers are carved from, are advised
+ * with MADV_HUGEPAGE.  Their data is only ALIGNMENT aligned, since it follows the header.
+ * system_mode, the default, uses new[] and delete[].
+ *
+ * The MemoryTracker and the server's memory limit count the data of the blocks, not the
+ * buffers kept on the free lists or the unused parts of size classes and arenas.  So in
+ * pool_mode and huge_page_mode a process may use more memory than its limit, by at most
+ * max_pooled_bytes plus the arenas.  release_pooled_memory is called when an allocation
+ * fails.
+ *
+ * The class of a buffer is kept in a header of ALIGNMENT bytes just before the data.  Every
+ * buffer obtained with posix_memalign, including the arenas, is recorded as a region, and
+ * is returned to the system with free().  Blocks may also wrap data that was not obtained
+ * from this allocator, so free_data looks up the region containing a pointer, and releases
+ * pointers that are not in any region with delete[].
+ *
+ * The global allocator should be set once, before any blocks are created.  If it has not
+ * been set, allocate and deallocate use new[] and delete[].  It may only be replaced while
+ * none of its buffers are in use.
+ *
+ * When built with OpenMP, the allocator may be used by several threads at once.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef BLOCK_ALLOCATOR_H_
+#define BLOCK_ALLOCATOR_H_
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "sip.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
+
+namespace sip {
+
+class BlockAllocator {
+public:
+	enum Mode {
+		system_mode,
+		pool_mode,
+		huge_page_mode
+	};
+
+	static const std::size_t ALIGNMENT = 64;
+	static const std::size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+	static const std::size_t ARENA_BYTES = 32 * HUGE_PAGE_BYTES;
+	static const std::size_t DEFAULT_MAX_POOLED_BYTES = 256 * 1024 * 1024;
+
+	explicit BlockAllocator(Mode mode, std::size_t max_pooled_bytes = DEFAULT_MAX_POOLED_BYTES);
+	~BlockAllocator();
+
+	static BlockAllocator* global;  //the globally accessible object.
+
+	static void set_global_block_allocator(BlockAllocator* block_allocator){
+		CHECK(global == NULL || global->num_live_ == 0,
+				"replacing the block allocator while its buffers are in use");
+		if (global != NULL) delete global;
+		global = block_allocator;
+	}
+
+	/** Allocates with the global allocator, or new[] if there is none. */
+	static double* allocate(std::size_t num_doubles) {
+		return global != NULL ? global->allocate_data(num_doubles) : new double[num_doubles];
+	}
+
+	/** Frees with the global allocator, or delete[] if there is none. */
+	static void deallocate(double* data) {
+		if (global != NULL) global->free_data(data);
+		else delete[] data;
+	}
+
+	/** Returns the memory held on the free lists of the global allocator to the system.
+	 * Buffers carved from huge page arenas stay on their free lists.
+	 * Returns the number of bytes released. */
+	static std::size_t release_pooled_memory() {
+		return global != NULL ? global->release_pooled() : 0;
+	}
+
+	/** The returned data is not initialized */
+	double* allocate_data(std::size_t num_doubles);
+	void free_data(double* data);
+	std::size_t release_pooled();
+
+	Mode mode() const { return mode_; }
+
+	/** Parses "system", "pool", or "huge".  Returns false if the string is not one of these. */
+	static bool parse_mode(const std::string& name, Mode& mode);
+	static const char* mode_name(Mode mode);
+
+	friend std::ostream& operator<<(std::ostream&, const BlockAllocator&);
+
+private:
+	/** Precedes the data of every buffer handed out by allocate_data */
+	struct BufferHeader {
+		std::size_t class_bytes;
+		bool from_arena;
+	};
+
+	static BufferHeader* header(char* buffer) { return reinterpret_cast<BufferHeader*>(buffer); }
+
+	std::size_t size_class(std::size_t bytes) const;
+	char* new_buffer(std::size_t class_bytes, bool& from_arena);
+	char* arena_buffer(std::size_t class_bytes);
+	char* system_buffer(std::size_t alignment, std::size_t bytes);
+	bool owns(const char* p) const;
+	void release_buffer(char* buffer);
+
+	const Mode mode_;
+	const std::size_t max_pooled_bytes_;
+
+	/** class size in bytes -> free buffers of that size, which start with their header */
+	typedef std::map<std::size_t, std::vector<char*> > FreeLists;
+	FreeLists free_lists_;
+	std::size_t pooled_bytes_;
+
+	/** start of each buffer obtained from the system -> its size in bytes.  Only changes when
+	 * memory is obtained from or returned to the system, not when a pooled buffer is reused. */
+	typedef std::map<const char*, std::size_t> Regions;
+	Regions regions_;
+
+	/** huge page arenas.  Buffers carved from them are never returned to the system */
+	std::vector<char*> arenas_;
+	char* arena_next_;
+	std::size_t arena_remaining_;
+
+	std::size_t num_live_;
+	std::size_t num_allocations_;
+	std::size_t num_reused_;
+	std::size_t num_foreign_frees_;
+	std::size_t max_pooled_bytes_seen_;
+
+#ifdef _OPENMP
+	omp_lock_t lock_;
+#endif //_OPENMP
+
+	DISALLOW_COPY_AND_ASSIGN(BlockAllocator);
+};
+
+} /* namespace sip */
+
+#endif /* BLOCK_ALLOCATOR_H_ */
@@ -0,0 +1,224 @@
+/*
+ * block_hash_map.h
+ *
+ * Open addressing hash map from BlockId to VALUE, used for the blocks of an array in
+ * IdBlockMap.
+ *
+ * It provides the subset of the std::map interface used with the per array maps, so it can
+ * replace std::map<BlockId, VALUE>.  Entries are stored in a single power of two table with
+ * linear probing, so a lookup hashes the id once and usually compares one 64 bit key, and an
+ * insertion does not allocate unless the table grows.  The key of a block id without a parent
+ * id (i.e. not a contiguous local region or subblock) whose index values fit is its packed
+ * index values (see BlockId::packed_indices), so comparing keys compares the ids.  Other ids
+ * get a hash with the top bit set and are compared with BlockId::operator==.
+ *
+ * Unlike std::map, the entries are not ordered, and insert and erase invalidate all
+ * iterators.  (Erase moves later entries of the probe sequence back instead of leaving
+ * tombstones.)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef BLOCK_HASH_MAP_H_
+#define BLOCK_HASH_MAP_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include "block_id.h"
+
+namespace sip {
+
+template <typename VALUE>
+class BlockHashMap {
+	struct Slot;
+public:
+	typedef std::pair<BlockId, VALUE> value_type;
+	typedef std::size_t size_type;
+
+	/** Iterates over the used slots of the table */
+	template <typename SLOT, typename ENTRY>
+	class Iterator {
+	public:
+		Iterator() : slot_(NULL), end_(NULL) {}
+		Iterator(SLOT* slot, SLOT* end) : slot_(slot), end_(end) { skip_unused(); }
+		/** conversion of iterator to const_iterator */
+		template <typename S, typename E>
+		Iterator(const Iterator<S, E>& other) : slot_(other.slot_), end_(other.end_) {}
+
+		ENTRY& operator*() const { return slot_->entry_; }
+		ENTRY* operator->() const { return &slot_->entry_; }
+		Iterator& operator++() {
+			++slot_;
+			skip_unused();
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator tmp(*this);
+			++*this;
+			return tmp;
+		}
+		bool operator==(const Iterator& rhs) const { return slot_ == rhs.slot_; }
+		bool operator!=(const Iterator& rhs) const { return slot_ != rhs.slot_; }
+	private:
+		void skip_unused() {
+			while (slot_ != end_ && !slot_->used_) ++slot_;
+		}
+		SLOT* slot_;
+		SLOT* end_;
+		template <typename S, typename E> friend class Iterator;
+		friend class BlockHashMap;
+	};
+	typedef Iterator<Slot, value_type> iterator;
+	typedef Iterator<const Slot, const value_type> const_iterator;
+
+	BlockHashMap() : table_(MIN_CAPACITY), size_(0) {}
+
+	iterator begin() { return iterator(first_slot(), end_slot()); }
+	iterator end() { return iterator(end_slot(), end_slot()); }
+	const_iterator begin() const { return const_iterator(first_slot(), end_slot()); }
+	const_iterator end() const { return const_iterator(end_slot(), end_slot()); }
+
+	size_type size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	iterator find(const BlockId& id) {
+		std::size_t i = find_slot(id, key(id));
+		return table_[i].used_ ? iterator(&table_[i], end_slot()) : end();
+	}
+
+	const_iterator find(const BlockId& id) const {
+		std::size_t i = find_slot(id, key(id));
+		return table_[i].used_ ? const_iterator(&table_[i], end_slot()) : end();
+	}
+
+	size_type count(const BlockId& id) const { return find(id) != end() ? 1 : 0; }
+
+	/** Inserts the entry unless the id is present.  The iterator refers to the entry
+	 * with the id. */
+	std::pair<iterator, bool> insert(const value_type& entry) {
+		uint64_t k = key(entry.first);
+		std::size_t i = find_slot(entry.first, k);
+		if (table_[i].used_) return std::make_pair(iterator(&table_[i], end_slot()), false);
+		if (2 * (size_ + 1) > table_.size()) {
+			grow();
+			i = find_slot(entry.first, k);
+		}
+		Slot& slot = table_[i];
+		slot.key_ = k;
+		slot.entry_ = entry;
+		slot.used_ = true;
+		++size_;
+		return std::make_pair(iterator(&slot, end_slot()), true);
+	}
+
+	VALUE& operator[](const BlockId& id) {
+		return insert(value_type(id, VALUE())).first->second;
+	}
+
+	void erase(iterator it) {
+		std::size_t i = it.slot_ - first_slot();
+		std::size_t mask = table_.size() - 1;
+		table_[i].used_ = false;
+		--size_;
+		//move back the following entries whose probe sequence passes the free slot
+		std::size_t j = i;
+		while (true) {
+			j = (j + 1) & mask;
+			Slot& slot = table_[j];
+			if (!slot.used_) break;
+			std::size_t home = hash(slot.key_) & mask;
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				table_[i] = slot;
+				slot.used_ = false;
+				i = j;
+			}
+		}
+		table_[i].entry_ = value_type();
+	}
+
+	size_type erase(const BlockId& id) {
+		iterator it = find(id);
+		if (it == end()) return 0;
+		erase(it);
+		return 1;
+	}
+
+	void clear() {
+		std::vector<Slot>(MIN_CAPACITY).swap(table_);
+		size_ = 0;
+	}
+
+private:
+	static const std::size_t MIN_CAPACITY = 16;
+	static const uint64_t UNPACKED_KEY = 1ULL << 63;
+
+	struct Slot {
+		Slot() : key_(0), used_(false) {}
+		uint64_t key_;
+		bool used_;
+		value_type entry_;
+	};
+
+	std::vector<Slot> table_;  //size is a power of 2, at most half full
+	std::size_t size_;
+
+	Slot* first_slot() { return &table_[0]; }
+	Slot* end_slot() { return &table_[0] + table_.size(); }
+	const Slot* first_slot() const { return &table_[0]; }
+	const Slot* end_slot() const { return &table_[0] + table_.size(); }
+
+	static uint64_t key(const BlockId& id) {
+		uint64_t packed;
+		if (id.packed_indices(packed)) return packed;
+		uint64_t h = static_cast<uint32_t>(id.array_id());
+		for (int i = 0; i < MAX_RANK; ++i) {
+			h = h * 1099511628211ULL + static_cast<uint32_t>(id.index_values(i));
+		}
+		if (id.is_contiguous_local()) {
+			for (int i = 0; i < MAX_RANK; ++i) {
+				h = h * 1099511628211ULL + static_cast<uint32_t>(id.upper_index_values(i));
+			}
+		}
+		return h | UNPACKED_KEY;
+	}
+
+	static std::size_t hash(uint64_t key) {
+		//Fibonacci hashing, the high bits are the best mixed
+		return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32);
+	}
+
+	static bool matches(const Slot& slot, const BlockId& id, uint64_t k) {
+		if (slot.key_ != k) return false;
+		if (k & UNPACKED_KEY) return slot.entry_.first == id;
+		return slot.entry_.first.array_id() == id.array_id();
+	}
+
+	/** The slot holding id, or the free slot where it would be inserted */
+	std::size_t find_slot(const BlockId& id, uint64_t k) const {
+		std::size_t mask = table_.size() - 1;
+		std::size_t i = hash(k) & mask;
+		while (table_[i].used_ && !matches(table_[i], id, k)) {
+			i = (i + 1) & mask;
+		}
+		return i;
+	}
+
+	void grow() {
+		std::vector<Slot> old(table_.size() * 2);
+		old.swap(table_);
+		std::size_t mask = table_.size() - 1;
+		for (typename std::vector<Slot>::iterator it = old.begin(); it != old.end(); ++it) {
+			if (!it->used_) continue;
+			std::size_t i = hash(it->key_) & mask;
+			while (table_[i].used_) i = (i + 1) & mask;
+			table_[i] = *it;
+		}
+	}
+};
+
+} /* namespace sip */
+
+#endif /* BLOCK_HASH_MAP_H_ */
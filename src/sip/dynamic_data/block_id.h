@@ -8,6 +8,7 @@
 
 
 #include <utility>   // for std::rel_ops.  Allows relational ops for BlockId to be derived from == and <
+#include <stdint.h>
 #include "sip.h"
 
 
@@ -178,6 +179,29 @@ public:
 
 	int upper_index_values (int i) const {return parent_id_ptr_->index_values_[i];}
 
+	/** Number of bits per index value in packed_indices */
+	static const int PACKED_BITS = 60 / MAX_RANK;
+
+	/** If this block has no parent id and its index values are in [0, 2^PACKED_BITS),
+	 * sets key to the index values packed into its low MAX_RANK * PACKED_BITS bits and
+	 * returns true.  Then two such ids of the same array are equal iff their keys are.
+	 *
+	 * @param key [out]
+	 * @return
+	 */
+	bool packed_indices(uint64_t& key) const {
+		if (parent_id_ptr_ != NULL) return false;
+		uint64_t packed = 0;
+		for (int i = 0; i < MAX_RANK; ++i) {
+			//negative values are converted to large ones
+			unsigned int value = static_cast<unsigned int>(index_values_[i]);
+			if (value >= (1u << PACKED_BITS)) return false;
+			packed = (packed << PACKED_BITS) | value;
+		}
+		key = packed;
+		return true;
+	}
+
 	/**Indicates whether this block or region overlap the given one
 	 *
 	 * @param
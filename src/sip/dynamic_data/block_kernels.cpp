@@ -0,0 +1,373 @@
+/*
+ * block_kernels.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "block_kernels.h"
+#include <algorithm>
+#include "sip.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
+
+/* The vector versions need per function target attributes and __builtin_cpu_supports
+ * with avx512f, which are available in gcc 5 and later and in clang. */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER) \
+	&& (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define BLOCK_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace sip {
+namespace block_kernels {
+
+namespace {
+
+typedef void (*fill_fn)(double*, std::size_t, double);
+typedef void (*scale_fn)(double*, std::size_t, double);
+typedef void (*scale_and_copy_fn)(double*, const double*, std::size_t, double);
+typedef void (*increment_fn)(double*, std::size_t, double);
+typedef void (*accumulate_fn)(double*, const double*, std::size_t);
+typedef void (*accumulate_scaled_fn)(double*, const double*, std::size_t, double);
+
+struct KernelTable {
+	fill_fn fill;
+	scale_fn scale;
+	scale_and_copy_fn scale_and_copy;
+	increment_fn increment;
+	accumulate_fn accumulate;
+	accumulate_scaled_fn accumulate_scaled;
+};
+
+//********************** scalar ***************************
+
+void scalar_fill(double* data, std::size_t n, double value) {
+	std::fill(data, data + n, value);
+}
+
+void scalar_scale(double* data, std::size_t n, double factor) {
+	for (std::size_t i = 0; i < n; ++i) data[i] *= factor;
+}
+
+void scalar_scale_and_copy(double* target, const double* source, std::size_t n, double factor) {
+	for (std::size_t i = 0; i < n; ++i) target[i] = source[i] * factor;
+}
+
+void scalar_increment(double* data, std::size_t n, double delta) {
+	for (std::size_t i = 0; i < n; ++i) data[i] += delta;
+}
+
+void scalar_accumulate(double* data, const double* to_add, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) data[i] += to_add[i];
+}
+
+void scalar_accumulate_scaled(double* data, const double* to_add, std::size_t n, double factor) {
+	for (std::size_t i = 0; i < n; ++i) data[i] += factor * to_add[i];
+}
+
+const KernelTable scalar_kernels = { scalar_fill, scalar_scale,
+		scalar_scale_and_copy, scalar_increment, scalar_accumulate,
+		scalar_accumulate_scaled };
+
+#ifdef BLOCK_KERNELS_X86
+
+//********************** AVX2 ***************************
+// Loops are unrolled by two vectors; the remainder is handled by the scalar loop.
+
+__attribute__((target("avx2"))) void avx2_fill(double* data, std::size_t n, double value) {
+	__m256d v = _mm256_set1_pd(value);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(data + i, v);
+		_mm256_storeu_pd(data + i + 4, v);
+	}
+	for (; i < n; ++i) data[i] = value;
+}
+
+__attribute__((target("avx2"))) void avx2_scale(double* data, std::size_t n, double factor) {
+	__m256d f = _mm256_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), f));
+		_mm256_storeu_pd(data + i + 4, _mm256_mul_pd(_mm256_loadu_pd(data + i + 4), f));
+	}
+	for (; i < n; ++i) data[i] *= factor;
+}
+
+__attribute__((target("avx2"))) void avx2_scale_and_copy(double* target, const double* source,
+		std::size_t n, double factor) {
+	__m256d f = _mm256_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(target + i, _mm256_mul_pd(_mm256_loadu_pd(source + i), f));
+		_mm256_storeu_pd(target + i + 4, _mm256_mul_pd(_mm256_loadu_pd(source + i + 4), f));
+	}
+	for (; i < n; ++i) target[i] = source[i] * factor;
+}
+
+__attribute__((target("avx2"))) void avx2_increment(double* data, std::size_t n, double delta) {
+	__m256d d = _mm256_set1_pd(delta);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(data + i, _mm256_add_pd(_mm256_loadu_pd(data + i), d));
+		_mm256_storeu_pd(data + i + 4, _mm256_add_pd(_mm256_loadu_pd(data + i + 4), d));
+	}
+	for (; i < n; ++i) data[i] += delta;
+}
+
+__attribute__((target("avx2"))) void avx2_accumulate(double* data, const double* to_add, std::size_t n) {
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(data + i,
+				_mm256_add_pd(_mm256_loadu_pd(data + i), _mm256_loadu_pd(to_add + i)));
+		_mm256_storeu_pd(data + i + 4,
+				_mm256_add_pd(_mm256_loadu_pd(data + i + 4), _mm256_loadu_pd(to_add + i + 4)));
+	}
+	for (; i < n; ++i) data[i] += to_add[i];
+}
+
+__attribute__((target("avx2"))) void avx2_accumulate_scaled(double* data, const double* to_add,
+		std::size_t n, double factor) {
+	__m256d f = _mm256_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_pd(data + i, _mm256_add_pd(_mm256_loadu_pd(data + i),
+				_mm256_mul_pd(_mm256_loadu_pd(to_add + i), f)));
+		_mm256_storeu_pd(data + i + 4, _mm256_add_pd(_mm256_loadu_pd(data + i + 4),
+				_mm256_mul_pd(_mm256_loadu_pd(to_add + i + 4), f)));
+	}
+	for (; i < n; ++i) data[i] += factor * to_add[i];
+}
+
+const KernelTable avx2_kernels = { avx2_fill, avx2_scale,
+		avx2_scale_and_copy, avx2_increment, avx2_accumulate,
+		avx2_accumulate_scaled };
+
+//********************** AVX-512 ***************************
+
+__attribute__((target("avx512f"))) void avx512_fill(double* data, std::size_t n, double value) {
+	__m512d v = _mm512_set1_pd(value);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(data + i, v);
+		_mm512_storeu_pd(data + i + 8, v);
+	}
+	for (; i < n; ++i) data[i] = value;
+}
+
+__attribute__((target("avx512f"))) void avx512_scale(double* data, std::size_t n, double factor) {
+	__m512d f = _mm512_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(data + i, _mm512_mul_pd(_mm512_loadu_pd(data + i), f));
+		_mm512_storeu_pd(data + i + 8, _mm512_mul_pd(_mm512_loadu_pd(data + i + 8), f));
+	}
+	for (; i < n; ++i) data[i] *= factor;
+}
+
+__attribute__((target("avx512f"))) void avx512_scale_and_copy(double* target, const double* source,
+		std::size_t n, double factor) {
+	__m512d f = _mm512_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(target + i, _mm512_mul_pd(_mm512_loadu_pd(source + i), f));
+		_mm512_storeu_pd(target + i + 8, _mm512_mul_pd(_mm512_loadu_pd(source + i + 8), f));
+	}
+	for (; i < n; ++i) target[i] = source[i] * factor;
+}
+
+__attribute__((target("avx512f"))) void avx512_increment(double* data, std::size_t n, double delta) {
+	__m512d d = _mm512_set1_pd(delta);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(data + i, _mm512_add_pd(_mm512_loadu_pd(data + i), d));
+		_mm512_storeu_pd(data + i + 8, _mm512_add_pd(_mm512_loadu_pd(data + i + 8), d));
+	}
+	for (; i < n; ++i) data[i] += delta;
+}
+
+__attribute__((target("avx512f"))) void avx512_accumulate(double* data, const double* to_add, std::size_t n) {
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(data + i,
+				_mm512_add_pd(_mm512_loadu_pd(data + i), _mm512_loadu_pd(to_add + i)));
+		_mm512_storeu_pd(data + i + 8,
+				_mm512_add_pd(_mm512_loadu_pd(data + i + 8), _mm512_loadu_pd(to_add + i + 8)));
+	}
+	for (; i < n; ++i) data[i] += to_add[i];
+}
+
+__attribute__((target("avx512f"))) void avx512_accumulate_scaled(double* data, const double* to_add,
+		std::size_t n, double factor) {
+	__m512d f = _mm512_set1_pd(factor);
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_pd(data + i, _mm512_add_pd(_mm512_loadu_pd(data + i),
+				_mm512_mul_pd(_mm512_loadu_pd(to_add + i), f)));
+		_mm512_storeu_pd(data + i + 8, _mm512_add_pd(_mm512_loadu_pd(data + i + 8),
+				_mm512_mul_pd(_mm512_loadu_pd(to_add + i + 8), f)));
+	}
+	for (; i < n; ++i) data[i] += factor * to_add[i];
+}
+
+const KernelTable avx512_kernels = { avx512_fill, avx512_scale,
+		avx512_scale_and_copy, avx512_increment, avx512_accumulate,
+		avx512_accumulate_scaled };
+
+#endif //BLOCK_KERNELS_X86
+
+const KernelTable& table_for(Isa isa) {
+#ifdef BLOCK_KERNELS_X86
+	if (isa == avx512_isa) return avx512_kernels;
+	if (isa == avx2_isa) return avx2_kernels;
+#endif //BLOCK_KERNELS_X86
+	return scalar_kernels;
+}
+
+Isa detect_isa() {
+#ifdef BLOCK_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return avx512_isa;
+	if (__builtin_cpu_supports("avx2")) return avx2_isa;
+#endif //BLOCK_KERNELS_X86
+	return scalar_isa;
+}
+
+/* Initialized during static initialization, before main, so that the kernels
+ * can be called from multiple threads without synchronization. */
+const Isa best_isa = detect_isa();
+const KernelTable* kernels = &table_for(best_isa);
+
+int threads = 1;
+
+/* Chunks given to threads are a multiple of this many doubles (one cache line)
+ * so that threads do not write to the same line. */
+const std::size_t CHUNK_ALIGN = 8;
+
+inline bool use_threads(std::size_t n) {
+#ifdef _OPENMP
+	return threads > 1 && n >= PARALLEL_THRESHOLD && !omp_in_parallel();
+#else
+	return false;
+#endif //_OPENMP
+}
+
+inline std::size_t chunk_size(std::size_t n) {
+	std::size_t chunk = (n + threads - 1) / threads;
+	return (chunk + CHUNK_ALIGN - 1) / CHUNK_ALIGN * CHUNK_ALIGN;
+}
+
+} /* anonymous namespace */
+
+void fill(double* data, std::size_t n, double value) {
+	fill_fn f = kernels->fill;
+	if (!use_threads(n)) {
+		f(data, n, value);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(data + begin, std::min(n, begin + chunk) - begin, value);
+	}
+}
+
+void scale(double* data, std::size_t n, double factor) {
+	scale_fn f = kernels->scale;
+	if (!use_threads(n)) {
+		f(data, n, factor);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(data + begin, std::min(n, begin + chunk) - begin, factor);
+	}
+}
+
+void scale_and_copy(double* target, const double* source, std::size_t n, double factor) {
+	scale_and_copy_fn f = kernels->scale_and_copy;
+	if (!use_threads(n)) {
+		f(target, source, n, factor);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(target + begin, source + begin, std::min(n, begin + chunk) - begin, factor);
+	}
+}
+
+void increment(double* data, std::size_t n, double delta) {
+	increment_fn f = kernels->increment;
+	if (!use_threads(n)) {
+		f(data, n, delta);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(data + begin, std::min(n, begin + chunk) - begin, delta);
+	}
+}
+
+void accumulate(double* data, const double* to_add, std::size_t n) {
+	accumulate_fn f = kernels->accumulate;
+	if (!use_threads(n)) {
+		f(data, to_add, n);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(data + begin, to_add + begin, std::min(n, begin + chunk) - begin);
+	}
+}
+
+void accumulate_scaled(double* data, const double* to_add, std::size_t n, double factor) {
+	accumulate_scaled_fn f = kernels->accumulate_scaled;
+	if (!use_threads(n)) {
+		f(data, to_add, n, factor);
+		return;
+	}
+	std::size_t chunk = chunk_size(n);
+#pragma omp parallel for num_threads(threads)
+	for (int t = 0; t < threads; ++t) {
+		std::size_t begin = std::min(n, t * chunk);
+		f(data + begin, to_add + begin, std::min(n, begin + chunk) - begin, factor);
+	}
+}
+
+void set_num_threads(int num_threads) {
+#ifdef _OPENMP
+	threads = std::max(1, std::min(num_threads, MAX_OMP_THREADS));
+#endif //_OPENMP
+}
+
+int num_threads() {
+	return threads;
+}
+
+Isa isa() {
+	return best_isa;
+}
+
+const char* isa_name(Isa isa) {
+	switch (isa) {
+	case avx512_isa: return "avx512";
+	case avx2_isa: return "avx2";
+	default: return "scalar";
+	}
+}
+
+} /* namespace block_kernels */
+} /* namespace sip */
@@ -0,0 +1,67 @@
+/*
+ * block_kernels.h
+ *
+ * Element-wise kernels used by Block and ServerBlock.
+ *
+ * Each operation has a scalar version and, on x86 compilers that support
+ * per function target attributes, AVX2 and AVX-512 versions.  The version
+ * used is chosen once at runtime from the features of the cpu.
+ *
+ * If the code is compiled with OpenMP, arrays of at least PARALLEL_THRESHOLD elements
+ * are split among num_threads() threads, unless the caller is already in a parallel
+ * region, such as a threaded pardo.  The default is a single thread.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef BLOCK_KERNELS_H_
+#define BLOCK_KERNELS_H_
+
+#include <cstddef>
+
+namespace sip {
+namespace block_kernels {
+
+enum Isa {
+	scalar_isa = 0,
+	avx2_isa = 1,
+	avx512_isa = 2
+};
+
+/** data[i] = value */
+void fill(double* data, std::size_t n, double value);
+
+/** data[i] *= factor */
+void scale(double* data, std::size_t n, double factor);
+
+/** target[i] = source[i] * factor */
+void scale_and_copy(double* target, const double* source, std::size_t n, double factor);
+
+/** data[i] += delta */
+void increment(double* data, std::size_t n, double delta);
+
+/** data[i] += to_add[i] */
+void accumulate(double* data, const double* to_add, std::size_t n);
+
+/** data[i] += factor * to_add[i].  The product is rounded before the add (no fma),
+ * so factor = -1 gives the same result as data[i] - to_add[i]. */
+void accumulate_scaled(double* data, const double* to_add, std::size_t n, double factor);
+
+/** Arrays with fewer elements are not split among threads (512KB of doubles) */
+const std::size_t PARALLEL_THRESHOLD = 1 << 16;
+
+/** Number of threads used for arrays of at least PARALLEL_THRESHOLD elements.
+ * Ignored unless compiled with OpenMP.  Limited to MAX_OMP_THREADS. */
+void set_num_threads(int num_threads);
+int num_threads();
+
+/** The instruction set in use, the best one supported by this cpu and build */
+Isa isa();
+
+const char* isa_name(Isa isa);
+
+} /* namespace block_kernels */
+} /* namespace sip */
+
+#endif /* BLOCK_KERNELS_H_ */
@@ -42,6 +42,11 @@ sip_tables_(sip_tables),
 block_map_(sip_tables.num_arrays()){
 }
 
+BlockManager::BlockManager(const SipTables &sip_tables, BlockManager& shared) :
+sip_tables_(sip_tables),
+block_map_(sip_tables.num_arrays(), shared.block_map_){
+}
+
 
 /**
  * Delete blocks being managed by the block manager.
@@ -205,6 +210,18 @@ void BlockManager::leave_scope() {
 	delete temps;
 }
 
+/* caches the blocks of the array that are not in the temp block list of any open scope */
+std::size_t BlockManager::cache_unscoped_blocks(int array_id) {
+	std::set<BlockId> scoped;
+	std::vector<BlockList*>::iterator it;
+	for (it = temp_block_list_stack_.begin(); it != temp_block_list_stack_.end(); ++it) {
+		for (BlockList::iterator lit = (*it)->begin(); lit != (*it)->end(); ++lit) {
+			if (lit->array_id() == array_id) scoped.insert(*lit);
+		}
+	}
+	return block_map_.cache_blocks_of_array(array_id, scoped);
+}
+
 
 
 std::ostream& operator<<(std::ostream& os, const BlockManager& obj){
@@ -22,6 +22,7 @@
 void list_blocks_with_number();
 void check_block_number_calculation(int& array_slot, int& rank,
 			int* index_values, int& size, int* extents,  double* data, int& ierr);
+class TestControllerParallel;
 
 namespace sip {
 class SipTables;
@@ -38,6 +39,10 @@ public:
 	typedef std::map<BlockId, int> BlockIdToIndexMap;
 
 	BlockManager(const SipTables &sip_tables);
+
+	/** Creates a BlockManager for the temp blocks of a thread of a threaded pardo, whose
+	 * block data is allocated from the block map of shared. */
+	BlockManager(const SipTables &sip_tables, BlockManager& shared);
 	~BlockManager();
 
 	void allocate_local(const BlockId&);
@@ -90,6 +95,13 @@ public:
 	 */
 	void leave_scope();
 
+	/** Adds an existing block to the temp Blocks of the current scope, as if it had been
+	 * allocated with is_scope_extent true.  Used for prefetched blocks when they are first used.
+	 */
+	void add_to_current_scope(const BlockId& id){
+		temp_block_list_stack_.back()->push_back(id);
+	}
+
 	/**
 	 * Deletes the map for the given array from the block map.  This is used by the
 	 * persistent_array_manager. The call is simply delegated to the block_map_.
@@ -100,6 +112,14 @@ public:
 		block_map_.delete_per_array_map_and_blocks(array_id);
 	}
 
+	/**
+	 * Moves the blocks of the given array that do not belong to an open scope to the
+	 * cache, where they may be found again by later gets or evicted.  Used at barriers
+	 * for distributed and served arrays that were not modified.  Returns the number of
+	 * blocks moved.
+	 */
+	std::size_t cache_unscoped_blocks(int array_id);
+
 	std::size_t total_blocks(){
 		return block_map_.total_blocks();
 	}
@@ -171,6 +191,7 @@ public:
 
 	friend class DataManager;
 	friend class Interpreter;
+	friend class ::TestControllerParallel;
 
 private:
 	/** Obtains block from BlockMap.
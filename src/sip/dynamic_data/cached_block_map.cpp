@@ -10,22 +10,147 @@
 #include "job_control.h"
 #include "sip_mpi_attr.h"
 #include "memory_tracker.h"
+#include "block_allocator.h"
+#include "block_kernels.h"
 
 namespace sip {
 
+const std::size_t CachedBlockMap::FREE_BUFFER_FRACTION;
+std::string CachedBlockMap::trace_file_prefix_;
+bool CachedBlockMap::trace_file_created_ = false;
+
 CachedBlockMap::CachedBlockMap(int num_arrays)
 	: block_map_(num_arrays), cache_(num_arrays), policy_(cache_),
 
 	  max_allocatable_bytes_(sip::JobControl::global->get_max_worker_data_memory_usage()),
 //	  pending_delete_bytes_(0),
-	  set_mem_limit_once_(false){
+	  set_mem_limit_once_(false),
+	  free_buffer_bytes_(0),
+	  num_allocations_(0),
+	  num_reused_(0),
+	  num_released_(0),
+	  max_free_buffer_bytes_(0)
+#ifdef HAVE_MPI
+	  , stats_(SIPMPIAttr::get_instance().company_communicator())
+#endif //HAVE_MPI
+	  , shared_(NULL)
+	  , trace_(NULL)
+{
+#ifdef _OPENMP
+	omp_init_nest_lock(&lock_);
+#endif //_OPENMP
+	if (!trace_file_prefix_.empty()) {
+		std::stringstream name;
+		name << trace_file_prefix_ << '.' << SIPMPIAttr::get_instance().global_rank();
+		//the maps of later programs append to the trace of the first
+		trace_ = new std::ofstream(name.str().c_str(),
+				trace_file_created_ ? std::ios_base::app : std::ios_base::trunc);
+		CHECK(trace_->good(), "could not open block cache trace file " + name.str());
+		trace_file_created_ = true;
+	}
+}
 
+CachedBlockMap::CachedBlockMap(int num_arrays, CachedBlockMap& shared)
+	: block_map_(num_arrays), cache_(num_arrays), policy_(cache_),
+	  max_allocatable_bytes_(shared.max_allocatable_bytes_),
+	  set_mem_limit_once_(false),
+	  free_buffer_bytes_(0),
+	  num_allocations_(0),
+	  num_reused_(0),
+	  num_released_(0),
+	  max_free_buffer_bytes_(0)
+#ifdef HAVE_MPI
+	  , stats_(SIPMPIAttr::get_instance().company_communicator())
+#endif //HAVE_MPI
+	  , shared_(&shared)
+	  , trace_(NULL)
+{
+#ifdef _OPENMP
+	omp_init_nest_lock(&lock_);
+#endif //_OPENMP
 }
 
 CachedBlockMap::~CachedBlockMap() {
 /** waits for blocks pending delete to be deleted*/
 //	WARN(pending_delete_bytes_==0, "pending_delete_bytes != 0 after wait_and_clean_pending in ~CachedBlockMap");
 	WARN(pending_delete_.size()==0, "pending_delete_ not empty in ~CachedBlockMap");
+	release_free_buffers(free_buffer_bytes_);
+	num_released_ = 0;
+	delete trace_;
+#ifdef _OPENMP
+	omp_destroy_nest_lock(&lock_);
+#endif //_OPENMP
+}
+
+void CachedBlockMap::lock() {
+#ifdef _OPENMP
+	omp_set_nest_lock(&lock_);
+#endif //_OPENMP
+}
+
+void CachedBlockMap::unlock() {
+#ifdef _OPENMP
+	omp_unset_nest_lock(&lock_);
+#endif //_OPENMP
+}
+
+void CachedBlockMap::set_trace_file_prefix(const std::string& prefix) {
+	trace_file_prefix_ = prefix;
+	trace_file_created_ = false;
+}
+
+void CachedBlockMap::trace(char event, const BlockId& block_id, std::size_t size) {
+	*trace_ << event << ' ' << block_id.array_id();
+	for (int i = 0; i < MAX_RANK; ++i) {
+		*trace_ << ' ' << block_id.index_values(i);
+	}
+	if (size > 0) *trace_ << ' ' << size;
+	*trace_ << '\n';
+}
+
+void CachedBlockMap::recycle_block(Block* block_ptr){
+#ifdef HAVE_MPI
+	//the buffer may still be the source of a put
+	block_ptr->wait();
+#endif //HAVE_MPI
+	double* data = block_ptr->data_;
+	std::size_t size = block_ptr->size();
+	if (shared_ == NULL && data != NULL && size > 0 && free_buffer_bytes_ + size * sizeof(double)
+			<= max_allocatable_bytes_ / FREE_BUFFER_FRACTION){
+		free_buffers_[size].push_back(data);
+		free_buffer_bytes_ += size * sizeof(double);
+		if (free_buffer_bytes_ > max_free_buffer_bytes_) max_free_buffer_bytes_ = free_buffer_bytes_;
+		block_ptr->data_ = NULL;  //the MemoryTracker still counts the buffer
+	}
+	delete block_ptr;
+}
+
+double* CachedBlockMap::take_free_buffer(std::size_t size){
+	FreeBuffers::iterator it = free_buffers_.find(size);
+	if (it == free_buffers_.end() || it->second.empty()) return NULL;
+	double* data = it->second.back();
+	it->second.pop_back();
+	free_buffer_bytes_ -= size * sizeof(double);
+	return data;
+}
+
+size_t CachedBlockMap::release_free_buffers(std::size_t bytes_to_free){
+	size_t released_bytes = 0;
+	FreeBuffers::reverse_iterator it = free_buffers_.rbegin();
+	while (released_bytes < bytes_to_free && it != free_buffers_.rend()){
+		std::size_t size = it->first;
+		std::vector<double*>& buffers = it->second;
+		while (released_bytes < bytes_to_free && !buffers.empty()){
+			BlockAllocator::deallocate(buffers.back());
+			buffers.pop_back();
+			MemoryTracker::global->dec_allocated(size);
+			released_bytes += size * sizeof(double);
+			++num_released_;
+		}
+		++it;
+	}
+	free_buffer_bytes_ -= released_bytes;
+	return released_bytes;
 }
 
 Block* CachedBlockMap::block(const BlockId& block_id){
@@ -34,9 +159,11 @@ Block* CachedBlockMap::block(const BlockId& block_id){
 	 */
 	Block* block_ptr = block_map_.block(block_id);
 	if (block_ptr == NULL){
+		if (trace_ != NULL) trace('l', block_id);
 		block_ptr = cache_.block(block_id);
 		if (block_ptr != NULL){
 			Block * dont_delete_block = cache_.get_and_remove_block(block_id);
+			policy_.release(block_id);
 			block_map_.insert_block(block_id, block_ptr);
 		}
 	}
@@ -45,8 +172,13 @@ Block* CachedBlockMap::block(const BlockId& block_id){
 
 
 
-size_t CachedBlockMap::free_up_bytes_in_cache(std::size_t requested_bytes_to_free) {
+size_t CachedBlockMap::free_up_bytes_in_cache(std::size_t requested_bytes_to_free,
+		std::size_t reusable_size) {
 	size_t freed_bytes = 0;
+	if (requested_bytes_to_free > 0){
+		//pooled buffers are not useful for the requested size, otherwise allocate_data would have taken one
+		freed_bytes += release_free_buffers(requested_bytes_to_free);
+	}
     while (freed_bytes < requested_bytes_to_free) {
         /** While not enough space is available, check to see if blocks in communication (pending block)
          * have been freed up. If so, check if space has been freed up (continue).
@@ -83,6 +215,10 @@ size_t CachedBlockMap::free_up_bytes_in_cache(std::size_t requested_bytes_to_fre
             Block* tmp_block_ptr = cache_.get_and_remove_block(block_id);
             size_t block_bytes = tmp_block_ptr->size() * sizeof(double);
             freed_bytes += block_bytes;
+            if (reusable_size > 0 && static_cast<std::size_t>(tmp_block_ptr->size()) == reusable_size){
+            	recycle_block(tmp_block_ptr);  //taken by allocate_data
+            	break;
+            }
             delete tmp_block_ptr;
         }
     }
@@ -102,6 +238,21 @@ double* CachedBlockMap::allocate_data(std::size_t size, bool initialize){
 //	    while (0 == i)
 //	        sleep(5);
 //	}
+		++num_allocations_;
+		if (shared_ != NULL){
+			shared_->lock();
+			double* data = shared_->allocate_data(size, initialize);
+			shared_->unlock();
+			return data;
+		}
+		double* data = take_free_buffer(size);
+		if (data != NULL){
+			++num_reused_;
+			if (initialize){
+				block_kernels::fill(data, size, 0.0);
+			}
+			return data;
+		}
 		size_t bytes_to_allocate = size*sizeof(double);
 		size_t allocated_bytes = MemoryTracker::global->get_allocated_bytes();
 //		std::cerr << "size, bytes_to_allocate, allocated_bytes = " <<
@@ -112,7 +263,6 @@ double* CachedBlockMap::allocate_data(std::size_t size, bool initialize){
 			bytes_to_free = bytes_to_allocate;
 		}
 		size_t freed = 0;
-		double* data = NULL;
 		bool allocated = false;
 //		std::cerr << "entering loop in allocate_data" << std::endl << std::flush;
 //		std::cerr << "size, bytes_to_allocate, allocated_bytes, bytes_to_free, freed" <<
@@ -120,13 +270,20 @@ double* CachedBlockMap::allocate_data(std::size_t size, bool initialize){
 //				std::endl << std::flush;
 		while (!allocated) {
 //			std::cerr << "in loop in allocate_data" << std::endl << std::flush;
-			freed = free_up_bytes_in_cache(bytes_to_free); //returns 0 if to_free <= 0
-			try {
+			freed = free_up_bytes_in_cache(bytes_to_free, size); //returns 0 if to_free <= 0
+			data = take_free_buffer(size);
+			if (data != NULL){
+				//an evicted block of the same size, still counted by the MemoryTracker
+				++num_reused_;
 				if (initialize){
-				data = new double[size]();
+					block_kernels::fill(data, size, 0.0);
 				}
-				else {
-					data = new double[size];
+				return data;
+			}
+			try {
+				data = BlockAllocator::allocate(size);
+				if (initialize){
+					block_kernels::fill(data, size, 0.0);
 				}
 				MemoryTracker::global->inc_allocated(size);
 //				WARN(MemoryTracker::global->get_allocated_bytes() <= max_allocatable_bytes_ ,
@@ -139,6 +296,7 @@ double* CachedBlockMap::allocate_data(std::size_t size, bool initialize){
 				if (freed < bytes_to_free){
 					fail(" Could not free requested amount of memory.  CachedBlockMap::allocate_data failed");
 				}
+				BlockAllocator::release_pooled_memory(); //memory cached by the allocator is not counted by the MemoryTracker
 				bytes_to_free = bytes_to_allocate; //in case bytes_to_free was 0, we want to try again.
 			}
 		}
@@ -227,6 +385,7 @@ void CachedBlockMap::cached_delete_block(const BlockId& block_id){
 //	free_up_bytes_in_cache(bytes_in_block);
 	cache_.insert_block(block_id, block_ptr);
 	policy_.touch(block_id);
+	if (trace_ != NULL) trace('c', block_id, block_ptr->size());
 
 //	block_map_.delete_block(block_id);
 
@@ -239,9 +398,9 @@ void CachedBlockMap::delete_block(const BlockId& block_id){
 //		pending_delete_bytes_ += tmp_block_ptr->size() * sizeof(double);
 		pending_delete_.push_back(tmp_block_ptr);
 	} else 
-	    delete tmp_block_ptr;
+	    recycle_block(tmp_block_ptr);
 #else // HAVE_MPI
-    delete tmp_block_ptr;
+    recycle_block(tmp_block_ptr);
 #endif // HAVE_MPI
 
 }
@@ -253,6 +412,24 @@ void CachedBlockMap::insert_per_array_map(int array_id, IdBlockMap<Block>::PerAr
 void CachedBlockMap::delete_per_array_map_and_blocks(int array_id){
  	 block_map_.delete_per_array_map_and_blocks(array_id);
 	 cache_.delete_per_array_map_and_blocks(array_id);
+	 policy_.remove_all_blocks_for_array(array_id);
+}
+
+std::size_t CachedBlockMap::cache_blocks_of_array(int array_id, const std::set<BlockId>& keep){
+	IdBlockMap<Block>::PerArrayMap* map_ptr = block_map_.per_array_map_or_null(array_id);
+	if (map_ptr == NULL) return 0;
+	std::vector<BlockId> to_cache;
+	for (IdBlockMap<Block>::PerArrayMap::iterator it = map_ptr->begin(); it != map_ptr->end(); ++it){
+		if (keep.find(it->first) != keep.end()) continue;
+#ifdef HAVE_MPI
+		it->second->wait();
+#endif //HAVE_MPI
+		to_cache.push_back(it->first);
+	}
+	for (std::vector<BlockId>::iterator it = to_cache.begin(); it != to_cache.end(); ++it){
+		cached_delete_block(*it);
+	}
+	return to_cache.size();
 }
 
 IdBlockMap<Block>::PerArrayMap* CachedBlockMap::get_and_remove_per_array_map(int array_id){
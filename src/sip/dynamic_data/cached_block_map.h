@@ -9,9 +9,24 @@
 #define CACHED_BLOCK_MAP_H_
 
 #include <cstddef>
+#include <fstream>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
 #include "id_block_map.h"
-#include "lru_array_policy.h"
+#include "lru_block_policy.h"
 #include "block.h"
+#include "counter.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#endif //HAVE_MPI
 
 
 
@@ -20,14 +35,38 @@ namespace sip {
 //void list_blocks(const SipTables& sip_tables, const IdBlockMap<Block>& obj, std::vector<std::pair<BlockId,size_t> > vec);
 class BlockId;
 /**
- * Block Map that caches blocks with a LRU array block replacement policy.
+ * Block Map that caches blocks with a LRU block replacement policy.
  * Delegates block operations to IdBlockMap<Block>
+ *
+ * The data of blocks deleted with delete_block, and of cached blocks evicted to make room
+ * for a block of the same size, is kept in free_buffers_, bucketed by the number of doubles.
+ * allocate_data hands these buffers to new blocks of that size.  Pooled buffers are still
+ * counted by the MemoryTracker, so the pool holds at most 1/FREE_BUFFER_FRACTION of
+ * max_allocatable_bytes_, and when memory is needed, only as many pooled buffers as
+ * required are released before cached blocks are evicted.
+ *
+ * The interpreters of the threads of a threaded pardo each have a map for their temp
+ * blocks that shares the worker's map.  Such a map has no buffer pool, and allocates block
+ * data from the shared map, holding its lock, so that blocks cached by the worker are
+ * evicted when memory is needed.  The shared map does not test or wait for pending blocks
+ * while threads are running, since its pending_delete_ list is emptied before they start.
  */
 class CachedBlockMap {
 public:
+	/** The buffer pool is limited to max_allocatable_bytes_ / FREE_BUFFER_FRACTION */
+	static const std::size_t FREE_BUFFER_FRACTION = 8;
+
 	CachedBlockMap(int num_arrays);
+
+	/** Creates a map whose block data is allocated from shared */
+	CachedBlockMap(int num_arrays, CachedBlockMap& shared);
 	~CachedBlockMap();
 
+	/** Lock for the threads of a threaded pardo accessing this map.  It may be acquired
+	 * several times by the same thread, and must be released as many times. */
+	void lock();
+	void unlock();
+
 	/** Obtains requested block
 	 *
 	 * If present only in cache, removes from cache and
@@ -86,6 +125,13 @@ public:
 	 */
 	void delete_per_array_map_and_blocks(int array_id);
 
+	/**
+	 * Moves the blocks of the indicated array that are in the block map, except those in
+	 * keep, to the cache, after waiting for any pending communication.  Returns the
+	 * number of blocks moved.
+	 */
+	std::size_t cache_blocks_of_array(int array_id, const std::set<BlockId>& keep);
+
 
 	/**
 	 * Returns a pointer to the PerArrayMap of the given array,
@@ -101,6 +147,16 @@ public:
 
 	/** Sets max_allocatable_bytes_ */
     void set_max_allocatable_bytes(std::size_t size);
+	std::size_t max_allocatable_bytes() const { return max_allocatable_bytes_; }
+
+	/** If prefix is not empty, the worker's CachedBlockMap of each program run afterwards
+	 * writes a trace of the accesses to its cache to the file prefix.<global rank>.  The
+	 * first one creates the file and later ones append to it.  (The maps of the threads of
+	 * a threaded pardo do not trace.)  A line is either
+	 * "c <array id> <MAX_RANK index values> <doubles>" when a block is put in the cache, or
+	 * "l <array id> <MAX_RANK index values>" when a block is looked up in it.
+	 * util/cache_policy_benchmark replays these traces. */
+	static void set_trace_file_prefix(const std::string& prefix);
 
 	//size is given in number of doubles
 	double* allocate_data(std::size_t size, bool initialize);
@@ -140,13 +196,92 @@ public:
     void c_list_blocks(const SipTables& sip_tables, std::vector<std::pair<BlockId,size_t > >& vec) const{
     	list_blocks(sip_tables,block_map_, vec);
     }
+
+	/** Frees buffers held in free_buffers_, largest first, until at least bytes_to_free
+	 * bytes have been freed or the pool is empty.
+	 * @return number of bytes freed
+	 */
+	size_t release_free_buffers(std::size_t bytes_to_free);
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		stats_.gather_and_print_statistics(os, this);
+	}
+
+	/**
+	 * Encapsulates the statistics for the buffer pool.
+	 *
+	 * num_allocations_ counts calls to allocate_data, num_reused_ those satisfied from
+	 * free_buffers_, and num_released_ the pooled buffers freed to make room for others.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_allocations_;
+		MPICounter num_reused_;
+		MPICounter num_released_;
+		MPICounter max_free_buffer_bytes_;
+
+		explicit Stats(const MPI_Comm& comm) :
+				num_allocations_(comm), num_reused_(comm), num_released_(comm),
+				max_free_buffer_bytes_(comm) {
+		}
+
+		void finalize(CachedBlockMap* parent) {
+			num_allocations_.inc(parent->num_allocations_);
+			num_reused_.inc(parent->num_reused_);
+			num_released_.inc(parent->num_released_);
+			max_free_buffer_bytes_.inc(parent->max_free_buffer_bytes_);
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, CachedBlockMap* parent) {
+			finalize(parent);
+			num_allocations_.reduce();
+			num_reused_.reduce();
+			num_allocations_.gather();
+			num_reused_.gather();
+			num_released_.gather();
+			max_free_buffer_bytes_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker block buffer pool" << std::endl;
+				os << "num_allocations_" << std::endl << num_allocations_;
+				os << "num_reused_" << std::endl << num_reused_;
+				os << "num_released_" << std::endl << num_released_;
+				os << "max_free_buffer_bytes_" << std::endl << max_free_buffer_bytes_;
+				os << "reuse rate," << reuse_rate(num_reused_.get_reduced_value(),
+						num_allocations_.get_reduced_value()) << std::endl;
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		std::ostream& gather_and_print_statistics(std::ostream& os, CachedBlockMap* parent) {
+			os << "Worker block buffer pool" << std::endl;
+			os << "num_allocations_," << parent->num_allocations_ << std::endl;
+			os << "num_reused_," << parent->num_reused_ << std::endl;
+			os << "num_released_," << parent->num_released_ << std::endl;
+			os << "max_free_buffer_bytes_," << parent->max_free_buffer_bytes_ << std::endl;
+			os << "reuse rate," << reuse_rate(parent->num_reused_, parent->num_allocations_)
+					<< std::endl;
+			os << std::endl;
+			return os;
+		}
+	};
+#endif //HAVE_MPI
+
+	/** Fraction of allocations satisfied from the buffer pool */
+	static double reuse_rate(std::size_t reused, std::size_t allocations) {
+		return allocations > 0 ? static_cast<double>(reused) / allocations : 0.0;
+	}
+
 private:
 
 	/* A block can be in at most one data structure:  block_map_, cache_, or pending_delete_*/
 
 	IdBlockMap<Block> block_map_; 	/*! Backing IdBlockMap */
 	IdBlockMap<Block> cache_;		/*! Backing Cache */
-	LRUArrayPolicy<Block> policy_;	/*! The block replacement Policy */
+	LRUBlockPolicy<Block> policy_;	/*! The block replacement Policy */
 	std::list<Block*> pending_delete_; /*! A list of blocks that would have been deleted when leaving a scope except they had a pending MPI_Request*/
 
 	/** Maximum number of bytes before deleting blocks from the cache_ */
@@ -158,7 +293,39 @@ private:
 	/** Whether the memory limit has been set once by set_max_allocatable_bytes */
 	bool set_mem_limit_once_;
 
-	size_t free_up_bytes_in_cache(std::size_t block_size);
+	/** number of doubles -> buffers of that size, no longer used by any block */
+	typedef std::map<std::size_t, std::vector<double*> > FreeBuffers;
+	FreeBuffers free_buffers_;
+	std::size_t free_buffer_bytes_;
+
+	std::size_t num_allocations_;
+	std::size_t num_reused_;
+	std::size_t num_released_;
+	std::size_t max_free_buffer_bytes_;
+	Stats stats_;
+
+	CachedBlockMap* shared_;  /*! Map that allocates the block data, or NULL */
+#ifdef _OPENMP
+	omp_nest_lock_t lock_;
+#endif //_OPENMP
+
+	static std::string trace_file_prefix_;
+	static bool trace_file_created_;  /*! Whether a map has created the trace file */
+	std::ofstream* trace_;  /*! NULL unless tracing */
+
+	/** Writes a trace line for the block, with the given size in doubles if not 0 */
+	void trace(char event, const BlockId& block_id, std::size_t size = 0);
+
+	/** Frees cached and pending blocks until at least block_size bytes have been freed.
+	 * If reusable_size is not 0, an evicted block with that many doubles is moved to
+	 * free_buffers_ instead, and counts as freed since allocate_data will take it. */
+	size_t free_up_bytes_in_cache(std::size_t block_size, std::size_t reusable_size = 0);
+
+	/** Deletes the block, moving its data to free_buffers_ if the pool has room for it */
+	void recycle_block(Block* block_ptr);
+
+	/** Removes and returns a buffer with size doubles from free_buffers_, or NULL */
+	double* take_free_buffer(std::size_t size);
 
 	friend class DataManager;
 	friend class TestControllerParallel;
@@ -54,7 +54,7 @@ std::ostream& operator<<(std::ostream& os, const WriteBack& obj) {
 
 ContiguousArrayManager::ContiguousArrayManager(const sip::SipTables& sip_tables,
 		setup::SetupReader& setup_reader, CachedBlockMap& block_map) :
-		sip_tables_(sip_tables), setup_reader_(setup_reader), block_map_(block_map) {
+		sip_tables_(sip_tables), setup_reader_(setup_reader), block_map_(block_map), shared_(NULL) {
 	//create static arrays in sial program.  All static arrays are allocated a startup
 	int num_arrays = sip_tables_.num_arrays();
 	for (int i = 0; i < num_arrays; ++i) {
@@ -95,6 +95,11 @@ ContiguousArrayManager::ContiguousArrayManager(const sip::SipTables& sip_tables,
 }
 
 
+ContiguousArrayManager::ContiguousArrayManager(const sip::SipTables& sip_tables,
+		ContiguousArrayManager& shared, CachedBlockMap& block_map) :
+		sip_tables_(sip_tables), setup_reader_(shared.setup_reader_), block_map_(block_map), shared_(&shared) {
+}
+
 /** delete all contiguous arrays except the predefined ones. */
 ContiguousArrayManager::~ContiguousArrayManager() {
 	ContiguousArrayMap::iterator it;
@@ -183,6 +188,7 @@ std::ostream& operator<<(std::ostream& os, const ContiguousArrayManager& obj) {
 }
 
 Block::BlockPtr ContiguousArrayManager::get_array(int array_id) {
+	if (shared_ != NULL) return shared_->get_array(array_id);
 	ContiguousArrayMap::iterator b = contiguous_array_map_.find(array_id);
 	if (b != contiguous_array_map_.end()) {
 		return b->second;
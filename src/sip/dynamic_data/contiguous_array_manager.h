@@ -86,6 +86,16 @@ public:
 	 * @param sipTables
 	 */
 	ContiguousArrayManager(const sip::SipTables&, setup::SetupReader&, CachedBlockMap& block_map_);
+
+	/** Creates a ContiguousArrayManager that accesses the arrays of shared, which keeps ownership
+	 * of them.  Blocks sliced out of the arrays are allocated from the given block_map.
+	 * This is used by the threads of a threaded pardo.
+	 *
+	 * @param sipTables
+	 * @param shared
+	 * @param block_map
+	 */
+	ContiguousArrayManager(const sip::SipTables&, ContiguousArrayManager& shared, CachedBlockMap& block_map_);
 	~ContiguousArrayManager();
 
 
@@ -208,6 +218,7 @@ private:
 	CachedBlockMap& block_map_; //used only for allocating and deallocating block data
 	const sip::SipTables & sip_tables_;
 	setup::SetupReader & setup_reader_;
+	ContiguousArrayManager* shared_; //owner of the arrays, or NULL if this object owns them
 
 
 	DISALLOW_COPY_AND_ASSIGN(ContiguousArrayManager);
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <sstream>
 #include <climits>
+#include <algorithm>
 
 #ifdef HAVE_MPI
 #include "sip_mpi_constants.h"
@@ -41,6 +42,31 @@ DataManager::DataManager(const SipTables &sipTables):
 }
 
 
+DataManager::DataManager(const SipTables &sipTables, DataManager& shared):
+     sip_tables_(sipTables),
+	 index_values_(shared.index_values_),
+     scalar_values_(shared.scalar_values_),
+     scalar_blocks_(sipTables.array_table_.entries_.size(),NULL),
+     int_table_(shared.int_table_),
+     block_manager_(sipTables, shared.block_manager_),
+     contiguous_array_manager_(sipTables, shared.contiguous_array_manager_, block_manager_.block_map_),
+     contiguous_local_array_manager_(sipTables, shared.block_manager_)
+        {
+		for (int i = 0; i < sipTables.array_table_.entries_.size(); ++i) {
+			if (sipTables.is_scalar(i)) {
+				scalar_blocks_[i] = new Block(scalar_address(i));
+			}
+		}
+}
+
+void DataManager::copy_values(const DataManager& other) {
+	std::copy(other.index_values_.begin(), other.index_values_.end(), index_values_.begin());
+	//copy in place since the scalar blocks point into scalar_values_
+	std::copy(other.scalar_values_.begin(), other.scalar_values_.end(), scalar_values_.begin());
+	int_table_.set_values(other.int_table_);
+}
+
+
 DataManager::~DataManager() {
     for (int i = 0; i < sip_tables_.array_table_.entries_.size(); ++i){
     	if (sip_tables_.is_scalar(i) ){
@@ -270,8 +296,16 @@ void DataManager::get_subblock_offsets_and_shape(Block::BlockPtr super_block, co
 
 
 
-void DataManager::enter_scope(){scope_count++;  block_manager_.enter_scope();}
-void DataManager::leave_scope(){scope_count--;  block_manager_.leave_scope();}
+void DataManager::enter_scope(){
+#pragma omp atomic
+	scope_count++;
+	block_manager_.enter_scope();
+}
+void DataManager::leave_scope(){
+#pragma omp atomic
+	scope_count--;
+	block_manager_.leave_scope();
+}
 
 
 } /* namespace sip */
@@ -38,6 +38,17 @@ public:
 
 	DataManager(const SipTables &sip_tables);
 
+	/** Creates a DataManager for a thread of a threaded pardo.  It has its own index values,
+	 * copies of the scalars and ints, and a BlockManager for its temp blocks, whose data is
+	 * allocated from the block map of shared.  Static and
+	 * contiguous local arrays are those of shared.  Local arrays are not accessible through
+	 * this object and must be obtained from shared.
+	 */
+	DataManager(const SipTables &sip_tables, DataManager& shared);
+
+	/** Sets the index values, scalars, and ints to the values in other */
+	void copy_values(const DataManager& other);
+
 
 
 	~DataManager();
@@ -8,11 +8,13 @@
 #ifndef ID_BLOCK_MAP_H_
 #define ID_BLOCK_MAP_H_
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <stack>
 #include <iostream>
 #include "block_id.h"
+#include "block_hash_map.h"
 #include "sip_interface.h"
 #include "sip_tables.h" 
 
@@ -29,9 +31,10 @@ template <typename BLOCK_TYPE>
 class IdBlockMap {
 public:
 
-	typedef std::map<BlockId, BLOCK_TYPE*> PerArrayMap;
+	/** Blocks of an array.  Unordered, see BlockHashMap */
+	typedef BlockHashMap<BLOCK_TYPE*> PerArrayMap;
 	typedef std::vector<PerArrayMap*> BlockMapVector;
-	typedef typename std::vector<std::map<BlockId, BLOCK_TYPE* >* >::size_type size_type;
+	typedef typename BlockMapVector::size_type size_type;
 
 
 	/**
@@ -339,6 +342,8 @@ void list_blocks(const SipTables& sip_tables, const IdBlockMap<BLOCK_TYPE>& obj,
 			}
 		}
 	}
+	//the per array maps are not ordered
+	std::sort(vec.begin(), vec.end());
 }
 
 /**
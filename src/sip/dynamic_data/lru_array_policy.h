@@ -115,12 +115,6 @@ private:
 
 };
 
-#ifdef HAVE_MPI
-class ServerBlock;
-// Template Specialization for ServerBlocks. Implementation in disk_backed_block_map.cpp
-template<> BlockId LRUArrayPolicy<ServerBlock>::get_next_block_for_removal(ServerBlock*& block);
-#endif // HAVE_MPI
-
 } /* namespace sip */
 
 
@@ -0,0 +1,329 @@
+/*
+ * lru_block_policy.h
+ *
+ * Block replacement policy that orders blocks, rather than arrays, by their last use.
+ *
+ * LRUArrayPolicy orders arrays, and evicts an arbitrary block of the least recently used
+ * array.  When two arrays are used together, as by every iteration of a pardo, it may evict
+ * a block of a small array that is needed by the next iteration.  This policy keeps the
+ * blocks in a doubly linked list threaded through a vector of nodes, with a BlockHashMap
+ * from BlockId to node, so touch, release and get_next_block_for_removal take constant time.
+ *
+ * Plain LRU evicts every block of a loop over more blocks than fit, such as the sweeps of
+ * an iterative program over a large array, before it is used again.  So a block that is
+ * touched for the first time goes to the least recently used end of the list, and only
+ * moves to the front when it is touched again (bimodal insertion).  The last RECENT_TOUCHES
+ * blocks that were evicted or released are remembered in a ghost list, and a block touched
+ * while in the ghost list also goes to the front.  Then a loop keeps the part of its blocks
+ * that fits, while blocks that are reused soon stay.  Every INSERT_FRONT_PERIOD'th new block
+ * goes to the front anyway.
+ *
+ * This is a variant of LRU with bimodal insertion and a ghost list, as in 2Q, not plain LRU.
+ * The constants were chosen with cache_policy_benchmark -t on its synthetic traces with 8,
+ * 12 and 16 segments (6, 4 and 3 sweeps).  With capacities of 5, 10, 25 and 50% of the
+ * footprint, 128 and 32 are within 0.3 points of the best hit rate of the values tried
+ * (INSERT_FRONT_PERIOD 1, 8, 32, 128 or never, RECENT_TOUCHES 0 to 1024) on every trace.
+ * For example, with 12 segments the hit rates are 0.160, 0.227, 0.432 and 0.658, against
+ * 0.054, 0.125, 0.348 and 0.617 for LRUArrayPolicy and 0.003, 0.005, 0.013 and 0.283 for
+ * plain LRU (INSERT_FRONT_PERIOD 1, RECENT_TOUCHES 0).
+ *
+ * Blocks of arrays that are no longer used would then stay forever, so the arrays with
+ * blocks in the list are also ordered by their last use, and each has a list of its blocks.
+ * If the least recently used array has not been touched during the last RECENT_TOUCHES
+ * touches, its blocks are evicted first.
+ *
+ * The policy does not own the blocks.  Blocks that were removed from the block map, or
+ * that are not evictable (e.g. server blocks whose chunk was already written out), are
+ * moved to the ghost list when they would be evicted.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef LRU_BLOCK_POLICY_H_
+#define LRU_BLOCK_POLICY_H_
+
+#include "id_block_map.h"
+#include "block_id.h"
+#include "block_hash_map.h"
+
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace sip {
+
+template <typename BLOCK_TYPE>
+class LRUBlockPolicy {
+public:
+	/** Every INSERT_FRONT_PERIOD'th new block is treated as recently used */
+	static const int INSERT_FRONT_PERIOD = 128;
+	/** Number of evicted or released blocks that are remembered, and number of touches
+	 * after which an array that was not touched is no longer used */
+	static const std::size_t RECENT_TOUCHES = 32;
+
+	/** The defaults of insert_front_period and recent_touches are INSERT_FRONT_PERIOD and
+	 * RECENT_TOUCHES.  Other values are for cache_policy_benchmark. */
+	LRUBlockPolicy(IdBlockMap<BLOCK_TYPE>& block_map,
+			int insert_front_period = INSERT_FRONT_PERIOD,
+			std::size_t recent_touches = RECENT_TOUCHES) :
+			block_map_(block_map), insert_front_period_(insert_front_period),
+			recent_touches_(recent_touches), clock_(0), num_new_(0), free_(NIL),
+			array_head_(NIL), array_tail_(NIL) {}
+
+	/*! Mark a block as recently used */
+	void touch(const BlockId& bid) {
+		++clock_;
+		typename BlockHashMap<int>::iterator it = index_.find(bid);
+		if (it != index_.end()) {
+			int node = it->second;
+			if (nodes_[node].resident_) {
+				unlink_resident(node);
+			} else {
+				unlink(ghost_, node);
+			}
+			link_resident(node, true);
+			return;
+		}
+		int node = new_node(bid);
+		index_.insert(std::make_pair(bid, node));
+		link_resident(node, ++num_new_ % insert_front_period_ == 0);
+	}
+
+	/*! The block left the block map to be used, e.g. a cached block that was needed again.
+	 * It is remembered as recently used. */
+	void release(const BlockId& bid) {
+		typename BlockHashMap<int>::iterator it = index_.find(bid);
+		if (it == index_.end() || !nodes_[it->second].resident_) return;
+		to_ghost(it->second);
+	}
+
+	/*! Removes all blocks with given array id.  Linear in the number of blocks of the
+	 * array. */
+	void remove_all_blocks_for_array(int array_id) {
+		if (array_id < static_cast<int>(arrays_.size())) {
+			while (arrays_[array_id].head_ != NIL) {
+				int node = arrays_[array_id].head_;
+				unlink_resident(node);
+				free_node(node);
+			}
+		}
+		int node = ghost_.head_;
+		while (node != NIL) {
+			int next = nodes_[node].next_;
+			if (nodes_[node].id_.array_id() == array_id) {
+				unlink(ghost_, node);
+				free_node(node);
+			}
+			node = next;
+		}
+	}
+
+	/*! Any blocks available to remove? */
+	bool any_blocks_for_removal() {
+		int node;
+		while ((node = victim()) != NIL) {
+			if (evictable(block_map_.block(nodes_[node].id_))) return true;
+			to_ghost(node);
+		}
+		return false;
+	}
+
+	/*! Get the next block for removal.  It is moved to the ghost list. */
+	BlockId get_next_block_for_removal(BLOCK_TYPE*& block) {
+		int node;
+		while ((node = victim()) != NIL) {
+			block = block_map_.block(nodes_[node].id_);
+			to_ghost(node);
+			if (evictable(block)) return nodes_[node].id_;
+		}
+		throw std::out_of_range("No blocks to remove !");
+	}
+
+	/*! Number of blocks that may be offered for removal, including those that are no
+	 * longer evictable */
+	std::size_t size() const { return resident_.size_; }
+
+	friend std::ostream& operator<<(std::ostream& os, const LRUBlockPolicy<BLOCK_TYPE>& obj) {
+		os << "LRU Blocks : [";
+		for (int node = obj.resident_.head_; node != NIL; node = obj.nodes_[node].next_) {
+			if (node != obj.resident_.head_) os << ", ";
+			os << obj.nodes_[node].id_;
+		}
+		os << "]" << std::endl;
+		return os;
+	}
+
+private:
+	static const int NIL = -1;
+
+	struct Node {
+		explicit Node(const BlockId& id) :
+				id_(id), prev_(NIL), next_(NIL), array_prev_(NIL), array_next_(NIL),
+				resident_(false) {}
+		BlockId id_;
+		int prev_;        //in resident_ or ghost_
+		int next_;        //also links the free nodes
+		int array_prev_;  //in the list of the blocks of the array, if resident
+		int array_next_;
+		bool resident_;
+	};
+
+	struct List {
+		List() : head_(NIL), tail_(NIL), size_(0) {}
+		int head_;  //most recently used
+		int tail_;  //least recently used
+		std::size_t size_;
+	};
+
+	/** The resident blocks of an array, and its place in the list of arrays */
+	struct Array {
+		Array() : head_(NIL), tail_(NIL), prev_(NIL), next_(NIL), last_touch_(0) {}
+		int head_;
+		int tail_;
+		int prev_;
+		int next_;
+		long last_touch_;
+	};
+
+	/*! Whether the block may be offered up for removal */
+	bool evictable(BLOCK_TYPE* block) { return block != NULL; }
+
+	/*! The node to evict next, or NIL */
+	int victim() {
+		if (array_tail_ != NIL
+				&& static_cast<std::size_t>(clock_ - arrays_[array_tail_].last_touch_) > recent_touches_) {
+			return arrays_[array_tail_].tail_;
+		}
+		return resident_.tail_;
+	}
+
+	int new_node(const BlockId& bid) {
+		if (free_ == NIL) {
+			nodes_.push_back(Node(bid));
+			return nodes_.size() - 1;
+		}
+		int node = free_;
+		free_ = nodes_[node].next_;
+		nodes_[node] = Node(bid);
+		return node;
+	}
+
+	void free_node(int node) {
+		index_.erase(nodes_[node].id_);
+		nodes_[node].next_ = free_;
+		free_ = node;
+	}
+
+	void unlink(List& list, int node) {
+		Node& n = nodes_[node];
+		if (n.prev_ != NIL) nodes_[n.prev_].next_ = n.next_; else list.head_ = n.next_;
+		if (n.next_ != NIL) nodes_[n.next_].prev_ = n.prev_; else list.tail_ = n.prev_;
+		n.prev_ = NIL;
+		n.next_ = NIL;
+		--list.size_;
+	}
+
+	void push_front(List& list, int node) {
+		Node& n = nodes_[node];
+		n.prev_ = NIL;
+		n.next_ = list.head_;
+		if (list.head_ != NIL) nodes_[list.head_].prev_ = node; else list.tail_ = node;
+		list.head_ = node;
+		++list.size_;
+	}
+
+	void push_back(List& list, int node) {
+		Node& n = nodes_[node];
+		n.next_ = NIL;
+		n.prev_ = list.tail_;
+		if (list.tail_ != NIL) nodes_[list.tail_].next_ = node; else list.head_ = node;
+		list.tail_ = node;
+		++list.size_;
+	}
+
+	/*! Makes the node resident and the array of its block the most recently used one */
+	void link_resident(int node, bool front) {
+		Node& n = nodes_[node];
+		n.resident_ = true;
+		if (front) push_front(resident_, node); else push_back(resident_, node);
+		int array_id = n.id_.array_id();
+		if (array_id >= static_cast<int>(arrays_.size())) arrays_.resize(array_id + 1);
+		Array& a = arrays_[array_id];
+		//the array's blocks are ordered by their last touch
+		n.array_prev_ = NIL;
+		n.array_next_ = a.head_;
+		if (a.head_ != NIL) {
+			nodes_[a.head_].array_prev_ = node;
+			unlink_array(array_id);
+		} else {
+			a.tail_ = node;
+		}
+		a.head_ = node;
+		a.last_touch_ = clock_;
+		a.prev_ = NIL;
+		a.next_ = array_head_;
+		if (array_head_ != NIL) arrays_[array_head_].prev_ = array_id; else array_tail_ = array_id;
+		array_head_ = array_id;
+	}
+
+	void unlink_resident(int node) {
+		Node& n = nodes_[node];
+		unlink(resident_, node);
+		n.resident_ = false;
+		int array_id = n.id_.array_id();
+		Array& a = arrays_[array_id];
+		if (n.array_prev_ != NIL) nodes_[n.array_prev_].array_next_ = n.array_next_; else a.head_ = n.array_next_;
+		if (n.array_next_ != NIL) nodes_[n.array_next_].array_prev_ = n.array_prev_; else a.tail_ = n.array_prev_;
+		n.array_prev_ = NIL;
+		n.array_next_ = NIL;
+		//arrays without resident blocks are not in the list of arrays
+		if (a.head_ == NIL) unlink_array(array_id);
+	}
+
+	void unlink_array(int array_id) {
+		Array& a = arrays_[array_id];
+		if (a.prev_ != NIL) arrays_[a.prev_].next_ = a.next_; else array_head_ = a.next_;
+		if (a.next_ != NIL) arrays_[a.next_].prev_ = a.prev_; else array_tail_ = a.prev_;
+		a.prev_ = NIL;
+		a.next_ = NIL;
+	}
+
+	/*! Moves a resident block to the ghost list, forgetting the oldest ghosts */
+	void to_ghost(int node) {
+		unlink_resident(node);
+		push_front(ghost_, node);
+		while (ghost_.size_ > recent_touches_) {
+			int oldest = ghost_.tail_;
+			unlink(ghost_, oldest);
+			free_node(oldest);
+		}
+	}
+
+	IdBlockMap<BLOCK_TYPE>& block_map_;
+	const int insert_front_period_;
+	const std::size_t recent_touches_;
+	std::vector<Node> nodes_;
+	BlockHashMap<int> index_;  /*! BlockId -> its node */
+	List resident_;  /*! blocks in the block map */
+	List ghost_;     /*! recently evicted or released blocks */
+	long clock_;     /*! number of touches */
+	long num_new_;   /*! number of touches of blocks that were not in either list */
+	int free_;       /*! first unused node */
+
+	std::vector<Array> arrays_;  /*! indexed by array id */
+	int array_head_;  /*! most recently used array with resident blocks */
+	int array_tail_;  /*! least recently used array with resident blocks */
+
+	DISALLOW_COPY_AND_ASSIGN(LRUBlockPolicy);
+};
+
+#ifdef HAVE_MPI
+class ServerBlock;
+// Template Specialization for ServerBlocks. Implementation in disk_backed_block_map.cpp
+template<> bool LRUBlockPolicy<ServerBlock>::evictable(ServerBlock* block);
+#endif // HAVE_MPI
+
+} /* namespace sip */
+
+#endif /* LRU_BLOCK_POLICY_H_ */
@@ -28,11 +28,14 @@ public:
 		global = memory_tracker;
 	}
 
+	//atomic since blocks may be allocated and freed by the threads of a threaded pardo
 	void inc_allocated(std::size_t size){
+#pragma omp atomic
 		allocated_bytes_ += size*sizeof(double);
 	}
 
 	void dec_allocated(std::size_t size){
+#pragma omp atomic
 		allocated_bytes_ -= size*sizeof(double);
 	}
 
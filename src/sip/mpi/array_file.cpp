@@ -207,6 +207,10 @@ void ArrayFile::chunk_write(const Chunk & chunk) {
 	int err = MPI_File_write_at(fh_, offset, chunk.data_, chunk_size_,
 	MPI_DOUBLE, &status);
 	CHECK(err == MPI_SUCCESS, "write_chunk failed");
+	//the server's helper threads may write chunks concurrently
+#ifdef _OPENMP
+#pragma omp critical(array_file_stats)
+#endif //_OPENMP
 	stats_.chunks_written_.inc();
 }
 
@@ -113,4 +113,53 @@ std::ostream& operator<<(std::ostream& os, const AsyncAcks& acks) {
 
 	return os;
 }
+
+AsyncSends::AsyncSends() :
+		pending_bytes_(0) {
+}
+
+AsyncSends::~AsyncSends() {
+	wait_all();
+}
+
+void AsyncSends::add(MPI_Request request, char* buffer, std::size_t bytes) {
+	Send send;
+	send.request_ = request;
+	send.buffer_ = buffer;
+	send.bytes_ = bytes;
+	pending_.push_back(send);
+	pending_bytes_ += bytes;
+	cleanup();
+	while (pending_bytes_ > MAX_PENDING_BYTES) {
+		wait_first();
+	}
+}
+
+void AsyncSends::cleanup() {
+	while (!pending_.empty()) {
+		int flag = 0;
+		SIPMPIUtils::check_err(
+				MPI_Test(&pending_.front().request_, &flag, MPI_STATUS_IGNORE));
+		if (!flag)
+			return;
+		pending_bytes_ -= pending_.front().bytes_;
+		delete[] pending_.front().buffer_;
+		pending_.pop_front();
+	}
+}
+
+void AsyncSends::wait_first() {
+	SIPMPIUtils::check_err(
+			MPI_Wait(&pending_.front().request_, MPI_STATUS_IGNORE));
+	pending_bytes_ -= pending_.front().bytes_;
+	delete[] pending_.front().buffer_;
+	pending_.pop_front();
+}
+
+void AsyncSends::wait_all() {
+	while (!pending_.empty()) {
+		wait_first();
+	}
+}
+
 } /* namespace sip */
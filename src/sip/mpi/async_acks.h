@@ -9,6 +9,8 @@
 #define ASYNC_ACKS_H_
 
 #include <mpi.h>
+#include <cstddef>
+#include <list>
 #include "aces_defs.h"
 #include "sip.h"
 
@@ -38,7 +40,7 @@ public:
    //TODO  I think that MPI allows a max number of outstanding messages to be 64,
    //which includes the posted async requests, and synchronous receives.
    //There should be a way to change the value in MPI.
-	static const size_t MAX_POSTED_ASYNC = 32;
+	static const size_t MAX_POSTED_ASYNC = 256;
 
 	/** called by sial_ops implementations that expect an ack from a server
 	 *
@@ -111,6 +113,54 @@ private:
 	DISALLOW_COPY_AND_ASSIGN(AsyncAcks);
 };
 
+/**
+ * Owns the buffers of messages sent by a worker with MPI_Isend, such as eager puts,
+ * until the sends are complete.
+ *
+ * Sends usually complete in the order they are posted, so add only tests the oldest
+ * sends.  If the buffers held exceed MAX_PENDING_BYTES, add waits for the oldest sends.
+ * sip_barrier calls wait_all.
+ */
+class AsyncSends {
+public:
+	AsyncSends();
+	~AsyncSends();
+
+	static const std::size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+	/**
+	 * Takes ownership of buffer, which must have been allocated with new[],
+	 * and deletes it when request is complete.
+	 *
+	 * @param request  for the MPI_Isend of buffer
+	 * @param buffer
+	 * @param bytes    size of buffer
+	 */
+	void add(MPI_Request request, char* buffer, std::size_t bytes);
+
+	/** Deletes the buffers of the oldest sends, up to the first one that is not complete */
+	void cleanup();
+
+	/** Waits for all sends and deletes their buffers */
+	void wait_all();
+
+	std::size_t pending_bytes() const { return pending_bytes_; }
+
+private:
+	struct Send {
+		MPI_Request request_;
+		char* buffer_;
+		std::size_t bytes_;
+	};
+	std::list<Send> pending_;
+	std::size_t pending_bytes_;
+
+	/** Waits for the oldest send and deletes its buffer */
+	void wait_first();
+
+	DISALLOW_COPY_AND_ASSIGN(AsyncSends);
+};
+
 } /* namespace sip */
 
 #endif /* ASYNC_ACKS_H_ */
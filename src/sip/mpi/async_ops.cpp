@@ -28,12 +28,87 @@ GetAsync::GetAsync(int mpi_source, int get_tag, ServerBlock* block, int pc) :
 
 
 
+/**  AccumulateAsync *******************/
+
+AccumulateAsync::AccumulateAsync(int mpi_source, int tag, ServerBlock* block, int pc) :
+		AsyncBase(pc), block_(block), mpi_source_(mpi_source), tag_(tag), accumulated_(0),
+		acked_(false) {
+}
+
+void AccumulateAsync::start_accumulate(double* data) {
+#ifdef _OPENMP
+	if (SIPServer::num_helper_threads() > 0) {
+		acked_ = SIPServer::helpers_call_mpi();
+		AccumulateAsync* op = this;
+#pragma omp task firstprivate(op, data)
+		{
+			op->accumulate_and_ack(data);
+#pragma omp flush
+			op->accumulated_ = 1;
+#pragma omp flush
+		}
+		return;
+	}
+#endif //_OPENMP
+	accumulate_and_ack(data);
+	accumulated_ = 1;
+}
+
+void AccumulateAsync::accumulate_and_ack(double* data) {
+	block_->accumulate_data(block_->size(), data);
+	if (acked_) {
+		//send ack to worker, the data has been accumulated into the block
+		SIPMPIUtils::check_err(
+				MPI_Send(0, 0, MPI_INT, mpi_source_, tag_, MPI_COMM_WORLD),
+				__LINE__, __FILE__);
+	}
+}
+
+bool AccumulateAsync::accumulated() {
+#ifdef _OPENMP
+#pragma omp flush
+#endif //_OPENMP
+	return accumulated_ != 0;
+}
+
+void AccumulateAsync::wait_accumulated() {
+	while (!accumulated()) {
+		//lets this thread run the task if no helper thread has started it
+#ifdef _OPENMP
+#pragma omp taskyield
+#endif //_OPENMP
+	}
+}
+
+void AccumulateAsync::do_handle() {
+	if (acked_) return;
+	//send ack to worker, the data has been accumulated into the block
+	SIPMPIUtils::check_err(
+			MPI_Send(0, 0, MPI_INT, mpi_source_, tag_, MPI_COMM_WORLD),
+			__LINE__, __FILE__);
+}
+
+std::string AccumulateAsync::to_string() const {
+	std::stringstream ss;
+	ss << AsyncBase::to_string();
+	ss << " source=" << mpi_source_ << " tag=" << tag_;
+	int transaction;
+	SIPMPIConstants::MessageType_t message_type;
+	BarrierSupport::decode_tag(tag_, message_type, transaction);
+	ss << " message type="
+			<< SIPMPIConstants::messageTypeToName(
+					SIPMPIConstants::intToMessageType(message_type))
+			<< " transaction=" << transaction << std::endl;
+	return ss.str();
+}
+
+
 /**  PutAccumulateAsync *******************/
 
 PutAccumulateDataAsync::PutAccumulateDataAsync(int mpi_source,
 		int put_accumulate_data_tag, ServerBlock* block, int pc) :
-		AsyncBase(pc), mpi_source_(mpi_source), tag_(put_accumulate_data_tag),  block_(
-				block), mpi_request_(MPI_REQUEST_NULL) {
+		AccumulateAsync(mpi_source, put_accumulate_data_tag, block, pc),
+		mpi_request_(MPI_REQUEST_NULL), received_(false) {
 	//allocate temp buffer
 
 //	temp_ = new double[block->size()];
@@ -56,48 +131,59 @@ PutAccumulateDataAsync::~PutAccumulateDataAsync() {
 }
 
 bool PutAccumulateDataAsync::do_test() {
-	int flag = 0;
-	MPI_Status status;
-	MPI_Test(&mpi_request_, &flag, &status);
-	if (flag) {
+	if (!received_) {
+		int flag = 0;
+		MPI_Status status;
+		MPI_Test(&mpi_request_, &flag, &status);
+		if (!flag) return false;
 		//check that received message was expected size
 		int count;
 		MPI_Get_count(&status, MPI_DOUBLE, &count);
 		CHECK(count == block_->size(), "count != block_->size()");
+		received_ = true;
+		start_accumulate(temp_);
 	}
-	return flag;
-}
-
-void PutAccumulateDataAsync::do_handle() {
-	//send ack to worker
-	SIPMPIUtils::check_err(
-			MPI_Send(0, 0, MPI_INT, mpi_source_, tag_, MPI_COMM_WORLD),
-			__LINE__, __FILE__);
-	//accumulate received data into block
-	block_->accumulate_data(block_->size(), temp_);
+	return accumulated();
 }
 
 void PutAccumulateDataAsync::do_wait() {
-	MPI_Status status;
-	MPI_Wait(&mpi_request_, &status);
-	//check that received message was expected size
-	int count;
-	MPI_Get_count(&status, MPI_DOUBLE, &count);
-	CHECK(count == block_->size(), "count != block_->size()");
+	if (!received_) {
+		MPI_Status status;
+		MPI_Wait(&mpi_request_, &status);
+		//check that received message was expected size
+		int count;
+		MPI_Get_count(&status, MPI_DOUBLE, &count);
+		CHECK(count == block_->size(), "count != block_->size()");
+		received_ = true;
+		start_accumulate(temp_);
+	}
+	wait_accumulated();
 }
 
 std::string PutAccumulateDataAsync::to_string() const {
 	std::stringstream ss;
 	ss << "PutAccumulateDataAsync";
-	ss << AsyncBase::to_string();
-	ss << " source=" << mpi_source_ << " tag=" << tag_;
-	int transaction;
-	SIPMPIConstants::MessageType_t message_type;
-	BarrierSupport::decode_tag(tag_, message_type, transaction);
-	ss << " message type="
-			<< SIPMPIConstants::messageTypeToName(
-					SIPMPIConstants::intToMessageType(message_type))
-			<< " transaction=" << transaction << std::endl;
+	ss << AccumulateAsync::to_string();
+	return ss.str();
+}
+
+
+/**  PutAccumulateEagerAsync *******************/
+
+PutAccumulateEagerAsync::PutAccumulateEagerAsync(int mpi_source,
+		int put_accumulate_tag, ServerBlock* block, char* buffer, double* data, int pc) :
+		AccumulateAsync(mpi_source, put_accumulate_tag, block, pc), buffer_(buffer) {
+	start_accumulate(data);
+}
+
+PutAccumulateEagerAsync::~PutAccumulateEagerAsync() {
+	delete [] buffer_;
+}
+
+std::string PutAccumulateEagerAsync::to_string() const {
+	std::stringstream ss;
+	ss << "PutAccumulateEagerAsync";
+	ss << AccumulateAsync::to_string();
 	return ss.str();
 }
 
@@ -179,6 +265,14 @@ pending_.push_back(
 num_pending_writes_++;
 }
 
+void ServerBlockAsyncManager::add_put_accumulate_eager(int mpi_source,
+	int put_accumulate_tag, ServerBlock* block, char* buffer, double* data, int pc) {
+//create async op (which starts the accumulate)
+pending_.push_back(
+		new PutAccumulateEagerAsync(mpi_source, put_accumulate_tag, block, buffer, data, pc));
+num_pending_writes_++;
+}
+
 void ServerBlockAsyncManager::add_put_accumulate_data_request(int mpi_source,
 	int put_accumulate_data_tag, ServerBlock* block, int pc) {
 //create async op (which posts irecv)
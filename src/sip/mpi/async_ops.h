@@ -195,6 +195,43 @@ private:
 	DISALLOW_COPY_AND_ASSIGN (GetAsync);
 };
 
+/** Base class of the put_accumulate operations at server, which accumulate data into
+ * the block and then ack the message.
+ *
+ * start_accumulate adds the data into the block.  If the server has helper threads, it is
+ * done in an OpenMP task, and the operation is enabled when the task has finished.  Otherwise
+ * it is done immediately.  If MPI provides MPI_THREAD_MULTIPLE, the task also sends the ack,
+ * so that the worker does not wait for the communication thread to handle the op.  Otherwise
+ * the task makes no MPI calls and do_handle sends the ack.
+ */
+class AccumulateAsync: public AsyncBase {
+public:
+	AccumulateAsync(int mpi_source, int tag, ServerBlock* block, int pc);
+	virtual ~AccumulateAsync() {
+	}
+protected:
+	ServerBlock* block_;
+	int mpi_source_;
+	int tag_;
+
+	void start_accumulate(double* data);
+	bool accumulated();
+	/** Waits for the accumulate started by start_accumulate */
+	void wait_accumulated();
+	std::string to_string() const;
+
+private:
+	volatile int accumulated_; //set by the helper thread, read after a flush
+	bool acked_;  //the ack is sent by the task
+
+	void accumulate_and_ack(double* data);
+	void do_handle();
+	bool do_is_write() {
+		return true;
+	}
+	DISALLOW_COPY_AND_ASSIGN (AccumulateAsync);
+};
+
 /** Represents asynchronous put_accumulate operation at server
  *
  * Instance will be created in response to put_accumulate message to handle
@@ -206,41 +243,69 @@ private:
  *             allocates temporary buffer,
  *             posts Irecv for block data.
  *
- * do_handle: sends ack for data message to source
- *           performs the accumulate operation of temp data into block
+ * do_test, do_wait: once the data has been received, start the accumulate operation of
+ *           temp data into block (see AccumulateAsync).
+ *
+ * do_handle: sends ack for data message to source, unless the accumulate task has sent it
  *
  * Destructor: deletes the temp data buffer.
  *
- *The constructor does not send the "reply" message to the source to let it know that
- *the data message can be sent.  This should be done AFTER this object is constructed
- *in order to ensure that the Irecv has been posted, and thus ensuring that the
- *large message can bypass the MPI buffers
+ *The worker sends the data message right after the put_accumulate message without waiting
+ *for a reply.  Since MPI does not let messages from the same source with the same communicator
+ *overtake each other, the put_accumulate message is always handled, and this object constructed,
+ *before the data can be received.  For large blocks, the MPI rendezvous protocol delays the
+ *transfer until the Irecv is posted.
  *
  *TODO:  reuse the temp buffers?
  *
  */
-class PutAccumulateDataAsync: public AsyncBase {
+class PutAccumulateDataAsync: public AccumulateAsync {
 public:
 	PutAccumulateDataAsync(int mpi_source, int put_accumulate_data_tag,
 			ServerBlock* block, int pc);
 	virtual ~PutAccumulateDataAsync();
 private:
-	ServerBlock* block_;
-	int mpi_source_;
-	int tag_;
 	MPI_Request mpi_request_;
 	double* temp_; //buffer to receive data.  created in constructor, deleted in destructor
+	bool received_;
 
 	bool do_test();
 	void do_wait();
-	void do_handle();
-	bool do_is_write() {
-		return true;
-	}
 	virtual std::string to_string() const;
 	DISALLOW_COPY_AND_ASSIGN (PutAccumulateDataAsync);
 };
 
+/** Represents the accumulate of the data of a PUT_ACCUMULATE_EAGER message, whose data
+ * arrives with the block id, including the combined contributions sent by a worker's
+ * PutAccumulateCombiner.
+ *
+ * Instances of this class own the received message buffer.
+ *
+ * Constructor: starts the accumulate (see AccumulateAsync).  The block should have been
+ *             obtained by get_block_for_accumulate, so there are no earlier pending ops.
+ *
+ * do_handle: sends ack to source, unless the accumulate task has sent it
+ *
+ * Destructor: deletes the message buffer.
+ */
+class PutAccumulateEagerAsync: public AccumulateAsync {
+public:
+	PutAccumulateEagerAsync(int mpi_source, int put_accumulate_tag,
+			ServerBlock* block, char* buffer, double* data, int pc);
+	virtual ~PutAccumulateEagerAsync();
+private:
+	char* buffer_;
+
+	bool do_test() {
+		return accumulated();
+	}
+	void do_wait() {
+		wait_accumulated();
+	}
+	virtual std::string to_string() const;
+	DISALLOW_COPY_AND_ASSIGN (PutAccumulateEagerAsync);
+};
+
 /** Represents asynchronous put data operation at server.
  *
  * Will be created in response to put message.
@@ -250,16 +315,13 @@ private:
  * to get_block_for_writing,  This method should call the block's
  * CommunicationState.wait method which waits for all pending ops to complete.
  *
- * Constructor: sends reply to source,
- *             posts Irecv for block data
+ * Constructor: posts Irecv for block data
  *             The receive buffer is the block's data array, which should exist already
  *
  * do_handle: sends ack for data message to source
  *
- *The constructor does not send the "reply" message to the source to let it know that
- *the data message can be sent.  This should be done AFTER this object is constructed
- *order to ensure that the Irecv has been posted (and thus ensuring that the message
- *bypasses MPI buffers
+ *As with PutAccumulateDataAsync, the worker does not wait for a reply before sending
+ *the data message.
  *
  */
 class PutDataAsync: public AsyncBase {
@@ -321,6 +383,10 @@ public:
 	void add_put_data_request(int mpi_source, int put_data_tag,
 			ServerBlock* block, int pc);
 
+	//takes ownership of buffer, which holds data.  increments num_pending_writes_
+	void add_put_accumulate_eager(int mpi_source, int put_accumulate_tag,
+			ServerBlock* block, char* buffer, double* data, int pc);
+
 	void add_get_reply(int mpi_source, int get_tag, ServerBlock *, int pc);
 
 	/**
@@ -253,6 +253,37 @@ public:
 		return put_accumulate_tag;
 	}
 
+	/**
+	 * Called by the worker to construct the mpi tag for a PUT_EAGER transaction, which
+	 * sends the block id and the data in one message.
+	 *
+	 * The worker's transaction number is updated.
+	 * @return tag
+	 */
+	int make_mpi_tag_for_PUT_EAGER(){
+		int tag = make_mpi_tag(SIPMPIConstants::PUT_EAGER, transaction_number_);
+		transaction_number_ = (transaction_number_ + 1) % (1 << NUM_TRANSACTION_NUMBER_BITS);
+		return tag;
+	}
+
+	/**
+	 * Called by the worker to construct the mpi tag for a PUT_ACCUMULATE_EAGER transaction.
+	 *
+	 * The worker's transaction number is updated.
+	 * @return tag
+	 */
+	int make_mpi_tag_for_PUT_ACCUMULATE_EAGER(){
+		int tag = make_mpi_tag(SIPMPIConstants::PUT_ACCUMULATE_EAGER, transaction_number_);
+		transaction_number_ = (transaction_number_ + 1) % (1 << NUM_TRANSACTION_NUMBER_BITS);
+		return tag;
+	}
+
+	int make_mpi_tag_for_GET_BATCH(){
+		int tag = make_mpi_tag(SIPMPIConstants::GET_BATCH, transaction_number_);
+		transaction_number_ = (transaction_number_ + 1) % (1 << NUM_TRANSACTION_NUMBER_BITS);
+		return tag;
+	}
+
 	/**
 	 * Called by worker to construct mpi tag for a DELETE transaction.
 	 *
@@ -7,6 +7,7 @@
 
 #include "chunk_manager.h"
 #include "server_block.h"
+#include "block_allocator.h"
 
 namespace sip {
 
@@ -21,7 +22,7 @@ ChunkManager::~ChunkManager() {
 	}
 }
 size_t ChunkManager::new_chunk() {
-	double* chunk_data = new double[chunk_size_];
+	double* chunk_data = BlockAllocator::allocate(chunk_size_);
     int chunk_number = chunks_.size();
 	offset_val_t offset = chunk_offset(chunk_number);
 	//if c++11, change to emplace version
@@ -39,7 +40,7 @@ void ChunkManager::new_chunk_for_restore(offset_val_t offset){
 
 size_t ChunkManager::reallocate_chunk_data(Chunk* chunk) {
 	CHECK(chunk->data_ == NULL, "reallocating chunk data that exists");
-	chunk->data_ = new double[chunk_size_];
+	chunk->data_ = BlockAllocator::allocate(chunk_size_);
 	return chunk_size_;
 }
 
@@ -117,7 +118,7 @@ size_t ChunkManager::assign_block_data_from_chunk(size_t num_doubles, bool initi
 
 size_t ChunkManager::delete_chunk_data(Chunk* chunk){
 	if(chunk->data_ != NULL){
-		delete chunk->data_;
+		BlockAllocator::deallocate(chunk->data_);
 		chunk->data_ = NULL;
 		return chunk_size_;
 	}
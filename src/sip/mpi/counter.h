@@ -117,6 +117,10 @@ public:
         friend class Counter<MPICounter>;
         friend std::ostream& operator<<(std::ostream& os,
                         const Counter<MPICounter>& obj);
+        /** Sum over the communicator.  Only valid at rank 0 after reduce */
+        size_t get_reduced_value() const {
+                return reduced_val_;
+        }
 protected:
         const MPI_Comm& comm_;
         std::vector<size_t> gathered_vals_;
@@ -360,6 +364,26 @@ protected:
 
                 return os;
         }
+public:
+        /** Prints the mean over the company of each nonzero entry, labeled with the
+         * line number and opcode of the entry's pc.  The list must be indexed by pc. */
+        void print_op_table_stats(std::ostream& os,
+                        const SipTables& sip_tables) const {
+                CHECK(reduce_done_, "must call reduce before print_op_table_stats");
+                int comm_size;
+                MPI_Comm_size(comm_, &comm_size);
+                double dcomm_size = static_cast<double>(comm_size);
+                os << "pc, line number, opcode, mean" << std::endl;
+                std::vector<size_t>::const_iterator it = reduced_vals_.begin();
+                for (int i = 0; i < size_; ++i, ++it) {
+                        if (*it != 0) {
+                                os << i << ',' << sip_tables.line_number(i) << ','
+                                                << sip_tables.opcode_name(i) << ','
+                                                << static_cast<double>(*it) / dcomm_size
+                                                << std::endl;
+                        }
+                }
+        }
 private:
         DISALLOW_COPY_AND_ASSIGN(MPICounterList);
 };
@@ -7,11 +7,136 @@
 
 #include <data_distribution.h>
 #include <sstream>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include "sip_mpi_utils.h"
 
 namespace sip {
 
+DataDistribution::Mode DataDistribution::mode_ = DataDistribution::cyclic_mode;
+std::vector<double> DataDistribution::server_weights_;
+
 DataDistribution::DataDistribution(const SipTables& sip_tables, SIPMPIAttr& sip_mpi_attr):
-		sip_tables_(sip_tables), sip_mpi_attr_(sip_mpi_attr) {
+		sip_tables_(sip_tables), sip_mpi_attr_(sip_mpi_attr),
+		placed_(sip_tables.num_arrays(), false),
+		placements_(sip_tables.num_arrays(), static_cast<Placement*>(NULL)) {
+	if (mode_ == cyclic_mode || sip_mpi_attr_.num_servers() == 0) return;
+	CHECK(sip_mpi_attr_.num_servers() <= 65536, "too many servers for balanced distribution");
+	for (int i = 0; i < sip_tables_.num_arrays(); ++i) {
+		placed_[i] = sip_tables_.is_distributed(i) && !sip_tables_.is_persistent(i);
+	}
+}
+
+DataDistribution::~DataDistribution() {
+	for (std::vector<Placement*>::iterator it = placements_.begin(); it != placements_.end(); ++it) {
+		delete *it;
+	}
+}
+
+void DataDistribution::set_mode(Mode mode) {
+	mode_ = mode;
+}
+
+DataDistribution::Mode DataDistribution::mode() {
+	return mode_;
+}
+
+bool DataDistribution::parse_mode(const std::string& name, Mode& mode) {
+	if (name == "cyclic") mode = cyclic_mode;
+	else if (name == "balanced") mode = balanced_mode;
+	else if (name == "profiled") mode = profiled_mode;
+	else return false;
+	return true;
+}
+
+const char* DataDistribution::mode_name(Mode mode) {
+	switch (mode) {
+	case cyclic_mode: return "cyclic";
+	case balanced_mode: return "balanced";
+	case profiled_mode: return "profiled";
+	}
+	return "unknown";
+}
+
+void DataDistribution::update_profile(long gets) {
+	if (mode_ != profiled_mode) return;
+	//limits of the weights, so a single program does not skew the distribution too much
+	const double min_weight = 0.5;
+	const double max_weight = 2.0;
+
+	SIPMPIAttr& sip_mpi_attr = SIPMPIAttr::get_instance();
+	std::vector<long> all_gets(sip_mpi_attr.global_size());
+	SIPMPIUtils::check_err(
+			MPI_Allgather(&gets, 1, MPI_LONG, &all_gets.front(), 1, MPI_LONG, MPI_COMM_WORLD));
+	const std::vector<int>& server_ranks = sip_mpi_attr.server_ranks();
+	long total = 0;
+	for (std::size_t i = 0; i < server_ranks.size(); ++i) {
+		total += all_gets[server_ranks[i]];
+	}
+	server_weights_.clear();
+	if (total == 0) return;
+	double average = static_cast<double>(total) / server_ranks.size();
+	for (std::size_t i = 0; i < server_ranks.size(); ++i) {
+		long server_gets = all_gets[server_ranks[i]];
+		double weight = server_gets == 0 ? max_weight : average / server_gets;
+		server_weights_.push_back(std::max(min_weight, std::min(max_weight, weight)));
+	}
+}
+
+bool DataDistribution::is_placed(int array_id) const {
+	return placed_[array_id];
+}
+
+const DataDistribution::Placement& DataDistribution::placement(int array_id) const {
+	Placement*& placement = placements_[array_id];
+	if (placement == NULL) {
+		placement = new Placement();
+		compute_placement(array_id, *placement);
+	}
+	return *placement;
+}
+
+const std::vector<double>& DataDistribution::server_weights() {
+	return server_weights_;
+}
+
+void DataDistribution::compute_placement(int array_id, Placement& placement) const {
+	size_t num_blocks = sip_tables_.num_blocks(array_id);
+	std::vector<double> block_bytes(num_blocks);
+	for (size_t n = 0; n < num_blocks; ++n) {
+		block_bytes[n] = sip_tables_.block_size(sip_tables_.block_id(array_id, n)) * sizeof(double);
+	}
+	place_blocks(block_bytes, sip_mpi_attr_.num_servers(), array_id,
+			mode_ == profiled_mode ? server_weights_ : std::vector<double>(), placement);
+}
+
+void DataDistribution::place_blocks(const std::vector<double>& block_bytes, int num_servers,
+		int rotation, const std::vector<double>& weights, Placement& placement) {
+	size_t num_blocks = block_bytes.size();
+	bool weighted = weights.size() == static_cast<std::size_t>(num_servers);
+	placement.server_slot_.resize(num_blocks);
+	placement.position_.resize(num_blocks);
+	std::vector<unsigned int> counts(num_servers, 0);
+
+	//least loaded server first, ties broken by slot rotated by rotation
+	typedef std::pair<double, int> Load;
+	std::priority_queue<Load, std::vector<Load>, std::greater<Load> > loads;
+	for (int i = 0; i < num_servers; ++i) {
+		loads.push(Load(0.0, i));
+	}
+	for (size_t n = 0; n < num_blocks; ++n) {
+		Load least = loads.top();
+		loads.pop();
+		int slot = (least.second + rotation) % num_servers;
+		placement.server_slot_[n] = slot;
+		placement.position_[n] = counts[slot]++;
+		double bytes = block_bytes[n];
+		least.first += weighted ? bytes / weights[slot] : bytes;
+		loads.push(least);
+	}
+	placement.max_blocks_at_server_ = num_blocks == 0 ? 0 : *std::max_element(counts.begin(), counts.end());
 }
 
 int DataDistribution::block_cyclic_distribution_server_rank(
@@ -50,7 +175,10 @@ int DataDistribution::hashed_indices_based_server_rank(
 }
 
 int DataDistribution::get_server_rank(const sip::BlockId& bid) const{
-// TODO
+	if (is_placed(bid.array_id())) {
+		const Placement& p = placement(bid.array_id());
+		return sip_mpi_attr_.server_ranks().at(p.server_slot_[sip_tables_.block_number(bid)]);
+	}
 	int server_global_rank = block_cyclic_distribution_server_rank(bid);
 	//int server_global_rank = hashed_indices_based_server_rank(bid);
 
@@ -65,6 +193,19 @@ bool DataDistribution::is_my_block(size_t block_number) const{
 }
 
 
+size_t DataDistribution::position_at_server(int array_id, size_t block_number) const {
+	if (is_placed(array_id)) return placement(array_id).position_[block_number];
+	//consistent with the cyclic distribution in server_rank_from_hash
+	return block_number / sip_mpi_attr_.num_servers();
+}
+
+size_t DataDistribution::max_blocks_at_server(int array_id) const {
+	if (is_placed(array_id)) return placement(array_id).max_blocks_at_server_;
+	size_t num_servers = sip_mpi_attr_.num_servers();
+	return (sip_tables_.num_blocks(array_id) + num_servers - 1) / num_servers;
+}
+
+
 int DataDistribution::server_rank_from_hash(std::size_t hash) const {
 	// Cyclic distribution
 	int num_servers = sip_mpi_attr_.num_servers();
@@ -9,6 +9,8 @@
 #define DATA_DISTRIBUTION_H_
 
 #include <list>
+#include <vector>
+#include <string>
 
 #include "block_id.h"
 #include "sip_tables.h"
@@ -20,12 +22,49 @@ namespace sip {
 /**
  * Decides distribution of block (statically)
  *
+ * In cyclic_mode, block number n of every array is at server n % num_servers.
+ *
+ * In balanced_mode, the blocks of each distributed array are assigned in order of block
+ * number to the server with the fewest bytes of the array so far, so servers hold about
+ * the same number of bytes even if block sizes vary.  The first server tried is rotated by
+ * array id.  profiled_mode is the same, except that the bytes of a server are scaled by
+ * its number of GETs in the previous program relative to the average (see update_profile),
+ * so servers that were busy get less data.
+ *
+ * In all modes, served arrays and arrays that are made persistent or restored in the
+ * program use the cyclic distribution, since their blocks must be found at the same
+ * servers in other programs and when restarting.
+ *
+ * The placement of an array is computed from the SipTables when it is first needed, and
+ * is the same at every process.
+ *
  * TODO server ranks should always be relative to server communicator.
  * need to change sial_ops_parallel to use an intercommunicator.
  */
 class DataDistribution {
 public:
+	enum Mode {
+		cyclic_mode,
+		balanced_mode,
+		profiled_mode
+	};
+
 	DataDistribution(const SipTables&, SIPMPIAttr&);
+	~DataDistribution();
+
+	/** Sets the mode of distributions created later.  Must be the same at all processes. */
+	static void set_mode(Mode mode);
+	static Mode mode();
+	static bool parse_mode(const std::string& name, Mode& mode);
+	static const char* mode_name(Mode mode);
+
+	/**
+	 * Collective over MPI_COMM_WORLD, called by all processes after each program.
+	 * gets is the number of GETs handled by this process in the program, 0 at workers.
+	 * Noop unless the mode is profiled_mode.
+	 * @param gets
+	 */
+	static void update_profile(long gets);
 
 	/**
 	 * Calculates and returns MPI rank of server that "owns" a given block.
@@ -33,12 +72,26 @@ public:
 	 * @return
 	 */
 	int get_server_rank(const sip::BlockId& block_id) const;
+	/** true if the server of the block is on this node, so its memory may be shared */
+	bool is_node_local(const sip::BlockId& block_id) const {
+		return sip_mpi_attr_.is_on_my_node(get_server_rank(block_id));
+	}
 	int block_cyclic_distribution_server_rank(const sip::BlockId& block_id) const;
 	int hashed_indices_based_server_rank(const sip::BlockId& block_id) const;
 
-	//precondition--called by server
+	//precondition--called by server.  Only for arrays with the cyclic distribution,
+	//which includes all arrays restored from files
 	bool is_my_block(size_t block_number) const;
 
+	/**
+	 * Position of a block among the blocks of its array at its server.  The blocks of an
+	 * array at a server have positions 0, 1, ... max_blocks_at_server(array_id) - 1.
+	 * @param block_number
+	 * @return
+	 */
+	size_t position_at_server(int array_id, size_t block_number) const;
+	size_t max_blocks_at_server(int array_id) const;
+
 
 //	/** Generates a list of all blocks for a given array
 //	 * @param [in] global_server_rank
@@ -51,15 +104,50 @@ public:
 //											const SipTables& sip_tables) const;
 
 //	long block_position_in_array(const sip::BlockId& bid) const;
+	/** true if the array uses balanced or profiled placement */
+	bool is_placed(int array_id) const;
+
+	/** Server slot and position at the server of each block of an array */
+	struct Placement {
+		std::vector<unsigned short> server_slot_;
+		std::vector<unsigned int> position_;
+		size_t max_blocks_at_server_;
+	};
+
+	/**
+	 * Places blocks with the given sizes in bytes at num_servers server slots, each at the
+	 * slot with the fewest bytes so far, ties broken by slot rotated by rotation.  If there
+	 * is a weight for each slot, the bytes of a slot are divided by its weight.
+	 */
+	static void place_blocks(const std::vector<double>& block_bytes, int num_servers,
+			int rotation, const std::vector<double>& weights, Placement& placement);
+
+	/** Weights of the server slots used by profiled_mode, empty if there is no profile */
+	static const std::vector<double>& server_weights();
+
 private:
 
+	static Mode mode_;
+	/** weight of each server slot for profiled_mode, empty for equal weights */
+	static std::vector<double> server_weights_;
+
 	const SipTables& sip_tables_;
 	SIPMPIAttr& sip_mpi_attr_;
 
+	std::vector<bool> placed_; //is_placed for each array
+
+	/** Indexed by array id, computed lazily.  Only accessed by the main thread. */
+	mutable std::vector<Placement*> placements_;
+
+	const Placement& placement(int array_id) const;
+	void compute_placement(int array_id, Placement& placement) const;
+
 
 //	void validate_block_position(const sip::BlockId& bid, long block_num) const;
 	int server_rank_from_hash(std::size_t hash) const;
 
+	DISALLOW_COPY_AND_ASSIGN(DataDistribution);
+
 
 //	bool increment_indices(int rank, index_value_array_t& upper,
 //			index_value_array_t& lower, index_value_array_t& current) const;
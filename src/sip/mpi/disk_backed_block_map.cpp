@@ -9,49 +9,24 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <set>
+#include <utility>
+#include <vector>
 #include "server_block.h"
 #include "block_id.h"
 #include "job_control.h"
 #include "sip_server.h"
+#include "block_allocator.h"
 
 namespace sip {
 
 /** Template specialization for ServerBlock.
  *
- * Regular LRU Array policy is to evict the
- * "first" block from the least recently used array.
- * For ServerBlocks however, since they are not
- * removed from the BlockMap, but are "emptied out",
- * the regular array policy won't work.
- *
- * This methods first chooses an array whose block
- * is to be evicted. It then finds one, skipping
- * over those blocks which have been "emptied" out.
- *
- * The pointer the the block is returned to avoid another search through the data structure
+ * ServerBlocks stay in the BlockMap when their chunk is written out,
+ * so blocks that have been "emptied out" are skipped.
  */
-template<> BlockId LRUArrayPolicy<ServerBlock>::get_next_block_for_removal(ServerBlock*& blockpp) {
-	/** Return an arbitrary block from the least recently used array
-	 */
-	if (lru_list_.empty())
-		throw std::out_of_range(
-				"No blocks have been touched, yet block requested for flushing");
-	while (!lru_list_.empty()) {
-		int to_remove_array = lru_list_.back();
-		IdBlockMap<ServerBlock>::PerArrayMap* array_map =
-				block_map_.per_array_map(to_remove_array);
-		IdBlockMap<ServerBlock>::PerArrayMap::iterator it = array_map->begin();
-		for (; it != array_map->end(); it++) {
-			ServerBlock *blk = it->second;
-			if (blk != NULL && blk->get_data() != NULL) {
-				blockpp = blk;
-				return it->first;
-			}
-		}
-		lru_list_.pop_back();
-	}
-	throw std::out_of_range(
-			"No server blocks to remove - all empty or none present !");
+template<> bool LRUBlockPolicy<ServerBlock>::evictable(ServerBlock* block) {
+	return block != NULL && block->get_data() != NULL;
 }
 
 const int DiskBackedBlockMap::BLOCKS_PER_CHUNK=4;
@@ -164,8 +139,9 @@ ServerBlock* DiskBackedBlockMap::get_block_for_accumulate(
 
 
 	} else {
-		//note that we do not wait for pending ops to complete when block is to be used in accumulate
-		//if here, the block exists.  If not in memory, read data from disk
+		//if here, the block exists.  Wait for pending ops on it, such as a get being sent or
+		//an accumulate on a helper thread, before the accumulate.  If not in memory, read
+		//data from disk
 		bool in_memory = (block->block_data_.get_data() != NULL);
 		if (in_memory){
 			block->wait();
@@ -197,11 +173,9 @@ double* DiskBackedBlockMap::allocate_data(size_t size, bool initialize){
 		freed = backup_and_free_doubles(to_free); //returns 0 if to_free <= 0
 
 		try {
+			data = BlockAllocator::allocate(size);
 			if (initialize){
-			data = new double[size]();
-			}
-			else {
-				data = new double[size];
+				std::fill(data, data + size, 0.0);
 			}
 			remaining_doubles_ -= size;
 
@@ -217,6 +191,7 @@ double* DiskBackedBlockMap::allocate_data(size_t size, bool initialize){
 			if (freed < to_free){
 				fail(" Could not free requested amount of memory and allocate failed");
 			}
+			BlockAllocator::release_pooled_memory();
 			to_free = size; //in case it was zero
 		}
 	}
@@ -225,7 +200,7 @@ double* DiskBackedBlockMap::allocate_data(size_t size, bool initialize){
 
 
 void DiskBackedBlockMap::free_data(double*& data, size_t size){
-	delete[] data;
+	BlockAllocator::deallocate(data);
 	data = NULL;
 	remaining_doubles_ += size;
 
@@ -443,6 +418,10 @@ size_t DiskBackedBlockMap::read_chunk_from_disk(ServerBlock* block,
 size_t DiskBackedBlockMap::backup_and_free_doubles(size_t requested_doubles_to_free)
 {
 	size_t freed_count = 0;
+	//chunks whose data is freed once they have been written.  With MPI_THREAD_MULTIPLE, the
+	//chunks are written by the server's helper threads, in parallel.
+	std::vector<std::pair<int, Chunk*> > chunks_to_free;
+	std::set<Chunk*> selected;
 	try {
 		while (freed_count < requested_doubles_to_free) { //if requested_doubles_to_free <= 0, no iterations performed.
 	//get a block to remove.  Also, we need its containing chunk and array.
@@ -450,23 +429,42 @@ size_t DiskBackedBlockMap::backup_and_free_doubles(size_t requested_doubles_to_f
 			BlockId block_id = policy_.get_next_block_for_removal(block);
 			int array_id = block_id.array_id();
 			Chunk* chunk = block->get_chunk();
-			//if the chunk doesn't have any data, just try the next block.  Otherwise
-			//wait for pending operations.  If it is not valid on disk, write to disk.
+			//if the chunk doesn't have any data, or has already been selected, just try the next
+			//block.  Otherwise wait for pending operations.  If it is not valid on disk, write to disk.
 			//Then free the data.
-			if (chunk->get_data(0) != NULL){  //get the data for entire chunk--offset is 0
+			if (chunk->get_data(0) != NULL && selected.insert(chunk).second){  //get the data for entire chunk--offset is 0
 				chunk->wait_all();
 				if (!chunk->valid_on_disk_){
 					ArrayFile* file = array_files_.at(array_id);
+#ifdef _OPENMP
+					if (SIPServer::helpers_call_mpi()) {
+#pragma omp task firstprivate(file, chunk)
+						file->chunk_write(*chunk);
+					} else {
+						file->chunk_write(*chunk);
+					}
+#else
 					file->chunk_write(*chunk);
+#endif //_OPENMP
 					chunk->valid_on_disk_=true;
 					disk_backing_[array_id]=true;
 				}
-				freed_count += chunk_managers_.at(array_id)->delete_chunk_data(chunk);
+				chunks_to_free.push_back(std::make_pair(array_id, chunk));
+				freed_count += chunk_managers_.at(array_id)->chunk_size();
 			}
 		}
 	} catch (const std::out_of_range& oor) {
 		//ran out of blocks, just return the number of doubles freed.
 	}
+#ifdef _OPENMP
+	if (SIPServer::helpers_call_mpi()) {
+#pragma omp taskwait
+	}
+#endif //_OPENMP
+	for (std::vector<std::pair<int, Chunk*> >::iterator it = chunks_to_free.begin();
+			it != chunks_to_free.end(); ++it) {
+		chunk_managers_.at(it->first)->delete_chunk_data(it->second);
+	}
 	return freed_count;
 }
 
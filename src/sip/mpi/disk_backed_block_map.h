@@ -9,7 +9,7 @@
 #define DISK_BACKED_BLOCK_MAP_H_
 
 #include "id_block_map.h"
-#include "lru_array_policy.h"
+#include "lru_block_policy.h"
 #include "timer.h"
 #include "counter.h"
 #include "array_file.h"
@@ -352,6 +352,8 @@ private:
 	 * Frees the requested number of doubles by writing chunk data to disk and updating
 	 * the "valid_on_disk" flag for those chunks.
 	 *
+	 * If the server's helper threads may make MPI calls, they write the chunks in parallel.
+	 *
 	 * Returns the actual number of doubles freed.  The caller is responsible for using
 	 * the returned value for memory accounting.
 	 *
@@ -445,7 +447,7 @@ private:
 	// of block_map_ here.
 
 	IdBlockMap<ServerBlock> block_map_;
-	LRUArrayPolicy<ServerBlock> policy_;
+	LRUBlockPolicy<ServerBlock> policy_;
 	std::vector<ArrayFile*> array_files_;
 	std::vector<ChunkManager*> chunk_managers_;
 	std::vector<bool> disk_backing_; //indicates whether array has been involved in disk backing
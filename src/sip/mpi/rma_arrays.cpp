@@ -0,0 +1,180 @@
+/*
+ * rma_arrays.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "rma_arrays.h"
+#include <algorithm>
+#include "sip_mpi_utils.h"
+#include "memory_tracker.h"
+
+namespace sip {
+
+std::size_t RmaArrays::max_bytes_ = RmaArrays::DEFAULT_MAX_BYTES;
+
+void RmaArrays::set_max_bytes(std::size_t max_bytes) {
+	max_bytes_ = max_bytes;
+}
+
+std::size_t RmaArrays::max_bytes() {
+	return max_bytes_;
+}
+
+RmaArrays::RmaArrays(const SipTables& sip_tables,
+		const DataDistribution& data_distribution, SIPMPIAttr& sip_mpi_attr) :
+		sip_tables_(sip_tables), data_distribution_(data_distribution),
+		sip_mpi_attr_(sip_mpi_attr), offsets_(sip_tables.num_arrays(), -1),
+		num_rma_arrays_(0), window_doubles_(0), win_(MPI_WIN_NULL),
+		shared_win_(MPI_WIN_NULL), base_(NULL) {
+	if (max_bytes_ == 0 || sip_mpi_attr_.num_servers() == 0) return;
+
+	//every process computes the same layout from the tables
+	std::size_t max_doubles = max_bytes_ / sizeof(double);
+	for (int i = 0; i < sip_tables_.num_arrays(); ++i) {
+		if (!sip_tables_.is_distributed(i) || sip_tables_.is_persistent(i)) continue;
+		std::size_t doubles = slots_per_server(i) * sip_tables_.max_block_size(i);
+		if (window_doubles_ + doubles > max_doubles) continue;
+		offsets_[i] = window_doubles_;
+		window_doubles_ += doubles;
+		++num_rma_arrays_;
+	}
+}
+
+void RmaArrays::create_window() {
+	if (num_rma_arrays_ == 0 || win_ != MPI_WIN_NULL) return;
+
+	//servers expose zeroed memory shared with their node, workers expose none
+	MPI_Aint local_bytes = 0;
+	if (sip_mpi_attr_.is_server()) {
+		local_bytes = window_doubles_ * sizeof(double);
+	}
+	SIPMPIUtils::check_err(
+			MPI_Win_allocate_shared(local_bytes, sizeof(double), MPI_INFO_NULL,
+					sip_mpi_attr_.node_communicator(), &base_, &shared_win_));
+	if (sip_mpi_attr_.is_server()) {
+		std::fill(base_, base_ + window_doubles_, 0.0);
+		MemoryTracker::global->inc_allocated(window_doubles_);
+	}
+	SIPMPIUtils::check_err(
+			MPI_Win_create(base_, local_bytes, sizeof(double), MPI_INFO_NULL,
+					MPI_COMM_WORLD, &win_));
+	if (sip_mpi_attr_.is_worker()) {
+		SIPMPIUtils::check_err(MPI_Win_lock_all(MPI_MODE_NOCHECK, win_));
+		//the lock is only needed for MPI_Win_sync
+		SIPMPIUtils::check_err(MPI_Win_lock_all(MPI_MODE_NOCHECK, shared_win_));
+		node_bases_.resize(sip_mpi_attr_.global_size(), NULL);
+		const std::vector<int>& servers = sip_mpi_attr_.server_ranks();
+		for (std::size_t i = 0; i < servers.size(); ++i) {
+			if (!sip_mpi_attr_.is_on_my_node(servers[i])) continue;
+			MPI_Aint size;
+			int disp_unit;
+			SIPMPIUtils::check_err(
+					MPI_Win_shared_query(shared_win_, sip_mpi_attr_.node_rank(servers[i]),
+							&size, &disp_unit, &node_bases_[servers[i]]));
+		}
+	}
+}
+
+RmaArrays::~RmaArrays() {
+	//normally already freed at the end of the program
+	free_window();
+}
+
+void RmaArrays::free_window() {
+	if (win_ == MPI_WIN_NULL) return;
+	if (sip_mpi_attr_.is_worker()) {
+		SIPMPIUtils::check_err(MPI_Win_unlock_all(win_));
+		SIPMPIUtils::check_err(MPI_Win_unlock_all(shared_win_));
+		node_bases_.clear();
+	}
+	//the world window must be freed before its memory
+	SIPMPIUtils::check_err(MPI_Win_free(&win_));
+	SIPMPIUtils::check_err(MPI_Win_free(&shared_win_));
+	if (sip_mpi_attr_.is_server()) {
+		MemoryTracker::global->dec_allocated(window_doubles_);
+	}
+	base_ = NULL;
+}
+
+bool RmaArrays::get(const BlockId& id, double* data, std::size_t size,
+		MPI_Request* request) {
+	int server_rank = data_distribution_.get_server_rank(id);
+	if (data_distribution_.is_node_local(id)) {
+		const double* block = node_bases_[server_rank] + displacement(id);
+		std::copy(block, block + size, data);
+		*request = MPI_REQUEST_NULL;
+		return true;
+	}
+	SIPMPIUtils::check_err(
+			MPI_Rget(data, size, MPI_DOUBLE, server_rank, displacement(id), size,
+					MPI_DOUBLE, win_, request));
+	return false;
+}
+
+void RmaArrays::accumulate(const BlockId& id, const double* data, std::size_t size,
+		MPI_Op op, MPI_Request* request) {
+	int server_rank = data_distribution_.get_server_rank(id);
+	SIPMPIUtils::check_err(
+			MPI_Raccumulate(data, size, MPI_DOUBLE, server_rank, displacement(id), size,
+					MPI_DOUBLE, op, win_, request));
+}
+
+void RmaArrays::clear_array(int array_id, int server_rank) {
+	const std::size_t max_chunk = 1024 * 1024;
+	std::size_t doubles = slots_per_server(array_id) * sip_tables_.max_block_size(array_id);
+	std::vector<double> zeros(std::min(doubles, max_chunk), 0.0);
+	MPI_Aint offset = offsets_.at(array_id);
+	//this worker's earlier operations on the array must not overlap the puts
+	SIPMPIUtils::check_err(MPI_Win_flush(server_rank, win_));
+	while (doubles > 0) {
+		std::size_t count = std::min(doubles, max_chunk);
+		SIPMPIUtils::check_err(
+				MPI_Put(&zeros.front(), count, MPI_DOUBLE, server_rank, offset, count,
+						MPI_DOUBLE, win_));
+		offset += count;
+		doubles -= count;
+	}
+	SIPMPIUtils::check_err(MPI_Win_flush(server_rank, win_));
+}
+
+void RmaArrays::flush_all() {
+	if (win_ == MPI_WIN_NULL) return;
+	SIPMPIUtils::check_err(MPI_Win_flush_all(win_));
+}
+
+void RmaArrays::flush(const BlockId& id) {
+	SIPMPIUtils::check_err(MPI_Win_flush(data_distribution_.get_server_rank(id), win_));
+	//a direct copy reads the memory through the shared window
+	if (data_distribution_.is_node_local(id)) sync();
+}
+
+void RmaArrays::sync() {
+	if (shared_win_ == MPI_WIN_NULL) return;
+	SIPMPIUtils::check_err(MPI_Win_sync(shared_win_));
+}
+
+std::size_t RmaArrays::slots_per_server(int array_id) const {
+	return data_distribution_.max_blocks_at_server(array_id);
+}
+
+MPI_Aint RmaArrays::displacement(const BlockId& id) const {
+	int array_id = id.array_id();
+	std::size_t position = data_distribution_.position_at_server(array_id,
+			sip_tables_.block_number(id));
+	return offsets_[array_id] + position * sip_tables_.max_block_size(array_id);
+}
+
+std::ostream& operator<<(std::ostream& os, const RmaArrays& obj) {
+	os << "One-sided arrays, window bytes per server," << obj.window_bytes() << std::endl;
+	for (std::size_t i = 0; i < obj.offsets_.size(); ++i) {
+		if (obj.offsets_[i] >= 0) {
+			os << obj.sip_tables_.array_name(i) << ',' << obj.offsets_[i] << std::endl;
+		}
+	}
+	return os;
+}
+
+} /* namespace sip */
@@ -0,0 +1,145 @@
+/*
+ * rma_arrays.h
+ *
+ * One-sided (MPI RMA) storage for distributed arrays.
+ *
+ * Each server exposes the blocks it owns of the eligible arrays in a single MPI window,
+ * and workers access them with MPI_Rget and MPI_Raccumulate (MPI_REPLACE for puts), so
+ * the server does not handle any messages for these arrays.
+ *
+ * An array is eligible if it is distributed (served arrays are disk backed), is never
+ * the argument of set_persistent or restore_persistent, and it fits, together with the
+ * eligible arrays declared before it, in max_bytes() at each server.  Thus the arrays
+ * never spill to disk.  The window holds a slot of max_block_size doubles for each block
+ * of an array at its server, in the order given by DataDistribution::position_at_server.
+ * So the directory is computed from the SipTables at each process and needs only the
+ * offset of each array.
+ *
+ * The memory of the window at each server is allocated with MPI_Win_allocate_shared on
+ * the node communicator, so a worker on the same node as the server of a block (see
+ * DataDistribution::is_node_local) gets it by copying it directly from the server's
+ * memory.  Puts and accumulates always use MPI operations, which keeps them atomic with
+ * respect to each other, and blocks of servers on other nodes are accessed with MPI_Rget.
+ * The blocks of other distributed and served arrays are held in the server's block map,
+ * not in shared memory, so they are always sent in messages, even on the same node.
+ *
+ * Unlike the blocks at the server, blocks are zero until written and reading them is
+ * not an error.  Data races are not checked at the server.
+ *
+ * create_window and free_window are collective over MPI_COMM_WORLD.  Workers hold a
+ * passive target epoch on all servers (MPI_Win_lock_all) from create_window until
+ * free_window.  Remote completion of the puts is ensured by flush_all, which must be
+ * called at the barrier before the workers synchronize, and sync must be called after
+ * they have synchronized so that direct copies see the updates.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef RMA_ARRAYS_H_
+#define RMA_ARRAYS_H_
+
+#include <mpi.h>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "block_id.h"
+#include "sip_tables.h"
+#include "sip_mpi_attr.h"
+#include "data_distribution.h"
+
+namespace sip {
+
+class RmaArrays {
+public:
+	/** 0 disables the one-sided backend */
+	static const std::size_t DEFAULT_MAX_BYTES = 0;
+
+	/** Sets the maximum number of bytes of the window at each server. */
+	static void set_max_bytes(std::size_t max_bytes);
+	static std::size_t max_bytes();
+
+	/** Computes the layout of the window, which is not created yet. */
+	RmaArrays(const SipTables& sip_tables, const DataDistribution& data_distribution,
+			SIPMPIAttr& sip_mpi_attr);
+
+	/** Frees the window if free_window has not been called. */
+	~RmaArrays();
+
+	/** Collective over MPI_COMM_WORLD.  Called by workers and servers at the start of
+	 * each SIAL program.  Noop if no array uses the one-sided backend. */
+	void create_window();
+
+	/** Collective over MPI_COMM_WORLD.  Called by workers and servers at the end of
+	 * each SIAL program. */
+	void free_window();
+
+	/** true if blocks of the array are accessed with one-sided operations */
+	bool is_rma_array(int array_id) const {
+		return win_ != MPI_WIN_NULL && offsets_.at(array_id) >= 0;
+	}
+
+	/** Number of arrays using the one-sided backend in this program */
+	int num_rma_arrays() const { return num_rma_arrays_; }
+
+	/** Bytes of the window at each server */
+	std::size_t window_bytes() const { return window_doubles_ * sizeof(double); }
+
+	/** Worker operations.  They are complete at the origin when request is complete.
+	 * The data of accumulate is combined with the block with op.
+	 *
+	 * get returns true if the block was copied from the memory of a server on this node,
+	 * in which case request is MPI_REQUEST_NULL. */
+	bool get(const BlockId& id, double* data, std::size_t size, MPI_Request* request);
+	void accumulate(const BlockId& id, const double* data, std::size_t size, MPI_Op op,
+			MPI_Request* request);
+
+	/** Sets the blocks of the array at the given server to zero.  Blocks until complete. */
+	void clear_array(int array_id, int server_rank);
+
+	/** Completes all operations of this worker at the servers */
+	void flush_all();
+
+	/** Completes the operations of this worker at the server of the block, so that a
+	 * following get of the block sees them */
+	void flush(const BlockId& id);
+
+	/** Makes the updates completed by all workers before they synchronized visible to the
+	 * direct copies of this worker */
+	void sync();
+
+	friend std::ostream& operator<<(std::ostream&, const RmaArrays&);
+
+private:
+	static std::size_t max_bytes_;
+
+	const SipTables& sip_tables_;
+	const DataDistribution& data_distribution_;
+	SIPMPIAttr& sip_mpi_attr_;
+
+	/** Offset of the first slot of each array in the window, in doubles.  -1 if the
+	 * array does not use the one-sided backend. */
+	std::vector<MPI_Aint> offsets_;
+	int num_rma_arrays_;
+	std::size_t window_doubles_;
+
+	MPI_Win win_;
+	MPI_Win shared_win_;  //the same memory, shared on the node communicator
+	double* base_;  //local part of the window, allocated at servers
+	/** Start of the window at each server on this node, indexed by global rank.  Only
+	 * set at workers. */
+	std::vector<double*> node_bases_;
+
+	/** Number of slots an array uses at each server */
+	std::size_t slots_per_server(int array_id) const;
+
+	/** Displacement of the block at its server */
+	MPI_Aint displacement(const BlockId& id) const;
+
+	DISALLOW_COPY_AND_ASSIGN(RmaArrays);
+};
+
+} /* namespace sip */
+
+#endif /* RMA_ARRAYS_H_ */
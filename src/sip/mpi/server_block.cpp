@@ -14,7 +14,7 @@
 
 #include "sip.h"
 
-#include "lru_array_policy.h"
+#include "block_kernels.h"
 
 using namespace std::rel_ops;
 namespace sip {
@@ -55,23 +55,19 @@ ServerBlock::dataPtr ServerBlock::accumulate_data(size_t asize, dataPtr to_add){
 	CHECK(size() == asize, "accumulating blocks of unequal size");
 	CHECK(data_ != NULL, "attempting to accumulate into block with null data_");
 	CHECK(to_add != NULL, "attempting to accumulate from null dataPtr");
-	for (size_t i = 0; i < asize; ++i){
-			data_[i] += to_add[i];
-	}
+	block_kernels::accumulate(data_, to_add, asize);
 	return data_;
 }
 
 ServerBlock::dataPtr ServerBlock::fill_data(double value) {
 	double* data_ = block_data_.get_data();
-	std::fill(data_+0, data_+size(), value);
+	block_kernels::fill(data_, size(), value);
 	return data_;
 }
 
 ServerBlock::dataPtr ServerBlock::scale_data(double factor) {
 	double* data_ = block_data_.get_data();
-	for (int i = 0; i < size(); ++i) {
-		data_[i] *= factor;
-	}
+	block_kernels::scale(data_, size(), factor);
 	return data_;
 }
 
@@ -196,6 +196,7 @@ private:
 	friend class PendingAsyncManager;
 
 	friend class DiskBackedBlockMap;
+	friend class TestServerBlocks;  //creates blocks for unit tests of the block policy
 
 
 	DISALLOW_COPY_AND_ASSIGN(ServerBlock);
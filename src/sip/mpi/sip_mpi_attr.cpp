@@ -73,7 +73,8 @@ SIPMPIAttr::SIPMPIAttr(RankDistribution& rank_distribution):
 		global_rank_(-1), global_size_(-1),
 		company_size_(-1),
 		server_group_(MPI_GROUP_NULL), worker_group_(MPI_GROUP_NULL),
-		server_comm_(MPI_COMM_NULL), worker_comm_(MPI_COMM_NULL), company_comm_(MPI_COMM_NULL){
+		server_comm_(MPI_COMM_NULL), worker_comm_(MPI_COMM_NULL), company_comm_(MPI_COMM_NULL),
+		node_comm_(MPI_COMM_NULL){
 
 
 	SIPMPIUtils::check_err(MPI_Comm_rank(MPI_COMM_WORLD, &global_rank_));
@@ -147,6 +148,18 @@ SIPMPIAttr::SIPMPIAttr(RankDistribution& rank_distribution):
 	delete [] worker_ranks;
 	delete [] server_ranks;
 
+	// Find the processes on this node
+	SIPMPIUtils::check_err(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, global_rank_, MPI_INFO_NULL, &node_comm_));
+	MPI_Group node_group;
+	SIPMPIUtils::check_err(MPI_Comm_group(node_comm_, &node_group));
+	std::vector<int> global_ranks(global_size_);
+	for (int i=0; i<global_size_; i++) global_ranks[i] = i;
+	node_ranks_.resize(global_size_);
+	SIPMPIUtils::check_err(MPI_Group_translate_ranks(univ_group_, global_size_, &global_ranks[0], node_group, &node_ranks_[0]));
+	for (int i=0; i<global_size_; i++)
+		if (node_ranks_[i] == MPI_UNDEFINED) node_ranks_[i] = -1;
+	SIPMPIUtils::check_err(MPI_Group_free(&node_group));
+
     if (rank_distribution.is_local_worker_to_communicate(global_rank_)){
     	my_servers_ = rank_distribution.local_servers_to_communicate(global_rank_);
     }
@@ -196,6 +209,8 @@ SIPMPIAttr::~SIPMPIAttr() {
 		SIPMPIUtils::check_err(MPI_Comm_free(&server_comm_));
 	if (worker_comm_ != MPI_COMM_NULL)
 		SIPMPIUtils::check_err(MPI_Comm_free(&worker_comm_));
+	if (node_comm_ != MPI_COMM_NULL)
+		SIPMPIUtils::check_err(MPI_Comm_free(&node_comm_));
 }
 
 } /* namespace sip */
@@ -64,6 +64,12 @@ public:
 
 	const std::vector<int>& my_servers(){return my_servers_;}
 
+	// Processes that can share memory with this one (MPI_COMM_TYPE_SHARED), usually a node.
+	const MPI_Comm& node_communicator() const { return node_comm_; }
+	bool is_on_my_node(int global_rank) const { return node_ranks_.at(global_rank) >= 0; }
+	// Rank in the node communicator of a process on this node, -1 otherwise
+	int node_rank(int global_rank) const { return node_ranks_.at(global_rank); }
+
 	friend std::ostream& operator<<(std::ostream&, const SIPMPIAttr&);
 
 
@@ -91,6 +97,8 @@ private:
 	MPI_Comm company_comm_; // This company's communicator
 	MPI_Comm server_comm_; // Server company communicator
 	MPI_Comm worker_comm_; // Worker company communicator
+	MPI_Comm node_comm_; // Processes on this node
+	std::vector<int> node_ranks_; // Rank in node_comm_ of each global rank, -1 if not on this node
 
 	// Temp variables to free up.
 	MPI_Group server_group_;
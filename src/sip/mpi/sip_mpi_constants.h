@@ -36,7 +36,10 @@ SIP_MESSAGE(SET_PERSISTENT, 8, "SET_PERSISTENT")\
 SIP_MESSAGE(RESTORE_PERSISTENT, 9, "RESTORE_PERSISTENT")\
 SIP_MESSAGE(PUT_INITIALIZE, 10, "PUT_INITIALIZE")\
 SIP_MESSAGE(PUT_INCREMENT, 11, "PUT_INCREMENT")\
-SIP_MESSAGE(PUT_SCALE, 12, "PUT_SCALE")
+SIP_MESSAGE(PUT_SCALE, 12, "PUT_SCALE")\
+SIP_MESSAGE(PUT_EAGER, 13, "PUT_EAGER")\
+SIP_MESSAGE(PUT_ACCUMULATE_EAGER, 14, "PUT_ACCUMULATE_EAGER")\
+SIP_MESSAGE(GET_BATCH, 15, "GET_BATCH")
 
 	enum MessageType_t {
 	#define SIP_MESSAGE(e,n,s) e = n,
@@ -9,6 +9,8 @@
 #define SIP_MPI_UTILS_H_
 
 #include <mpi.h>
+#include <cstddef>
+#include <cstring>
 #include "block_id.h"
 
 
@@ -56,6 +58,64 @@ public:
 		pardo_section = buff[pos];
 	}
 
+	/** A GET_BATCH message contains, for each block, the BlockID buffer followed by the
+	 * tag of the reply.  The number of blocks is given by the size of the message. */
+	static const int GET_BATCH_ELEMS_PER_BLOCK = BLOCKID_BUFF_ELEMS + 1;
+	static const int MAX_GET_BATCH = 16;
+
+	/** Writes the GET_BATCH_ELEMS_PER_BLOCK ints of one block of a GET_BATCH message */
+	static void encode_get_batch_entry(int buff[], const BlockId& id, int pc, int pardo_section,
+			int reply_tag){
+		encode_BlockID_buff(buff, id, pc, pardo_section);
+		buff[BLOCKID_BUFF_ELEMS] = reply_tag;
+	}
+
+	static void decode_get_batch_entry(int buff[], BlockId& id, int& pc, int& pardo_section,
+			int& reply_tag){
+		decode_BlockID_buff(buff, id, pc, pardo_section);
+		reply_tag = buff[BLOCKID_BUFF_ELEMS];
+	}
+
+	/** Blocks with at most this many elements are put with a single eager message
+	 * containing the BlockID buffer followed by the data.  Larger blocks are sent as a
+	 * BlockID message followed by a data message. */
+	static const int EAGER_PUT_MAX_DOUBLES = 2048;
+
+	/** Bytes at the start of an eager put message used by the BlockID buffer, rounded up
+	 * so that the data is aligned */
+	static const int EAGER_PUT_HEADER_BYTES =
+			(BLOCKID_BUFF_ELEMS * sizeof(int) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+
+	static std::size_t eager_put_bytes(std::size_t num_doubles) {
+		return EAGER_PUT_HEADER_BYTES + num_doubles * sizeof(double);
+	}
+
+	/** Writes the BlockID buffer at the start of an eager put message */
+	static void encode_eager_put_header(char* buff, const BlockId& id, int pc,
+			int pardo_section){
+		int header[BLOCKID_BUFF_ELEMS];
+		encode_BlockID_buff(header, id, pc, pardo_section);
+		std::memcpy(buff, header, sizeof(header));
+	}
+
+	/** Returns a new[] allocated eager put message for the given block */
+	static char* encode_eager_put_buff(const BlockId& id, int pc, int pardo_section,
+			const double* data, std::size_t num_doubles){
+		char* buff = new char[eager_put_bytes(num_doubles)];
+		encode_eager_put_header(buff, id, pc, pardo_section);
+		std::memcpy(buff + EAGER_PUT_HEADER_BYTES, data, num_doubles * sizeof(double));
+		return buff;
+	}
+
+	/** Decodes the BlockID buffer of an eager put message and returns a pointer to its data */
+	static const double* decode_eager_put_buff(const char* buff, BlockId& id, int& pc,
+			int& pardo_section){
+		int header[BLOCKID_BUFF_ELEMS];
+		std::memcpy(header, buff, sizeof(header));
+		decode_BlockID_buff(header, id, pc, pardo_section);
+		return reinterpret_cast<const double*>(buff + EAGER_PUT_HEADER_BYTES);
+	}
+
 
 
 
@@ -10,10 +10,20 @@
 #include <sstream>
 #include "sial_ops_parallel.h"
 #include <iomanip>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
 
 namespace sip {
 
 SIPServer* SIPServer::global_sipserver = NULL;
+#ifdef _OPENMP
+int SIPServer::num_helper_threads_ = SIPServer::DEFAULT_NUM_HELPER_THREADS;
+#else
+int SIPServer::num_helper_threads_ = 0;
+#endif //_OPENMP
+bool SIPServer::helpers_call_mpi_ = false;
 
 SIPServer::SIPServer(SipTables& sip_tables, DataDistribution& data_distribution,
 		SIPMPIAttr& sip_mpi_attr,
@@ -25,17 +35,56 @@ SIPServer::SIPServer(SipTables& sip_tables, DataDistribution& data_distribution,
 				persistent_array_manager), terminated_(false),
 				last_seen_worker_(0),
 				pc_(0),
+				rma_arrays_(sip_tables, data_distribution, sip_mpi_attr),
 				stats_(sip_mpi_attr.company_communicator(), sip_tables.op_table_size()+1)
 				{
 	mpi_type_.initialize_mpi_scalar_op_type();
 	SIPServer::global_sipserver = this;
+	rma_arrays_.create_window();
 }
 
 SIPServer::~SIPServer() {
 	SIPServer::global_sipserver = NULL;
 }
 
+void SIPServer::set_num_helper_threads(int num_helper_threads) {
+#ifdef _OPENMP
+	num_helper_threads_ = std::max(num_helper_threads, 0);
+#else
+	num_helper_threads_ = 0;
+#endif //_OPENMP
+}
+
+int SIPServer::num_helper_threads() {
+	return num_helper_threads_;
+}
+
+void SIPServer::set_helpers_call_mpi(bool helpers_call_mpi) {
+	helpers_call_mpi_ = helpers_call_mpi;
+}
+
+bool SIPServer::helpers_call_mpi() {
+	return helpers_call_mpi_ && num_helper_threads_ > 0;
+}
+
 void SIPServer::run() {
+#ifdef _OPENMP
+	if (num_helper_threads_ > 0) {
+		//The master thread makes all MPI calls.  The other threads wait at the
+		//implicit barrier at the end of the parallel region, where they execute the
+		//tasks created by the async ops.
+#pragma omp parallel num_threads(num_helper_threads_ + 1)
+		{
+#pragma omp master
+			run_loop();
+		}
+		return;
+	}
+#endif //_OPENMP
+	run_loop();
+}
+
+void SIPServer::run_loop() {
 	stats_.total_timer_.start();
 	int my_rank = sip_mpi_attr_.global_rank();
 
@@ -117,6 +166,10 @@ void SIPServer::run() {
 			handle_GET(mpi_source, mpi_tag);
 		}
 			break;
+		case SIPMPIConstants::GET_BATCH: {
+			handle_GET_BATCH(mpi_source, mpi_tag);
+		}
+			break;
 		case SIPMPIConstants::PUT: {
 			handle_PUT(mpi_source, mpi_tag, transaction_number);
 		}
@@ -125,6 +178,14 @@ void SIPServer::run() {
 			handle_PUT_ACCUMULATE(mpi_source, mpi_tag, transaction_number);
 		}
 			break;
+		case SIPMPIConstants::PUT_EAGER: {
+			handle_PUT_EAGER(mpi_source, mpi_tag);
+		}
+			break;
+		case SIPMPIConstants::PUT_ACCUMULATE_EAGER: {
+			handle_PUT_ACCUMULATE_EAGER(mpi_source, mpi_tag);
+		}
+			break;
 		case SIPMPIConstants::PUT_INITIALIZE: {
 			handle_PUT_INITIALIZE(mpi_source, mpi_tag);
 		}
@@ -182,7 +243,38 @@ void SIPServer::handle_GET(int mpi_source, int get_tag) {
 	int section;
 	SIPMPIUtils::decode_BlockID_buff(buffer, block_id, pc_, section);
 	last_seen_worker_ = mpi_source;
+	reply_to_GET(mpi_source, get_tag, block_id, section);
+}
+
+void SIPServer::handle_GET_BATCH(int mpi_source, int get_batch_tag) {
+
+	//receive the message, whose size gives the number of blocks
+	MPI_Status status;
+	SIPMPIUtils::check_err(
+			MPI_Probe(mpi_source, get_batch_tag, MPI_COMM_WORLD, &status), __LINE__, __FILE__);
+	int count;
+	SIPMPIUtils::check_err(MPI_Get_count(&status, MPI_INT, &count), __LINE__, __FILE__);
+	CHECK(count > 0 && count % SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK == 0,
+			"malformed GET_BATCH message");
+	std::vector<int> buffer(count);
+	SIPMPIUtils::check_err(
+			MPI_Recv(&buffer.front(), count, MPI_INT, mpi_source, get_batch_tag,
+					MPI_COMM_WORLD, &status));
+	last_seen_worker_ = mpi_source;
+	stats_.num_batched_gets_.inc(count / SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK);
+
+	//handle each get as if it had been sent separately
+	for (int pos = 0; pos < count; pos += SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK) {
+		BlockId block_id;
+		int section;
+		int get_tag;
+		SIPMPIUtils::decode_get_batch_entry(&buffer[pos], block_id, pc_, section, get_tag);
+		reply_to_GET(mpi_source, get_tag, block_id, section);
+	}
+}
 
+void SIPServer::reply_to_GET(int mpi_source, int get_tag, const BlockId& block_id,
+		int section) {
     //retrieve the block
 	stats_.get_block_timer_.start(pc_);
 	ServerBlock* block = disk_backed_block_map_.get_block_for_reading(block_id,
@@ -191,6 +283,7 @@ void SIPServer::handle_GET(int mpi_source, int get_tag) {
 
 	//create async op to handle the reply
 	async_ops_.add_get_reply(mpi_source, get_tag, block_id, block, pc_);
+	stats_.num_gets_.inc();
 
 
 	//handle section number updates
@@ -243,10 +336,7 @@ void SIPServer::handle_PUT(int mpi_source, int put_tag,
 			transaction_number);
 	async_ops_.add_put_data_request(mpi_source, put_data_tag, block_id, block, pc_);
 
-	//send ack to worker, who is waiting for it
-	SIPMPIUtils::check_err(
-			MPI_Send(0, 0, MPI_INT, mpi_source, put_tag, MPI_COMM_WORLD),
-			__LINE__, __FILE__);
+	//the worker sends the data without waiting for a reply, the data message is acked
 
 	//handle section number updates
 	SIP_LOG(
@@ -302,10 +392,7 @@ void SIPServer::handle_PUT_ACCUMULATE(int mpi_source, int put_accumulate_tag,
 			SIPMPIConstants::PUT_ACCUMULATE_DATA, transaction_number);
 	async_ops_.add_put_accumulate_data_request(mpi_source, put_accumulate_data_tag, block_id, block, pc_);
 
-	//send ack to worker, who is waiting for it
-	SIPMPIUtils::check_err(
-			MPI_Send(0, 0, MPI_INT, mpi_source, put_accumulate_tag, MPI_COMM_WORLD),
-			__LINE__, __FILE__);
+	//the worker sends the data without waiting for a reply, the data message is acked
 
 	//handle section number updates
 	if(section < state_.section_number_){
@@ -333,6 +420,113 @@ void SIPServer::handle_PUT_ACCUMULATE(int mpi_source, int put_accumulate_tag,
 
 }
 
+void SIPServer::handle_PUT_EAGER(int mpi_source, int put_tag) {
+	//receive and decode the message, which contains both the block id and the data
+	BlockId block_id;
+	int section;
+	size_t size;
+	char* buffer = receive_eager_put(mpi_source, put_tag, size);
+	const double* data = SIPMPIUtils::decode_eager_put_buff(buffer, block_id, pc_, section);
+	last_seen_worker_ = mpi_source;
+
+	//retrieve the block for writing, this waits for pending operations on it
+	stats_.get_block_timer_.start(pc_);
+	ServerBlock* block = disk_backed_block_map_.get_block_for_writing(block_id);
+	stats_.get_block_timer_.pause(pc_);
+	CHECK(block->size() == size, "eager put data size does not match block size");
+	std::copy(data, data + size, block->get_data());
+	delete [] buffer;
+
+	//ack, the worker waits for it at the next barrier
+	SIPMPIUtils::check_err(
+			MPI_Send(0, 0, MPI_INT, mpi_source, put_tag, MPI_COMM_WORLD),
+			__LINE__, __FILE__);
+
+	SIP_LOG(
+			std::cout << "S " << sip_mpi_attr_.global_rank() << " : eager put for block " << block_id.str(sip_tables_) << ", size = " << size << ", sent from = " << mpi_source << ", at line = " << line_number(pc_) << std::endl;)
+
+	//handle section number updates
+	if(section < state_.section_number_){
+		std::cout << "illegal section number "<< section
+				<< " where state_.section_number_ = "<< state_.section_number_
+				<< " at block "<< block_id << " line" << line_number(pc_) << " from worker "
+				<< last_seen_worker_ << std::endl;
+		std::cout << std::flush;
+	}
+	state_.check_section_number_invariant(
+			section);
+
+	//data race check
+	if (!block->update_and_check_consistency(SIPMPIConstants::PUT,
+			mpi_source, section)) {
+		std::stringstream err_ss;
+		err_ss << "Incorrect PUT block semantics (data race) for " << block_id
+				<<  " from worker "
+				<< mpi_source << ". Probably a missing sip_barrier";
+		SIAL_CHECK(false, err_ss.str(), line_number(pc_));
+	}
+}
+
+void SIPServer::handle_PUT_ACCUMULATE_EAGER(int mpi_source, int put_accumulate_tag) {
+	//receive and decode the message, which contains both the block id and the data
+	BlockId block_id;
+	int section;
+	size_t size;
+	char* buffer = receive_eager_put(mpi_source, put_accumulate_tag, size);
+	const double* data = SIPMPIUtils::decode_eager_put_buff(buffer, block_id, pc_, section);
+	last_seen_worker_ = mpi_source;
+
+	//retrieve the block for accumulate
+	stats_.get_block_timer_.start(pc_);
+	ServerBlock* block = disk_backed_block_map_.get_block_for_accumulate(
+			block_id);
+	stats_.get_block_timer_.pause(pc_);
+	CHECK(block->size() == size, "eager put_accumulate data size does not match block size");
+
+	//accumulate, on a helper thread if there is one, and ack.  The worker waits for the ack
+	//at the next barrier.  The op owns the buffer.
+	async_ops_.add_put_accumulate_eager(mpi_source, put_accumulate_tag, block_id,
+			block, buffer, const_cast<double*>(data), pc_);
+
+	//handle section number updates
+	if(section < state_.section_number_){
+		std::cout << "illegal section number "<< section
+				<< " where state_.section_number_ = "<< state_.section_number_
+				<< " at block "<< block_id << " line" << line_number(pc_) << " from worker "
+				<< last_seen_worker_ << std::endl;
+		std::cout <<  std::flush;
+	}
+	state_.check_section_number_invariant(
+			section);
+
+	//data race check
+	if (!block->update_and_check_consistency(SIPMPIConstants::PUT_ACCUMULATE,
+			mpi_source, section)) {
+		std::stringstream err_ss;
+		err_ss << "Incorrect PUT_ACCUMULATE block semantics (data race) for " << block_id
+				<<  " from worker "
+				<< mpi_source << ". Probably a missing sip_barrier";
+		SIAL_CHECK(false, err_ss.str(),line_number(pc_));
+	}
+
+	SIP_LOG(
+			std::cout << "S " << sip_mpi_attr_.global_rank() << " : eager put accumulate for block " << block_id.str(sip_tables_) << ", size = " << size << ", from = " << mpi_source << ", at line = " << line_number(pc_) << std::endl << std::flush;)
+}
+
+char* SIPServer::receive_eager_put(int mpi_source, int tag, size_t& size) {
+	MPI_Status status;
+	SIPMPIUtils::check_err(
+			MPI_Probe(mpi_source, tag, MPI_COMM_WORLD, &status), __LINE__, __FILE__);
+	int bytes;
+	SIPMPIUtils::check_err(MPI_Get_count(&status, MPI_BYTE, &bytes), __LINE__, __FILE__);
+	CHECK(bytes >= SIPMPIUtils::EAGER_PUT_HEADER_BYTES, "malformed eager put message");
+	char* buffer = new char[bytes];
+	SIPMPIUtils::check_err(
+			MPI_Recv(buffer, bytes, MPI_BYTE, mpi_source, tag, MPI_COMM_WORLD, &status),
+			__LINE__, __FILE__);
+	size = (bytes - SIPMPIUtils::EAGER_PUT_HEADER_BYTES) / sizeof(double);
+	return buffer;
+}
 
 void SIPServer::handle_DELETE(int mpi_source, int delete_tag) {
 	SIP_LOG(
@@ -518,6 +712,9 @@ void SIPServer::handle_END_PROGRAM(int mpi_source, int end_program_tag) {
 			MPI_Send(0, 0, MPI_INT, mpi_source, end_program_tag,
 					MPI_COMM_WORLD), __LINE__, __FILE__);
 
+	//the workers free the window after receiving the ack
+	rma_arrays_.free_window();
+
 	//set terminated flag;
 	terminated_ = true;
 	disk_backed_block_map_.stats_.finalize(&disk_backed_block_map_);
@@ -646,6 +843,8 @@ std::ostream& SIPServer::Stats::gather_and_print_statistics(std::ostream& os, SI
 	pending_timer_.reduce();
 	handle_op_timer_.reduce();
 	num_ops_.gather();
+	num_batched_gets_.gather();
+	num_gets_.gather();
 	server->async_ops_.pending_counter_.gather();
 
 	if (server->sip_mpi_attr_.is_company_master()){
@@ -674,6 +873,10 @@ std::ostream& SIPServer::Stats::gather_and_print_statistics(std::ostream& os, SI
 		os << pending_timer_ ;
 		os << std::endl << "num_ops_" << std::endl;
 		os << num_ops_ ;
+		os << std::endl << "num_batched_gets_" << std::endl;
+		os << num_batched_gets_ ;
+		os << std::endl << "num_gets_" << std::endl;
+		os << num_gets_ ;
 		os << std::endl << "async_ops_pending_" << std::endl;
 		os << server->async_ops_.pending_counter_ ;
 	}
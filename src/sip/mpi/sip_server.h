@@ -20,6 +20,7 @@
 #include "barrier_support.h"
 #include "server_persistent_array_manager.h"
 #include "disk_backed_block_map.h"
+#include "rma_arrays.h"
 //#include "server_timer.h"
 #include "counter.h"
 #include "timer.h"
@@ -81,6 +82,14 @@ public:
 		pending_counter_.inc();
 	}
 
+	void add_put_accumulate_eager(int mpi_source, int put_accumulate_tag, BlockId id, ServerBlock* block,
+			char* buffer, double* data, int pc){
+		if (pending_counter_.get_value() > MAX_PENDING) wait_all();
+		block->async_state_.add_put_accumulate_eager(mpi_source, put_accumulate_tag, block, buffer, data, pc);
+		pending_.push_back(std::pair<BlockId,ServerBlock*>(id,block));
+		pending_counter_.inc();
+	}
+
 	void add_get_reply(int mpi_source, int get_tag, BlockId id, ServerBlock* block, int pc){
 		if (pending_counter_.get_value() > MAX_PENDING) wait_all();
 		block->async_state_.add_get_reply(mpi_source, get_tag, block, pc);
@@ -187,6 +196,7 @@ private:
  * GET: server receives GET from worker, replies with requested block.  It is a fatal error for a worker to request a block that doesn't exist
  * PUT: server receives PUT from worker with block id, server receives matching PUT_DATA from worker.  replies with PUT_DATA_ACK.
  * PUT_ACCUMULATE: server receives PUT_ACCUMLATE from worker with block id, server receives matching PUT_ACCUMULATE_DATA from worker.  replies with PUT_ACCUMULATE_DATA_ACK.
+ * PUT_EAGER, PUT_ACCUMULATE_EAGER: server receives a single message with the block id followed by the data of a small block.  replies with an ack containing the same tag.
  * PUT_INITIALIZE: server receives PUT_INITIALIZE from  worker with block id and double value and replies with ack containing same tag.  Server initializes each element of the
  *     block to the value. If the block does not exist, it is created.
  * PUT_INCREMENT: server receives PUT_INCREMENT from worker with block id and double value and replies with ack containing the same tag.  Server increments each element
@@ -217,10 +227,30 @@ public:
 	static SIPServer* global_sipserver;
 
 	/**
-	 * Main server loop
+	 * Main server loop.
+	 *
+	 * If there are helper threads, the loop runs in the master thread of an OpenMP
+	 * parallel region and the helper threads accumulate the data of put_accumulate
+	 * messages, both eager and not (see AccumulateAsync).  With MPI_THREAD_FUNNELED, only
+	 * the master thread makes MPI calls.  With MPI_THREAD_MULTIPLE, the helper threads also
+	 * send the acks of the accumulates and write the chunks backed up to disk.  Reading a
+	 * chunk from disk, and the reply to a get, stay in the master thread, which needs the data
+	 * before handling the next message for the block.
 	 */
 	void run();
 
+	static const int DEFAULT_NUM_HELPER_THREADS = 0;
+
+	/** Sets the number of helper threads.  0 handles everything in the loop thread.
+	 * Ignored, and always 0, without OpenMP. */
+	static void set_num_helper_threads(int num_helper_threads);
+	static int num_helper_threads();
+
+	/** Whether helper threads may make MPI calls, i.e. MPI provides MPI_THREAD_MULTIPLE.
+	 * False if there are no helper threads. */
+	static void set_helpers_call_mpi(bool helpers_call_mpi);
+	static bool helpers_call_mpi();
+
 
 	IdBlockMap<ServerBlock>::PerArrayMap* per_array_map(int array_id){
 		return disk_backed_block_map_.per_array_map(array_id);
@@ -280,6 +310,8 @@ public:
 			MPITimer pending_timer_;
 			MPITimer total_timer_;
 			MPICounter num_ops_;
+			MPICounter num_batched_gets_;  //gets received in GET_BATCH messages
+			MPICounter num_gets_;  //all gets
 			MPITimer handle_op_timer_;
 			std::ostream& gather_and_print_statistics(std::ostream& os, SIPServer* server);
 			Stats(const MPI_Comm& comm, size_t list_size):
@@ -289,10 +321,15 @@ public:
 			pending_timer_(comm),
 			total_timer_(comm),
 			num_ops_(comm),
+			num_batched_gets_(comm),
+			num_gets_(comm),
 			handle_op_timer_(comm){
 			}
 	};
 
+	/** Number of blocks requested by GETs in this program */
+	long num_gets() { return stats_.num_gets_.get_value(); }
+
 	std::ostream& gather_and_print_statistics(std::ostream& os){
 		stats_.gather_and_print_statistics(os, this);
 		disk_backed_block_map_.stats_.gather_and_print_statistics(os, &disk_backed_block_map_);
@@ -315,6 +352,11 @@ public:
 
 
 private:
+	static int num_helper_threads_;
+	static bool helpers_call_mpi_;
+
+	void run_loop();
+
     const SipTables &sip_tables_;
 	const SIPMPIAttr & sip_mpi_attr_;
 	const DataDistribution &data_distribution_;
@@ -340,6 +382,10 @@ private:
 
 	ServerPersistentArrayManager* persistent_array_manager_;
 	DiskBackedBlockMap disk_backed_block_map_;
+
+	/** Distributed arrays whose blocks are in an MPI window instead of the block map.
+	 * The server does not handle messages for them. */
+	RmaArrays rma_arrays_;
 	PendingAsyncManager async_ops_;
 
 
@@ -363,6 +409,24 @@ private:
 	 */
 	void handle_GET(int mpi_source, int tag);
 
+	/**
+	 * Get batch
+	 *
+	 * invoked by server loop.
+	 *
+	 * Receives a message with several block ids from the same worker, each followed by the
+	 * tag the worker expects the block with, and replies to each as handle_GET does.
+	 * The worker has posted a receive for each block.
+	 *
+	 * @param mpi_source  requesting worker
+	 * @param tag         tag of the GET_BATCH message
+	 */
+	void handle_GET_BATCH(int mpi_source, int tag);
+
+	/** Retrieves the block, creates the async op that sends it with get_tag, and checks
+	 * the section number and data races.  pc_ must have been set from the request. */
+	void reply_to_GET(int mpi_source, int get_tag, const BlockId& block_id, int section);
+
 	/**
 	 * Put
 	 *
@@ -372,8 +436,8 @@ private:
 	 * Receives the message and obtains the block_id and block size.
 	 * Get the block, creating it if
 	 *    it doesn't exist.
-	 * Creates an async op to manage the receive
-	 * Sends an ack to the source
+	 * Creates an async op to manage the receive.  The worker sends the data
+	 * without waiting for a reply, so no ack is sent for this message.
 	 *
 	 * @param mpi_source
 	 * @param put_tag
@@ -399,6 +463,39 @@ private:
 	 */
 	void handle_PUT_ACCUMULATE(int mpi_source, int put_accumulate_tag, int put_accumulate_data_tag);
 
+	/**
+	 * put_eager
+	 *
+	 * invoked by server loop.
+	 *
+	 * Receives a message containing the block id followed by the data of a small block,
+	 * copies the data into the block, creating it if it doesn't exist, and sends an ack
+	 * with the same tag.  The worker does not wait for the ack before the next barrier.
+	 *
+	 * @param [in] mpi_source
+	 * @param [in] put_tag
+	 */
+	void handle_PUT_EAGER(int mpi_source, int put_tag);
+
+	/**
+	 * put_accumulate_eager
+	 *
+	 * invoked by server loop.
+	 *
+	 * As handle_PUT_EAGER, but accumulates the data into the block, which is created and
+	 * initialized to zero if it doesn't exist.
+	 *
+	 * @param [in] mpi_source
+	 * @param [in] put_accumulate_tag
+	 */
+	void handle_PUT_ACCUMULATE_EAGER(int mpi_source, int put_accumulate_tag);
+
+	/**
+	 * Receives an eager put message of any size.  Returns the new[] allocated buffer and
+	 * sets size to the number of doubles following the header.
+	 */
+	char* receive_eager_put(int mpi_source, int tag, size_t& size);
+
 /**
  * put_initialize
  *
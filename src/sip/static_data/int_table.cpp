@@ -7,6 +7,7 @@
 
 #include "int_table.h"
 #include <stdexcept>
+#include <algorithm>
 
 namespace sip {
 
@@ -53,6 +54,10 @@ int IntTable::value(int slot) const {
 void IntTable::set_value(int slot, int value) {
 	values_[slot] = value;
 }
+
+void IntTable::set_values(const IntTable& other) {
+	std::copy(other.values_.begin(), other.values_.end(), values_.begin());
+}
 /** returns the name associated with the given slot */
 std::string IntTable::name(int slot) const {
 	try {
@@ -30,6 +30,8 @@ public:
 	int value(int slot) const;
 	/** set the indicated int to the given value */
 	void set_value(int slot, int value) ;
+	/** sets the value of each int to its value in other, which must have the same slots */
+	void set_values(const IntTable& other);
 	/** returns the name associated with the given slot */
 	std::string name(int slot) const;
 	/** returns the slot associated with the given name */
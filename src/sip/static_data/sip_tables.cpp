@@ -103,6 +103,52 @@ bool SipTables::is_served(int array_table_slot) const {
 	return sip::is_sip_consistent_attr(attr);
 }
 
+bool SipTables::is_persistent(int array_table_slot) const {
+	for (int pc = 0; pc < op_table_.size(); ++pc) {
+		opcode_t opcode = op_table_.opcode(pc);
+		if ((opcode == set_persistent_op || opcode == restore_persistent_op)
+				&& op_table_.arg1(pc) == array_table_slot)
+			return true;
+	}
+	return false;
+}
+
+void SipTables::find_written_arrays(std::vector<bool>& written) const {
+	written.assign(num_arrays(), false);
+	for (int pc = 0; pc < op_table_.size(); ++pc) {
+		switch (op_table_.opcode(pc)) {
+		case delete_op:
+			written[op_table_.arg0(pc)] = true;
+			break;
+		case restore_persistent_op:
+			written[op_table_.arg1(pc)] = true;
+			break;
+		case put_accumulate_op:
+		case put_replace_op:
+		case put_initialize_op:
+		case put_increment_op:
+		case put_scale_op: {
+			//The target is selected by a push_block_selector before the put, possibly
+			//followed by the selectors and instructions of the right hand side.  So every
+			//array selected after the previous statement that uses the selector stack is
+			//included.
+			for (int prev = pc - 1; prev >= 0; --prev) {
+				opcode_t opcode = op_table_.opcode(prev);
+				if (opcode == push_block_selector_op) {
+					written[op_table_.arg1(prev)] = true;
+				} else if (opcode == get_op || opcode == sip_barrier_op
+						|| (opcode >= put_accumulate_op && opcode <= put_scale_op)) {
+					break;
+				}
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
 bool SipTables::is_contiguous_local(int array_table_slot) const {
     int attr = array_table_.array_type(array_table_slot);
 	return is_contiguous_local_attr(attr);
@@ -344,6 +390,12 @@ int SipTables::num_segments(int index_table_slot) const {
 int SipTables::num_subsegments(int index_slot, int parent_segment_value) const {return index_table_.num_subsegments(index_slot, parent_segment_value);}
 bool SipTables::is_subindex(int index_table_slot) const {return index_table_.is_subindex(index_table_slot);}
 int SipTables::parent_index(int subindex_slot) const {return index_table_.parent(subindex_slot);}
+int SipTables::segment_extent(int index_table_slot, int segment_value) const {
+	return index_table_.segment_extent(index_table_slot, segment_value);
+}
+int SipTables::index_extent(int index_table_slot) const {
+	return index_table_.index_extent(index_table_slot);
+}
 
 std::ostream& SipTables::print(std::ostream& os) const {
 	os << *this << std::endl;
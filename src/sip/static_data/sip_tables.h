@@ -81,6 +81,12 @@ public:
 	bool is_predefined(int array_table_slot) const;
 	bool is_distributed(int array_table_slot) const;
 	bool is_served(int array_table_slot) const;
+	/** true if the array is the argument of set_persistent or restore_persistent in
+	 * this program, so its blocks are kept between programs */
+	bool is_persistent(int array_table_slot) const;
+	/** Sets written[i] if array i may be modified at the servers in this program: it is
+	 * the target of a put, deleted, or restored.  Conservative, see the implementation. */
+	void find_written_arrays(std::vector<bool>& written) const;
 	bool is_contiguous_local(int array_table_slot) const;
 	int num_arrays() const;
 	size_t num_blocks(int array_id) const { return array_table_.num_blocks(array_id); }
@@ -156,6 +162,10 @@ public:
 	int num_subsegments(int index_slot, int parent_segment_value) const;
 	bool is_subindex(int index_table_slot) const;
 	int parent_index(int subindex_slot) const;
+	/** Number of elements in a segment and in the whole range of an index that is not
+	 * a subindex */
+	int segment_extent(int index_table_slot, int segment_value) const;
+	int index_extent(int index_table_slot) const;
 
 //special instructions
 	const SpecialInstructionManager& special_instruction_manager() const { return special_instruction_manager_ ;}
@@ -170,6 +180,18 @@ public:
 		return op_table_.line_number(pc);
 	}
 
+	opcode_t opcode(int pc) const{
+		return op_table_.opcode(pc);
+	}
+
+	int arg0(int pc) const{
+		return op_table_.arg0(pc);
+	}
+
+	const index_selector_t& index_selectors(int pc) const{
+		return op_table_.index_selectors(pc);
+	}
+
 	std::string opcode_name(int pc) const{
 		if (pc < op_table_.size()) return opcodeToName(op_table_.opcode(pc));
 		//the worker sends the server an end_program instruction with pc = 1 + last pc, which is the op_table_.size()
@@ -177,6 +177,14 @@ void tensor_block_copy__(int&, int&, int*, int*, double*, double*, int&);
  */
 void tensor_block_contract__(int&, int*, double*, int&, int*, double*, int&, int*, double*, int&, int*, int&);
 
+
+/* BLAS dgemm, also used by tensor_block_contract_.
+   C := alpha*op( A )*op( B ) + beta*C
+ */
+void dgemm_(const char* transa, const char* transb, const int* m, const int* n, const int* k,
+		const double* alpha, const double* a, const int* lda, const double* b, const int* ldb,
+		const double* beta, double* c, const int* ldc);
+
 }
 
 
@@ -0,0 +1,582 @@
+/*
+ * contraction_engine.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "contraction_engine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+#include "tensor_ops_c_prototypes.h"
+#include "memory_tracker.h"
+#include "small_gemm.h"
+
+namespace sip {
+
+namespace {
+
+bool perm_trivial(int n, const int* o2n) {
+	for (int j = 1; j <= n; ++j) {
+		if (o2n[j] != j) return false;
+	}
+	return true;
+}
+
+/**
+ * Checks that every index of each operand appears exactly once in the pattern and
+ * that the extents of matching indices agree.  Translated from contr_ptrn_ok in
+ * tensor_block_contract_.
+ */
+bool contraction_pattern_ok(const int* ptrn,
+		int lr, const segment_size_array_t& lshape,
+		int rr, const segment_size_array_t& rshape,
+		int dr, const segment_size_array_t& dshape) {
+	int bus[3 * MAX_RANK];
+	int jl = dr + lr + rr;
+	std::fill(bus + 0, bus + jl, 0);
+	for (int j0 = 1; j0 <= lr; ++j0) {
+		int j1 = ptrn[j0 - 1];
+		if (j1 > 0 && j1 <= dr) { //uncontracted index
+			++bus[j1 - 1];
+			++bus[dr + j0 - 1];
+			if (lshape[j0 - 1] != dshape[j1 - 1]) return false;
+		} else if (j1 < 0 && -j1 <= rr) { //contracted index
+			++bus[dr + lr - j1 - 1];
+			if (lshape[j0 - 1] != rshape[-j1 - 1]) return false;
+		} else {
+			return false;
+		}
+	}
+	for (int j0 = lr + 1; j0 <= lr + rr; ++j0) {
+		int j1 = ptrn[j0 - 1];
+		if (j1 > 0 && j1 <= dr) { //uncontracted index
+			++bus[j1 - 1];
+			++bus[dr + j0 - 1];
+			if (rshape[j0 - lr - 1] != dshape[j1 - 1]) return false;
+		} else if (j1 < 0 && -j1 <= lr) { //contracted index
+			++bus[dr - j1 - 1];
+			if (rshape[j0 - lr - 1] != lshape[-j1 - 1]) return false;
+		} else {
+			return false;
+		}
+	}
+	for (int j = 0; j < jl; ++j) {
+		if (bus[j] != 1) return false;
+	}
+	return true;
+}
+
+/** Possible layouts of the contracted and uncontracted indices of an operand, see group_order */
+const int interleaved = 0;
+const int contracted_first = 1;
+const int contracted_last = 2;
+
+/**
+ * Splits the labels of an operand into its contracted (negative) and uncontracted
+ * (positive) labels and returns whether the contracted labels come first,
+ * last, either (if one of the groups is empty), or are interleaved with the uncontracted ones.
+ */
+int group_order(const std::vector<int>& labels, std::vector<int>& contracted,
+		std::vector<int>& uncontracted) {
+	contracted.clear();
+	uncontracted.clear();
+	int transitions = 0;
+	for (std::size_t i = 0; i < labels.size(); ++i) {
+		bool c = labels[i] < 0;
+		if (c) contracted.push_back(labels[i]);
+		else uncontracted.push_back(labels[i]);
+		if (i > 0 && c != (labels[i - 1] < 0)) ++transitions;
+	}
+	if (transitions > 1) return interleaved;
+	if (transitions == 0) return contracted_first | contracted_last;
+	return labels[0] < 0 ? contracted_first : contracted_last;
+}
+
+}  //anonymous namespace
+
+int ContractionPlan::init(const int* ptrn,
+		int lrank, const segment_size_array_t& lshape,
+		int rrank, const segment_size_array_t& rshape,
+		int drank, const segment_size_array_t& dshape,
+		bool transpose_free) {
+	if (lrank < 0 || lrank > MAX_RANK || rrank < 0 || rrank > MAX_RANK
+			|| drank < 0 || drank > MAX_RANK) {
+		return -1; //invalid tensor ranks
+	}
+	if (!contraction_pattern_ok(ptrn, lrank, lshape, rrank, rshape, drank, dshape)) {
+		return 1;
+	}
+	lrank_ = lrank;
+	rrank_ = rrank;
+	drank_ = drank;
+	std::copy(lshape + 0, lshape + MAX_RANK, lshape_);
+	std::copy(rshape + 0, rshape + MAX_RANK, rshape_);
+	std::fill(lo2n_ + 0, lo2n_ + MAX_RANK + 1, 0);
+	std::fill(ro2n_ + 0, ro2n_ + MAX_RANK + 1, 0);
+	std::fill(do2n_ + 0, do2n_ + MAX_RANK + 1, 0);
+	std::fill(dtp_extents_ + 0, dtp_extents_ + MAX_RANK, 1);
+	lld_ = 1;
+	lrd_ = 1;
+	lcd_ = 1;
+	lo2n_[0] = ro2n_[0] = do2n_[0] = 1;
+
+	//destination operand:  matrix order is the uncontracted indices of l followed by those of r
+	dsize_ = 1;
+	for (int j = 0; j < drank; ++j) dsize_ *= dshape[j];
+	int j1 = 0;
+	for (int j0 = 0; j0 < lrank + rrank; ++j0) {
+		if (ptrn[j0] > 0) do2n_[++j1] = ptrn[j0];
+	}
+	dtransp_ = drank > 0 && !perm_trivial(j1, do2n_);
+	for (int j = 1; j <= drank; ++j) dtp_extents_[j - 1] = dshape[do2n_[j] - 1];
+
+	//right operand:  contracted indices first
+	rsize_ = 1;
+	for (int j = 0; j < rrank; ++j) rsize_ *= rshape[j];
+	j1 = 0;
+	for (int j0 = 1; j0 <= rrank; ++j0) {
+		if (ptrn[lrank + j0 - 1] < 0) {
+			ro2n_[j0] = ++j1;
+			lcd_ *= rshape[j0 - 1];
+		}
+	}
+	for (int j0 = 1; j0 <= rrank; ++j0) {
+		if (ptrn[lrank + j0 - 1] > 0) {
+			ro2n_[j0] = ++j1;
+			lrd_ *= rshape[j0 - 1];
+		}
+	}
+	rtransp_ = rrank > 0 && !perm_trivial(j1, ro2n_);
+
+	//left operand:  contracted indices first, in the order of the corresponding indices of r
+	lsize_ = 1;
+	for (int j = 0; j < lrank; ++j) lsize_ *= lshape[j];
+	std::vector<std::pair<int, int> > contracted; //(position in r, position in l)
+	for (int j0 = 1; j0 <= lrank; ++j0) {
+		if (ptrn[j0 - 1] < 0) contracted.push_back(std::make_pair(-ptrn[j0 - 1], j0));
+	}
+	std::sort(contracted.begin(), contracted.end());
+	j1 = 0;
+	for (std::vector<std::pair<int, int> >::iterator it = contracted.begin();
+			it != contracted.end(); ++it) {
+		lo2n_[it->second] = ++j1;
+	}
+	for (int j0 = 1; j0 <= lrank; ++j0) {
+		if (ptrn[j0 - 1] > 0) {
+			lo2n_[j0] = ++j1;
+			lld_ *= lshape[j0 - 1];
+		}
+	}
+	ltransp_ = lrank > 0 && !perm_trivial(j1, lo2n_);
+
+	if (drank > 0 && lrank > 0 && rrank > 0) kernel_ = gemm_kernel;
+	else if (drank == 0 && lrank > 0 && rrank > 0) kernel_ = dot_kernel;
+	else if (drank > 0 && lrank > 0) kernel_ = scale_left_kernel;
+	else if (drank > 0 && rrank > 0) kernel_ = scale_right_kernel;
+	else kernel_ = scalar_kernel;
+
+	swap_operands_ = false;
+	transa_ = 'T';
+	transb_ = 'N';
+	m_ = static_cast<int>(lld_);
+	n_ = static_cast<int>(lrd_);
+	k_ = static_cast<int>(lcd_);
+	lda_ = k_;
+	ldb_ = k_;
+	ldc_ = m_;
+	batch_count_ = 1;
+	lstride_ = rstride_ = dstride_ = 0;
+	if (transpose_free && kernel_ == gemm_kernel && (ltransp_ || rtransp_ || dtransp_)
+			&& init_strided_gemm(ptrn, rshape, dshape)) {
+		kernel_ = strided_gemm_kernel;
+		ltransp_ = rtransp_ = dtransp_ = false;
+	}
+	std::size_t work = static_cast<std::size_t>(m_) * n_ * k_;
+	small_ = (kernel_ == gemm_kernel || kernel_ == strided_gemm_kernel)
+			&& work <= small_gemm::max_work();
+	return 0;
+}
+
+bool ContractionPlan::init_strided_gemm(const int* ptrn,
+		const segment_size_array_t& rshape, const segment_size_array_t& dshape) {
+	//label the indices.  Uncontracted indices are labeled by their (1-based) position in d,
+	//contracted ones by minus their position in r.
+	std::vector<int> l, r, d;
+	for (int j = 1; j <= drank_; ++j) d.push_back(j);
+	for (int j = 1; j <= lrank_; ++j) l.push_back(ptrn[j - 1]);
+	for (int j = 1; j <= rrank_; ++j) r.push_back(ptrn[lrank_ + j - 1] > 0 ? ptrn[lrank_ + j - 1] : -j);
+
+	std::size_t batch_count = 1;
+	char batch_operand = ' ';
+	std::vector<int> lc, lu, rc, ru;
+	while (true) {
+		int lorder = group_order(l, lc, lu);
+		int rorder = group_order(r, rc, ru);
+		if (lorder != interleaved && rorder != interleaved && lc == rc) {
+			std::size_t u = 1, v = 1, c = 1;
+			for (std::size_t i = 0; i < lu.size(); ++i) u *= dshape[lu[i] - 1];
+			for (std::size_t i = 0; i < ru.size(); ++i) v *= dshape[ru[i] - 1];
+			for (std::size_t i = 0; i < lc.size(); ++i) c *= rshape[-lc[i] - 1];
+			std::vector<int> uv(lu);
+			uv.insert(uv.end(), ru.begin(), ru.end());
+			std::vector<int> vu(ru);
+			vu.insert(vu.end(), lu.begin(), lu.end());
+			bool found = true;
+			if (d == uv) {  //d(u,v) = l(u,c) * r(c,v)
+				swap_operands_ = false;
+				m_ = static_cast<int>(u);
+				n_ = static_cast<int>(v);
+				if (lorder & contracted_last) { transa_ = 'N'; lda_ = static_cast<int>(u); }
+				else { transa_ = 'T'; lda_ = static_cast<int>(c); }
+				if (rorder & contracted_first) { transb_ = 'N'; ldb_ = static_cast<int>(c); }
+				else { transb_ = 'T'; ldb_ = static_cast<int>(v); }
+			} else if (d == vu) {  //d(v,u) = r(v,c) * l(c,u)
+				swap_operands_ = true;
+				m_ = static_cast<int>(v);
+				n_ = static_cast<int>(u);
+				if (rorder & contracted_last) { transa_ = 'N'; lda_ = static_cast<int>(v); }
+				else { transa_ = 'T'; lda_ = static_cast<int>(c); }
+				if (lorder & contracted_first) { transb_ = 'N'; ldb_ = static_cast<int>(c); }
+				else { transb_ = 'T'; ldb_ = static_cast<int>(u); }
+			} else {
+				found = false;
+			}
+			if (found) {
+				k_ = static_cast<int>(c);
+				ldc_ = m_;
+				batch_count_ = batch_count;
+				lstride_ = batch_operand == 'l' ? u * c : 0;
+				rstride_ = batch_operand == 'r' ? v * c : 0;
+				dstride_ = u * v;
+				return true;
+			}
+		}
+		//move the slowest index of d into the batch, if it is also the slowest index
+		//of the operand already contributing to the batch
+		if (d.empty()) return false;
+		int last = d.back();
+		if (batch_operand != 'r' && !l.empty() && l.back() == last) {
+			batch_operand = 'l';
+			l.pop_back();
+		} else if (batch_operand != 'l' && !r.empty() && r.back() == last) {
+			batch_operand = 'r';
+			r.pop_back();
+		} else {
+			return false;
+		}
+		d.pop_back();
+		batch_count *= dshape[last - 1];
+	}
+}
+
+std::ostream& operator<<(std::ostream& os, const ContractionPlan& obj) {
+	os << "ranks (l,r,d)=" << obj.lrank_ << ',' << obj.rrank_ << ',' << obj.drank_;
+	os << " matrix dims (l,r,c)=" << obj.lld_ << ',' << obj.lrd_ << ',' << obj.lcd_;
+	os << " transpose (l,r,d)=" << obj.ltransp_ << ',' << obj.rtransp_ << ',' << obj.dtransp_;
+	os << " kernel=" << obj.kernel_;
+	if (obj.kernel_ == ContractionPlan::strided_gemm_kernel) {
+		os << " gemm (m,n,k)=" << obj.m_ << ',' << obj.n_ << ',' << obj.k_;
+		os << " trans=" << obj.transa_ << obj.transb_ << " swap=" << obj.swap_operands_;
+		os << " batch_count=" << obj.batch_count_;
+	}
+	os << " small=" << obj.small_;
+	return os;
+}
+
+
+ContractionShapes::ContractionShapes(int lrank, const segment_size_array_t& lshape,
+		int rrank, const segment_size_array_t& rshape,
+		int drank, const segment_size_array_t& dshape) {
+	std::fill(lshape_ + 0, lshape_ + MAX_RANK, 1);
+	std::fill(rshape_ + 0, rshape_ + MAX_RANK, 1);
+	std::fill(dshape_ + 0, dshape_ + MAX_RANK, 1);
+	std::copy(lshape + 0, lshape + lrank, lshape_);
+	std::copy(rshape + 0, rshape + rrank, rshape_);
+	std::copy(dshape + 0, dshape + drank, dshape_);
+}
+
+bool ContractionShapes::operator<(const ContractionShapes& rhs) const {
+	for (int i = 0; i < MAX_RANK; ++i) {
+		if (lshape_[i] != rhs.lshape_[i]) return lshape_[i] < rhs.lshape_[i];
+	}
+	for (int i = 0; i < MAX_RANK; ++i) {
+		if (rshape_[i] != rhs.rshape_[i]) return rshape_[i] < rhs.rshape_[i];
+	}
+	for (int i = 0; i < MAX_RANK; ++i) {
+		if (dshape_[i] != rhs.dshape_[i]) return dshape_[i] < rhs.dshape_[i];
+	}
+	return false;
+}
+
+bool ContractionShapes::operator==(const ContractionShapes& rhs) const {
+	return std::equal(lshape_ + 0, lshape_ + MAX_RANK, rhs.lshape_)
+			&& std::equal(rshape_ + 0, rshape_ + MAX_RANK, rhs.rshape_)
+			&& std::equal(dshape_ + 0, dshape_ + MAX_RANK, rhs.dshape_);
+}
+
+
+const std::size_t ContractionPlanCache::MAX_PLANS_PER_PC;
+
+ContractionPlanCache::ContractionPlanCache(std::size_t num_pcs) :
+		plans_(num_pcs, NULL), last_used_(num_pcs, NULL), hits_(num_pcs, 0),
+		misses_(num_pcs, 0) {
+}
+
+ContractionPlanCache::~ContractionPlanCache() {
+	for (std::vector<PerPcPlans*>::iterator it = plans_.begin(); it != plans_.end(); ++it) {
+		delete *it;
+	}
+}
+
+const ContractionPlan* ContractionPlanCache::find(int pc, const ContractionShapes& shapes) {
+	PerPcPlans::value_type* last = last_used_[pc];
+	if (last != NULL && last->first == shapes) {
+		++hits_[pc];
+		return &last->second;
+	}
+	PerPcPlans* plans = plans_[pc];
+	if (plans != NULL) {
+		PerPcPlans::iterator it = plans->find(shapes);
+		if (it != plans->end()) {
+			++hits_[pc];
+			last_used_[pc] = &*it;
+			return &it->second;
+		}
+	}
+	++misses_[pc];
+	return NULL;
+}
+
+const ContractionPlan* ContractionPlanCache::insert(int pc, const ContractionShapes& shapes,
+		const ContractionPlan& plan) {
+	PerPcPlans*& plans = plans_[pc];
+	if (plans == NULL) {
+		plans = new PerPcPlans();
+	} else if (plans->size() >= MAX_PLANS_PER_PC) {
+		plans->clear();
+	}
+	PerPcPlans::value_type* entry = &*(plans->insert(std::make_pair(shapes, plan)).first);
+	last_used_[pc] = entry;
+	return &entry->second;
+}
+
+
+ContractionWorkspace::~ContractionWorkspace() {
+	if (data_ != NULL) {
+		delete[] data_;
+		MemoryTracker::global->dec_allocated(capacity_);
+	}
+}
+
+double* ContractionWorkspace::reserve(std::size_t size) {
+	if (size <= capacity_) return data_;
+	if (data_ != NULL) {
+		delete[] data_;
+		MemoryTracker::global->dec_allocated(capacity_);
+		data_ = NULL;
+		capacity_ = 0;
+	}
+	try {
+		data_ = new double[size];
+	} catch (const std::bad_alloc& ba) {
+		std::cerr << "Not enough memory in ContractionWorkspace::reserve" << std::endl << std::flush;
+		throw ba;
+	}
+	MemoryTracker::global->inc_allocated(size);
+	capacity_ = size;
+	++num_allocations_;
+	return data_;
+}
+
+
+ContractionEngine::ContractionEngine(std::size_t num_pcs) :
+		workspaces_(std::max(1, sip::MAX_OMP_THREADS), static_cast<Workspaces*>(NULL)),
+		plan_cache_(num_pcs),
+		num_contractions_(0),
+		num_small_contractions_(0),
+#ifdef HAVE_MPI
+		stats_(SIPMPIAttr::get_instance().company_communicator(), num_pcs)
+#else
+		stats_(num_pcs)
+#endif //HAVE_MPI
+{
+#ifdef _OPENMP
+	omp_init_lock(&lock_);
+#endif //_OPENMP
+}
+
+ContractionEngine::~ContractionEngine() {
+	for (std::vector<Workspaces*>::iterator it = workspaces_.begin(); it != workspaces_.end(); ++it) {
+		delete *it;
+	}
+#ifdef _OPENMP
+	omp_destroy_lock(&lock_);
+#endif //_OPENMP
+}
+
+ContractionEngine::Workspaces& ContractionEngine::workspaces() {
+#ifdef _OPENMP
+	int thread = omp_get_thread_num();
+#else
+	int thread = 0;
+#endif //_OPENMP
+	Workspaces*& w = workspaces_[thread];
+	if (w == NULL) w = new Workspaces();
+	return *w;
+}
+
+bool ContractionEngine::find_plan(int pc, const ContractionShapes& shapes,
+		ContractionPlan& plan) {
+#ifdef _OPENMP
+	omp_set_lock(&lock_);
+#endif //_OPENMP
+	const ContractionPlan* cached = plan_cache_.find(pc, shapes);
+	if (cached != NULL) plan = *cached;
+#ifdef _OPENMP
+	omp_unset_lock(&lock_);
+#endif //_OPENMP
+	return cached != NULL;
+}
+
+int ContractionEngine::make_plan(int pc, const ContractionShapes& shapes,
+		const int* contraction_pattern, int lrank, int rrank, int drank,
+		ContractionPlan& plan) {
+	int ierr = plan.init(contraction_pattern, lrank, shapes.lshape_, rrank, shapes.rshape_,
+			drank, shapes.dshape_);
+	if (ierr != 0) return ierr;
+#ifdef _OPENMP
+	omp_set_lock(&lock_);
+#endif //_OPENMP
+	plan_cache_.insert(pc, shapes, plan);
+#ifdef _OPENMP
+	omp_unset_lock(&lock_);
+#endif //_OPENMP
+	return 0;
+}
+
+int ContractionEngine::contract(const int* contraction_pattern,
+		double* ldata, int lrank, const segment_size_array_t& lshape,
+		double* rdata, int rrank, const segment_size_array_t& rshape,
+		double* ddata, int drank, const segment_size_array_t& dshape) {
+	ContractionPlan plan;
+	int ierr = plan.init(contraction_pattern, lrank, lshape, rrank, rshape, drank, dshape);
+	if (ierr != 0) return ierr;
+	return contract(plan, ldata, rdata, ddata);
+}
+
+int ContractionEngine::contract(const ContractionPlan& plan, double* ldata,
+		double* rdata, double* ddata) {
+	int ierr = 0;
+	int nthreads = plan.small_ ? 1 : sip::MAX_OMP_THREADS;
+#pragma omp atomic
+	++num_contractions_;
+	if (plan.small_) {
+#pragma omp atomic
+		++num_small_contractions_;
+	}
+	Workspaces& w = workspaces();
+
+	//transpose the operands, if needed
+	double* ltp = ldata;
+	if (plan.ltransp_) {
+		ltp = w.left_.reserve(plan.lsize_);
+		int rank = plan.lrank_;
+		segment_size_array_t extents;
+		std::copy(plan.lshape_ + 0, plan.lshape_ + MAX_RANK, extents);
+		int o2n[MAX_RANK + 1];
+		std::copy(plan.lo2n_ + 0, plan.lo2n_ + MAX_RANK + 1, o2n);
+		tensor_block_copy__(nthreads, rank, extents, o2n, ldata, ltp, ierr);
+		if (ierr != 0) return ierr;
+	}
+	double* rtp = rdata;
+	if (plan.rtransp_) {
+		rtp = w.right_.reserve(plan.rsize_);
+		int rank = plan.rrank_;
+		segment_size_array_t extents;
+		std::copy(plan.rshape_ + 0, plan.rshape_ + MAX_RANK, extents);
+		int o2n[MAX_RANK + 1];
+		std::copy(plan.ro2n_ + 0, plan.ro2n_ + MAX_RANK + 1, o2n);
+		tensor_block_copy__(nthreads, rank, extents, o2n, rdata, rtp, ierr);
+		if (ierr != 0) return ierr;
+	}
+	double* dtp = plan.dtransp_ ? w.dest_.reserve(plan.dsize_) : ddata;
+
+	//multiply.  Like tensor_block_contract_, the destination is overwritten, not accumulated.
+	switch (plan.kernel_) {
+	case ContractionPlan::gemm_kernel: {
+		int m = static_cast<int>(plan.lld_);
+		int n = static_cast<int>(plan.lrd_);
+		int k = static_cast<int>(plan.lcd_);
+		if (plan.small_) {
+			small_gemm::gemm('T', 'N', m, n, k, ltp, k, rtp, k, dtp, m);
+			break;
+		}
+		double alpha = 1.0;
+		double beta = 0.0;
+		dgemm_("T", "N", &m, &n, &k, &alpha, ltp, &k, rtp, &k, &beta, dtp, &m);
+		break;
+	}
+	case ContractionPlan::dot_kernel: {
+		double val = 0.0;
+		for (std::size_t i = 0; i < plan.lcd_; ++i) val += ltp[i] * rtp[i];
+		dtp[0] = val;
+		break;
+	}
+	case ContractionPlan::scale_left_kernel: {
+		double scalar = rtp[0];
+		for (std::size_t i = 0; i < plan.dsize_; ++i) dtp[i] = ltp[i] * scalar;
+		break;
+	}
+	case ContractionPlan::scale_right_kernel: {
+		double scalar = ltp[0];
+		for (std::size_t i = 0; i < plan.dsize_; ++i) dtp[i] = rtp[i] * scalar;
+		break;
+	}
+	case ContractionPlan::scalar_kernel:
+		dtp[0] = ltp[0] * rtp[0];
+		break;
+	case ContractionPlan::strided_gemm_kernel: {
+		double alpha = 1.0;
+		double beta = 0.0;
+		char transa = plan.transa_;
+		char transb = plan.transb_;
+		double* a = plan.swap_operands_ ? rdata : ldata;
+		double* b = plan.swap_operands_ ? ldata : rdata;
+		std::size_t astride = plan.swap_operands_ ? plan.rstride_ : plan.lstride_;
+		std::size_t bstride = plan.swap_operands_ ? plan.lstride_ : plan.rstride_;
+		if (plan.small_) {
+			for (std::size_t i = 0; i < plan.batch_count_; ++i) {
+				small_gemm::gemm(transa, transb, plan.m_, plan.n_, plan.k_,
+						a + i * astride, plan.lda_, b + i * bstride, plan.ldb_,
+						ddata + i * plan.dstride_, plan.ldc_);
+			}
+			break;
+		}
+		for (std::size_t i = 0; i < plan.batch_count_; ++i) {
+			dgemm_(&transa, &transb, &plan.m_, &plan.n_, &plan.k_, &alpha,
+					a + i * astride, &plan.lda_, b + i * bstride, &plan.ldb_, &beta,
+					ddata + i * plan.dstride_, &plan.ldc_);
+		}
+		break;
+	}
+	}
+
+	//transpose the matrix result into the destination block
+	if (plan.dtransp_) {
+		int rank = plan.drank_;
+		segment_size_array_t extents;
+		std::copy(plan.dtp_extents_ + 0, plan.dtp_extents_ + MAX_RANK, extents);
+		int o2n[MAX_RANK + 1];
+		std::copy(plan.do2n_ + 0, plan.do2n_ + MAX_RANK + 1, o2n);
+		tensor_block_copy__(nthreads, rank, extents, o2n, dtp, ddata, ierr);
+	}
+	return ierr;
+}
+
+} /* namespace sip */
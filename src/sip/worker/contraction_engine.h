@@ -0,0 +1,386 @@
+/*
+ * contraction_engine.h
+ *
+ * Block contraction  d = l * r  done on the C++ side of the tensor library.
+ *
+ * This follows the algorithm in tensor_block_contract_ (tensor_dil_omp.F90):  the operands
+ * are transposed so that the contraction becomes a single matrix multiply, dgemm is
+ * called, and the result is transposed into the destination block.   The difference is
+ * that the buffers holding the transposed operands are not allocated and freed on every call.
+ * Instead, the engine owns a workspace for each of the three operands that grows to the largest
+ * size requested and is then reused by all subsequent contractions.
+ *
+ * The worker's interpreter owns one ContractionEngine, which is shared with the threads of
+ * a threaded pardo.  Each OpenMP thread has its own workspaces, and plans are copied out of
+ * the plan cache while holding a lock, so they stay valid when another thread's plan
+ * replaces them in the cache.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef CONTRACTION_ENGINE_H_
+#define CONTRACTION_ENGINE_H_
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "counter.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#endif //HAVE_MPI
+
+namespace sip {
+
+/**
+ * Everything about a contraction that depends only on the contraction pattern and
+ * the shapes of the operands.
+ *
+ * The permutations use the convention expected by tensor_block_copy__:  element 0 is +1 and
+ * elements 1..rank give the (fortran, 1-based) new position of each old index.
+ */
+struct ContractionPlan {
+	/** Identifies the code that multiplies the (transposed) operands */
+	enum Kernel {
+		gemm_kernel,          //d(l,r) = l(c,l)^T * r(c,r)
+		dot_kernel,           //scalar d = l(c) . r(c)
+		scale_left_kernel,    //d = l * scalar r
+		scale_right_kernel,   //d = scalar l * r
+		scalar_kernel,        //scalar d = scalar l * scalar r
+		strided_gemm_kernel   //loop of gemms on the untransposed operands, see init_strided_gemm
+	};
+
+	int lrank_;
+	int rrank_;
+	int drank_;
+	segment_size_array_t lshape_;
+	segment_size_array_t rshape_;
+	int lo2n_[MAX_RANK + 1];
+	int ro2n_[MAX_RANK + 1];
+	int do2n_[MAX_RANK + 1];
+	bool ltransp_;
+	bool rtransp_;
+	bool dtransp_;
+	std::size_t lsize_;
+	std::size_t rsize_;
+	std::size_t dsize_;
+	std::size_t lld_; //number of rows of the left matrix  (product of uncontracted extents of l)
+	std::size_t lrd_; //number of columns of the right matrix (product of uncontracted extents of r)
+	std::size_t lcd_; //contracted dimension (product of contracted extents)
+	segment_size_array_t dtp_extents_;  //extents of the destination block in matrix order
+	Kernel kernel_;
+
+	//parameters of the strided_gemm_kernel.  a and b are the first and second
+	//gemm operands;  if swap_operands_, a is r and b is l.
+	bool swap_operands_;
+	char transa_;
+	char transb_;
+	int m_;
+	int n_;
+	int k_;
+	int lda_;
+	int ldb_;
+	int ldc_;
+	std::size_t batch_count_;
+	std::size_t lstride_;  //offset between consecutive sub-matrices of l
+	std::size_t rstride_;
+	std::size_t dstride_;
+
+	//if true, the matrix multiplies use small_gemm::gemm instead of dgemm_ and the
+	//transposes, if any, are done on a single thread.  See small_gemm.h
+	bool small_;
+
+	/**
+	 * Initializes the plan.  Returns 0 on success, and the error code that tensor_block_contract__
+	 * would have returned otherwise.
+	 *
+	 * @param contraction_pattern  pattern in the format returned by get_contraction_ptrn_
+	 * @param transpose_free  if true and possible, use the strided_gemm_kernel instead of transposing
+	 */
+	int init(const int* contraction_pattern,
+			int lrank, const segment_size_array_t& lshape,
+			int rrank, const segment_size_array_t& rshape,
+			int drank, const segment_size_array_t& dshape,
+			bool transpose_free = true);
+
+	/**
+	 * Tries to express a contraction that would need a transpose as a loop of gemms
+	 * on the operands as they are.
+	 *
+	 * This works when, after removing a trailing group of uncontracted indices that is
+	 * trailing in both d and one of the operands, the contracted indices appear in the same
+	 * order and as a leading or trailing group in l and r, and the uncontracted indices of
+	 * each operand form a leading or trailing group of d in the same order.   Each gemm then
+	 * works on a contiguous sub-matrix of each operand, with transa and transb chosen to
+	 * match the layout, and the trailing group is looped over.
+	 *
+	 * Returns true, and sets the strided gemm parameters, if the contraction has this form.
+	 */
+	bool init_strided_gemm(const int* contraction_pattern,
+			const segment_size_array_t& rshape, const segment_size_array_t& dshape);
+
+	friend std::ostream& operator<<(std::ostream& os, const ContractionPlan& obj);
+};
+
+
+/**
+ * The operand shapes of one contraction, used as the key of the ContractionPlanCache.
+ * Extents beyond the rank of an operand are set to 1.
+ */
+struct ContractionShapes {
+	segment_size_array_t lshape_;
+	segment_size_array_t rshape_;
+	segment_size_array_t dshape_;
+
+	ContractionShapes(int lrank, const segment_size_array_t& lshape,
+			int rrank, const segment_size_array_t& rshape,
+			int drank, const segment_size_array_t& dshape);
+
+	bool operator<(const ContractionShapes& rhs) const;
+	bool operator==(const ContractionShapes& rhs) const;
+};
+
+
+/**
+ * Caches ContractionPlans by pc and operand shapes.
+ *
+ * For a given pc, the index ids of all three operands, and thus the contraction pattern,
+ * are fixed, so the plan only depends on the segment sizes of the blocks.  A SIAL
+ * line typically executes with a small number of distinct shapes, and usually with
+ * the same shape as the previous time, which is checked before the map.
+ */
+class ContractionPlanCache {
+public:
+	explicit ContractionPlanCache(std::size_t num_pcs);
+	~ContractionPlanCache();
+
+	/** Returns the cached plan, or NULL.  Updates the hit and miss counts for pc */
+	const ContractionPlan* find(int pc, const ContractionShapes& shapes);
+
+	/** Adds the plan to the cache and returns a pointer to the cached copy */
+	const ContractionPlan* insert(int pc, const ContractionShapes& shapes,
+			const ContractionPlan& plan);
+
+	std::size_t num_pcs() const { return hits_.size(); }
+	std::size_t hits(int pc) const { return hits_[pc]; }
+	std::size_t misses(int pc) const { return misses_[pc]; }
+
+	/** Upper bound on the number of plans kept for a single pc.  The plans for a pc are
+	 * discarded when it is exceeded. */
+	static const std::size_t MAX_PLANS_PER_PC = 1024;
+
+private:
+	typedef std::map<ContractionShapes, ContractionPlan> PerPcPlans;
+	std::vector<PerPcPlans*> plans_;
+	std::vector<PerPcPlans::value_type*> last_used_;
+	std::vector<std::size_t> hits_;
+	std::vector<std::size_t> misses_;
+
+	DISALLOW_COPY_AND_ASSIGN(ContractionPlanCache);
+};
+
+
+/**
+ * A buffer of doubles that is only reallocated when a larger size is requested.
+ * Memory held by the workspace is reported to the MemoryTracker.
+ */
+class ContractionWorkspace {
+public:
+	ContractionWorkspace() : data_(NULL), capacity_(0), num_allocations_(0) {}
+	~ContractionWorkspace();
+
+	/** returns a buffer that can hold at least size doubles.  The contents are undefined. */
+	double* reserve(std::size_t size);
+
+	std::size_t capacity() const { return capacity_; }
+	std::size_t num_allocations() const { return num_allocations_; }
+
+private:
+	double* data_;
+	std::size_t capacity_;
+	std::size_t num_allocations_;
+	DISALLOW_COPY_AND_ASSIGN(ContractionWorkspace);
+};
+
+
+class ContractionEngine {
+public:
+	/** @param num_pcs  size of the op table, used to size the plan cache */
+	explicit ContractionEngine(std::size_t num_pcs);
+	~ContractionEngine();
+
+	/** Copies the cached plan for the contraction at pc with the given shapes to plan.
+	 * Returns false if there is none. */
+	bool find_plan(int pc, const ContractionShapes& shapes, ContractionPlan& plan);
+
+	/**
+	 * Initializes plan for the contraction at pc with the given shapes and caches it.
+	 * Returns the error code of ContractionPlan::init, and caches nothing if it is not 0.
+	 */
+	int make_plan(int pc, const ContractionShapes& shapes, const int* contraction_pattern,
+			int lrank, int rrank, int drank, ContractionPlan& plan);
+
+	/**
+	 * Computes d = l * r.  The contents of d are overwritten.
+	 *
+	 * @param contraction_pattern  pattern in the format returned by get_contraction_ptrn_
+	 * @return 0 on success, otherwise the error code tensor_block_contract__ would have returned.
+	 */
+	int contract(const int* contraction_pattern,
+			double* ldata, int lrank, const segment_size_array_t& lshape,
+			double* rdata, int rrank, const segment_size_array_t& rshape,
+			double* ddata, int drank, const segment_size_array_t& dshape);
+
+	/** Computes d = l * r with a plan that has already been initialized for these shapes. */
+	int contract(const ContractionPlan& plan, double* ldata, double* rdata, double* ddata);
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os, const SipTables& sip_tables) {
+		stats_.gather_and_print_statistics(os, this, sip_tables);
+	}
+
+	std::size_t num_contractions() const { return num_contractions_; }
+	std::size_t num_small_contractions() const { return num_small_contractions_; }
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * Workspaces never shrink, so their capacities are the high water marks.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_contractions_;
+		MPICounter num_workspace_allocations_;
+		MPICounter num_small_contractions_;
+		MPICounter left_workspace_doubles_;
+		MPICounter right_workspace_doubles_;
+		MPICounter dest_workspace_doubles_;
+		MPICounterList plan_cache_hits_;
+		MPICounterList plan_cache_misses_;
+
+		Stats(const MPI_Comm& comm, std::size_t num_pcs) :
+				num_contractions_(comm), num_workspace_allocations_(comm),
+				num_small_contractions_(comm),
+				left_workspace_doubles_(comm), right_workspace_doubles_(comm),
+				dest_workspace_doubles_(comm), plan_cache_hits_(comm, num_pcs),
+				plan_cache_misses_(comm, num_pcs) {
+		}
+
+		void finalize(ContractionEngine* parent) {
+			num_contractions_.inc(parent->num_contractions_);
+			num_small_contractions_.inc(parent->num_small_contractions_);
+			for (std::size_t t = 0; t < parent->workspaces_.size(); ++t) {
+				const Workspaces* w = parent->workspaces_[t];
+				if (w == NULL) continue;
+				num_workspace_allocations_.inc(w->left_.num_allocations()
+						+ w->right_.num_allocations() + w->dest_.num_allocations());
+				left_workspace_doubles_.inc(w->left_.capacity());
+				right_workspace_doubles_.inc(w->right_.capacity());
+				dest_workspace_doubles_.inc(w->dest_.capacity());
+			}
+			for (std::size_t pc = 0; pc < parent->plan_cache_.num_pcs(); ++pc) {
+				plan_cache_hits_.inc(pc, parent->plan_cache_.hits(pc));
+				plan_cache_misses_.inc(pc, parent->plan_cache_.misses(pc));
+			}
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, ContractionEngine* parent,
+				const SipTables& sip_tables) {
+			finalize(parent);
+			plan_cache_hits_.reduce();
+			plan_cache_misses_.reduce();
+			num_contractions_.gather();
+			num_workspace_allocations_.gather();
+			num_small_contractions_.gather();
+			left_workspace_doubles_.gather();
+			right_workspace_doubles_.gather();
+			dest_workspace_doubles_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker contraction engine" << std::endl;
+				os << "num_contractions_" << std::endl << num_contractions_;
+				os << "num_workspace_allocations_" << std::endl << num_workspace_allocations_;
+				os << "num_small_contractions_" << std::endl << num_small_contractions_;
+				os << "left_workspace_doubles_" << std::endl << left_workspace_doubles_;
+				os << "right_workspace_doubles_" << std::endl << right_workspace_doubles_;
+				os << "dest_workspace_doubles_" << std::endl << dest_workspace_doubles_;
+				os << std::endl;
+				os << "Worker contraction plan_cache_hits_" << std::endl;
+				plan_cache_hits_.print_op_table_stats(os, sip_tables);
+				os << "Worker contraction plan_cache_misses_" << std::endl;
+				plan_cache_misses_.print_op_table_stats(os, sip_tables);
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		explicit Stats(std::size_t num_pcs) {}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, ContractionEngine* parent,
+				const SipTables& sip_tables) {
+			os << "Worker contraction engine" << std::endl;
+			os << "num_contractions_," << parent->num_contractions_ << std::endl;
+			os << "num_small_contractions_," << parent->num_small_contractions_ << std::endl;
+			std::size_t left = 0, right = 0, dest = 0;
+			for (std::size_t t = 0; t < parent->workspaces_.size(); ++t) {
+				const Workspaces* w = parent->workspaces_[t];
+				if (w == NULL) continue;
+				left += w->left_.capacity();
+				right += w->right_.capacity();
+				dest += w->dest_.capacity();
+			}
+			os << "left_workspace_doubles_," << left << std::endl;
+			os << "right_workspace_doubles_," << right << std::endl;
+			os << "dest_workspace_doubles_," << dest << std::endl;
+			os << std::endl;
+			os << "Worker contraction plan cache" << std::endl;
+			os << "pc, line number, opcode, hits, misses" << std::endl;
+			for (std::size_t pc = 0; pc < parent->plan_cache_.num_pcs(); ++pc) {
+				std::size_t hits = parent->plan_cache_.hits(pc);
+				std::size_t misses = parent->plan_cache_.misses(pc);
+				if (hits + misses > 0) {
+					os << pc << ',' << sip_tables.line_number(pc) << ','
+							<< sip_tables.opcode_name(pc) << ',' << hits << ','
+							<< misses << std::endl;
+				}
+			}
+			os << std::endl;
+			return os;
+		}
+	};
+#endif //HAVE_MPI
+
+private:
+	/** The workspaces of one thread */
+	struct Workspaces {
+		ContractionWorkspace left_;
+		ContractionWorkspace right_;
+		ContractionWorkspace dest_;
+	};
+
+	/** The workspaces of the calling thread, created when first needed */
+	Workspaces& workspaces();
+
+	std::vector<Workspaces*> workspaces_;  /*! indexed by OpenMP thread number */
+	ContractionPlanCache plan_cache_;
+#ifdef _OPENMP
+	omp_lock_t lock_;  /*! protects plan_cache_ */
+#endif //_OPENMP
+	std::size_t num_contractions_;
+	std::size_t num_small_contractions_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(ContractionEngine);
+};
+
+} /* namespace sip */
+
+#endif /* CONTRACTION_ENGINE_H_ */
@@ -99,11 +99,12 @@ bool FragmentPardoLoopManager::increment_all() {
 	return more;
 }
 
+Block::BlockPtr FragmentPardoLoopManager::static_array(const std::string& name) {
+	return Interpreter::global_interpreter->get_static(sip_tables_.array_slot(name));
+}
+
 void FragmentPardoLoopManager::form_rcut_dist() {
-	int rcut_dist_array_slot = sip_tables_.array_slot(std::string("rcut_dist"));
-	Block::BlockPtr bptr_rcut_dist =
-			data_manager_.contiguous_array_manager().get_array(
-					rcut_dist_array_slot);
+	Block::BlockPtr bptr_rcut_dist = static_array("rcut_dist");
 	double *val_rcut_dist = bptr_rcut_dist->get_data();
 	int rcut_dist_size = bptr_rcut_dist->size();
 	int num_frag = upper_bound_[0] - lower_seg_[0];
@@ -124,10 +125,7 @@ void FragmentPardoLoopManager::form_rcut_dist() {
 }
 
 void FragmentPardoLoopManager::form_elst_dist() {
-	int elst_dist_array_slot = sip_tables_.array_slot(std::string("elst_dist"));
-	Block::BlockPtr bptr_elst_dist =
-			data_manager_.contiguous_array_manager().get_array(
-					elst_dist_array_slot);
+	Block::BlockPtr bptr_elst_dist = static_array("elst_dist");
 	double *val_elst_dist = bptr_elst_dist->get_data();
 	int elst_dist_size = bptr_elst_dist->size();
 	int num_frag = upper_bound_[0] - lower_seg_[0];
@@ -148,10 +146,7 @@ void FragmentPardoLoopManager::form_elst_dist() {
 }
 
 void FragmentPardoLoopManager::form_swao_frag() {
-	int swao_frag_array_slot = sip_tables_.array_slot(std::string("swao_frag"));
-	Block::BlockPtr bptr_swao_frag =
-			data_manager_.contiguous_array_manager().get_array(
-					swao_frag_array_slot);
+	Block::BlockPtr bptr_swao_frag = static_array("swao_frag");
 	double *val_swao_frag = bptr_swao_frag->get_data();
 	int swao_frag_size = bptr_swao_frag->size();
 	swao_frag.resize(swao_frag_size);
@@ -164,10 +159,7 @@ void FragmentPardoLoopManager::form_swao_frag() {
     
     
     void FragmentPardoLoopManager::form_swmoa_frag() {
-        int swmoa_frag_array_slot = sip_tables_.array_slot(std::string("swmoa_frag"));
-        Block::BlockPtr bptr_swmoa_frag =
-        data_manager_.contiguous_array_manager().get_array(
-                                                           swmoa_frag_array_slot);
+        Block::BlockPtr bptr_swmoa_frag = static_array("swmoa_frag");
         double *val_swmoa_frag = bptr_swmoa_frag->get_data();
         int swmoa_frag_size = bptr_swmoa_frag->size();
         swmoa_frag.resize(swmoa_frag_size);
@@ -179,11 +171,7 @@ void FragmentPardoLoopManager::form_swao_frag() {
     }
 
 void FragmentPardoLoopManager::form_swocca_frag() {
-	int swocca_frag_array_slot = sip_tables_.array_slot(
-			std::string("swocca_frag"));
-	Block::BlockPtr bptr_swocca_frag =
-			data_manager_.contiguous_array_manager().get_array(
-					swocca_frag_array_slot);
+	Block::BlockPtr bptr_swocca_frag = static_array("swocca_frag");
 	double *val_swocca_frag = bptr_swocca_frag->get_data();
 	int swocca_frag_size = bptr_swocca_frag->size();
 	swocca_frag.resize(swocca_frag_size);
@@ -195,11 +183,7 @@ void FragmentPardoLoopManager::form_swocca_frag() {
 }
 
 void FragmentPardoLoopManager::form_swvirta_frag() {
-	int swvirta_frag_array_slot = sip_tables_.array_slot(
-			std::string("swvirta_frag"));
-	Block::BlockPtr bptr_swvirta_frag =
-			data_manager_.contiguous_array_manager().get_array(
-					swvirta_frag_array_slot);
+	Block::BlockPtr bptr_swvirta_frag = static_array("swvirta_frag");
 	double *val_swvirta_frag = bptr_swvirta_frag->get_data();
 	int swvirta_frag_size = bptr_swvirta_frag->size();
 	swvirta_frag.resize(swvirta_frag_size);
@@ -269,6 +253,11 @@ bool FragmentPardoLoopManager::fragment_special_where_clause(int typ, int index,
 	return where_clause;
 }
 
+bool FragmentPardoLoopManager::do_may_enumerate() const {
+	//the fragment where clauses have not been checked for use by threads
+	return false;
+}
+
 std::string FragmentPardoLoopManager::to_string() const {
 	std::stringstream ss;
 	ss << "Balanced Task Allocation Parallel Pardo Loop:  num_indices="
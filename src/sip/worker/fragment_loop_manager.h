@@ -32,6 +32,7 @@ protected:
 
 	virtual std::string to_string() const;
 	virtual void do_finalize();
+	virtual bool do_may_enumerate() const;
 
 	DataManager & data_manager_;
 	const SipTables & sip_tables_;
@@ -46,6 +47,9 @@ protected:
 	bool increment_single_index(int index);
 	bool increment_all();
 
+	/** Returns the static array with the given name, completing its broadcast if pending */
+	Block::BlockPtr static_array(const std::string& name);
+
 	void form_rcut_dist();
 	void form_elst_dist();
 	void form_swao_frag();
@@ -0,0 +1,273 @@
+/*
+ * fused_block_ops.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "fused_block_ops.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <sys/time.h>
+#include "op_table.h"
+#include "sip_tables.h"
+#include "block_kernels.h"
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif //HAVE_MPI
+
+namespace sip {
+
+namespace {
+
+double wall_time() {
+#ifdef HAVE_MPI
+	return MPI_Wtime();
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+#endif //HAVE_MPI
+}
+
+/** true if the instructions at the two pcs have the same lhs block selector */
+bool same_lhs(const OpTable& op_table, int pc0, int pc1) {
+	if (op_table.arg0(pc0) != op_table.arg0(pc1)
+			|| op_table.arg1(pc0) != op_table.arg1(pc1))
+		return false;
+	const index_selector_t& s0 = op_table.index_selectors(pc0);
+	const index_selector_t& s1 = op_table.index_selectors(pc1);
+	return std::equal(s0 + 0, s0 + MAX_RANK, s1 + 0);
+}
+
+}  //anonymous namespace
+
+const std::size_t FusedBlockOps::TILE_SIZE;
+
+FusedBlockOps::FusedBlockOps(const OpTable& op_table) :
+		run_end_(op_table.size(), -1),
+		num_runs_(0),
+		run_start_(-1),
+		current_run_end_(-1),
+		dest_(NULL),
+		size_(0),
+		executions_(op_table.size(), 0),
+		fused_ops_(op_table.size(), 0),
+		unfused_bytes_(op_table.size(), 0),
+		fused_bytes_(op_table.size(), 0),
+		seconds_(op_table.size(), 0.0),
+#ifdef HAVE_MPI
+		stats_(SIPMPIAttr::get_instance().company_communicator(), op_table.size())
+#else
+		stats_(op_table.size())
+#endif //HAVE_MPI
+{
+	int nops = op_table.size();
+	int pc = 0;
+	while (pc < nops) {
+		if (!is_fusable(op_table.opcode(pc))) {
+			++pc;
+			continue;
+		}
+		//extend the run as long as the next fusable instruction, skipping glue, has the same lhs
+		int start = pc;
+		int last = pc;
+		int num_ops = 1;
+		int next = pc + 1;
+		while (next < nops) {
+			opcode_t opcode = op_table.opcode(next);
+			if (is_fusable(opcode)) {
+				if (!same_lhs(op_table, start, next)) break;
+				last = next;
+				++num_ops;
+			} else if (!is_glue(opcode)) {
+				break;
+			}
+			++next;
+		}
+		if (num_ops > 1) {
+			run_end_[start] = last + 1;
+			++num_runs_;
+		}
+		pc = last + 1;
+	}
+}
+
+FusedBlockOps::~FusedBlockOps() {
+}
+
+bool FusedBlockOps::is_fusable(opcode_t opcode) {
+	switch (opcode) {
+	case block_copy_op:
+	case block_fill_op:
+	case block_scale_op:
+	case block_scale_assign_op:
+	case block_accumulate_scalar_op:
+	case block_add_op:
+	case block_subtract_op:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FusedBlockOps::is_glue(opcode_t opcode) {
+	switch (opcode) {
+	case push_block_selector_op:
+	case int_load_value_op:
+	case int_load_literal_op:
+	case index_load_value_op:
+	case scalar_load_value_op:
+	case scalar_add_op:
+	case scalar_subtract_op:
+	case scalar_multiply_op:
+	case scalar_divide_op:
+	case scalar_neg_op:
+	case scalar_sqrt_op:
+	case scalar_exp_op:
+	case cast_to_scalar_op:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FusedBlockOps::begin_run(int pc) {
+	CHECK(!in_run(), "SIP bug: nested fused block op runs");
+	run_start_ = pc;
+	current_run_end_ = run_end_[pc];
+}
+
+void FusedBlockOps::end_run() {
+	flush();
+	executions_[run_start_]++;
+	run_start_ = -1;
+	current_run_end_ = -1;
+}
+
+void FusedBlockOps::flush() {
+	if (steps_.empty()) return;
+	double start = wall_time();
+	evaluate();
+	seconds_[run_start_] += wall_time() - start;
+	fused_bytes_[run_start_] += fused_doubles() * sizeof(double);
+	fused_ops_[run_start_] += steps_.size();
+	steps_.clear();
+	dest_ = NULL;
+	size_ = 0;
+}
+
+void FusedBlockOps::add_step(double* d, std::size_t n, const Step& step,
+		std::size_t unfused_doubles) {
+	CHECK(in_run(), "SIP bug: fused block op outside of a run");
+	if (d != dest_ || n != size_) {
+		flush();
+		dest_ = d;
+		size_ = n;
+	}
+	steps_.push_back(step);
+	unfused_bytes_[run_start_] += unfused_doubles * sizeof(double);
+}
+
+void FusedBlockOps::fill(double* d, std::size_t n, double value) {
+	add_step(d, n, Step(Step::fill_step, NULL, NULL, value), n);
+}
+
+void FusedBlockOps::scale(double* d, std::size_t n, double factor) {
+	add_step(d, n, Step(Step::scale_step, NULL, NULL, factor), 2 * n);
+}
+
+void FusedBlockOps::increment(double* d, std::size_t n, double delta) {
+	add_step(d, n, Step(Step::increment_step, NULL, NULL, delta), 2 * n);
+}
+
+void FusedBlockOps::scale_and_copy(double* d, const double* s, std::size_t n, double factor) {
+	add_step(d, n, Step(Step::copy_step, s, NULL, factor), 2 * n);
+}
+
+void FusedBlockOps::combine(double* d, const double* l, const double* r, std::size_t n,
+		double factor) {
+	add_step(d, n, Step(Step::combine_step, l, r, factor), 3 * n);
+}
+
+/** Applies each step to a tile of the destination before moving to the next tile.  Since
+ * every step is element-wise and completes on the tile before the next one starts, operands
+ * that are the destination itself see the same values as in the unfused execution. */
+void FusedBlockOps::evaluate() {
+	for (std::size_t begin = 0; begin < size_; begin += TILE_SIZE) {
+		std::size_t n = std::min(TILE_SIZE, size_ - begin);
+		double* d = dest_ + begin;
+		for (std::vector<Step>::const_iterator it = steps_.begin(); it != steps_.end(); ++it) {
+			const double* a = it->a_ == NULL ? NULL : it->a_ + begin;
+			const double* b = it->b_ == NULL ? NULL : it->b_ + begin;
+			switch (it->kind_) {
+			case Step::fill_step:
+				block_kernels::fill(d, n, it->c_);
+				break;
+			case Step::scale_step:
+				block_kernels::scale(d, n, it->c_);
+				break;
+			case Step::increment_step:
+				block_kernels::increment(d, n, it->c_);
+				break;
+			case Step::copy_step:
+				if (a == d && it->c_ == 1.0) break;
+				block_kernels::scale_and_copy(d, a, n, it->c_);
+				break;
+			case Step::combine_step:
+				if (a == d) {
+					block_kernels::accumulate_scaled(d, b, n, it->c_);
+				} else if (b == d) {  //d = l + c*d
+					block_kernels::scale(d, n, it->c_);
+					block_kernels::accumulate(d, a, n);
+				} else {
+					std::copy(a, a + n, d);
+					block_kernels::accumulate_scaled(d, b, n, it->c_);
+				}
+				break;
+			}
+		}
+	}
+}
+
+/** Doubles moved by evaluate:  each distinct operand is read once, the destination is
+ * written once, and read once unless the first step overwrites it. */
+std::size_t FusedBlockOps::fused_doubles() const {
+	std::set<const double*> operands;
+	for (std::vector<Step>::const_iterator it = steps_.begin(); it != steps_.end(); ++it) {
+		if (it->a_ != NULL && it->a_ != dest_) operands.insert(it->a_);
+		if (it->b_ != NULL && it->b_ != dest_) operands.insert(it->b_);
+	}
+	const Step& first = steps_.front();
+	bool reads_dest = first.kind_ == Step::scale_step || first.kind_ == Step::increment_step
+			|| (first.kind_ == Step::copy_step && first.a_ == dest_)
+			|| (first.kind_ == Step::combine_step && (first.a_ == dest_ || first.b_ == dest_));
+	return size_ * (operands.size() + 1 + (reads_dest ? 1 : 0));
+}
+
+#ifndef HAVE_MPI
+std::ostream& FusedBlockOps::Stats::gather_and_print_statistics(std::ostream& os,
+		FusedBlockOps* parent, const SipTables& sip_tables) {
+	os << "Worker fused block ops" << std::endl;
+	os << "num_runs_in_op_table_," << parent->num_runs_ << std::endl;
+	os << "pc, line number, opcode, executions, fused ops, unfused bytes, fused bytes, seconds, GB/s"
+			<< std::endl;
+	for (std::size_t pc = 0; pc < parent->executions_.size(); ++pc) {
+		if (parent->executions_[pc] == 0) continue;
+		double seconds = parent->seconds_[pc];
+		os << pc << ',' << sip_tables.line_number(pc) << ','
+				<< sip_tables.opcode_name(pc) << ',' << parent->executions_[pc] << ','
+				<< parent->fused_ops_[pc] << ',' << parent->unfused_bytes_[pc] << ','
+				<< parent->fused_bytes_[pc] << ',' << seconds << ','
+				<< (seconds > 0 ? 1.0e-9 * parent->fused_bytes_[pc] / seconds : 0.0)
+				<< std::endl;
+	}
+	os << std::endl;
+	return os;
+}
+#endif //HAVE_MPI
+
+} /* namespace sip */
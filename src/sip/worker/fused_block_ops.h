@@ -0,0 +1,203 @@
+/*
+ * fused_block_ops.h
+ *
+ * Fuses short runs of element-wise block instructions that update the same block.
+ *
+ * A sequence of SIAL statements like
+ *
+ *     tmp2[a,i,b,j]  = tmp1[a,i,b,j]
+ *     tmp2[a,i,b,j] *= 0.5
+ *     tmp2[a,i,b,j] += T2old[a,i,b,j]
+ *
+ * is compiled into block_copy_op, block_scale_op and block_add_op instructions, each of
+ * which makes a full pass over the blocks involved.  When the op table is loaded, runs of
+ * block_copy, block_fill, block_scale, block_scale_assign, block_accumulate_scalar, block_add
+ * and block_subtract instructions that all have the same lhs, separated only by
+ * instructions that push selectors or scalars on the stacks, are identified.  While the
+ * interpreter is executing such a run, the element-wise operations are recorded instead
+ * of performed, and at the end of the run they are evaluated together, one cache sized
+ * tile of the destination at a time.  Each operand is then read from memory once
+ * and the destination written once.
+ *
+ * Operations that cannot be deferred (for example ones on contiguous array slices that
+ * must be written back after the instruction) are executed immediately after flushing
+ * the pending operations, so the result is always the same as executing the instructions
+ * one at a time.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef FUSED_BLOCK_OPS_H_
+#define FUSED_BLOCK_OPS_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "opcode.h"
+#include "counter.h"
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#include "timer.h"
+#endif //HAVE_MPI
+
+namespace sip {
+
+class OpTable;
+class SipTables;
+
+class FusedBlockOps {
+public:
+	explicit FusedBlockOps(const OpTable& op_table);
+	~FusedBlockOps();
+
+	/** Instructions that may be part of a run */
+	static bool is_fusable(opcode_t opcode);
+
+	/** Instructions that may appear between the instructions of a run.  These must not
+	 * read or write blocks */
+	static bool is_glue(opcode_t opcode);
+
+	/** If a run starts at pc, returns the pc following the last instruction in the run,
+	 * otherwise -1 */
+	int run_end(int pc) const { return run_end_[pc]; }
+
+	std::size_t num_runs() const { return num_runs_; }
+
+	/** true between begin_run and end_run */
+	bool in_run() const { return run_start_ >= 0; }
+
+	int current_run_end() const { return current_run_end_; }
+
+	void begin_run(int pc);
+
+	/** Evaluates the pending operations and updates the statistics for the run */
+	void end_run();
+
+	/** Evaluates the pending operations */
+	void flush();
+
+	/** The deferred operations.  d is the destination, with n elements */
+	void fill(double* d, std::size_t n, double value);
+	void scale(double* d, std::size_t n, double factor);
+	void increment(double* d, std::size_t n, double delta);
+	void scale_and_copy(double* d, const double* s, std::size_t n, double factor);
+	/** d = l + factor * r.  Either of l and r may be d */
+	void combine(double* d, const double* l, const double* r, std::size_t n, double factor);
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os, const SipTables& sip_tables) {
+		stats_.gather_and_print_statistics(os, this, sip_tables);
+	}
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * Statistics are kept per run and reported at the pc of the first instruction of the run.
+	 * unfused_bytes_ is the memory traffic the instructions would have caused if executed
+	 * one at a time, fused_bytes_ the traffic of the fused evaluation, and seconds_ the time
+	 * spent in the fused evaluation.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_runs_;
+		MPICounter num_fused_ops_;
+		MPICounterList unfused_bytes_;
+		MPICounterList fused_bytes_;
+		MPITimerList seconds_;
+
+		Stats(const MPI_Comm& comm, std::size_t num_pcs) :
+				num_runs_(comm), num_fused_ops_(comm), unfused_bytes_(comm, num_pcs),
+				fused_bytes_(comm, num_pcs), seconds_(comm, num_pcs) {
+		}
+
+		void finalize(FusedBlockOps* parent) {
+			for (std::size_t pc = 0; pc < parent->executions_.size(); ++pc) {
+				num_runs_.inc(parent->executions_[pc]);
+				num_fused_ops_.inc(parent->fused_ops_[pc]);
+				unfused_bytes_.inc(pc, parent->unfused_bytes_[pc]);
+				fused_bytes_.inc(pc, parent->fused_bytes_[pc]);
+				if (parent->executions_[pc] > 0) seconds_.inc(pc, parent->seconds_[pc]);
+			}
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, FusedBlockOps* parent,
+				const SipTables& sip_tables) {
+			finalize(parent);
+			unfused_bytes_.reduce();
+			fused_bytes_.reduce();
+			seconds_.reduce();
+			num_runs_.gather();
+			num_fused_ops_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker fused block ops" << std::endl;
+				os << "num_runs_" << std::endl << num_runs_;
+				os << "num_fused_ops_" << std::endl << num_fused_ops_;
+				os << std::endl;
+				os << "Worker fused block ops unfused_bytes_" << std::endl;
+				unfused_bytes_.print_op_table_stats(os, sip_tables);
+				os << "Worker fused block ops fused_bytes_" << std::endl;
+				fused_bytes_.print_op_table_stats(os, sip_tables);
+				os << "Worker fused block ops seconds_" << std::endl;
+				seconds_.print_op_table_stats(os, sip_tables);
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		explicit Stats(std::size_t num_pcs) {}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, FusedBlockOps* parent,
+				const SipTables& sip_tables);
+	};
+#endif //HAVE_MPI
+
+private:
+	/** One deferred operation.  The operation is d = a * c for copy_step,
+	 * and d = a + c * b for combine_step */
+	struct Step {
+		enum Kind {
+			fill_step, scale_step, increment_step, copy_step, combine_step
+		};
+		Kind kind_;
+		const double* a_;
+		const double* b_;
+		double c_;
+		Step(Kind kind, const double* a, const double* b, double c) :
+				kind_(kind), a_(a), b_(b), c_(c) {
+		}
+	};
+
+	/** Number of doubles in the destination processed by all steps before moving on. */
+	static const std::size_t TILE_SIZE = 1024;
+
+	void add_step(double* d, std::size_t n, const Step& step, std::size_t unfused_doubles);
+	void evaluate();
+	std::size_t fused_doubles() const;
+
+	std::vector<int> run_end_;
+	std::size_t num_runs_;
+
+	int run_start_;
+	int current_run_end_;
+	double* dest_;
+	std::size_t size_;
+	std::vector<Step> steps_;
+
+	std::vector<std::size_t> executions_;
+	std::vector<std::size_t> fused_ops_;
+	std::vector<std::size_t> unfused_bytes_;
+	std::vector<std::size_t> fused_bytes_;
+	std::vector<double> seconds_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(FusedBlockOps);
+};
+
+} /* namespace sip */
+
+#endif /* FUSED_BLOCK_OPS_H_ */
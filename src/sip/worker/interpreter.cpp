@@ -35,13 +35,19 @@
 namespace sip {
 
 Interpreter* Interpreter::global_interpreter = NULL;
+const int Interpreter::NO_BLOCK_LOCK;
 
 Interpreter::Interpreter(const SipTables& sipTables,
 		SialPrinter* printer) :
 		sip_tables_(sipTables),  printer_(printer), data_manager_(
 				sipTables), op_table_(sipTables.op_table_), persistent_array_manager_(
-		NULL), sial_ops_(data_manager_,
-		NULL,  sipTables)
+		NULL), sial_ops_(*new SialOpsType(data_manager_,
+		NULL,  sipTables)), contraction_engine_(*new ContractionEngine(sipTables.op_table_size())),
+		fused_block_ops_(sipTables.op_table_),
+		threaded_pardo_(*new ThreadedPardo(sipTables, sipTables.op_table_)),
+				pardo_prefetch_(*new PardoPrefetch(sipTables, sipTables.op_table_)),
+				where_clause_cache_(*new WhereClauseCache(sipTables, sipTables.op_table_)), parent_(NULL),
+				held_block_lock_(NO_BLOCK_LOCK)
 {
 	_init(sipTables);
 }
@@ -50,8 +56,13 @@ Interpreter::Interpreter(const SipTables& sipTables,
 		WorkerPersistentArrayManager* persistent_array_manager) :
 		sip_tables_(sipTables),  printer_(printer), data_manager_(
 				sipTables), op_table_(sipTables.op_table_), persistent_array_manager_(
-				persistent_array_manager), sial_ops_(data_manager_,
-				persistent_array_manager,  sipTables){
+				persistent_array_manager), sial_ops_(*new SialOpsType(data_manager_,
+				persistent_array_manager,  sipTables)), contraction_engine_(*new ContractionEngine(
+				sipTables.op_table_size())), fused_block_ops_(sipTables.op_table_),
+				threaded_pardo_(*new ThreadedPardo(sipTables, sipTables.op_table_)),
+				pardo_prefetch_(*new PardoPrefetch(sipTables, sipTables.op_table_)),
+				where_clause_cache_(*new WhereClauseCache(sipTables, sipTables.op_table_)), parent_(NULL),
+				held_block_lock_(NO_BLOCK_LOCK){
 	_init(sipTables);
 }
 
@@ -59,13 +70,49 @@ Interpreter::Interpreter(const SipTables& sipTables,
 		WorkerPersistentArrayManager* persistent_array_manager) :
 		sip_tables_(sipTables),  printer_(NULL), data_manager_(
 				sipTables), op_table_(sip_tables_.op_table_), persistent_array_manager_(
-				persistent_array_manager), sial_ops_(data_manager_,
-				persistent_array_manager,  sipTables){
+				persistent_array_manager), sial_ops_(*new SialOpsType(data_manager_,
+				persistent_array_manager,  sipTables)), contraction_engine_(*new ContractionEngine(
+				sipTables.op_table_size())), fused_block_ops_(sipTables.op_table_),
+				threaded_pardo_(*new ThreadedPardo(sipTables, sipTables.op_table_)),
+				pardo_prefetch_(*new PardoPrefetch(sipTables, sipTables.op_table_)),
+				where_clause_cache_(*new WhereClauseCache(sipTables, sipTables.op_table_)), parent_(NULL),
+				held_block_lock_(NO_BLOCK_LOCK){
 	_init(sipTables);
 }
 
+/** Shares the static data, printer, persistent array manager, SialOps, ContractionEngine,
+ * ThreadedPardo, PardoPrefetch, and WhereClauseCache with the parent and has its own
+ * stacks, scalar and index values, fused block ops, and block map for temp blocks.
+ * Does not call _init, so global_interpreter still refers to the parent. */
+Interpreter::Interpreter(Interpreter& parent) :
+		sip_tables_(parent.sip_tables_),  printer_(parent.printer_), data_manager_(
+				parent.sip_tables_, parent.data_manager_), op_table_(parent.op_table_), persistent_array_manager_(
+				parent.persistent_array_manager_), sial_ops_(parent.sial_ops_),
+				contraction_engine_(parent.contraction_engine_), fused_block_ops_(parent.op_table_),
+				threaded_pardo_(parent.threaded_pardo_),
+				pardo_prefetch_(parent.pardo_prefetch_),
+				where_clause_cache_(parent.where_clause_cache_), parent_(&parent),
+				held_block_lock_(NO_BLOCK_LOCK){
+	pc = 0;
+	gpu_enabled_ = false;
+	tracer_ = new Tracer(sip_tables_);
+	timer_pc_ = 0;
+	iteration_ = 0;
+}
+
 Interpreter::~Interpreter() {
+	for (std::vector<Interpreter*>::iterator it = pardo_threads_.begin();
+			it != pardo_threads_.end(); ++it) {
+		delete *it;
+	}
 	delete tracer_;
+	if (parent_ == NULL) {
+		delete &where_clause_cache_;
+		delete &pardo_prefetch_;
+		delete &threaded_pardo_;
+		delete &contraction_engine_;
+		delete &sial_ops_;
+	}
 }
 
 void Interpreter::_init(const SipTables& sip_tables) {
@@ -81,6 +128,10 @@ void Interpreter::_init(const SipTables& sip_tables) {
 	if (printer_ == NULL) printer_ = new SialPrinterForProduction(std::cout, sip::SIPMPIAttr::get_instance().global_rank(), sip_tables);
 	timer_pc_ = 0;
 	iteration_=0;
+#ifdef HAVE_MPI
+	//collective, so only here and not in the interpreters of pardo threads
+	sial_ops_.begin_program();
+#endif //HAVE_MPI
 #ifdef HAVE_CUDA
 	int devid;
 	int rank = 0;
@@ -101,6 +152,13 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 	bool have_pragma = false;
 	int  pragma_slot = -1;
 	while (pc < pc_end) {
+		if (fused_block_ops_.in_run() && pc == fused_block_ops_.current_run_end()) {
+			fused_block_ops_.end_run();
+		}
+		if (!fused_block_ops_.in_run() && fused_block_ops_.run_end(pc) > 0
+				&& fused_block_ops_.run_end(pc) <= pc_end) {
+			fused_block_ops_.begin_run(pc);
+		}
 		opcode_t opcode = op_table_.opcode(pc);
 		CHECK(write_back_list_.empty() && read_block_list_.empty(),
 				"SIP bug:  write_back_list  or read_block_list not empty at top of interpreter loop");
@@ -195,7 +253,11 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 							num_indices, index_selectors(), data_manager_, sip_tables_,
 							SIPMPIAttr::get_instance(), num_where_clauses, this, iteration_	);
 			}
-			loop_start(loop);
+			if (parent_ == NULL && threaded_pardo_.enabled(pc, loop)) {
+				run_threaded_pardo(loop);
+			} else {
+				loop_start(loop);
+			}
 		}
 			break;
 		case endpardo_op: {
@@ -211,7 +273,7 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 		case broadcast_static_op: {
 //			std::cout << "calling broadcast_static with args " << arg0() << ", " << control_stack_.top() << std::endl;
 			Block::BlockPtr block = get_static(arg0());
-			sial_ops_.broadcast_static(block, control_stack_.top());
+			sial_ops_.broadcast_static(block, control_stack_.top(), arg0(), pc);
 			control_stack_.pop();
 			++pc;
 		}
@@ -258,7 +320,7 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 			break;
 		case get_op: { //TODO  check this.  Have compiler put block info in instruction?
 			sip::BlockId id = get_block_id_from_selector_stack();
-			sial_ops_.get(id, pc);
+			if (sial_ops_.get(id, pc)) pardo_prefetch_.record_hit();
 			++pc;
 		}
 			break;
@@ -618,7 +680,7 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 		case collective_sum_op: {
 			double rhs_value = expression_stack_.top();
 			expression_stack_.pop();
-			sial_ops_.collective_sum(rhs_value, arg0());
+			sial_ops_.collective_sum(rhs_value, arg0(), pc);
 			++pc;
 		}
 			break;
@@ -641,7 +703,12 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 			//#endif
 			//check for self assignment
 			if (lhs_block->get_data() != rhs_block->get_data()) {
-				lhs_block->copy_data_(rhs_block);
+				if (defer_block_op()) {
+					fused_block_ops_.scale_and_copy(lhs_block->get_data(),
+							rhs_block->get_data(), lhs_block->size(), 1.0);
+				} else {
+					lhs_block->copy_data_(rhs_block);
+				}
 			}
 			//#ifdef HAVE_CUDA
 			//				if (gpu_enabled_) {
@@ -681,7 +748,11 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 			sip::Block::BlockPtr lhs_block = get_block_from_instruction('w',
 					true);
 			double rhs = expression_stack_.top();
-			lhs_block->fill(rhs);
+			if (defer_block_op()) {
+				fused_block_ops_.fill(lhs_block->get_data(), lhs_block->size(), rhs);
+			} else {
+				lhs_block->fill(rhs);
+			}
 			expression_stack_.pop();
 			//#ifdef HAVE_CUDA
 			//			if (gpu_enabled_) {   //FIXME.  This looks OK, but need to double check
@@ -696,7 +767,12 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 		case block_scale_op: {
 			sip::Block::BlockPtr lhs_block = get_block_from_instruction('u',
 					true);
-			lhs_block->scale(expression_stack_.top());
+			if (defer_block_op()) {
+				fused_block_ops_.scale(lhs_block->get_data(), lhs_block->size(),
+						expression_stack_.top());
+			} else {
+				lhs_block->scale(expression_stack_.top());
+			}
 			expression_stack_.pop();
 			++pc;
 		}
@@ -708,7 +784,12 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 			double factor = expression_stack_.top();
 			std::cout << current_line() << ":  factor = " << factor
 					<< std::endl;
-			lhs_block->scale_and_copy(rhs_block, factor);
+			if (defer_block_op()) {
+				fused_block_ops_.scale_and_copy(lhs_block->get_data(),
+						rhs_block->get_data(), lhs_block->size(), factor);
+			} else {
+				lhs_block->scale_and_copy(rhs_block, factor);
+			}
 			expression_stack_.pop();
 			++pc;
 		}
@@ -716,7 +797,12 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 		case block_accumulate_scalar_op: {
 			sip::Block::BlockPtr lhs_block = get_block_from_instruction('u',
 					true);
-			lhs_block->increment_elements(expression_stack_.top());
+			if (defer_block_op()) {
+				fused_block_ops_.increment(lhs_block->get_data(), lhs_block->size(),
+						expression_stack_.top());
+			} else {
+				lhs_block->increment_elements(expression_stack_.top());
+			}
 			expression_stack_.pop();
 			++pc;
 		}
@@ -900,9 +986,13 @@ void Interpreter::interpret(int pc_start, int pc_end) {
 
 		//TODO  only call where necessary
 		contiguous_blocks_post_op();
+		if (held_block_lock_ != NO_BLOCK_LOCK) release_block_lock();
 		tracer_->trace_op(pc, opcode);
 		timer_trace(pc, opcode, current_line());
 	}			// while
+	if (fused_block_ops_.in_run()) {
+		fused_block_ops_.end_run();
+	}
 				//interpreter loop finished.  Ensure all timers turned off.
 //	timer_trace(pc, invalid_op, -99);
 	tracer_->stop_trace();
@@ -1225,40 +1315,37 @@ void Interpreter::handle_contraction(int drank,
 	sip::Block::BlockPtr lblock = get_block_from_selector_stack('r', lid, true);
 	int lrank = sip_tables_.array_rank(lid);
 
-	//get contraction pattern
-	int pattern_size = drank + lrank + rrank;
-	std::vector<int> aces_pattern(pattern_size, 0);	// Initialize vector with pattern_size elements of value 0
-	std::vector<int>::iterator it;
-	it = aces_pattern.begin();
+	//look up the plan for this line and these shapes.  The contraction pattern only
+	//needs to be computed the first time a combination is seen.
+	sip::ContractionShapes shapes(lrank, lblock->shape().segment_sizes_,
+			rrank, rblock->shape().segment_sizes_, drank, dshape);
+	sip::ContractionPlan plan;
+	int ierr = 0;
+	if (!contraction_engine_.find_plan(pc, shapes, plan)) {
+		int pattern_size = drank + lrank + rrank;
+		std::vector<int> aces_pattern(pattern_size, 0);	// Initialize vector with pattern_size elements of value 0
+		std::vector<int>::iterator it;
+		it = aces_pattern.begin();
 
-	it = std::copy(dselected_index_ids + 0, dselected_index_ids + drank, it);
-	it = std::copy(lselector.index_ids_ + 0, lselector.index_ids_ + lrank, it);
-	it = std::copy(rselector.index_ids_ + 0, rselector.index_ids_ + rrank, it);
+		it = std::copy(dselected_index_ids + 0, dselected_index_ids + drank, it);
+		it = std::copy(lselector.index_ids_ + 0, lselector.index_ids_ + lrank, it);
+		it = std::copy(rselector.index_ids_ + 0, rselector.index_ids_ + rrank, it);
 
-	int contraction_pattern[MAX_RANK * 2];
-	int ierr;
+		int contraction_pattern[MAX_RANK * 2];
 
-	get_contraction_ptrn_(drank, lrank, rrank, &aces_pattern[0],
-			contraction_pattern, ierr);
-	CHECK_WITH_LINE(ierr == 0, std::string("error returned from get_contraction_ptrn_"),
+		get_contraction_ptrn_(drank, lrank, rrank, &aces_pattern[0],
+				contraction_pattern, ierr);
+		CHECK_WITH_LINE(ierr == 0, std::string("error returned from get_contraction_ptrn_"),
+				line_number());
+		ierr = contraction_engine_.make_plan(pc, shapes, contraction_pattern,
+				lrank, rrank, drank, plan);
+		CHECK_WITH_LINE(ierr == 0, std::string("invalid contraction pattern"),
+				line_number());
+	}
+	ierr = contraction_engine_.contract(plan, lblock->get_data(),
+			rblock->get_data(), ddata);
+	CHECK_WITH_LINE(ierr == 0, std::string("error returned from block contraction"),
 			line_number());
-//    INPUT:
-//    ! - nthreads - number of threads requested;
-//    ! - contr_ptrn(1:left_rank+right_rank) - contraction pattern;
-//    ! - ltens/ltens_num_dim/ltens_dim_extent - left tensor block / its rank / and dimension extents;
-//    ! - rtens/rtens_num_dim/rtens_dim_extent - right tensor block / its rank / and dimension extents;
-//    ! - dtens/dtens_num_dim/dtens_dim_extent - destination tensor block (initialized!) / its rank / and dimension extents;
-//    !OUTPUT:
-//    ! - dtens - modified destination tensor block;
-//    ! - ierr - error code (0: success);
-//     */
-	int nthreads = sip::MAX_OMP_THREADS;
-	tensor_block_contract__(nthreads, contraction_pattern, lblock->get_data(),
-			lrank,
-			const_cast<segment_size_array_t&>(lblock->shape().segment_sizes_),
-			rblock->get_data(), rrank,
-			const_cast<segment_size_array_t&>(rblock->shape().segment_sizes_),
-			ddata, drank, dshape, ierr);
 }
 
 //
@@ -1661,6 +1748,7 @@ void Interpreter::loop_start(LoopManager * loop) {
 	if (loop->update()) { //there is at least one iteration of loop
 		loop_manager_stack_.push(loop);
 		data_manager_.enter_scope();
+		prefetch_next_iteration(loop, loop_body_pc - 1);
 	} else {
 		loop->finalize();
 		delete loop;
@@ -1670,16 +1758,179 @@ void Interpreter::loop_start(LoopManager * loop) {
 	}
 }
 
+void Interpreter::prefetch_next_iteration(LoopManager * loop, int pardo_pc) {
+	if (!pardo_prefetch_.enabled(pardo_pc)) return;  //false for do loops
+	index_value_array_t next_values;
+	if (!loop->next_iteration(next_values)) return;
+
+	//compute the block ids with the pardo indices set to their next values
+	int num_indices = op_table_.arg1(pardo_pc);
+	const index_selector_t& index_ids = op_table_.index_selectors(pardo_pc);
+	index_value_array_t current_values;
+	for (int i = 0; i < num_indices; ++i) {
+		current_values[i] = data_manager_.index_value(index_ids[i]);
+		data_manager_.set_index_value(index_ids[i], next_values[i]);
+	}
+	std::size_t num_prefetches = 0;
+	const PardoPrefetch::GetList& gets = pardo_prefetch_.gets(pardo_pc);
+	for (PardoPrefetch::GetList::const_iterator it = gets.begin(); it != gets.end(); ++it) {
+		BlockId id = block_id(it->selector_);
+		if (sial_ops_.prefetch(id, it->pc_, PardoPrefetch::max_bytes())) ++num_prefetches;
+	}
+	sial_ops_.flush_gets();
+	for (int i = 0; i < num_indices; ++i) {
+		data_manager_.set_index_value(index_ids[i], current_values[i]);
+	}
+	pardo_prefetch_.record(num_prefetches);
+}
+
+void Interpreter::run_threaded_pardo(LoopManager * loop) {
+	int pardo_pc = pc;
+	int enddo_pc = arg0();
+	int num_indices = arg1();
+	int body_pc = pc + 1;
+	const index_selector_t& index_ids = index_selectors();
+
+	//enumerate this worker's iterations and the pc following their where clauses
+	std::vector<int> start_pcs;
+	std::vector<int> index_values;
+	control_stack_.push(body_pc);
+	control_stack_.push(enddo_pc);
+	pc = body_pc;
+	while (loop->update()) {
+		start_pcs.push_back(pc);
+		for (int i = 0; i < num_indices; ++i) {
+			index_values.push_back(data_manager_.index_value(index_ids[i]));
+		}
+	}
+	loop->finalize();
+	delete loop;
+	control_stack_.pop();
+	control_stack_.pop();
+	pc = enddo_pc + 1; //jump to statement following endpardo
+
+	int num_iterations = start_pcs.size();
+	if (num_iterations == 0) return;
+	int num_threads = ThreadedPardo::num_threads();
+	//the threads access static arrays and the block map without communicating
+	sial_ops_.wait_for_broadcasts(pardo_pc);
+	data_manager_.block_manager_.block_map_.wait_and_clean_pending();
+	while (pardo_threads_.size() < static_cast<std::size_t>(num_threads)) {
+		pardo_threads_.push_back(new Interpreter(*this));
+	}
+	for (int t = 0; t < num_threads; ++t) {
+		pardo_threads_[t]->data_manager_.copy_values(data_manager_);
+	}
+
+	double start = ThreadedPardo::wall_time();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,1) num_threads(num_threads)
+#endif //_OPENMP
+	for (int iter = 0; iter < num_iterations; ++iter) {
+#ifdef _OPENMP
+		Interpreter* child = pardo_threads_[omp_get_thread_num()];
+#else
+		Interpreter* child = pardo_threads_[0];
+#endif //_OPENMP
+		child->run_pardo_iteration(body_pc, start_pcs[iter], enddo_pc, num_indices,
+				index_ids, &index_values[iter * num_indices]);
+	}
+	threaded_pardo_.record(pardo_pc, num_iterations, ThreadedPardo::wall_time() - start);
+}
+
+void Interpreter::run_pardo_iteration(int body_pc, int start_pc, int end_pc, int num_indices,
+		const index_selector_t& index_ids, const int* index_values) {
+	for (int i = 0; i < num_indices; ++i) {
+		data_manager_.set_index_value(index_ids[i], index_values[i]);
+	}
+	control_stack_.push(body_pc);
+	control_stack_.push(end_pc);
+	data_manager_.enter_scope();
+	interpret(start_pc, end_pc);
+	data_manager_.leave_scope();
+	control_stack_.pop();
+	control_stack_.pop();
+	for (int i = 0; i < num_indices; ++i) {
+		data_manager_.set_index_undefined(index_ids[i]);
+	}
+}
+
+Block::BlockPtr Interpreter::get_shared_block(char intent, const BlockId& id,
+		bool is_contiguous) {
+	if (is_contiguous) {
+		//reading makes a private copy of the slice, which is allocated from this thread's map.
+		//w and u are treated identically for contiguous arrays, and the slice is written back
+		//to the array after the instruction, so the array stays locked until then.
+		if (intent == 'r') {
+			return data_manager_.contiguous_array_manager_.get_block_for_reading(id,
+					read_block_list_);
+		}
+		hold_block_lock(BlockId(id.array_id()));
+		return data_manager_.contiguous_array_manager_.get_block_for_updating(id,
+				write_back_list_);
+	}
+	//local arrays are in the parent's block map, accessed without communication
+	if (intent != 'r') hold_block_lock(id);
+	BlockManager& shared = parent_->data_manager_.block_manager_;
+	Block::BlockPtr block = NULL;
+	shared.block_map_.lock();
+	switch (intent) {
+	case 'r':
+		block = shared.get_block_for_reading(id);
+		break;
+	case 'w':
+		block = shared.get_block_for_writing(id, false);
+		break;
+	case 'u':
+		block = shared.get_block_for_updating(id);
+		break;
+	default:
+		sip::check(false,
+				"SIP bug:  illegal or unsupported intent given to get_block");
+	}
+	shared.block_map_.unlock();
+	return block;
+}
+
+Block::BlockPtr Interpreter::get_temp_block(char intent, const BlockId& id) {
+	BlockManager& temps = data_manager_.block_manager_;
+	switch (intent) {
+	case 'r':
+		return temps.get_block_for_reading(id);
+	case 'w':
+		return temps.get_block_for_writing(id, true);
+	case 'u':
+		return temps.get_block_for_updating(id);
+	default:
+		sip::check(false,
+				"SIP bug:  illegal or unsupported intent given to get_block");
+	}
+	return NULL;
+}
+
+void Interpreter::hold_block_lock(const BlockId& id) {
+	CHECK(held_block_lock_ == NO_BLOCK_LOCK,
+			"SIP bug: a block lock is already held for this instruction");
+	held_block_lock_ = parent_->threaded_pardo_.lock_block(id);
+}
+
+void Interpreter::release_block_lock() {
+	parent_->threaded_pardo_.unlock_block(held_block_lock_);
+	held_block_lock_ = NO_BLOCK_LOCK;
+}
+
 void Interpreter::loop_end() {
 	int own_pc = pc;  //save pc of enddo instruction
 	int own_pc_from_stack = control_stack_.top();
 	control_stack_.pop(); //remove own location
 	pc = control_stack_.top();
 	control_stack_.push(own_pc_from_stack);
+	int loop_body_pc = pc;
 	data_manager_.leave_scope();
 	bool more_iterations = loop_manager_stack_.top()->update();
 	if (more_iterations) {
 		data_manager_.enter_scope();
+		prefetch_next_iteration(loop_manager_stack_.top(), loop_body_pc - 1);
 	} else {
 		LoopManager* loop = loop_manager_stack_.top();
 		loop->finalize();
@@ -1788,6 +2039,11 @@ sip::Block::BlockPtr Interpreter::get_block(char intent,
 		BlockId tmp_id(array_id, lower, upper);
 		id = tmp_id;
 		Block::BlockPtr block;
+		//in a child, the slices are in the parent's block map
+		if (parent_ != NULL) {
+			if (intent != 'r') hold_block_lock(BlockId(array_id));
+			parent_->data_manager_.block_manager_.block_map_.lock();
+		}
 		switch (intent) {
 		case 'w': {
 			block =
@@ -1811,6 +2067,7 @@ sip::Block::BlockPtr Interpreter::get_block(char intent,
 			fail("SIP bug:  illegal or unsupported intent given to get_block");
 
 		}
+		if (parent_ != NULL) parent_->data_manager_.block_manager_.block_map_.unlock();
 		return block;
 	}
 	if (sip_tables_.array_rank(selector.array_id_) == 0) { //this "array" was declared to be a scalar.  Nothing to remove from selector stack.
@@ -1819,6 +2076,9 @@ sip::Block::BlockPtr Interpreter::get_block(char intent,
 		return block;
 	}
 	if (selector.rank_ == 0) { //this is a static array provided without a selector, block is entire array
+		//the broadcasts were completed before the children started
+		if (parent_ == NULL) sial_ops_.wait_for_broadcast(array_id, pc);
+		else if (intent != 'r') hold_block_lock(BlockId(array_id));
 		block = data_manager_.contiguous_array_manager_.get_array(array_id);
 		id = sip::BlockId(array_id);
 		return block;
@@ -1836,6 +2096,13 @@ sip::Block::BlockPtr Interpreter::get_block(char intent,
 	SIAL_CHECK(!is_contiguous || contiguous_allowed,
 			"using contiguous block in a context that doesn't support it",
 			line_number());
+	if (is_contiguous && parent_ == NULL) sial_ops_.wait_for_broadcast(array_id, pc);
+	if (parent_ != NULL) {
+		if (is_contiguous || !sip_tables_.is_scope_extent(selector.array_id_)) {
+			return get_shared_block(intent, id, is_contiguous);
+		}
+		return get_temp_block(intent, id);
+	}
 	switch (intent) {
 	case 'r': {
 		block = is_contiguous ?
@@ -1902,6 +2169,9 @@ void Interpreter::handle_block_add(int pc) {
 	// In that case, check if r & d have the same selector indices
 	// If not, create a temp block with the permuted block and do the operation
 
+	// If the operation is deferred and no permutation is needed, r is used directly
+	// since the fused evaluation handles r aliasing d.
+
 	Block *tempblock = NULL;
 	bool no_permute_d_r = true;
 	for(int i=0; i<r_selector.rank_; ++i){
@@ -1911,12 +2181,18 @@ void Interpreter::handle_block_add(int pc) {
 		}
 	}
 
+	bool defer = defer_block_op();
 	if (lblock != dblock){
 		if (!compatible_l_r_indices)
 					fail("Incompatible indices for l & r on RHS", line_number());
 		if(!no_permute_d_r)
 			fail("Incompatible indices for LHS & RHS", line_number());
-	} else {
+	} else if (!(defer && no_permute_d_r)) {
+		// the permutation reads r, which may have pending updates
+		if (defer) {
+			fused_block_ops_.flush();
+			defer = false;
+		}
 		// Created a transposed temporary block.
 		// This will become the new rdata.
 //		Block::dataPtr tempdata = new double[rblock->size()];
@@ -1927,6 +2203,10 @@ void Interpreter::handle_block_add(int pc) {
 	}
 
 	size_t size = dblock->size();
+	if (defer) {
+		fused_block_ops_.combine(ddata, ldata, rdata, size, 1.0);
+		return;
+	}
 	for (size_t i = 0; i != size; ++i) {
 		*(ddata++) = *(ldata++) + *(rdata++);
 	}
@@ -1964,6 +2244,9 @@ void Interpreter::handle_block_subtract(int pc) {
 	// In that case, check if r & d have the same selector indices
 	// If not, create a temp block with the permuted block and do the operation
 
+	// If the operation is deferred and no permutation is needed, r is used directly
+	// since the fused evaluation handles r aliasing d.
+
 	Block *tempblock = NULL;
 	bool no_permute_d_r = true;
 	for(int i=0; i<r_selector.rank_; ++i){
@@ -1973,12 +2256,18 @@ void Interpreter::handle_block_subtract(int pc) {
 		}
 	}
 
+	bool defer = defer_block_op();
 	if (lblock != dblock){
 		if (!compatible_l_r_indices)
 					fail("Incompatible indices for l & r on RHS", line_number());
 		if(!no_permute_d_r)
 			fail("Incompatible indices for LHS & RHS", line_number());
-	} else {
+	} else if (!(defer && no_permute_d_r)) {
+		// the permutation reads r, which may have pending updates
+		if (defer) {
+			fused_block_ops_.flush();
+			defer = false;
+		}
 		// Created a transposed temporary block.
 		// This will become the new rdata.
 //		Block::dataPtr tempdata = new double[rblock->size()];
@@ -1989,6 +2278,10 @@ void Interpreter::handle_block_subtract(int pc) {
 	}
 
 	size_t size = dblock->size();
+	if (defer) {
+		fused_block_ops_.combine(ddata, ldata, rdata, size, -1.0);
+		return;
+	}
 	for (size_t i = 0; i != size; ++i) {
 		*(ddata++) = *(ldata++) - *(rdata++);
 	}
@@ -1996,6 +2289,14 @@ void Interpreter::handle_block_subtract(int pc) {
 	delete tempblock;
 }
 
+bool Interpreter::defer_block_op() {
+	if (!fused_block_ops_.in_run()) return false;
+	if (write_back_list_.empty() && read_block_list_.empty()
+			&& held_block_lock_ == NO_BLOCK_LOCK) return true;
+	fused_block_ops_.flush();
+	return false;
+}
+
 void Interpreter::contiguous_blocks_post_op() {
 
 	// Write back all contiguous slices
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <stack>
+#include <vector>
 #include <sstream>
 #include "block_manager.h"
 #include "contiguous_array_manager.h"
@@ -29,6 +30,11 @@
 #include "sial_math.h"
 #include "tracer.h"
 #include "counter.h"
+#include "contraction_engine.h"
+#include "fused_block_ops.h"
+#include "threaded_pardo.h"
+#include "pardo_prefetch.h"
+#include "where_clause_cache.h"
 #include "sip_mpi_attr.h"
 
 
@@ -141,7 +147,9 @@ public:
 				|| sip_tables_.is_served(array_slot);
 	}
 
+	/** Returns the static array, completing its broadcast if pending */
 	Block* get_static(int array_id){
+		if (parent_ == NULL) sial_ops_.wait_for_broadcast(array_id, pc);
 		return data_manager_.contiguous_array_manager_.get_array(array_id);
 	}
 	Block* get_and_remove_contiguous_array(int array_id) {
@@ -189,6 +197,13 @@ public:
 	    	sial_ops_.print_op_table_stats(os, sip_tables_);
 	    	os << std::endl << std::flush;
 	    }
+	    contraction_engine_.gather_and_print_statistics(os, sip_tables_);
+	    fused_block_ops_.gather_and_print_statistics(os, sip_tables_);
+	    threaded_pardo_.gather_and_print_statistics(os, sip_tables_);
+	    pardo_prefetch_.gather_and_print_statistics(os);
+	    where_clause_cache_.gather_and_print_statistics(os);
+	    sial_ops_.gather_and_print_statistics(os);
+	    data_manager_.block_manager_.block_map_.gather_and_print_statistics(os);
 	}
 
 
@@ -298,12 +313,44 @@ private:
 	WorkerPersistentArrayManager* persistent_array_manager_;
 
 #ifdef HAVE_MPI
-	SialOpsParallel sial_ops_;  //todo make this a template param
+	typedef SialOpsParallel SialOpsType;  //todo make this a template param
 #else
-	SialOpsSequential sial_ops_;
+	typedef SialOpsSequential SialOpsType;
 #endif
+
+	/* sial_ops_, contraction_engine_, threaded_pardo_, pardo_prefetch_, and
+	 * where_clause_cache_ are created by the worker's interpreter and shared by its
+	 * children, which do not delete them. */
+	SialOpsType& sial_ops_;
 //	SIAL_OPS_TYPE sial_ops_;
 
+	/** Performs block contractions, owns the reusable transpose workspaces */
+	ContractionEngine& contraction_engine_;
+
+	/** Runs of element-wise block instructions found in the op_table_, and their deferred operations */
+	FusedBlockOps fused_block_ops_;
+
+	/** Eligibility of the pardo loops for threaded execution, and the block locks for shared data */
+	ThreadedPardo& threaded_pardo_;
+
+	/** The gets of each pardo that may be prefetched for its next iteration */
+	PardoPrefetch& pardo_prefetch_;
+
+	/** The iterations of pardos whose where clauses only depend on indices and ints */
+	WhereClauseCache& where_clause_cache_;
+
+	/** For a child interpreter executing pardo iterations on a thread, the worker's
+	 * interpreter that owns the shared data.  NULL otherwise. */
+	Interpreter* parent_;
+
+	/** Child interpreters, one per thread.  Created the first time a pardo runs threaded. */
+	std::vector<Interpreter*> pardo_threads_;
+
+	/** In a child, the index of the parent's block lock held until the current instruction
+	 * is complete, or NO_BLOCK_LOCK */
+	int held_block_lock_;
+	static const int NO_BLOCK_LOCK = -1;
+
 	/** the "program counter". Actually, the current location in the op_table_.
 	 */
 	int pc; //technically, this should be pc_, but I'm going to leave it this way for convenience
@@ -365,6 +412,15 @@ private:
 	 */
 	void contiguous_blocks_post_op();
 
+	/**
+	 * Called by the element-wise block instructions after their blocks have been obtained.
+	 * Returns true if the instruction is part of a fused run and its operation should be
+	 * handed to fused_block_ops_.  Otherwise flushes any pending fused operations
+	 * so that the instruction can be executed immediately.  Instructions involving contiguous array
+	 * slices are never deferred since the slices are written back or freed after each instruction.
+	 */
+	bool defer_block_op();
+
 
 	/**
 	 * Records whether or not we are executing in a section of code where gpu_on has been invoked
@@ -390,6 +446,33 @@ private:
 	void loop_start(LoopManager * loop);
 	void loop_end();
 
+	/** Constructs a child interpreter that executes pardo iterations for parent on a thread */
+	explicit Interpreter(Interpreter& parent);
+
+	/** Enumerates the iterations of the pardo loop at pc that belong to this worker, then
+	 * executes them with the child interpreters.  Leaves pc after the endpardo. */
+	void run_threaded_pardo(LoopManager * loop);
+
+	/** Issues the prefetchable gets of the pardo at pardo_pc for the next iteration of loop.
+	 * Called after loop has been updated for the current iteration. */
+	void prefetch_next_iteration(LoopManager * loop, int pardo_pc);
+
+	/** Executes one pardo iteration in a child.  start_pc is the first instruction after the
+	 * where clauses, and index_values are the values of the pardo's indices. */
+	void run_pardo_iteration(int body_pc, int start_pc, int end_pc, int num_indices,
+			const index_selector_t& index_ids, const int* index_values);
+
+	/** Gets a block of an array owned by the parent.  Only called in a child. */
+	Block::BlockPtr get_shared_block(char intent, const BlockId& id, bool is_contiguous);
+
+	/** Gets a block of a temp array from this child's block map, without the SialOps,
+	 * which belong to the parent.  Only called in a child. */
+	Block::BlockPtr get_temp_block(char intent, const BlockId& id);
+
+	/** Acquires the parent's block lock of id until the current instruction is complete */
+	void hold_block_lock(const BlockId& id);
+	void release_block_lock();
+
 
 	/** Gets the rank and array Id index_selector array from the instruction.
 	 *
@@ -484,7 +567,9 @@ private:
 
 	friend class ::TestControllerParallel;
 	friend class ::TestController;
-	friend class BalancedTaskAllocParallelPardoLoop; //for interpret_where
+	friend class BalancedTaskAllocParallelPardoLoop; //for interpret_where and where_clause_cache_
+	friend class EnumeratedParallelPardoLoop; //for interpret_where and where_clause_cache_
+	friend class DynamicTaskAllocParallelPardoLoop; //for sial_ops_
 	friend class Fragment_Nij_aa__PardoLoopManager;
 	friend class Fragment_Nij_a_a_PardoLoopManager;
 	friend class Fragment_Nij_oo__PardoLoopManager;
@@ -7,6 +7,7 @@
 
 #include "loop_manager.h"
 #include <sstream>
+#include <algorithm>
 #include "interpreter.h"
 #include "create_map.h"
 #include "fragment_loop_manager.h"
@@ -23,6 +24,12 @@ LoopManager::~LoopManager() {
 void LoopManager::do_set_to_exit() {
 	to_exit_ = true;
 }
+bool LoopManager::do_next_iteration(index_value_array_t& index_values) {
+	return false;
+}
+bool LoopManager::do_may_enumerate() const {
+	return true;
+}
 std::ostream& operator<<(std::ostream& os, const LoopManager &obj) {
 	os << obj.to_string();
 	return os;
@@ -313,6 +320,29 @@ bool StaticTaskAllocParallelPardoLoop::do_update() {
 	}
 }
 
+bool StaticTaskAllocParallelPardoLoop::do_next_iteration(index_value_array_t& index_values) {
+	if (to_exit_ || first_time_)
+		return false;
+	int company_rank = sip_mpi_attr_.company_rank();
+	int num_workers = sip_mpi_attr_.num_workers();
+	index_value_array_t current;
+	for (int i = 0; i < num_indices_; ++i) {
+		current[i] = data_manager_.index_value(index_id_[i]);
+	}
+	//same steps as do_update, with a copy of the iteration count
+	long iteration = iteration_ + 1;
+	bool more_iters = increment_indices();
+	while (more_iters && iteration % num_workers != company_rank) {
+		more_iters = increment_indices();
+		iteration++;
+	}
+	for (int i = 0; i < num_indices_; ++i) {
+		index_values[i] = data_manager_.index_value(index_id_[i]);
+		data_manager_.set_index_value(index_id_[i], current[i]);
+	}
+	return more_iters;
+}
+
 void StaticTaskAllocParallelPardoLoop::do_finalize() {
 	for (int i = 0; i < num_indices_; ++i) {
 		data_manager_.set_index_undefined(index_id_[i]);
@@ -408,7 +438,8 @@ BalancedTaskAllocParallelPardoLoop::BalancedTaskAllocParallelPardoLoop(
 				num_indices), first_time_(true), iteration_(iteration), sip_mpi_attr_(
 				sip_mpi_attr), num_where_clauses_(num_where_clauses), company_rank_(
 				sip_mpi_attr.company_rank()), num_workers_(
-				sip_mpi_attr_.num_workers()), interpreter_(interpreter) {
+				sip_mpi_attr_.num_workers()), interpreter_(interpreter), pardo_pc_(
+				interpreter->pc), cached_(NULL), cached_next_(0), recording_(false) {
 
 	std::copy(index_id + 0, index_id + MAX_RANK, index_id_ + 0);
 	for (int i = 0; i < num_indices; ++i) {
@@ -469,10 +500,17 @@ bool BalancedTaskAllocParallelPardoLoop::do_update() {
 
 	if (to_exit_)
 		return false;
+	WhereClauseCache& cache = interpreter_->where_clause_cache_;
 	bool more_iters;
 	if (first_time_) {
 		first_time_ = false;
+		cached_ = cache.find(pardo_pc_, data_manager_);
+		if (cached_ != NULL)
+			return next_cached_iteration();
+		recording_ = cache.begin_recording(pardo_pc_, data_manager_);
 		more_iters = initialize_indices();
+	} else if (cached_ != NULL) {
+		return next_cached_iteration();
 	} else {
 		more_iters = increment_indices();
 	}
@@ -482,6 +520,8 @@ bool BalancedTaskAllocParallelPardoLoop::do_update() {
 		//if true, the pc will be after the last where clause
 		//otherwise it is undefined
 		if(where_clauses_value){
+			if (recording_)
+				record_iteration();
 			iteration_++;
 			if ((iteration_-1) % num_workers_ == company_rank_){
 //				std::cout << "rank " << company_rank_ << " executing iteration";
@@ -495,9 +535,78 @@ bool BalancedTaskAllocParallelPardoLoop::do_update() {
 		}
 		more_iters = increment_indices();
 	}
+	//all points have been visited
+	if (recording_)
+		cache.end_recording(pardo_pc_);
 	return more_iters; //this should be false here
 }
 
+bool BalancedTaskAllocParallelPardoLoop::next_cached_iteration() {
+	long num_iterations = cached_->size() / num_indices_;
+	while (cached_next_ < num_iterations) {
+		long k = cached_next_++;
+		iteration_++;
+		if ((iteration_-1) % num_workers_ == company_rank_) {
+			for (int i = 0; i < num_indices_; ++i) {
+				data_manager_.set_index_value(index_id_[i], (*cached_)[k * num_indices_ + i]);
+			}
+			interpreter_->pc = interpreter_->where_clause_cache_.body_pc(pardo_pc_);
+			return true;
+		}
+	}
+	return false;
+}
+
+void BalancedTaskAllocParallelPardoLoop::record_iteration() {
+	index_value_array_t values;
+	for (int i = 0; i < num_indices_; ++i) {
+		values[i] = data_manager_.index_value(index_id_[i]);
+	}
+	interpreter_->where_clause_cache_.record(pardo_pc_, values, num_indices_);
+}
+
+bool BalancedTaskAllocParallelPardoLoop::do_next_iteration(index_value_array_t& index_values) {
+	if (to_exit_ || first_time_)
+		return false;
+	if (cached_ != NULL) {
+		long num_iterations = cached_->size() / num_indices_;
+		long iteration = iteration_;
+		for (long k = cached_next_; k < num_iterations; ++k) {
+			iteration++;
+			if ((iteration - 1) % num_workers_ == company_rank_) {
+				for (int i = 0; i < num_indices_; ++i) {
+					index_values[i] = (*cached_)[k * num_indices_ + i];
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+	index_value_array_t current;
+	for (int i = 0; i < num_indices_; ++i) {
+		current[i] = data_manager_.index_value(index_id_[i]);
+	}
+	int pc = interpreter_->pc;  //interpret_where moves the pc
+	//same steps as do_update, with a copy of the iteration count
+	long iteration = iteration_;
+	bool found = false;
+	bool more_iters = increment_indices();
+	while (more_iters && !found) {
+		if (interpreter_->interpret_where(num_where_clauses_)) {
+			iteration++;
+			found = (iteration - 1) % num_workers_ == company_rank_;
+		}
+		if (!found)
+			more_iters = increment_indices();
+	}
+	for (int i = 0; i < num_indices_; ++i) {
+		index_values[i] = data_manager_.index_value(index_id_[i]);
+		data_manager_.set_index_value(index_id_[i], current[i]);
+	}
+	interpreter_->pc = pc;
+	return found;
+}
+
 void BalancedTaskAllocParallelPardoLoop::do_finalize() {
 	for (int i = 0; i < num_indices_; ++i) {
 		data_manager_.set_index_undefined(index_id_[i]);
@@ -535,6 +644,334 @@ std::ostream& operator<<(std::ostream& os,
 	return os;
 }
 
+//++++++++++++++++++++++++++++++++++++++++++++
+
+EnumeratedParallelPardoLoop::EnumeratedParallelPardoLoop(
+		int num_indices, const int (&index_id)[MAX_RANK],
+		DataManager & data_manager, const SipTables & sip_tables,
+		int num_where_clauses, Interpreter* interpreter, long& iteration) :
+		num_indices_(num_indices), iteration_(iteration),
+				num_where_clauses_(num_where_clauses), pardo_pc_(interpreter->pc),
+				data_manager_(data_manager), sip_tables_(sip_tables),
+				interpreter_(interpreter), num_iterations_(0) {
+
+	std::copy(index_id + 0, index_id + MAX_RANK, index_id_ + 0);
+	for (int i = 0; i < num_indices; ++i) {
+		lower_seg_[i] = sip_tables_.lower_seg(index_id_[i]);
+		upper_bound_[i] = lower_seg_[i]
+				+ sip_tables_.num_segments(index_id_[i]);
+		CHECK_WITH_LINE(lower_seg_[i] < upper_bound_[i],
+				"Pardo loop index " + sip_tables_.index_name(index_id_[i])
+						+ " has empty range",
+				Interpreter::global_interpreter->line_number());
+	}
+}
+
+EnumeratedParallelPardoLoop::~EnumeratedParallelPardoLoop() {
+}
+
+inline bool EnumeratedParallelPardoLoop::increment_indices() {
+	bool more = false; 	// More iterations?
+	int current_value;
+	for (int i = 0; i < num_indices_; ++i) {
+		current_value = data_manager_.index_value(index_id_[i]);
+		++current_value;
+		if (current_value < upper_bound_[i]) {
+			//increment current index and return
+			data_manager_.set_index_value(index_id_[i], current_value);
+			more = true;
+			break;
+		} else {
+			//wrap around and handle next index
+			data_manager_.set_index_value(index_id_[i], lower_seg_[i]);
+		}
+	} //if here, then all indices are at their max value
+	return more;
+}
+
+inline bool EnumeratedParallelPardoLoop::initialize_indices() {
+	for (int i = 0; i < num_indices_; ++i) {
+		if (lower_seg_[i] >= upper_bound_[i]) {
+			return false; //this loop has an empty range in at least one dimension.
+		}
+		CHECK_WITH_LINE(
+				data_manager_.index_value(index_id_[i])
+						== DataManager::undefined_index_value,
+				"SIAL or SIP error, index "
+						+ sip_tables_.index_name(index_id_[i])
+						+ " already has value before loop",
+				Interpreter::global_interpreter->line_number());
+		data_manager_.set_index_value(index_id_[i], lower_seg_[i]);
+	}
+	return true;
+}
+
+void EnumeratedParallelPardoLoop::enumerate_iterations() {
+	WhereClauseCache& cache = interpreter_->where_clause_cache_;
+	const WhereClauseCache::IterationList* cached = cache.find(pardo_pc_, data_manager_);
+	if (cached != NULL) {
+		iterations_ = *cached;
+		num_iterations_ = iterations_.size() / num_indices_;
+		for (long k = 0; k < num_iterations_; ++k) {
+			for (int i = 0; i < num_indices_; ++i) {
+				data_manager_.set_index_value(index_id_[i], iterations_[k * num_indices_ + i]);
+			}
+			iteration_found();
+		}
+	} else {
+		bool recording = cache.begin_recording(pardo_pc_, data_manager_);
+		bool more_iters = initialize_indices();
+		while (more_iters) {
+			if (interpreter_->interpret_where(num_where_clauses_)) {
+				for (int i = 0; i < num_indices_; ++i) {
+					iterations_.push_back(data_manager_.index_value(index_id_[i]));
+				}
+				if (recording)
+					cache.record(pardo_pc_, &iterations_[iterations_.size() - num_indices_],
+							num_indices_);
+				iteration_found();
+			}
+			more_iters = increment_indices();
+		}
+		if (recording)
+			cache.end_recording(pardo_pc_);
+		num_iterations_ = iterations_.size() / num_indices_;
+	}
+	//later balanced loops continue the round robin as if this one had been balanced
+	iteration_ += num_iterations_;
+}
+
+void EnumeratedParallelPardoLoop::start_iteration(long k) {
+	std::vector<int>::const_iterator values = iterations_.begin() + k * num_indices_;
+	for (int i = 0; i < num_indices_; ++i) {
+		data_manager_.set_index_value(index_id_[i], values[i]);
+	}
+	WhereClauseCache& cache = interpreter_->where_clause_cache_;
+	if (cache.cacheable(pardo_pc_)) {
+		interpreter_->pc = cache.body_pc(pardo_pc_);
+		return;
+	}
+	//sets the pc after the last where clause
+	bool where_clauses_value = interpreter_->interpret_where(num_where_clauses_);
+	CHECK_WITH_LINE(where_clauses_value,
+			"where clause of pardo changed its value in the loop",
+			Interpreter::global_interpreter->line_number());
+}
+
+void EnumeratedParallelPardoLoop::do_finalize() {
+	for (int i = 0; i < num_indices_; ++i) {
+		data_manager_.set_index_undefined(index_id_[i]);
+	}
+}
+
+bool EnumeratedParallelPardoLoop::do_may_enumerate() const {
+	//the dynamic loop claims chunks from the shared counter in update
+	return false;
+}
+
+std::string EnumeratedParallelPardoLoop::to_string() const {
+	std::stringstream ss;
+	ss << "index_ids_=[";
+	for (int i = 0; i < num_indices_; ++i) {
+		ss << (i == 0 ? "" : ",") << sip_tables_.index_name(index_id_[i]);
+	}
+	ss << "] num_iterations_=" << num_iterations_;
+	ss << " current= [";
+	for (int i = 0; i < num_indices_; ++i) {
+		ss << (i == 0 ? "" : ",")
+				<< data_manager_.index_value_to_string(index_id_[i]);
+	}
+	ss << "]";
+	return ss.str();
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++
+
+DynamicTaskAllocParallelPardoLoop::DynamicTaskAllocParallelPardoLoop(
+		int num_indices, const int (&index_id)[MAX_RANK],
+		DataManager & data_manager, const SipTables & sip_tables,
+		SIPMPIAttr & sip_mpi_attr, int num_where_clauses,
+		Interpreter* interpreter, long& iteration) :
+		EnumeratedParallelPardoLoop(num_indices, index_id, data_manager,
+				sip_tables, num_where_clauses, interpreter, iteration),
+		first_time_(true), next_(0), end_(0) {
+}
+
+DynamicTaskAllocParallelPardoLoop::~DynamicTaskAllocParallelPardoLoop() {
+}
+
+bool DynamicTaskAllocParallelPardoLoop::do_update() {
+	if (to_exit_)
+		return false;
+	PardoTaskCounter& counter = interpreter_->sial_ops_.pardo_task_counter();
+	if (first_time_) {
+		first_time_ = false;
+		enumerate_iterations();
+		counter.begin_loop(pardo_pc_);
+	}
+	if (next_ == end_ && !counter.claim(pardo_pc_, num_iterations_, next_, end_))
+		return false;
+	start_iteration(next_++);
+	return true;
+}
+
+std::string DynamicTaskAllocParallelPardoLoop::to_string() const {
+	std::stringstream ss;
+	ss << "Dynamic Task Allocation Parallel Pardo Loop:  num_indices="
+			<< num_indices_ << std::endl;
+	ss << EnumeratedParallelPardoLoop::to_string();
+	ss << " chunk=[" << next_ << "," << end_ << ")";
+	return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os,
+		const DynamicTaskAllocParallelPardoLoop &obj) {
+	os << obj.to_string();
+	return os;
+}
+
+//++++++++++++++++++++++++++++++++++++++++++++
+
+WeightedTaskAllocParallelPardoLoop::WeightedTaskAllocParallelPardoLoop(
+		int num_indices, const int (&index_id)[MAX_RANK],
+		DataManager & data_manager, const SipTables & sip_tables,
+		SIPMPIAttr & sip_mpi_attr, int num_where_clauses,
+		Interpreter* interpreter, long& iteration) :
+		EnumeratedParallelPardoLoop(num_indices, index_id, data_manager,
+				sip_tables, num_where_clauses, interpreter, iteration),
+		first_time_(true), company_rank_(sip_mpi_attr.company_rank()),
+		num_workers_(sip_mpi_attr.num_workers()), next_(0), end_(0) {
+	find_cost_terms();
+}
+
+WeightedTaskAllocParallelPardoLoop::~WeightedTaskAllocParallelPardoLoop() {
+}
+
+void WeightedTaskAllocParallelPardoLoop::find_cost_terms() {
+	int enddo_pc = sip_tables_.arg0(pardo_pc_);
+	//pcs of the block selectors pushed by the last two push_block_selector instructions
+	int last_selector = -1;
+	int previous_selector = -1;
+	for (int pc = pardo_pc_ + 1; pc < enddo_pc; ++pc) {
+		switch (sip_tables_.opcode(pc)) {
+		case push_block_selector_op:
+			previous_selector = last_selector;
+			last_selector = pc;
+			break;
+		case block_contract_op:
+		case block_contract_to_scalar_op:
+			//the operands are the last two selectors
+			add_cost_term(last_selector, previous_selector, 2.0);
+			break;
+		case get_op:
+		case put_accumulate_op:
+		case put_replace_op:
+			add_cost_term(last_selector, -1, 1.0);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void WeightedTaskAllocParallelPardoLoop::add_cost_term(int selector_pc,
+		int other_selector_pc, double multiplier) {
+	if (selector_pc < 0) return;
+	CostTerm term;
+	term.multiplier_ = multiplier;
+	int pcs[] = { selector_pc, other_selector_pc };
+	for (int k = 0; k < 2; ++k) {
+		if (pcs[k] < 0) continue;
+		const index_selector_t& selectors = sip_tables_.index_selectors(pcs[k]);
+		for (int i = 0; i < MAX_RANK; ++i) {
+			int id = selectors[i];
+			if (id == unused_index_slot || id == wild_card_slot) continue;
+			//the indices of the result of a contraction are indices of the operands,
+			//and summed indices appear in both
+			if (std::find(term.index_ids_.begin(), term.index_ids_.end(), id)
+					== term.index_ids_.end()) {
+				term.index_ids_.push_back(id);
+			}
+		}
+	}
+	cost_terms_.push_back(term);
+}
+
+double WeightedTaskAllocParallelPardoLoop::extent(int index_id) const {
+	if (sip_tables_.is_subindex(index_id)) {
+		return extent(sip_tables_.parent_index(index_id));
+	}
+	int value = data_manager_.index_value(index_id);
+	if (value == DataManager::undefined_index_value) {
+		return sip_tables_.index_extent(index_id);
+	}
+	return sip_tables_.segment_extent(index_id, value);
+}
+
+void WeightedTaskAllocParallelPardoLoop::iteration_found() {
+	double weight = 0.0;
+	for (std::vector<CostTerm>::const_iterator it = cost_terms_.begin();
+			it != cost_terms_.end(); ++it) {
+		double term = it->multiplier_;
+		for (std::size_t i = 0; i < it->index_ids_.size(); ++i) {
+			term *= extent(it->index_ids_[i]);
+		}
+		weight += term;
+	}
+	weights_.push_back(weight > 0.0 ? weight : 1.0);
+}
+
+bool WeightedTaskAllocParallelPardoLoop::do_update() {
+	if (to_exit_)
+		return false;
+	if (first_time_) {
+		first_time_ = false;
+		enumerate_iterations();
+		double total = 0.0;
+		for (long k = 0; k < num_iterations_; ++k) {
+			total += weights_[k];
+		}
+		//an iteration belongs to the worker whose share contains its midpoint.  Every
+		//worker computes the same sums, so the ranges do not overlap.
+		double before = 0.0;
+		next_ = num_iterations_;
+		end_ = num_iterations_;
+		for (long k = 0; k < num_iterations_; ++k) {
+			double midpoint = before + 0.5 * weights_[k];
+			int worker = std::min(num_workers_ - 1,
+					static_cast<int>(midpoint * num_workers_ / total));
+			if (worker == company_rank_ && next_ == num_iterations_) next_ = k;
+			if (worker > company_rank_) {
+				end_ = k;
+				break;
+			}
+			before += weights_[k];
+		}
+		if (next_ > end_) next_ = end_;
+		weights_.clear();
+	}
+	if (next_ == end_)
+		return false;
+	start_iteration(next_++);
+	return true;
+}
+
+std::string WeightedTaskAllocParallelPardoLoop::to_string() const {
+	std::stringstream ss;
+	ss << "Weighted Task Allocation Parallel Pardo Loop:  num_indices="
+			<< num_indices_ << std::endl;
+	ss << EnumeratedParallelPardoLoop::to_string();
+	ss << " num_cost_terms=" << cost_terms_.size();
+	ss << " range=[" << next_ << "," << end_ << ")";
+	return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os,
+		const WeightedTaskAllocParallelPardoLoop &obj) {
+	os << obj.to_string();
+	return os;
+}
+
 #endif
 
 } /* namespace sip */
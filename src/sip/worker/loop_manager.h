@@ -8,6 +8,7 @@
 #ifndef LOOP_MANAGER_H_
 #define LOOP_MANAGER_H_
 
+#include <vector>
 #include "config.h"
 #include "aces_defs.h"
 #include "sip.h"
@@ -41,6 +42,25 @@ public:
 	void set_to_exit() {
 		do_set_to_exit();
 	}
+	/** Sets index_values[i] to the value the i-th managed index will have in the next
+	 * iteration executed by this worker and returns true.  The loop and the values of its
+	 * indices are left unchanged.  Returns false if there is no next iteration, or if this
+	 * loop manager cannot look ahead.
+	 *
+	 * Where clauses are evaluated with the current values of any variables they use, so the
+	 * result is a prediction.  Must be called right after update, while the pc and control
+	 * stack are those of the loop's pardo or endpardo instruction.
+	 */
+	bool next_iteration(index_value_array_t& index_values) {
+		return do_next_iteration(index_values);
+	}
+	/** true if the iterations of this worker may all be found by calling update until it
+	 * returns false before any of them executes, as a threaded pardo does.  False if the
+	 * loop manager claims iterations while updating, so that this worker would claim all
+	 * of them. */
+	bool may_enumerate() const {
+		return do_may_enumerate();
+	}
 
 	friend std::ostream& operator<<(std::ostream&, const LoopManager &);
 protected:
@@ -50,6 +70,8 @@ private:
 	virtual bool do_update() = 0;
 	virtual void do_finalize() = 0;
 	virtual void do_set_to_exit();
+	virtual bool do_next_iteration(index_value_array_t& index_values);
+	virtual bool do_may_enumerate() const;
 
 	DISALLOW_COPY_AND_ASSIGN(LoopManager);
 };
@@ -125,6 +147,7 @@ protected:
 	virtual std::string to_string() const;
 	virtual bool do_update();
 	virtual void do_finalize();
+	virtual bool do_next_iteration(index_value_array_t& index_values);
 	bool first_time_;
 	int num_indices_;
 	long iteration_;
@@ -174,6 +197,7 @@ private:
 	virtual std::string to_string() const;
 	virtual bool do_update();
 	virtual void do_finalize();
+	virtual bool do_next_iteration(index_value_array_t& index_values);
 	bool first_time_;
 	int num_indices_;
 	long& iteration_;
@@ -188,15 +212,159 @@ private:
 	int company_rank_;
 	int num_workers_;
 	Interpreter* interpreter_;
+	int pardo_pc_;
+
+	/** The iterations of this pardo found by an earlier execution, and the position of the
+	 * next one.  NULL if the where clauses are evaluated. */
+	const std::vector<int>* cached_;
+	long cached_next_;
+	bool recording_;  //the iterations are being recorded in the where clause cache
 
 	bool increment_indices();
 	bool initialize_indices();
+	bool next_cached_iteration();
+	void record_iteration();
 
 	DISALLOW_COPY_AND_ASSIGN(BalancedTaskAllocParallelPardoLoop);
 
 };
 
 
+/**
+ * Base class for loop managers that enumerate the iterations whose where clauses are
+ * true at the first update, in the same order at every worker, and then execute the
+ * subset of them chosen by the subclass with start_iteration.
+ *
+ * The where clauses are evaluated again by start_iteration to set the pc, so they must
+ * not depend on values computed in the loop.  Cannot look ahead.
+ */
+class EnumeratedParallelPardoLoop: public LoopManager {
+public:
+	virtual ~EnumeratedParallelPardoLoop();
+protected:
+	EnumeratedParallelPardoLoop(int num_indices,
+			const int (&index_ids)[MAX_RANK], DataManager & data_manager,
+			const SipTables & sip_tables, int num_where_clauses,
+			Interpreter* interpreter, long& iteration);
+
+	/** Fills iterations_, calling iteration_found for each iteration while the indices
+	 * have its values. */
+	void enumerate_iterations();
+	/** Called by enumerate_iterations */
+	virtual void iteration_found() {}
+
+	/** Sets the indices to the values of the given iteration and the pc after the last
+	 * where clause */
+	void start_iteration(long k);
+
+	virtual std::string to_string() const;
+	virtual void do_finalize();
+	virtual bool do_may_enumerate() const;
+
+	int num_indices_;
+	long& iteration_;
+	index_selector_t index_id_;
+	index_value_array_t lower_seg_;
+	index_value_array_t upper_bound_;
+	int num_where_clauses_;
+	int pardo_pc_;
+
+	DataManager & data_manager_;
+	const SipTables & sip_tables_;
+	Interpreter* interpreter_;
+
+	/** index values of the iterations whose where clauses are true, num_indices_ each */
+	std::vector<int> iterations_;
+	long num_iterations_;
+
+private:
+	bool increment_indices();
+	bool initialize_indices();
+
+	DISALLOW_COPY_AND_ASSIGN(EnumeratedParallelPardoLoop);
+};
+
+
+/**
+ * Hands out the iterations of the loop dynamically.
+ *
+ * Each worker claims guided chunks of the enumerated iterations from the shared counter
+ * of the pardo (see PardoTaskCounter) until all of them have been claimed.  So workers
+ * that are delayed or got cheap iterations do not wait for the others at the next
+ * barrier.  Since the counter is a single slot at the company master, stealing between
+ * workers is not needed.
+ */
+class DynamicTaskAllocParallelPardoLoop: public EnumeratedParallelPardoLoop {
+public:
+	DynamicTaskAllocParallelPardoLoop(int num_indices,
+			const int (&index_ids)[MAX_RANK], DataManager & data_manager,
+			const SipTables & sip_tables, SIPMPIAttr& sip_mpi_attr,
+			int num_where_clauses, Interpreter* interpreter, long& iteration);
+	virtual ~DynamicTaskAllocParallelPardoLoop();
+	friend std::ostream& operator<<(std::ostream&,
+			const DynamicTaskAllocParallelPardoLoop &);
+private:
+	virtual std::string to_string() const;
+	virtual bool do_update();
+	bool first_time_;
+	long next_;   //next iteration of the claimed chunk
+	long end_;    //end of the claimed chunk
+
+	DISALLOW_COPY_AND_ASSIGN(DynamicTaskAllocParallelPardoLoop);
+
+};
+
+
+/**
+ * Gives each worker a contiguous range of the enumerated iterations with about the same
+ * estimated cost.
+ *
+ * The cost of an iteration is the number of flops of the contractions in the body of the
+ * loop plus the number of elements of the blocks it gets and puts.  The extent of a pardo
+ * index is that of its segment in the iteration, and an index without a value, which
+ * must be an index of a do loop in the body, contributes the extent of its whole range.
+ * A subindex contributes the extent of its parent.  Where clauses, if statements and
+ * cached blocks are ignored, and an iteration without contractions and transfers has
+ * cost 1.
+ */
+class WeightedTaskAllocParallelPardoLoop: public EnumeratedParallelPardoLoop {
+public:
+	WeightedTaskAllocParallelPardoLoop(int num_indices,
+			const int (&index_ids)[MAX_RANK], DataManager & data_manager,
+			const SipTables & sip_tables, SIPMPIAttr& sip_mpi_attr,
+			int num_where_clauses, Interpreter* interpreter, long& iteration);
+	virtual ~WeightedTaskAllocParallelPardoLoop();
+	friend std::ostream& operator<<(std::ostream&,
+			const WeightedTaskAllocParallelPardoLoop &);
+private:
+	virtual std::string to_string() const;
+	virtual bool do_update();
+	virtual void iteration_found();
+	bool first_time_;
+	int company_rank_;
+	int num_workers_;
+	long next_;   //next iteration of this worker
+	long end_;    //end of the iterations of this worker
+
+	/** The indices of the blocks in a term of the cost, which is
+	 * multiplier_ * (product of the extents of the indices) */
+	struct CostTerm {
+		std::vector<int> index_ids_;
+		double multiplier_;
+	};
+	std::vector<CostTerm> cost_terms_;
+	std::vector<double> weights_; //of the enumerated iterations
+
+	/** Builds cost_terms_ from the body of the pardo */
+	void find_cost_terms();
+	void add_cost_term(int selector_pc, int other_selector_pc, double multiplier);
+	double extent(int index_id) const;
+
+	DISALLOW_COPY_AND_ASSIGN(WeightedTaskAllocParallelPardoLoop);
+
+};
+
+
 #endif
 
 } /* namespace sip */
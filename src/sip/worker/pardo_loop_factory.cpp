@@ -34,6 +34,8 @@ std::map<std::string, enum PardoLoopFactory::Loop_t> PardoLoopFactory::pardo_var
 #ifdef HAVE_MPI
 ("StaticTaskAllocParallelPardoLoop",PardoLoopFactory::StaticTaskAllocParallelPardoLoop)
 ("BalancedTaskAllocParallelPardoLoop",PardoLoopFactory::BalancedTaskAllocParallelPardoLoop)
+("DynamicTaskAllocParallelPardoLoop",PardoLoopFactory::DynamicTaskAllocParallelPardoLoop)
+("WeightedTaskAllocParallelPardoLoop",PardoLoopFactory::WeightedTaskAllocParallelPardoLoop)
 ("Frag{Nij}{aa}{}", PardoLoopFactory::Fragment_Nij_aa__PardoLoopManager)
 ("Frag{Nij}{a}{a}", PardoLoopFactory::Fragment_Nij_a_a_PardoLoopManager)
 ("Frag{Nij}{o}{o}", PardoLoopFactory::Fragment_Nij_o_o_PardoLoopManager)
@@ -124,6 +126,14 @@ std::map<std::string, enum PardoLoopFactory::Loop_t> PardoLoopFactory::pardo_var
 			return  new sip::BalancedTaskAllocParallelPardoLoop(
 				num_indices, index_ids, data_manager, sip_tables,
 				sip_mpi_attr, num_where_clauses, interpreter, iteration);
+		case DynamicTaskAllocParallelPardoLoop:
+			return  new sip::DynamicTaskAllocParallelPardoLoop(
+				num_indices, index_ids, data_manager, sip_tables,
+				sip_mpi_attr, num_where_clauses, interpreter, iteration);
+		case WeightedTaskAllocParallelPardoLoop:
+			return  new sip::WeightedTaskAllocParallelPardoLoop(
+				num_indices, index_ids, data_manager, sip_tables,
+				sip_mpi_attr, num_where_clauses, interpreter, iteration);
 		case Fragment_Nij_aa__PardoLoopManager:
 			return new sip::Fragment_Nij_aa__PardoLoopManager(
 			num_indices, index_ids, data_manager, sip_tables,
@@ -59,6 +59,8 @@ public:
 		TestStaticTaskAllocParallelPardoLoop,
 		StaticTaskAllocParallelPardoLoop,
 		BalancedTaskAllocParallelPardoLoop,
+		DynamicTaskAllocParallelPardoLoop,
+		WeightedTaskAllocParallelPardoLoop,
 		Fragment_Nij_aa__PardoLoopManager,
 		Fragment_Nij_a_a_PardoLoopManager,
 		Fragment_Nij_o_o_PardoLoopManager,
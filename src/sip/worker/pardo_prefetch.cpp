@@ -0,0 +1,94 @@
+/*
+ * pardo_prefetch.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "pardo_prefetch.h"
+#include <algorithm>
+#include "array_constants.h"
+#include "op_table.h"
+#include "sip_tables.h"
+
+namespace sip {
+
+std::size_t PardoPrefetch::max_bytes_ = PardoPrefetch::DEFAULT_MAX_BYTES;
+
+PardoPrefetch::PardoPrefetch(const SipTables& sip_tables, const OpTable& op_table) :
+		gets_(sip_tables.op_table_size()),
+		num_loops_(0),
+		num_lookaheads_(0),
+		num_prefetches_(0),
+		num_hits_(0)
+#ifdef HAVE_MPI
+		, stats_(SIPMPIAttr::get_instance().company_communicator())
+#endif //HAVE_MPI
+{
+	for (int pc = 0; pc < op_table.size(); ++pc) {
+		if (op_table.opcode(pc) != pardo_op) continue;
+		analyze_body(sip_tables, op_table, pc);
+		if (!gets_[pc].empty()) ++num_loops_;
+	}
+}
+
+PardoPrefetch::~PardoPrefetch() {
+}
+
+void PardoPrefetch::set_max_bytes(std::size_t max_bytes) {
+	max_bytes_ = max_bytes;
+}
+
+std::size_t PardoPrefetch::max_bytes() {
+	return max_bytes_;
+}
+
+void PardoPrefetch::analyze_body(const SipTables& sip_tables, const OpTable& op_table,
+		int pardo_pc) {
+	int end_pc = op_table.arg0(pardo_pc);
+	int num_indices = op_table.arg1(pardo_pc);
+	int num_where_clauses = op_table.arg2(pardo_pc);
+	const index_selector_t& pardo_indices = op_table.index_selectors(pardo_pc);
+
+	//the where clauses are evaluated again for the lookahead, so they must not touch blocks
+	int pc = pardo_pc + 1;
+	for (int where = 0; where < num_where_clauses && pc < end_pc; ++pc) {
+		opcode_t opcode = op_table.opcode(pc);
+		if (opcode == block_load_scalar_op || opcode == push_block_selector_op) return;
+		if (opcode == where_op) ++where;
+	}
+
+	//indices whose values change in the body
+	std::vector<int> loop_indices;
+	for (pc = pardo_pc + 1; pc < end_pc; ++pc) {
+		opcode_t opcode = op_table.opcode(pc);
+		if (opcode == do_op || opcode == dosubindex_op) {
+			loop_indices.push_back(op_table.index_selectors(pc)[0]);
+		}
+	}
+
+	for (pc = pardo_pc + 2; pc < end_pc; ++pc) {
+		if (op_table.opcode(pc) != get_op || op_table.opcode(pc - 1) != push_block_selector_op)
+			continue;
+		int rank = op_table.arg0(pc - 1);
+		int array_id = op_table.arg1(pc - 1);
+		if (!sip_tables.is_distributed(array_id)) continue;
+		const index_selector_t& selector_indices = op_table.index_selectors(pc - 1);
+		bool ok = true;
+		for (int i = 0; i < rank && ok; ++i) {
+			int slot = selector_indices[i];
+			if (slot == wild_card_slot || slot == unused_index_slot || sip_tables.is_subindex(slot)) {
+				ok = false;
+			} else if (std::find(pardo_indices, pardo_indices + num_indices, slot)
+					== pardo_indices + num_indices) {
+				ok = std::find(loop_indices.begin(), loop_indices.end(), slot) == loop_indices.end();
+			}
+		}
+		if (ok) {
+			gets_[pardo_pc].push_back(Get(pc, BlockSelector(rank, array_id, selector_indices)));
+		}
+	}
+}
+
+} /* namespace sip */
@@ -0,0 +1,170 @@
+/*
+ * pardo_prefetch.h
+ *
+ * Prefetching of the blocks of distributed arrays needed by the next iteration of a pardo.
+ *
+ * Once a worker starts an iteration of a pardo loop, the interpreter asks the loop's
+ * LoopManager for the index values of the next iteration it will execute, and posts the GETs
+ * of that iteration.  The blocks then arrive while the current iteration computes, and the
+ * get in the next iteration finds them already present or in flight.
+ *
+ * The gets that can be prefetched are found once, when the program is loaded.  For each
+ * pardo, these are the get instructions in its body whose block selector follows a
+ * push_block_selector_op, refers to a distributed array, and uses only the pardo's indices
+ * and indices whose value does not change in the body.  Selectors with subindices or indices
+ * of do loops in the body are skipped, as are pardos whose where clauses load block values.
+ *
+ * Prefetched blocks are not counted against the scope of the current iteration.  The get
+ * that uses one adds it to its own scope; unused ones are deleted at the next barrier.  At
+ * most max_bytes() of prefetched, not yet used blocks are held, and a prefetch is skipped if
+ * it would require evicting cached blocks.  A prefetch is only issued for an array that has
+ * already been read since the last barrier, so it never introduces a data race error.
+ * A max_bytes() of 0 disables prefetching.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef PARDO_PREFETCH_H_
+#define PARDO_PREFETCH_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "block_selector.h"
+#include "counter.h"
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#endif //HAVE_MPI
+
+namespace sip {
+
+class SipTables;
+class OpTable;
+
+class PardoPrefetch {
+public:
+	/** A get instruction that may be prefetched and its selector */
+	struct Get {
+		Get(int pc, const BlockSelector& selector) : pc_(pc), selector_(selector) {}
+		int pc_;
+		BlockSelector selector_;
+	};
+	typedef std::vector<Get> GetList;
+
+	static const std::size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+	PardoPrefetch(const SipTables& sip_tables, const OpTable& op_table);
+	~PardoPrefetch();
+
+	/** Sets the maximum number of bytes in prefetched blocks that have not been used yet.
+	 * 0 disables prefetching. */
+	static void set_max_bytes(std::size_t max_bytes);
+	static std::size_t max_bytes();
+
+	/** true if the next iteration of the pardo whose pardo_op is at pc should be prefetched */
+	bool enabled(int pc) const { return max_bytes_ > 0 && !gets_[pc].empty(); }
+
+	/** The gets that may be prefetched for the pardo at pc */
+	const GetList& gets(int pc) const { return gets_[pc]; }
+
+	std::size_t num_loops() const { return num_loops_; }
+
+	/** Records a lookahead and the number of GETs it issued */
+	void record(std::size_t num_prefetches) {
+		num_lookaheads_++;
+		num_prefetches_ += num_prefetches;
+	}
+
+	/** Records a get satisfied by a prefetch */
+	void record_hit() { num_hits_++; }
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		stats_.gather_and_print_statistics(os, this);
+	}
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * num_lookaheads_ counts the iterations whose successor was prefetched, num_prefetches_
+	 * the GETs issued for them, and num_hits_ the gets that found a prefetched block.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_lookaheads_;
+		MPICounter num_prefetches_;
+		MPICounter num_hits_;
+
+		explicit Stats(const MPI_Comm& comm) :
+				num_lookaheads_(comm), num_prefetches_(comm), num_hits_(comm) {
+		}
+
+		void finalize(PardoPrefetch* parent) {
+			num_lookaheads_.inc(parent->num_lookaheads_);
+			num_prefetches_.inc(parent->num_prefetches_);
+			num_hits_.inc(parent->num_hits_);
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, PardoPrefetch* parent) {
+			finalize(parent);
+			num_prefetches_.reduce();
+			num_hits_.reduce();
+			num_lookaheads_.gather();
+			num_prefetches_.gather();
+			num_hits_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker pardo prefetch, max bytes," << PardoPrefetch::max_bytes()
+						<< ", loops," << parent->num_loops_ << std::endl;
+				os << "num_lookaheads_" << std::endl << num_lookaheads_;
+				os << "num_prefetches_" << std::endl << num_prefetches_;
+				os << "num_hits_" << std::endl << num_hits_;
+				os << "hit rate," << hit_rate(num_hits_.get_reduced_value(),
+						num_prefetches_.get_reduced_value()) << std::endl;
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		std::ostream& gather_and_print_statistics(std::ostream& os, PardoPrefetch* parent) {
+			os << "Worker pardo prefetch, max bytes," << PardoPrefetch::max_bytes()
+					<< ", loops," << parent->num_loops_ << std::endl;
+			os << "num_lookaheads_," << parent->num_lookaheads_ << std::endl;
+			os << "num_prefetches_," << parent->num_prefetches_ << std::endl;
+			os << "num_hits_," << parent->num_hits_ << std::endl;
+			os << "hit rate," << hit_rate(parent->num_hits_, parent->num_prefetches_) << std::endl;
+			os << std::endl;
+			return os;
+		}
+	};
+#endif //HAVE_MPI
+
+	/** Fraction of the prefetched blocks that were used */
+	static double hit_rate(std::size_t hits, std::size_t prefetches) {
+		return prefetches > 0 ? static_cast<double>(hits) / prefetches : 0.0;
+	}
+
+private:
+	void analyze_body(const SipTables& sip_tables, const OpTable& op_table, int pardo_pc);
+
+	static std::size_t max_bytes_;
+
+	/** pc of pardo_op -> gets that may be prefetched.  Empty for other pcs. */
+	std::vector<GetList> gets_;
+	std::size_t num_loops_;
+
+	std::size_t num_lookaheads_;
+	std::size_t num_prefetches_;
+	std::size_t num_hits_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(PardoPrefetch);
+};
+
+} /* namespace sip */
+
+#endif /* PARDO_PREFETCH_H_ */
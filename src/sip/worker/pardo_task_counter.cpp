@@ -0,0 +1,94 @@
+/*
+ * pardo_task_counter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "pardo_task_counter.h"
+#include <algorithm>
+#include "sip_mpi_utils.h"
+
+namespace sip {
+
+PardoTaskCounter::PardoTaskCounter(int num_slots, SIPMPIAttr& sip_mpi_attr) :
+		sip_mpi_attr_(sip_mpi_attr), num_slots_(num_slots), win_(MPI_WIN_NULL),
+		base_(NULL), generations_(num_slots, 0), observed_(num_slots, 0),
+		num_loops_(sip_mpi_attr.company_communicator()),
+		num_chunks_(sip_mpi_attr.company_communicator()),
+		num_failed_claims_(sip_mpi_attr.company_communicator()),
+		num_iterations_(sip_mpi_attr.company_communicator()) {
+}
+
+PardoTaskCounter::~PardoTaskCounter() {
+	//normally already freed at the end of the program
+	free_window();
+}
+
+void PardoTaskCounter::create_window() {
+	if (win_ != MPI_WIN_NULL) return;
+	MPI_Aint local_bytes = 0;
+	if (sip_mpi_attr_.is_company_master()) {
+		local_bytes = num_slots_ * sizeof(long long);
+	}
+	SIPMPIUtils::check_err(
+			MPI_Win_allocate(local_bytes, sizeof(long long), MPI_INFO_NULL,
+					sip_mpi_attr_.company_communicator(), &base_, &win_));
+	if (sip_mpi_attr_.is_company_master()) {
+		std::fill(base_, base_ + num_slots_, 0LL);
+	}
+	std::fill(generations_.begin(), generations_.end(), 0LL);
+	std::fill(observed_.begin(), observed_.end(), 0LL);
+	//the slots must be zero before any worker accesses them
+	SIPMPIUtils::check_err(MPI_Barrier(sip_mpi_attr_.company_communicator()));
+	SIPMPIUtils::check_err(MPI_Win_lock_all(MPI_MODE_NOCHECK, win_));
+}
+
+void PardoTaskCounter::free_window() {
+	if (win_ == MPI_WIN_NULL) return;
+	SIPMPIUtils::check_err(MPI_Win_unlock_all(win_));
+	SIPMPIUtils::check_err(MPI_Win_free(&win_));
+	base_ = NULL;
+}
+
+void PardoTaskCounter::begin_loop(int pc) {
+	++generations_.at(pc);
+	CHECK(generations_[pc] < MAX_GENERATION, "too many executions of a dynamic pardo");
+	num_loops_.inc();
+}
+
+bool PardoTaskCounter::claim(int pc, long num_iterations, long& begin, long& end) {
+	CHECK(win_ != MPI_WIN_NULL, "dynamic pardo without a task counter window");
+	long long generation = generations_.at(pc);
+	long long observed = observed_[pc];
+	while (true) {
+		long long observed_generation = observed >> COUNT_BITS;
+		if (observed_generation > generation) break;  //the other workers are done
+		long long claimed = observed_generation < generation ? 0 : observed & COUNT_MASK;
+		if (claimed >= num_iterations) break;
+		long long remaining = num_iterations - claimed;
+		long long chunk = std::max(1LL,
+				remaining / (GUIDED_DIVISOR * sip_mpi_attr_.num_workers()));
+		long long desired = (generation << COUNT_BITS) | (claimed + chunk);
+		long long result;
+		SIPMPIUtils::check_err(
+				MPI_Compare_and_swap(&desired, &observed, &result, MPI_LONG_LONG, 0, pc,
+						win_));
+		SIPMPIUtils::check_err(MPI_Win_flush(0, win_));
+		if (result == observed) {
+			observed_[pc] = desired;
+			begin = claimed;
+			end = claimed + chunk;
+			num_chunks_.inc();
+			num_iterations_.inc(chunk);
+			return true;
+		}
+		num_failed_claims_.inc();
+		observed = result;
+	}
+	observed_[pc] = observed;
+	return false;
+}
+
+} /* namespace sip */
@@ -0,0 +1,115 @@
+/*
+ * pardo_task_counter.h
+ *
+ * Shared iteration counters for dynamically scheduled pardo loops.
+ *
+ * The counters are kept in an MPI window at the company master, one 64 bit slot per
+ * op, indexed by the pc of the pardo.  Each worker enumerates the iterations of the loop
+ * in the same order and claims chunks of them by atomically advancing the counter of the
+ * pardo with MPI_Compare_and_swap.  The size of the chunk is a fraction of the iterations
+ * that have not been claimed yet (guided scheduling), so the chunks shrink towards the
+ * end of the loop and workers that arrive late or got cheap iterations take more of them.
+ *
+ * Since there is no barrier between two executions of the same pardo, a slot holds the
+ * number of times the pardo has been executed (the generation, which is the same at all
+ * workers) in its upper bits and the number of claimed iterations in the lower bits.  A
+ * worker starting a new execution resets the count when it sees an older generation.  A
+ * worker only starts a new execution after it failed to claim a chunk of the previous one,
+ * i.e. after all its iterations were claimed, so a worker that sees a newer generation
+ * knows that its execution is done.
+ *
+ * create_window and free_window are collective over the company communicator.  Workers
+ * hold a passive target epoch on the master (MPI_Win_lock_all) in between.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef PARDO_TASK_COUNTER_H_
+#define PARDO_TASK_COUNTER_H_
+
+#include <mpi.h>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "counter.h"
+#include "sip_mpi_attr.h"
+
+namespace sip {
+
+class PardoTaskCounter {
+public:
+	/** A chunk is 1/GUIDED_DIVISOR of the unclaimed iterations per worker */
+	static const int GUIDED_DIVISOR = 2;
+
+	/** num_slots is the size of the op table */
+	PardoTaskCounter(int num_slots, SIPMPIAttr& sip_mpi_attr);
+
+	/** Frees the window if free_window has not been called. */
+	~PardoTaskCounter();
+
+	/** Collective over the company communicator.  Called by the workers at the start of
+	 * each SIAL program. */
+	void create_window();
+
+	/** Collective over the company communicator.  Called by the workers at the end of
+	 * each SIAL program. */
+	void free_window();
+
+	bool has_window() const { return win_ != MPI_WIN_NULL; }
+
+	/** Starts a new execution of the pardo at pc.  Local. */
+	void begin_loop(int pc);
+
+	/**
+	 * Claims the next chunk of the current execution of the pardo at pc, which has
+	 * num_iterations iterations.  Sets [begin, end) to the claimed iterations and returns
+	 * true, or returns false if all iterations have been claimed.
+	 */
+	bool claim(int pc, long num_iterations, long& begin, long& end);
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		num_loops_.gather();
+		num_chunks_.gather();
+		num_failed_claims_.gather();
+		num_iterations_.gather();
+		if (sip_mpi_attr_.is_company_master()) {
+			os << "Worker dynamically scheduled pardo loops" << std::endl;
+			os << num_loops_ << std::endl;
+			os << "Worker chunks of pardo iterations claimed" << std::endl;
+			os << num_chunks_ << std::endl;
+			os << "Worker compare and swaps that had to be retried" << std::endl;
+			os << num_failed_claims_ << std::endl;
+			os << "Worker pardo iterations claimed" << std::endl;
+			os << num_iterations_ << std::endl;
+		}
+	}
+
+private:
+	static const int COUNT_BITS = 40;
+	static const long long COUNT_MASK = (1LL << COUNT_BITS) - 1;
+	static const long long MAX_GENERATION = 1LL << (63 - COUNT_BITS);
+
+	SIPMPIAttr& sip_mpi_attr_;
+	const int num_slots_;
+	MPI_Win win_;
+	long long* base_;  //slots, allocated at the company master
+
+	/** Number of executions of each pardo by this worker */
+	std::vector<long long> generations_;
+	/** Last value of each slot seen by this worker, used as the compare value of the
+	 * next claim */
+	std::vector<long long> observed_;
+
+	MPICounter num_loops_;
+	MPICounter num_chunks_;
+	MPICounter num_failed_claims_;
+	MPICounter num_iterations_;
+
+	DISALLOW_COPY_AND_ASSIGN(PardoTaskCounter);
+};
+
+} /* namespace sip */
+
+#endif /* PARDO_TASK_COUNTER_H_ */
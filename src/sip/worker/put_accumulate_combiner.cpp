@@ -0,0 +1,119 @@
+/*
+ * put_accumulate_combiner.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "put_accumulate_combiner.h"
+#include <algorithm>
+#include "block_kernels.h"
+#include "sip_mpi_utils.h"
+#include "memory_tracker.h"
+
+namespace sip {
+
+std::size_t PutAccumulateCombiner::max_bytes_ = PutAccumulateCombiner::DEFAULT_MAX_BYTES;
+
+PutAccumulateCombiner::PutAccumulateCombiner() :
+		bytes_(0),
+		num_puts_(0),
+		num_combined_(0),
+		num_evicted_(0),
+		bytes_saved_(0),
+		max_used_bytes_(0),
+		stats_(SIPMPIAttr::get_instance().company_communicator()) {
+}
+
+PutAccumulateCombiner::~PutAccumulateCombiner() {
+	//contributions should have been sent at the last barrier
+	for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+		MemoryTracker::global->dec_allocated(it->second.size_);
+		delete [] it->second.buffer_;
+	}
+}
+
+void PutAccumulateCombiner::set_max_bytes(std::size_t max_bytes) {
+	max_bytes_ = max_bytes;
+}
+
+std::size_t PutAccumulateCombiner::max_bytes() {
+	return max_bytes_;
+}
+
+bool PutAccumulateCombiner::add(const BlockId& id, const double* data, std::size_t size,
+		int pc, ContributionList& evicted) {
+	std::size_t bytes = size * sizeof(double);
+	if (bytes == 0 || bytes > max_bytes_) return false;
+	num_puts_++;
+
+	EntryMap::iterator it = entries_.find(id);
+	if (it != entries_.end()) {
+		Entry& entry = it->second;
+		CHECK(entry.size_ == size, "put_accumulate source blocks of unequal size");
+		double* sum = reinterpret_cast<double*>(entry.buffer_ + SIPMPIUtils::EAGER_PUT_HEADER_BYTES);
+		block_kernels::accumulate(sum, data, size);
+		entry.pc_ = pc;
+		num_combined_++;
+		bytes_saved_ += bytes;
+		return true;
+	}
+
+	while (bytes_ + bytes > max_bytes_) {
+		remove(entries_.find(ages_.front()), evicted);
+		num_evicted_++;
+	}
+
+	Entry entry;
+	entry.buffer_ = new char[SIPMPIUtils::eager_put_bytes(size)];
+	std::copy(data, data + size,
+			reinterpret_cast<double*>(entry.buffer_ + SIPMPIUtils::EAGER_PUT_HEADER_BYTES));
+	entry.size_ = size;
+	entry.pc_ = pc;
+	entry.age_ = ages_.insert(ages_.end(), id);
+	entries_.insert(std::make_pair(id, entry));
+	MemoryTracker::global->inc_allocated(size);
+	bytes_ += bytes;
+	max_used_bytes_ = std::max(max_used_bytes_, bytes_);
+	return true;
+}
+
+bool PutAccumulateCombiner::remove_block(const BlockId& id, ContributionList& removed) {
+	EntryMap::iterator it = entries_.find(id);
+	if (it == entries_.end()) return false;
+	remove(it, removed);
+	return true;
+}
+
+void PutAccumulateCombiner::remove_array(int array_id, ContributionList& removed) {
+	EntryMap::iterator it = entries_.begin();
+	while (it != entries_.end()) {
+		if (it->first.array_id() == array_id) {
+			remove(it++, removed);
+		} else {
+			++it;
+		}
+	}
+}
+
+void PutAccumulateCombiner::remove_all(ContributionList& removed) {
+	while (!entries_.empty()) {
+		remove(entries_.find(ages_.front()), removed);
+	}
+}
+
+void PutAccumulateCombiner::remove(EntryMap::iterator it, ContributionList& removed) {
+	Contribution contribution;
+	contribution.id_ = it->first;
+	contribution.buffer_ = it->second.buffer_;
+	contribution.size_ = it->second.size_;
+	contribution.pc_ = it->second.pc_;
+	removed.push_back(contribution);
+	bytes_ -= contribution.size_ * sizeof(double);
+	MemoryTracker::global->dec_allocated(contribution.size_);
+	ages_.erase(it->second.age_);
+	entries_.erase(it);
+}
+
+} /* namespace sip */
@@ -0,0 +1,170 @@
+/*
+ * put_accumulate_combiner.h
+ *
+ * Worker side combining of put_accumulate contributions.
+ *
+ * Within a section between two barriers, a block of a distributed or served array may only
+ * be the target of put_accumulates, whose order does not matter (this is checked at the
+ * server by DistributedBlockConsistency).  So instead of sending every contribution, a
+ * worker sums the contributions to the same block locally and sends the sum once.
+ *
+ * Each combined block is kept in a buffer laid out as a SIPMPIUtils eager put message, so
+ * the buffer can be sent as is after the header is filled in.  Blocks are removed, and must
+ * be sent by the caller, when the buffers would exceed max_bytes() (oldest block first), when
+ * their array is deleted, and at the barrier.  The server allows a worker to follow its
+ * put_accumulates to a block with a get or another put in the same section, so the
+ * contribution to a block is also removed before the worker sends any other operation on
+ * it, which then arrives at the server after the contribution.  A max_bytes() of 0 disables combining.
+ * The data of the combined blocks is charged to the MemoryTracker until it is removed, so
+ * the worker's block map leaves room for it.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef PUT_ACCUMULATE_COMBINER_H_
+#define PUT_ACCUMULATE_COMBINER_H_
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "block_id.h"
+#include "counter.h"
+#include "sip_mpi_attr.h"
+
+namespace sip {
+
+class PutAccumulateCombiner {
+public:
+	/** The combined contribution to a block, removed from the combiner.  The receiver
+	 * owns buffer_, which was allocated with new[] and holds an eager put message whose
+	 * header has not been written yet. */
+	struct Contribution {
+		BlockId id_;
+		char* buffer_;
+		std::size_t size_;  //number of doubles
+		int pc_;            //of the last put_accumulate
+	};
+	typedef std::vector<Contribution> ContributionList;
+
+	static const std::size_t DEFAULT_MAX_BYTES = 32 * 1024 * 1024;
+
+	PutAccumulateCombiner();
+	~PutAccumulateCombiner();
+
+	/** Sets the maximum number of bytes in combined blocks.  0 disables combining. */
+	static void set_max_bytes(std::size_t max_bytes);
+	static std::size_t max_bytes();
+
+	/**
+	 * Adds data to the combined contribution to block id.
+	 *
+	 * Returns false, and does nothing, if combining is disabled or the block alone does not
+	 * fit in max_bytes().  Otherwise, contributions evicted to make room are appended to
+	 * evicted.
+	 */
+	bool add(const BlockId& id, const double* data, std::size_t size, int pc,
+			ContributionList& evicted);
+
+	/** Removes the contribution to block id, if any, appending it to removed.  Returns
+	 * whether there was one. */
+	bool remove_block(const BlockId& id, ContributionList& removed);
+
+	/** Removes the contributions to blocks of the given array, appending them to removed */
+	void remove_array(int array_id, ContributionList& removed);
+
+	/** Removes all contributions, appending them to removed */
+	void remove_all(ContributionList& removed);
+
+	std::size_t num_blocks() const { return entries_.size(); }
+	std::size_t bytes() const { return bytes_; }
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		stats_.gather_and_print_statistics(os, this);
+	}
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * num_puts_ counts the put_accumulates given to add, num_combined_ those added to an
+	 * existing contribution, num_evicted_ the contributions removed to make room,
+	 * and bytes_saved_ the data that was not sent because it was combined.
+	 */
+	struct Stats {
+		MPICounter num_puts_;
+		MPICounter num_combined_;
+		MPICounter num_evicted_;
+		MPICounter bytes_saved_;
+		MPIMaxCounter max_bytes_;
+
+		explicit Stats(const MPI_Comm& comm) :
+				num_puts_(comm), num_combined_(comm), num_evicted_(comm),
+				bytes_saved_(comm), max_bytes_(comm) {
+		}
+
+		void finalize(PutAccumulateCombiner* parent) {
+			num_puts_.inc(parent->num_puts_);
+			num_combined_.inc(parent->num_combined_);
+			num_evicted_.inc(parent->num_evicted_);
+			bytes_saved_.inc(parent->bytes_saved_);
+			max_bytes_.set(parent->max_used_bytes_);
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os,
+				PutAccumulateCombiner* parent) {
+			finalize(parent);
+			bytes_saved_.reduce();
+			num_puts_.gather();
+			num_combined_.gather();
+			num_evicted_.gather();
+			bytes_saved_.gather();
+			max_bytes_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker put_accumulate combining, max bytes,"
+						<< PutAccumulateCombiner::max_bytes() << std::endl;
+				os << "num_puts_" << std::endl << num_puts_;
+				os << "num_combined_" << std::endl << num_combined_;
+				os << "num_evicted_" << std::endl << num_evicted_;
+				os << "bytes_saved_" << std::endl << bytes_saved_;
+				os << "total bytes saved," << bytes_saved_.get_reduced_value() << std::endl;
+				os << "max_bytes_" << std::endl << max_bytes_;
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+
+private:
+	struct Entry {
+		char* buffer_;
+		std::size_t size_;
+		int pc_;
+		std::list<BlockId>::iterator age_;  //position in ages_
+	};
+	typedef std::map<BlockId, Entry> EntryMap;
+
+	static std::size_t max_bytes_;
+
+	EntryMap entries_;
+	std::list<BlockId> ages_;  //oldest first
+	std::size_t bytes_;
+
+	void remove(EntryMap::iterator it, ContributionList& removed);
+
+	std::size_t num_puts_;
+	std::size_t num_combined_;
+	std::size_t num_evicted_;
+	std::size_t bytes_saved_;
+	std::size_t max_used_bytes_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(PutAccumulateCombiner);
+};
+
+} /* namespace sip */
+
+#endif /* PUT_ACCUMULATE_COMBINER_H_ */
@@ -7,18 +7,22 @@
 #include <iostream>
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
 #include "sip_mpi_utils.h"
 #include "interpreter.h"
 
 #include "sip_tables.h"
 #include "data_manager.h"
 #include "worker_persistent_array_manager.h"
+#include "memory_tracker.h"
 
 namespace sip {
 
 int SialOpsPid_line_section_size = BlockId::MPI_BLOCK_ID_COUNT + 2;
 
 #ifdef HAVE_MPI //only compile if parallel
+const std::size_t SialOpsParallel::BROADCAST_CHUNK_DOUBLES;
+
 SialOpsParallel::SialOpsParallel(DataManager& data_manager,
 		WorkerPersistentArrayManager* persistent_array_manager,
 		const SipTables& sip_tables) :
@@ -26,28 +30,46 @@ SialOpsParallel::SialOpsParallel(DataManager& data_manager,
 				SIPMPIAttr::get_instance()), data_manager_(data_manager), block_manager_(
 				data_manager.block_manager_), data_distribution_(sip_tables_,
 				sip_mpi_attr_), persistent_array_manager_(
-				persistent_array_manager), mode_(sip_tables_.num_arrays(), NONE),
-				wait_time_(sip_mpi_attr_.company_communicator(), sip_tables_.op_table_size()+1)
+				persistent_array_manager), rma_arrays_(sip_tables_, data_distribution_, sip_mpi_attr_),
+				mode_(sip_tables_.num_arrays(), NONE),
+				wait_time_(sip_mpi_attr_.company_communicator(), sip_tables_.op_table_size()+1),
+				written_(sip_tables_.num_arrays(), 0),
+				barrier_request_(MPI_REQUEST_NULL), barrier_pc_(0), barrier_pending_(false),
+				num_retained_blocks_(sip_mpi_attr_.company_communicator()),
+				prefetched_bytes_(0),
+				queued_gets_server_(-1),
+				num_get_batches_(sip_mpi_attr_.company_communicator()),
+				num_batched_gets_(sip_mpi_attr_.company_communicator()),
+				num_node_local_gets_(sip_mpi_attr_.company_communicator()),
+				num_sum_allreduces_(sip_mpi_attr_.company_communicator()),
+				num_batched_sums_(sip_mpi_attr_.company_communicator()),
+				pardo_task_counter_(sip_tables_.op_table_size(), sip_mpi_attr_)
 {
 //	initialize_mpi_type();
 	mpi_type_.initialize_mpi_scalar_op_type();
+	sip_tables_.find_written_arrays(modified_at_servers_);
 }
 
 SialOpsParallel::~SialOpsParallel() {
 }
 
 void SialOpsParallel::sip_barrier(int pc) {
+	complete_barrier();
+	flush_gets();
 
-	// Remove and deallocate cached blocks of distributed and served arrays.
-	// This is done here to ensure that all pending "gets" have been satisfied.
-	//TODO optimize this--if only read and needed in the future, don't need to delete.
-	for (int i = 0; i < sip_tables_.num_arrays(); ++i) {
-		if (sip_tables_.is_distributed(i) || sip_tables_.is_served(i))
-			block_manager_.delete_per_array_map_and_blocks(i);
-	}
+	//Send the combined put_accumulates first so that they are acked below.
+	PutAccumulateCombiner::ContributionList contributions;
+	put_accumulate_combiner_.remove_all(contributions);
+	send_contributions(contributions);
+	prefetched_.clear();
+	prefetched_bytes_ = 0;
 
 	//wait for all expected acks,
 	ack_handler_.wait_all();
+	//the acked eager puts have been received, so this only completes the requests
+	eager_sends_.wait_all();
+	//complete the one-sided operations at the servers before synchronizing
+	rma_arrays_.flush_all();
 
   //At this point, all pending gets have been received and all
  //puts should have been acked, thus the blocks are no longer pending.
@@ -59,13 +81,39 @@ void SialOpsParallel::sip_barrier(int pc) {
 //	CHECK(block_manager_.block_map_.pending_list_size() == 0, "pending list not empty at barrier", current_line());
 
 
-	//Now, do an MPI barrier with the other workers.
-	if (sip_mpi_attr_.company_size() > 1) {
-		wait_time_.start(pc);
-		MPI_Comm worker_comm = sip_mpi_attr_.company_communicator();
-		SIPMPIUtils::check_err(MPI_Barrier(worker_comm));
-		wait_time_.pause(pc);
+	//Now, synchronize with the other workers.  Instead of an MPI_Barrier, the
+	//arrays written in this section by any worker are combined with an allreduce,
+	//which cannot complete before all workers have joined.  It is only started here,
+	//and completed by complete_barrier when this worker needs data that the other
+	//workers may have written in this section, or sends a message to a server.  Until
+	//then, work that does not depend on them, such as computing with local arrays and
+	//getting cached or one-sided blocks of arrays that are not modified at the servers,
+	//overlaps the wait for slower workers.
+	barrier_send_ = written_;
+	barrier_written_ = written_;
+	if (sip_mpi_attr_.company_size() > 1 && !written_.empty()) {
+		SIPMPIUtils::check_err(
+				MPI_Iallreduce(&barrier_send_.front(), &barrier_written_.front(),
+						written_.size(), MPI_INT, MPI_LOR,
+						sip_mpi_attr_.company_communicator(), &barrier_request_));
+	} else if (sip_mpi_attr_.company_size() > 1) {
+		SIPMPIUtils::check_err(
+				MPI_Ibarrier(sip_mpi_attr_.company_communicator(), &barrier_request_));
+	}
+	barrier_pc_ = pc;
+	barrier_pending_ = true;
+
+	// Local copies of blocks of arrays that are not modified at the servers in this
+	// program are only stale if this worker wrote them, so they are handled now.  The
+	// other arrays are handled when the barrier is complete.  This is done after the
+	// acks to ensure that all pending "gets" have been satisfied.
+	for (int i = 0; i < sip_tables_.num_arrays(); ++i) {
+		if ((sip_tables_.is_distributed(i) || sip_tables_.is_served(i))
+				&& !modified_at_servers_[i]) {
+			update_local_copies(i, written_[i]);
+		}
 	}
+	std::fill(written_.begin(), written_.end(), 0);
 	//DEBUG  this code checks that the barrier is from the same op_table entry at each worker.
 	//If not, it prints a warning
 //	int num_workers;
@@ -84,18 +132,58 @@ void SialOpsParallel::sip_barrier(int pc) {
 //		}}
 //	}
 
+	//the section number is updated when the barrier is complete
+	reset_mode();
+	SIP_LOG(std::cout<< "W " << sip_mpi_attr_.global_rank() << " : Done with BARRIER "<< std::endl);
+}
+
+void SialOpsParallel::complete_barrier() {
+	if (!barrier_pending_) return;
+	wait_time_.start(barrier_pc_);
+	SIPMPIUtils::check_err(MPI_Wait(&barrier_request_, MPI_STATUS_IGNORE));
+	wait_time_.pause(barrier_pc_);
+	finish_barrier();
+}
+
+void SialOpsParallel::test_barrier() {
+	if (!barrier_pending_) return;
+	int flag = 0;
+	SIPMPIUtils::check_err(MPI_Test(&barrier_request_, &flag, MPI_STATUS_IGNORE));
+	if (flag) finish_barrier();
+}
+
+void SialOpsParallel::finish_barrier() {
+	barrier_pending_ = false;
+	// Remove and deallocate local copies of blocks of distributed and served arrays
+	// that were written in the section by any worker.
+	for (int i = 0; i < sip_tables_.num_arrays(); ++i) {
+		if ((sip_tables_.is_distributed(i) || sip_tables_.is_served(i))
+				&& modified_at_servers_[i]) {
+			update_local_copies(i, barrier_written_[i]);
+		}
+	}
+	//the other workers' one-sided updates are complete, make them visible to direct copies
+	rma_arrays_.sync();
+
 	//update the local sip_barrier state;
-	//increment section number, reset msg number
+	//increment section number, reset msg number.
+	//No messages were sent to the servers while the barrier was pending.
 //	//DEBUG
 //	std::cout<<"W " << sip_mpi_attr_.global_rank()
 //	     		<< " : calling update_state_at_barrier "
 //	     		<<  " at line "<< current_line()
 //	     		<< " in program " << JobControl::global->get_program_name() << std::endl << std::flush;
 	barrier_support_.update_state_at_barrier();
+}
 
-
-	reset_mode();
-	SIP_LOG(std::cout<< "W " << sip_mpi_attr_.global_rank() << " : Done with BARRIER "<< std::endl);
+void SialOpsParallel::update_local_copies(int array_id, bool written) {
+	// Blocks of arrays that were only read are still valid, so they are moved to the
+	// cache to satisfy gets in later sections.
+	if (written) {
+		block_manager_.delete_per_array_map_and_blocks(array_id);
+	} else {
+		num_retained_blocks_.inc(block_manager_.cache_unscoped_blocks(array_id));
+	}
 }
 
 /** Currently this is a no-op.  Map, and blocks are created lazily when needed */
@@ -108,15 +196,26 @@ void SialOpsParallel::create_distributed(int array_id, int pc) {
  * careful to remove any blocks that should not be delete from the block_map_ first.
  */
 void SialOpsParallel::delete_distributed(int array_id, int pc) {
+	complete_barrier();
+	flush_gets();
 
-	//delete any blocks stored locally along with the map
+	//delete any blocks stored locally along with the map, other workers
+	//delete theirs at the next barrier
 	block_manager_.block_map_.delete_per_array_map_and_blocks(array_id);
+	written_[array_id] = 1;
+
+	//send combined put_accumulates to the array before it is deleted
+	PutAccumulateCombiner::ContributionList contributions;
+	put_accumulate_combiner_.remove_array(array_id, contributions);
+	send_contributions(contributions);
 
 	//send delete message to server if responsible worker
 	const std::vector<int>& server_ranks = sip_mpi_attr_.my_servers();
     for (std::vector<int>::const_iterator it = server_ranks.begin(); it != server_ranks.end(); ++it){
         int server_rank = *it;
-		if (server_rank > 0) {
+		if (server_rank > 0 && rma_arrays_.is_rma_array(array_id)) {
+			rma_arrays_.clear_array(array_id, server_rank);
+		} else if (server_rank > 0) {
 			int to_send[3] = { array_id, pc, barrier_support_.section_number() };
 			SIP_LOG(std::cout<<"W " << sip_mpi_attr_.global_rank() << " : sending DELETE to server "<< server_rank << std::endl);
 			int delete_tag = barrier_support_.make_mpi_tag_for_DELETE();
@@ -129,14 +228,76 @@ void SialOpsParallel::delete_distributed(int array_id, int pc) {
 }
 
 //TODO optimize this.  Can reduce searches in block map.
-void SialOpsParallel::get(BlockId& block_id, int pc) {
+bool SialOpsParallel::get(BlockId& block_id, int pc) {
+	if (barrier_needed_for_get(block_id)) complete_barrier();
 	//check for "data race"
 	check_and_set_mode(block_id, READ);
+	//the get must see this worker's own put_accumulates
+	if (send_combined(block_id) && rma_arrays_.is_rma_array(block_id.array_id())) {
+		rma_arrays_.flush(block_id);
+	}
 
 	//if block already exists, or has pending request, just return
 	Block::BlockPtr block = block_manager_.block(block_id);
-	if (block != NULL)
+	bool prefetched = false;
+	std::map<BlockId, std::size_t>::iterator it = prefetched_.find(block_id);
+	if (it != prefetched_.end()) {
+		//if the block is gone, the entry is stale
+		prefetched = block != NULL;
+		prefetched_bytes_ -= it->second;
+		prefetched_.erase(it);
+	}
+	if (block != NULL) {
+		if (prefetched) {
+			//not added to a scope by prefetch
+			block_manager_.add_to_current_scope(block_id);
+		}
+		if (!next_is_get(pc)) flush_gets();
+		return prefetched;
+	}
+
+	post_get(block_id, pc, true);
+	if (!next_is_get(pc)) flush_gets();
+	return false;
+}
+
+bool SialOpsParallel::next_is_get(int pc) const {
+	return pc + 2 < static_cast<int>(sip_tables_.op_table_size())
+			&& sip_tables_.opcode(pc + 1) == push_block_selector_op
+			&& sip_tables_.opcode(pc + 2) == get_op;
+}
+
+bool SialOpsParallel::prefetch(const BlockId& block_id, int pc, std::size_t max_bytes) {
+	//only arrays that are already being read, so a data race is never reported for a
+	//get that is not executed
+	if (mode_.at(block_id.array_id()) != READ)
+		return false;
+	//do not wait for the barrier
+	if (barrier_needed_for_get(block_id))
+		return false;
+	if (block_manager_.block(block_id) != NULL)
+		return false;
+	std::size_t bytes = sip_tables_.shape(block_id).num_elems() * sizeof(double);
+	if (prefetched_bytes_ + bytes > max_bytes)
+		return false;
+	if (MemoryTracker::global->get_allocated_bytes() + bytes
+			> block_manager_.block_map().max_allocatable_bytes())
+		return false;
+
+	post_get(block_id, pc, false);
+	prefetched_.insert(std::make_pair(block_id, bytes));
+	prefetched_bytes_ += bytes;
+	return true;
+}
+
+void SialOpsParallel::post_get(const BlockId& block_id, int pc, bool is_scope_extent) {
+	if (rma_arrays_.is_rma_array(block_id.array_id())) {
+		//read the block from the server's window, the request is kept in the block
+		Block::BlockPtr block = block_manager_.get_block_for_writing(block_id, is_scope_extent);
+		if (rma_arrays_.get(block_id, block->get_data(), block->size(), block->mpi_request()))
+			num_node_local_gets_.inc();
 		return;
+	}
 
 	//post receive
 	int server_rank = data_distribution_.get_server_rank(block_id);
@@ -149,7 +310,7 @@ void SialOpsParallel::get(BlockId& block_id, int pc) {
     		<< " to server "<< server_rank << std::endl);
 
 	//create block
-	block = block_manager_.get_block_for_writing(block_id, true);
+	Block::BlockPtr block = block_manager_.get_block_for_writing(block_id, is_scope_extent);
 
 	//post an asynchronous receive and store the request in the
 	//block's state.
@@ -160,14 +321,50 @@ void SialOpsParallel::get(BlockId& block_id, int pc) {
 					get_tag, MPI_COMM_WORLD, block->mpi_request()));
 
 
-	//construct and send the get message
-    int send_buff[SIPMPIUtils::BLOCKID_BUFF_ELEMS];
-    SIPMPIUtils::encode_BlockID_buff(send_buff, block_id, pc ,barrier_support_.section_number());
+	//queue the get message, gets to a different server are sent first
+	if (!queued_gets_.empty() && queued_gets_server_ != server_rank) flush_gets();
+	QueuedGet queued;
+	queued.id_ = block_id;
+	queued.pc_ = pc;
+	queued.tag_ = get_tag;
+	queued_gets_.push_back(queued);
+	queued_gets_server_ = server_rank;
+	if (queued_gets_.size() >= SIPMPIUtils::MAX_GET_BATCH) flush_gets();
+}
 
-    SIPMPIUtils::check_err(
-    		MPI_Send(send_buff, SIPMPIUtils::BLOCKID_BUFF_ELEMS, MPI_INT,
-    				server_rank, get_tag, MPI_COMM_WORLD));
+void SialOpsParallel::flush_gets() {
+	if (queued_gets_.empty()) return;
+	int section = barrier_support_.section_number();
+
+	//a single get is sent as before, with the tag of the reply
+	if (queued_gets_.size() == 1) {
+		const QueuedGet& queued = queued_gets_.front();
+		int send_buff[SIPMPIUtils::BLOCKID_BUFF_ELEMS];
+		SIPMPIUtils::encode_BlockID_buff(send_buff, queued.id_, queued.pc_, section);
+		SIPMPIUtils::check_err(
+				MPI_Send(send_buff, SIPMPIUtils::BLOCKID_BUFF_ELEMS, MPI_INT,
+						queued_gets_server_, queued.tag_, MPI_COMM_WORLD));
+		queued_gets_.clear();
+		return;
+	}
 
+	int count = queued_gets_.size() * SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK;
+	std::vector<int> send_buff(count);
+	int pos = 0;
+	for (std::vector<QueuedGet>::iterator it = queued_gets_.begin(); it != queued_gets_.end(); ++it) {
+		SIPMPIUtils::encode_get_batch_entry(&send_buff[pos], it->id_, it->pc_, section, it->tag_);
+		pos += SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK;
+	}
+	int get_batch_tag = barrier_support_.make_mpi_tag_for_GET_BATCH();
+	SIP_LOG(std::cout<<"W " << sip_mpi_attr_.global_rank()
+			<< " : sending GET_BATCH for " << queued_gets_.size() << " blocks"
+			<< " to server "<< queued_gets_server_ << std::endl);
+	SIPMPIUtils::check_err(
+			MPI_Send(&send_buff.front(), count, MPI_INT, queued_gets_server_, get_batch_tag,
+					MPI_COMM_WORLD));
+	num_get_batches_.inc();
+	num_batched_gets_.inc(queued_gets_.size());
+	queued_gets_.clear();
 }
 
 //NOTE:  I can't remember why the source block was copied.
@@ -231,14 +428,14 @@ void SialOpsParallel::get(BlockId& block_id, int pc) {
  */
 void SialOpsParallel::put_replace(BlockId& target_id,
 		const Block::BlockPtr source_block, int pc) {
+	complete_barrier();
+	flush_gets();
 
 	//partial check for data races
 	check_and_set_mode(target_id, WRITE);
+	send_combined(target_id);
 
-	//send message with array_id to server
 	int server_rank = data_distribution_.get_server_rank(target_id);
-	int put_tag, put_data_tag;
-	put_tag = barrier_support_.make_mpi_tags_for_PUT(put_data_tag);
 
 //    CHECK(server_rank>=0&&server_rank<sip_mpi_attr_.global_size(), "invalid server rank",current_line());
 
@@ -247,40 +444,59 @@ void SialOpsParallel::put_replace(BlockId& target_id,
      		<< " to server "<< server_rank << " at line "<< current_line()
      		<< " in program " << JobControl::global->get_program_name() << std::endl << std::flush;);
 
+	if (rma_arrays_.is_rma_array(target_id.array_id())) {
+		//the block is not modified until the put is complete, as in send_put.  An
+		//accumulate is used since, unlike puts, accumulates to a block are ordered.
+		source_block->wait();
+		rma_arrays_.accumulate(target_id, source_block->get_data(), source_block->size(),
+				MPI_REPLACE, source_block->mpi_request());
+	} else if (source_block->size() <= SIPMPIUtils::EAGER_PUT_MAX_DOUBLES) {
+		int put_tag = barrier_support_.make_mpi_tag_for_PUT_EAGER();
+		send_eager_put(target_id, source_block, server_rank, put_tag, pc);
+	} else {
+		int put_tag, put_data_tag;
+		put_tag = barrier_support_.make_mpi_tags_for_PUT(put_data_tag);
+		send_put(target_id, source_block, server_rank, put_tag, put_data_tag, pc);
+	}
+}
 
+void SialOpsParallel::send_eager_put(const BlockId& target_id,
+		const Block::BlockPtr source_block, int server_rank, int tag, int pc) {
+	//the block id and data go in one message, whose buffer is owned by eager_sends_
+	std::size_t size = source_block->size();
+	char* buff = SIPMPIUtils::encode_eager_put_buff(target_id, pc,
+			barrier_support_.section_number(), source_block->get_data(), size);
+	std::size_t bytes = SIPMPIUtils::eager_put_bytes(size);
+	MPI_Request request;
+	SIPMPIUtils::check_err(
+			MPI_Isend(buff, bytes, MPI_BYTE, server_rank, tag, MPI_COMM_WORLD, &request));
+	eager_sends_.add(request, buff, bytes);
 
-//    // Construct int array to send to server.
-//    const int to_send_size = BlockId::MPI_BLOCK_ID_COUNT + 2;
-//    const int line_num_offset = BlockId::MPI_BLOCK_ID_COUNT;
-//    const int section_num_offset = line_num_offset + 1;
-//    int to_send[to_send_size]; // BlockId & line number
-//    int *serialized_block_id = target_id.to_mpi_array();
-//    std::copy(serialized_block_id + 0, serialized_block_id + BlockId::MPI_BLOCK_ID_COUNT, to_send);
-//    to_send[line_num_offset] = current_line();
-//    to_send[section_num_offset] = barrier_support_.section_number();
+	//the server acks after applying the data
+	ack_handler_.expect_ack_from(server_rank, tag);
+}
 
+void SialOpsParallel::send_put(const BlockId& target_id,
+		const Block::BlockPtr source_block, int server_rank, int tag, int data_tag, int pc) {
 	//construct and send the request message
     int send_buff[SIPMPIUtils::BLOCKID_BUFF_ELEMS];
     SIPMPIUtils::encode_BlockID_buff(send_buff, target_id, pc,
     		barrier_support_.section_number());
-
 	SIPMPIUtils::check_err(
 			MPI_Send(send_buff, SIPMPIUtils::BLOCKID_BUFF_ELEMS, MPI_INT,
-					server_rank, put_tag, MPI_COMM_WORLD));
-
-	//wait for ack from server
-	//TODO make this asynchronous
-	ack_handler_.expect_sync_ack_from(server_rank, put_tag);
-
-	//TODO handle asynchrony using new framework.
-//	MPI_Request request;
-		SIPMPIUtils::check_err(
-				MPI_Isend(source_block->get_data(), source_block->size(), MPI_DOUBLE,
-						server_rank, put_data_tag, MPI_COMM_WORLD, source_block->mpi_request()));
+					server_rank, tag, MPI_COMM_WORLD));
 
-	//the data message should be acked
-	ack_handler_.expect_ack_from(server_rank, put_data_tag);
+	//Send the data right away.  The server posts the receive for it when it handles the
+	//request message, which precedes it.  The request is kept in the source block, so the
+	//block is not modified or freed until the send is complete.  The block may still be
+	//the source of an earlier put.
 	source_block->wait();
+	SIPMPIUtils::check_err(
+			MPI_Isend(source_block->get_data(), source_block->size(), MPI_DOUBLE,
+					server_rank, data_tag, MPI_COMM_WORLD, source_block->mpi_request()));
+
+	//the data message is acked, the ack is awaited at the next barrier
+	ack_handler_.expect_ack_from(server_rank, data_tag);
 }
 
 //NOTE:  I can't remember why the source block was copied.
@@ -331,14 +547,12 @@ void SialOpsParallel::put_replace(BlockId& target_id,
  */
 void SialOpsParallel::put_accumulate(BlockId& target_id,
 		const Block::BlockPtr source_block, int pc) {
+	complete_barrier();
+	flush_gets();
 	//partial check for data races
 	check_and_set_mode(target_id, WRITE);
 
-	//send message with target block's id to server
 	int server_rank = data_distribution_.get_server_rank(target_id);
-	int put_accumulate_tag, put_accumulate_data_tag;
-	put_accumulate_tag = barrier_support_.make_mpi_tags_for_PUT_ACCUMULATE(
-			put_accumulate_data_tag);
 
 //    CHECK(server_rank>=0&&server_rank<sip_mpi_attr_.global_size(), "invalid server rank",current_line());
 
@@ -346,73 +560,89 @@ void SialOpsParallel::put_accumulate(BlockId& target_id,
        		<< " : sending PUT_ACCUMULATE for block " << target_id
        		<< " to server "<< server_rank << std::endl);
 
+	//sum with earlier put_accumulates to the block, the sum is sent later
+	PutAccumulateCombiner::ContributionList evicted;
+	if (put_accumulate_combiner_.add(target_id, source_block->get_data(),
+			source_block->size(), pc, evicted)) {
+		send_contributions(evicted);
+		return;
+	}
 
-	//construct and send the request message
-    int send_buff[SIPMPIUtils::BLOCKID_BUFF_ELEMS];
-    SIPMPIUtils::encode_BlockID_buff(send_buff, target_id, pc,
-    		barrier_support_.section_number());
-
-	SIPMPIUtils::check_err(
-			MPI_Send(send_buff, SIPMPIUtils::BLOCKID_BUFF_ELEMS, MPI_INT,
-					server_rank, put_accumulate_tag, MPI_COMM_WORLD));
-
-	//wait for acknowledgment
-	//TODO make this asynchronous
-	ack_handler_.expect_sync_ack_from(server_rank, put_accumulate_tag);
-
-	//TODO handle with new asynch framework
-	SIPMPIUtils::check_err(
-			MPI_Isend(source_block->get_data(), source_block->size(), MPI_DOUBLE,
-					server_rank, put_accumulate_data_tag, MPI_COMM_WORLD, source_block->mpi_request()));
-
-	ack_handler_.expect_ack_from(server_rank, put_accumulate_data_tag);
-
-	source_block->wait();
-
-
-
+	if (rma_arrays_.is_rma_array(target_id.array_id())) {
+		source_block->wait();
+		rma_arrays_.accumulate(target_id, source_block->get_data(), source_block->size(),
+				MPI_SUM, source_block->mpi_request());
+	} else if (source_block->size() <= SIPMPIUtils::EAGER_PUT_MAX_DOUBLES) {
+		int put_accumulate_tag = barrier_support_.make_mpi_tag_for_PUT_ACCUMULATE_EAGER();
+		send_eager_put(target_id, source_block, server_rank, put_accumulate_tag, pc);
+	} else {
+		int put_accumulate_tag, put_accumulate_data_tag;
+		put_accumulate_tag = barrier_support_.make_mpi_tags_for_PUT_ACCUMULATE(
+				put_accumulate_data_tag);
+		send_put(target_id, source_block, server_rank, put_accumulate_tag,
+				put_accumulate_data_tag, pc);
+	}
+}
 
 
-//    // Construct int array to send to server.
-//    const int to_send_size = BlockId::MPI_BLOCK_ID_COUNT + 2;
-//    const int line_num_offset = BlockId::MPI_BLOCK_ID_COUNT;
-//    const int section_num_offset = line_num_offset + 1;
-//    int to_send[to_send_size]; // BlockId & line number
-//    int *serialized_block_id = target_id.to_mpi_array();
-//    std::copy(serialized_block_id + 0, serialized_block_id + BlockId::MPI_BLOCK_ID_COUNT, to_send);
-//    to_send[line_num_offset] = current_line();
-//    to_send[section_num_offset] = barrier_support_.section_number();
-//
-//	//send block id
-//	SIPMPIUtils::check_err(
-//			MPI_Send(to_send, to_send_size, MPI_INT,
-//					server_rank, put_accumulate_tag, MPI_COMM_WORLD));
-////	//immediately follow with the data
-////	SIPMPIUtils::check_err(
-////			MPI_Send(source_block->get_data(), source_block->size(), MPI_DOUBLE,
-////					server_rank, put_accumulate_data_tag, MPI_COMM_WORLD));
-//	//wait for ack from server
-//	//TODO handle asynchronously??
-//	ack_handler_.expect_sync_ack_from(server_rank, put_accumulate_tag);
-//	MPI_Request request;
-//		SIPMPIUtils::check_err(
-//				MPI_Isend(source_block->get_data(), source_block->size(), MPI_DOUBLE,
-//						server_rank, put_accumulate_data_tag, MPI_COMM_WORLD, source_block->mpi_request()));
-//		source_block->state().set_request(request);
-	//ack
-//	ack_handler_.expect_ack_from(server_rank, put_accumulate_data_tag);
-//
-//	SIP_LOG(
-//			std::cout<< "W " << sip_mpi_attr_.global_rank() << " : Done with PUT_ACCUMULATE for block " << target_id << " to server rank " << server_rank << std::endl);
 
+void SialOpsParallel::send_contributions(
+		PutAccumulateCombiner::ContributionList& contributions) {
+	for (PutAccumulateCombiner::ContributionList::iterator it = contributions.begin();
+			it != contributions.end(); ++it) {
+		std::size_t bytes = SIPMPIUtils::eager_put_bytes(it->size_);
+		MPI_Request request;
+		if (rma_arrays_.is_rma_array(it->id_.array_id())) {
+			//only the data part of the buffer is used
+			double* data = reinterpret_cast<double*>(
+					it->buffer_ + SIPMPIUtils::EAGER_PUT_HEADER_BYTES);
+			rma_arrays_.accumulate(it->id_, data, it->size_, MPI_SUM, &request);
+			eager_sends_.add(request, it->buffer_, bytes);
+			continue;
+		}
+		int server_rank = data_distribution_.get_server_rank(it->id_);
+		int tag = barrier_support_.make_mpi_tag_for_PUT_ACCUMULATE_EAGER();
+		SIPMPIUtils::encode_eager_put_header(it->buffer_, it->id_, it->pc_,
+				barrier_support_.section_number());
+		SIPMPIUtils::check_err(
+				MPI_Isend(it->buffer_, bytes, MPI_BYTE, server_rank, tag, MPI_COMM_WORLD,
+						&request));
+		eager_sends_.add(request, it->buffer_, bytes);
+		ack_handler_.expect_ack_from(server_rank, tag);
+	}
+	contributions.clear();
 }
 
+bool SialOpsParallel::send_combined(const BlockId& id) {
+	PutAccumulateCombiner::ContributionList contributions;
+	if (!put_accumulate_combiner_.remove_block(id, contributions)) return false;
+	send_contributions(contributions);
+	return true;
+}
 
+void SialOpsParallel::rma_scalar_op(const BlockId& target_id, double value, MPI_Op op) {
+	std::size_t size = sip_tables_.block_size(target_id);
+	std::size_t bytes = size * sizeof(double);
+	char* buff = new char[bytes];
+	double* data = reinterpret_cast<double*>(buff);
+	std::fill(data, data + size, value);
+	MPI_Request request;
+	rma_arrays_.accumulate(target_id, data, size, op, &request);
+	eager_sends_.add(request, buff, bytes);
+}
 
 void SialOpsParallel::put_initialize(BlockId& target_id, double value, int pc){
+	complete_barrier();
+	flush_gets();
 
 	//partial check for data races
 	check_and_set_mode(target_id,WRITE);
+	send_combined(target_id);
+
+	if (rma_arrays_.is_rma_array(target_id.array_id())) {
+		rma_scalar_op(target_id, value, MPI_REPLACE);
+		return;
+	}
 
 	//send message with target_id and value to server
 	int my_rank = sip_mpi_attr_.global_rank();
@@ -456,9 +686,17 @@ void SialOpsParallel::put_initialize(BlockId& target_id, double value, int pc){
 }
 
 void SialOpsParallel::put_increment(BlockId& target_id, double value, int pc){
+	complete_barrier();
+	flush_gets();
 
 	//partial check for data races
 	check_and_set_mode(target_id,WRITE);
+	send_combined(target_id);
+
+	if (rma_arrays_.is_rma_array(target_id.array_id())) {
+		rma_scalar_op(target_id, value, MPI_SUM);
+		return;
+	}
 
 	//send message with target_id and value to server
 	int my_rank = sip_mpi_attr_.global_rank();
@@ -490,9 +728,17 @@ void SialOpsParallel::put_increment(BlockId& target_id, double value, int pc){
 }
 
 void SialOpsParallel::put_scale(BlockId& target_id, double value, int pc){
+	complete_barrier();
+	flush_gets();
 
 	//partial check for data races
 	check_and_set_mode(target_id,WRITE);
+	send_combined(target_id);
+
+	if (rma_arrays_.is_rma_array(target_id.array_id())) {
+		rma_scalar_op(target_id, value, MPI_PROD);
+		return;
+	}
 
 	//send message with target_id and value to server
 	int my_rank = sip_mpi_attr_.global_rank();
@@ -546,22 +792,58 @@ void SialOpsParallel::prepare_accumulate(BlockId& lhs_id,
 	put_accumulate(lhs_id, source_ptr, pc);
 }
 
-void SialOpsParallel::collective_sum(double rhs_value,
-		int dest_array_slot) {
+void SialOpsParallel::collective_sum(double rhs_value, int dest_array_slot, int pc) {
+	QueuedSum sum;
+	sum.dest_array_slot_ = dest_array_slot;
+	sum.value_ = rhs_value;
+	queued_sums_.push_back(sum);
+	if (!next_is_collective_sum(pc)) flush_collective_sums();
+}
 
-	double lhs_value = data_manager_.scalar_value(dest_array_slot);
+bool SialOpsParallel::next_is_collective_sum(int pc) const {
+	//every worker makes the same decision, so the allreduces match
+	const int max_distance = 16;
+	for (int next = pc + 1;
+			next < static_cast<int>(sip_tables_.op_table_size()) && next <= pc + max_distance; ++next) {
+		opcode_t opcode = sip_tables_.opcode(next);
+		if (opcode == collective_sum_op)
+			return true;
+		if (opcode < int_load_value_op || opcode > cast_to_scalar_op
+				|| opcode == int_store_op || opcode == scalar_store_op)
+			return false;
+		if (opcode == scalar_load_value_op) {
+			for (std::vector<QueuedSum>::const_iterator it = queued_sums_.begin();
+					it != queued_sums_.end(); ++it) {
+				if (it->dest_array_slot_ == sip_tables_.arg0(next))
+					return false;
+			}
+		}
+	}
+	return false;
+}
 
-	double reduced_value = 0.0;
+void SialOpsParallel::flush_collective_sums() {
+	std::size_t n = queued_sums_.size();
+	if (n == 0) return;
+	std::vector<double> values(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		values[i] = queued_sums_[i].value_;
+	}
+	std::vector<double> reduced(values);
 	if (sip_mpi_attr_.num_workers() > 1) {
 		const MPI_Comm& worker_comm = sip_mpi_attr_.company_communicator();
 		SIPMPIUtils::check_err(
-				MPI_Allreduce(&rhs_value, &reduced_value, 1, MPI_DOUBLE, MPI_SUM,
+				MPI_Allreduce(&values.front(), &reduced.front(), n, MPI_DOUBLE, MPI_SUM,
 						worker_comm));
-	} else {
-		reduced_value = rhs_value;
 	}
-
-	data_manager_.set_scalar_value(dest_array_slot,lhs_value + reduced_value);
+	//in order, since a scalar may be the destination of several sums
+	for (std::size_t i = 0; i < n; ++i) {
+		int slot = queued_sums_[i].dest_array_slot_;
+		data_manager_.set_scalar_value(slot, data_manager_.scalar_value(slot) + reduced[i]);
+	}
+	num_sum_allreduces_.inc();
+	if (n > 1) num_batched_sums_.inc(n);
+	queued_sums_.clear();
 }
 
 
@@ -608,11 +890,43 @@ bool SialOpsParallel::nearlyEqual(double a, double  b, double epsilon) {
 }
 
 
-void SialOpsParallel::broadcast_static(Block::BlockPtr source_or_dest, int source_worker){
-	if (sip_mpi_attr_.num_workers()>0 ){
-	   SIPMPIUtils::check_err(MPI_Bcast(source_or_dest->get_data() , source_or_dest->size(), MPI_DOUBLE, source_worker,
-			   sip_mpi_attr_.company_communicator()));
-    }
+void SialOpsParallel::broadcast_static(Block::BlockPtr source_or_dest, int source_worker,
+		int array_id, int pc) {
+	if (sip_mpi_attr_.num_workers() <= 0) return;
+	//the buffer of a previous broadcast of the array must not be overwritten
+	wait_for_broadcast(array_id, pc);
+	double* data = source_or_dest->get_data();
+	std::size_t size = source_or_dest->size();
+	const MPI_Comm& worker_comm = sip_mpi_attr_.company_communicator();
+	if (size <= BROADCAST_CHUNK_DOUBLES) {
+		SIPMPIUtils::check_err(MPI_Bcast(data, size, MPI_DOUBLE, source_worker, worker_comm));
+		return;
+	}
+	std::vector<MPI_Request>& requests = pending_broadcasts_[array_id];
+	for (std::size_t offset = 0; offset < size; offset += BROADCAST_CHUNK_DOUBLES) {
+		int count = std::min(BROADCAST_CHUNK_DOUBLES, size - offset);
+		MPI_Request request;
+		SIPMPIUtils::check_err(
+				MPI_Ibcast(data + offset, count, MPI_DOUBLE, source_worker, worker_comm,
+						&request));
+		requests.push_back(request);
+	}
+}
+
+void SialOpsParallel::wait_for_broadcast(int array_id, int pc) {
+	std::map<int, std::vector<MPI_Request> >::iterator it = pending_broadcasts_.find(array_id);
+	if (it == pending_broadcasts_.end()) return;
+	wait_time_.start(pc);
+	SIPMPIUtils::check_err(
+			MPI_Waitall(it->second.size(), &it->second.front(), MPI_STATUSES_IGNORE));
+	wait_time_.pause(pc);
+	pending_broadcasts_.erase(it);
+}
+
+void SialOpsParallel::wait_for_broadcasts(int pc) {
+	while (!pending_broadcasts_.empty()) {
+		wait_for_broadcast(pending_broadcasts_.begin()->first, pc);
+	}
 }
 
 
@@ -628,6 +942,10 @@ void SialOpsParallel::broadcast_static(Block::BlockPtr source_or_dest, int sourc
  */
 void SialOpsParallel::set_persistent(Interpreter * worker, int array_slot,
 		int string_slot, int pc) {
+	complete_barrier();
+	flush_gets();
+	//a static array may be saved or replaced
+	wait_for_broadcast(array_slot, pc);
 	if (sip_tables_.is_distributed(array_slot)
 			|| sip_tables_.is_served(array_slot)) {
 		const std::vector<int>& server_ranks = sip_mpi_attr_.my_servers();
@@ -664,10 +982,16 @@ void SialOpsParallel::set_persistent(Interpreter * worker, int array_slot,
 
 void SialOpsParallel::restore_persistent(Interpreter* worker, int array_slot,
 		int string_slot, int pc) {
+	complete_barrier();
+	flush_gets();
+	//a static array may be saved or replaced
+	wait_for_broadcast(array_slot, pc);
 	SIP_LOG(std::cout << "restore_persistent with array " << sip_tables_.array_name(array_slot) << " in slot " << array_slot << " and string \"" << sip_tables_.string_literal(string_slot) << "\"" << std::endl);
 
 	if (sip_tables_.is_distributed(array_slot)
 			|| sip_tables_.is_served(array_slot)) {
+		//the servers replace the array's blocks
+		written_[array_slot] = 1;
 		const std::vector<int>& server_ranks = sip_mpi_attr_.my_servers();
 		for (std::vector<int>::const_iterator it = server_ranks.begin(); it != server_ranks.end(); ++it){
 			int my_server = *it;
@@ -691,13 +1015,20 @@ void SialOpsParallel::restore_persistent(Interpreter* worker, int array_slot,
 
 }
 
+void SialOpsParallel::begin_program() {
+	rma_arrays_.create_window();
+	pardo_task_counter_.create_window();
+}
+
 void SialOpsParallel::end_program() {
 	//implicit sip_barrier
 	//this is required to ensure that there are no pending messages
 	//at the server when the end_program message arrives.
 
 	int end_prog_pc = sip_tables_.op_table_size();
+	wait_for_broadcasts(end_prog_pc);
 	sip_barrier(end_prog_pc);
+	complete_barrier();
     const std::vector<int>& server_ranks = sip_mpi_attr_.my_servers();
     for (std::vector<int>::const_iterator it = server_ranks.begin(); it != server_ranks.end(); ++it){
         int my_server = *it;
@@ -714,6 +1045,8 @@ void SialOpsParallel::end_program() {
 		}
     }
 	//the program is done and the servers know it.
+	rma_arrays_.free_window();
+	pardo_task_counter_.free_window();
 	SIP_LOG(std::cout << "leaving end_program" << std::endl << std::flush);
 }
 
@@ -732,6 +1065,7 @@ void SialOpsParallel::end_program() {
 
 //enum array_mode {NONE, READ, WRITE};
 bool SialOpsParallel::check_and_set_mode(int array_id, array_mode mode) {
+	if (mode != READ) written_[array_id] = 1;
 	array_mode current = mode_.at(array_id);
 	if (current == NONE) {
 		mode_[array_id] = mode;
@@ -761,6 +1095,7 @@ Block::BlockPtr SialOpsParallel::get_block_for_reading(const BlockId& id, int pc
 	int array_id = id.array_id();
 	if (sip_tables_.is_distributed(array_id)
 			|| sip_tables_.is_served(array_id)) {
+		if (barrier_needed(array_id)) complete_barrier();
 		check_and_set_mode(array_id, READ);
 		return wait_and_CHECK(block_manager_.get_block_for_reading(id), pc);
 	}
@@ -774,6 +1109,7 @@ Block::BlockPtr SialOpsParallel::get_block_for_writing(const BlockId& id,
 			|| sip_tables_.is_served(array_id)) {
 			CHECK(!is_scope_extent,
 				"sip bug: asking for scope-extent dist or served block");
+		if (barrier_needed(array_id)) complete_barrier();
 		check_and_set_mode(array_id, WRITE);
 	}
 	return wait_and_CHECK(block_manager_.get_block_for_writing(id, is_scope_extent),pc);
@@ -797,6 +1133,10 @@ Block::BlockPtr SialOpsParallel::get_block_for_updating(const BlockId& id, int p
 //For the time being, we will just call the version of wait that does not  check the size.
 //If asynch puts turn out to be useful, we can revisit this.
 Block::BlockPtr SialOpsParallel::wait_and_CHECK(Block::BlockPtr b, int pc) {
+	//the block may be the target of a get that has not been sent
+	flush_gets();
+	//let the barrier progress, it is completed here if it is done
+	test_barrier();
 
 //		if (sialx_timers_ && !b->test()){
 //			sialx_timers_->start_timer(pc, SialxTimer::BLOCKWAITTIME);
@@ -7,6 +7,7 @@
 #define SIAL_OPS_PARALLEL_H_
 
 #include <mpi.h>
+#include <map>
 #include "sip.h"
 //#include "sip_tables.h"
 #include "barrier_support.h"
@@ -17,6 +18,9 @@
 #include "counter.h"
 #include "timer.h"
 #include "sip_mpi_utils.h"
+#include "put_accumulate_combiner.h"
+#include "pardo_task_counter.h"
+#include "rma_arrays.h"
 //#include "data_manager.h"
 //#include "worker_persistent_array_manager.h"
 
@@ -50,7 +54,23 @@ public:
 	void create_distributed(int array_id, int pc);
 	void restore_distributed(int array_id, IdBlockMap<Block>* bid_map, int pc);
 	void delete_distributed(int array_id, int pc);
-	void get(BlockId&, int pc);
+	/** Returns true if the block was prefetched */
+	bool get(BlockId&, int pc);
+	/**
+	 * Posts a GET for a block that is expected to be needed soon, without adding the block
+	 * to the current scope.  The GET is not posted, and false is returned, if the block is
+	 * already present, the array is not in READ mode, the prefetched blocks not yet used by a
+	 * get would exceed max_bytes, or the block could only be allocated by evicting cached
+	 * blocks.  See PardoPrefetch.
+	 */
+	bool prefetch(const BlockId&, int pc, std::size_t max_bytes);
+	/**
+	 * Sends the GET requests that have been queued.  Consecutive gets to the same server
+	 * are sent as one GET_BATCH message.  The queue is sent when a get is not followed by
+	 * another get, before any other message to a server, and before waiting for a block;
+	 * callers that post several prefetches call this afterwards.
+	 */
+	void flush_gets();
 	void put_replace(BlockId&, const Block::BlockPtr, int pc);
 	void put_accumulate(BlockId&, const Block::BlockPtr, int pc);
 	void put_initialize(BlockId&, double value, int pc);
@@ -63,15 +83,38 @@ public:
 	void prepare(BlockId&, Block::BlockPtr, int pc);
 	void prepare_accumulate(BlockId&, Block::BlockPtr, int pc);
 
-	void collective_sum(double rhs_value, int dest_array_slot);
+	/**
+	 * Adds the sum of rhs_value over the workers to the scalar.  If the following
+	 * instructions only compute the value of another collective_sum that does not read
+	 * the destination, the sum is queued, and the queued sums are reduced with one
+	 * allreduce at the last one.
+	 */
+	void collective_sum(double rhs_value, int dest_array_slot, int pc);
 	bool assert_same(int source_array_slot);
-	void broadcast_static(Block::BlockPtr block, int source_worker);
+	/**
+	 * Static arrays of more than BROADCAST_CHUNK_DOUBLES elements are broadcast in chunks
+	 * with MPI_Ibcast, so the chunks are pipelined and the broadcast overlaps the
+	 * following instructions until it is completed by wait_for_broadcast.
+	 */
+	void broadcast_static(Block::BlockPtr block, int source_worker, int array_id, int pc);
+	static const std::size_t BROADCAST_CHUNK_DOUBLES = 128 * 1024;
+	/** Completes the broadcast of the static array, if pending.  Must be called before
+	 * the array is accessed. */
+	void wait_for_broadcast(int array_id, int pc);
+	/** Completes all pending broadcasts */
+	void wait_for_broadcasts(int pc);
 
 	void set_persistent(Interpreter*, int array_id, int string_slot, int pc);
 	void restore_persistent(Interpreter*, int array_id, int string_slot, int pc);
 
+	/** Collective over MPI_COMM_WORLD with the servers.  Called once at the start of
+	 * the program by the top level interpreter. */
+	void begin_program();
 	void end_program();
 
+	/** Counters of the dynamically scheduled pardo loops */
+	PardoTaskCounter& pardo_task_counter() { return pardo_task_counter_; }
+
 //	void print_to_ostream(std::ostream& out, const std::string& to_print);
 
 	/**
@@ -101,6 +144,33 @@ public:
 
 	void reduce() { wait_time_.reduce(); }
 
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		num_retained_blocks_.gather();
+		num_get_batches_.gather();
+		num_batched_gets_.gather();
+		num_node_local_gets_.gather();
+		num_sum_allreduces_.gather();
+		num_batched_sums_.gather();
+		if (sip_mpi_attr_.is_company_master()) {
+			os << "Worker blocks of distributed and served arrays kept at barriers" << std::endl;
+			os << num_retained_blocks_ << std::endl;
+			os << "Worker GET_BATCH messages" << std::endl;
+			os << num_get_batches_ << std::endl;
+			os << "Worker gets coalesced into GET_BATCH messages" << std::endl;
+			os << num_batched_gets_ << std::endl;
+			os << "Worker one-sided gets copied from servers on the same node" << std::endl;
+			os << num_node_local_gets_ << std::endl;
+			os << "Worker collective_sum allreduces" << std::endl;
+			os << num_sum_allreduces_ << std::endl;
+			os << "Worker collective_sums batched with others" << std::endl;
+			os << num_batched_sums_ << std::endl;
+			os << rma_arrays_ << std::endl;
+		}
+		put_accumulate_combiner_.gather_and_print_statistics(os);
+		pardo_task_counter_.gather_and_print_statistics(os);
+	}
+
 	void print_op_table_stats(std::ostream& os,
 						const SipTables& sip_tables) const {
 		wait_time_.print_op_table_stats_impl(os, sip_tables);
@@ -135,8 +205,10 @@ private:
 	WorkerPersistentArrayManager* persistent_array_manager_;
 
 	AsyncAcks ack_handler_;
+	AsyncSends eager_sends_;
 	BarrierSupport barrier_support_;
 	DataDistribution data_distribution_; // Data distribution scheme
+	RmaArrays rma_arrays_; // Distributed arrays accessed with one-sided operations
 	MPIScalarOpType mpi_type_;
 
 	// Instrumentation
@@ -152,6 +224,118 @@ private:
 	 */
 	std::vector<array_mode> mode_;
 
+	/** 1 for each distributed or served array written by this worker in the current
+	 * section.  At the barrier, the flags of all workers are or'ed.  Local copies of
+	 * blocks of arrays written by any worker are deleted, other blocks are kept.
+	 * MPI_INT elements for the allreduce. */
+	std::vector<int> written_;
+
+	/** Split phase barrier.  sip_barrier starts the allreduce of written_ into
+	 * barrier_written_, and complete_barrier waits for it.  complete_barrier must be
+	 * called before any operation that depends on the data written by other workers in
+	 * the previous section: the next barrier, puts, deletes, persistence operations, and
+	 * gets and local copies of blocks of arrays in modified_at_servers_.  It must also
+	 * be called before sending any message to a server, which could otherwise arrive
+	 * before messages that other workers sent before the barrier. */
+	std::vector<bool> modified_at_servers_; //see SipTables::find_written_arrays
+	std::vector<int> barrier_send_;
+	std::vector<int> barrier_written_;
+	MPI_Request barrier_request_;
+	int barrier_pc_;
+	bool barrier_pending_;
+
+	void complete_barrier();
+	/** Completes the barrier if the allreduce is done, without waiting */
+	void test_barrier();
+	void finish_barrier();
+	/** true if blocks of the array may not be accessed until the barrier is complete */
+	bool barrier_needed(int array_id) const {
+		return barrier_pending_ && modified_at_servers_[array_id];
+	}
+	/** true if a get of the block may not be posted until the barrier is complete:
+	 * its array may be modified at the servers, or the get would send a message */
+	bool barrier_needed_for_get(const BlockId& id) {
+		return barrier_needed(id.array_id()) || (barrier_pending_
+				&& !rma_arrays_.is_rma_array(id.array_id())
+				&& block_manager_.block(id) == NULL);
+	}
+	/** Deletes the local copies of blocks of a distributed or served array at the
+	 * barrier if written, and otherwise moves them to the cache */
+	void update_local_copies(int array_id, bool written);
+
+	MPICounter num_retained_blocks_; //kept at barriers
+
+	/** Prefetched blocks that have not been used by a get, and their size in bytes.
+	 * Cleared at barriers, when blocks of distributed arrays are deleted. */
+	std::map<BlockId, std::size_t> prefetched_;
+	std::size_t prefetched_bytes_;
+
+	/** Sums the put_accumulates to each block until the next barrier */
+	PutAccumulateCombiner put_accumulate_combiner_;
+
+	/** Posts the receive for the block and queues the GET request for its server */
+	void post_get(const BlockId& block_id, int pc, bool is_scope_extent);
+
+	/** A GET request whose receive has been posted, but has not been sent */
+	struct QueuedGet {
+		BlockId id_;
+		int pc_;
+		int tag_;
+	};
+	std::vector<QueuedGet> queued_gets_;
+	int queued_gets_server_;
+	MPICounter num_get_batches_;
+	MPICounter num_batched_gets_;
+	MPICounter num_node_local_gets_; //copied from the shared memory of a server on this node
+
+	/** true if the instruction after the get at pc is another get */
+	bool next_is_get(int pc) const;
+
+	/** A collective_sum that has not been reduced */
+	struct QueuedSum {
+		int dest_array_slot_;
+		double value_;
+	};
+	std::vector<QueuedSum> queued_sums_;
+	MPICounter num_sum_allreduces_;
+	MPICounter num_batched_sums_;
+
+	PardoTaskCounter pardo_task_counter_;
+
+	/** true if the collective_sum at pc is followed by another one, with only integer and
+	 * scalar expression instructions that do not load a queued destination between them */
+	bool next_is_collective_sum(int pc) const;
+	void flush_collective_sums();
+
+	/** Requests for the chunks of pending static broadcasts, by array id */
+	std::map<int, std::vector<MPI_Request> > pending_broadcasts_;
+
+	/**
+	 * Puts of blocks with at most SIPMPIUtils::EAGER_PUT_MAX_DOUBLES elements send the
+	 * block id and the data in a single nonblocking message, which the server applies
+	 * and acks.  Larger blocks send the block id, then immediately the data with
+	 * MPI_Isend from the source block; the server acks the data.  Neither waits for the
+	 * server; the acks are awaited at the next barrier.
+	 *
+	 * tag and data_tag determine whether the put replaces or accumulates.
+	 */
+	void send_eager_put(const BlockId& target_id, const Block::BlockPtr source_block,
+			int server_rank, int tag, int pc);
+	void send_put(const BlockId& target_id, const Block::BlockPtr source_block,
+			int server_rank, int tag, int data_tag, int pc);
+
+	/** Sends combined put_accumulates removed from put_accumulate_combiner_ as eager
+	 * put_accumulate messages, and takes ownership of their buffers */
+	void send_contributions(PutAccumulateCombiner::ContributionList& contributions);
+
+	/** Sends the combined put_accumulates to the block, if any, so that they reach the
+	 * server before another operation on the block.  Returns whether there were any. */
+	bool send_combined(const BlockId& id);
+
+	/** Applies value to each element of a block of an array in rma_arrays_ with op.
+	 * The buffer is owned by eager_sends_ until the operation is complete. */
+	void rma_scalar_op(const BlockId& target_id, double value, MPI_Op op);
+
 	/**
 	 * checks that the number of double values received is the same as expected.
 	 * If not, it is a fatal error
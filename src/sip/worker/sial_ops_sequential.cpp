@@ -49,8 +49,9 @@ void SialOpsSequential::delete_distributed(int array_id, int pc) {
 	block_manager_.delete_per_array_map_and_blocks(array_id);
 }
 
-void SialOpsSequential::get(BlockId& block_id, int pc) {
+bool SialOpsSequential::get(BlockId& block_id, int pc) {
 	get_block_for_reading(block_id, 0);  //second argument is only used in parallel version.
+	return false;
 }
 
 /** A put appears in a SIAL program as
@@ -108,7 +109,7 @@ void SialOpsSequential::prepare_accumulate(BlockId& lhs_id,
 
 
 
-void SialOpsSequential::collective_sum(double rhs_value, int dest_array_slot) {
+void SialOpsSequential::collective_sum(double rhs_value, int dest_array_slot, int pc) {
        double lhs_value = data_manager_.scalar_value(dest_array_slot);
        data_manager_.set_scalar_value(dest_array_slot, lhs_value + rhs_value);
 }
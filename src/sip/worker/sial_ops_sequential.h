@@ -32,7 +32,12 @@ public:
 	void create_distributed(int array_id, int pc);
 	void restore_distributed(int array_id, IdBlockMap<Block>* bid_map, int pc);
 	void delete_distributed(int array_id, int pc);
-	void get(BlockId&, int pc);
+	/** Always returns false, blocks are never prefetched */
+	bool get(BlockId&, int pc);
+	/** Distributed arrays are local, so there is nothing to prefetch.  Returns false. */
+	bool prefetch(const BlockId&, int pc, std::size_t max_bytes) { return false; }
+	/** gets are not sent anywhere, nothing to do */
+	void flush_gets() {}
 	void put_replace(BlockId&, const Block::BlockPtr, int pc);
 	void put_accumulate(BlockId&, const Block::BlockPtr, int pc);
 	void put_initialize(const BlockId&, double value, int pc);
@@ -45,9 +50,11 @@ public:
 	void prepare(BlockId&, Block::BlockPtr, int pc);
 	void prepare_accumulate(BlockId&, Block::BlockPtr, int pc);
 
-	void collective_sum(double rhs_value, int dest_array_slot);
+	void collective_sum(double rhs_value, int dest_array_slot, int pc);
 	bool assert_same(int source_array_slot) {return true;}
-	void broadcast_static(Block::BlockPtr block, int source_worker) {}
+	void broadcast_static(Block::BlockPtr block, int source_worker, int array_id, int pc) {}
+	void wait_for_broadcast(int array_id, int pc) {}
+	void wait_for_broadcasts(int pc) {}
 
 	void set_persistent(Interpreter*, int array_id, int string_slot, int pc);
 	void restore_persistent(Interpreter*, int array_id, int string_slot, int pc);
@@ -78,6 +85,9 @@ public:
 
 	void reduce() { }
 
+	/** put_accumulates are applied directly, there is nothing to report */
+	void gather_and_print_statistics(std::ostream& os) { }
+
 	void print_op_table_stats(std::ostream& os,
 						const SipTables& sip_tables) const {}
 
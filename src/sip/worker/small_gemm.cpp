@@ -0,0 +1,170 @@
+/*
+ * small_gemm.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "small_gemm.h"
+#include <algorithm>
+
+/* As in block_kernels.cpp, the AVX2 version needs per function target attributes. */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER) \
+	&& (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define SMALL_GEMM_X86
+#include <immintrin.h>
+#endif
+
+namespace sip {
+namespace small_gemm {
+
+namespace {
+
+std::size_t max_work_ = DEFAULT_MAX_WORK;
+
+/**
+ * Computes the M x N tile of c at c, with k terms.  a points to the first row of the tile
+ * in op(a), b to the first column of the tile in op(b).
+ */
+template <int M, int N, bool TA, bool TB>
+void tile(int k, const double* a, int lda, const double* b, int ldb, double* c, int ldc) {
+	double acc[N][M];
+	for (int j = 0; j < N; ++j) {
+		for (int i = 0; i < M; ++i) acc[j][i] = 0.0;
+	}
+	for (int p = 0; p < k; ++p) {
+		double av[M];
+		for (int i = 0; i < M; ++i) av[i] = TA ? a[p + i * lda] : a[i + p * lda];
+		for (int j = 0; j < N; ++j) {
+			double bv = TB ? b[j + p * ldb] : b[p + j * ldb];
+			for (int i = 0; i < M; ++i) acc[j][i] += av[i] * bv;
+		}
+	}
+	for (int j = 0; j < N; ++j) {
+		for (int i = 0; i < M; ++i) c[i + j * ldc] = acc[j][i];
+	}
+}
+
+#ifdef SMALL_GEMM_X86
+
+/** AVX2 version of tile<MR, NR, TA, TB>.  The tile is held in eight vector registers. */
+template <bool TA, bool TB>
+__attribute__((target("avx2,fma")))
+void avx2_tile(int k, const double* a, int lda, const double* b, int ldb, double* c, int ldc) {
+	__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+	__m256d c02 = _mm256_setzero_pd(), c03 = _mm256_setzero_pd();
+	__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+	__m256d c12 = _mm256_setzero_pd(), c13 = _mm256_setzero_pd();
+	for (int p = 0; p < k; ++p) {
+		__m256d a0, a1;
+		if (TA) {
+			const double* ap = a + p;
+			a0 = _mm256_set_pd(ap[3 * lda], ap[2 * lda], ap[lda], ap[0]);
+			a1 = _mm256_set_pd(ap[7 * lda], ap[6 * lda], ap[5 * lda], ap[4 * lda]);
+		} else {
+			const double* ap = a + static_cast<std::size_t>(p) * lda;
+			a0 = _mm256_loadu_pd(ap);
+			a1 = _mm256_loadu_pd(ap + 4);
+		}
+		const double* bp = TB ? b + static_cast<std::size_t>(p) * ldb : b + p;
+		std::size_t bstep = TB ? 1 : ldb;
+		__m256d bv = _mm256_broadcast_sd(bp);
+		c00 = _mm256_fmadd_pd(a0, bv, c00);
+		c10 = _mm256_fmadd_pd(a1, bv, c10);
+		bv = _mm256_broadcast_sd(bp + bstep);
+		c01 = _mm256_fmadd_pd(a0, bv, c01);
+		c11 = _mm256_fmadd_pd(a1, bv, c11);
+		bv = _mm256_broadcast_sd(bp + 2 * bstep);
+		c02 = _mm256_fmadd_pd(a0, bv, c02);
+		c12 = _mm256_fmadd_pd(a1, bv, c12);
+		bv = _mm256_broadcast_sd(bp + 3 * bstep);
+		c03 = _mm256_fmadd_pd(a0, bv, c03);
+		c13 = _mm256_fmadd_pd(a1, bv, c13);
+	}
+	_mm256_storeu_pd(c, c00);
+	_mm256_storeu_pd(c + 4, c10);
+	_mm256_storeu_pd(c + ldc, c01);
+	_mm256_storeu_pd(c + ldc + 4, c11);
+	_mm256_storeu_pd(c + 2 * ldc, c02);
+	_mm256_storeu_pd(c + 2 * ldc + 4, c12);
+	_mm256_storeu_pd(c + 3 * ldc, c03);
+	_mm256_storeu_pd(c + 3 * ldc + 4, c13);
+}
+
+bool use_avx2() {
+	static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return supported;
+}
+
+#endif //SMALL_GEMM_X86
+
+typedef void (*tile_fn)(int, const double*, int, const double*, int, double*, int);
+
+/** The tile kernels for each tile size up to MR x NR, indexed by [rows - 1][columns - 1] */
+template <bool TA, bool TB>
+struct TileTable {
+	static const tile_fn kernels[MR][NR];
+};
+
+#define SMALL_GEMM_TILE_ROW(M) \
+	{ &tile<M, 1, TA, TB>, &tile<M, 2, TA, TB>, &tile<M, 3, TA, TB>, &tile<M, 4, TA, TB> }
+
+template <bool TA, bool TB>
+const tile_fn TileTable<TA, TB>::kernels[MR][NR] = {
+	SMALL_GEMM_TILE_ROW(1), SMALL_GEMM_TILE_ROW(2), SMALL_GEMM_TILE_ROW(3),
+	SMALL_GEMM_TILE_ROW(4), SMALL_GEMM_TILE_ROW(5), SMALL_GEMM_TILE_ROW(6),
+	SMALL_GEMM_TILE_ROW(7), SMALL_GEMM_TILE_ROW(8)
+};
+
+#undef SMALL_GEMM_TILE_ROW
+
+template <bool TA, bool TB>
+void gemm_tiles(int m, int n, int k, const double* a, int lda, const double* b, int ldb,
+		double* c, int ldc) {
+	for (int j = 0; j < n; j += NR) {
+		int nr = std::min(NR, n - j);
+		const double* bj = TB ? b + j : b + static_cast<std::size_t>(j) * ldb;
+		double* cj = c + static_cast<std::size_t>(j) * ldc;
+		tile_fn full = TileTable<TA, TB>::kernels[MR - 1][NR - 1];
+#ifdef SMALL_GEMM_X86
+		if (use_avx2()) full = &avx2_tile<TA, TB>;
+#endif //SMALL_GEMM_X86
+		for (int i = 0; i < m; i += MR) {
+			int mr = std::min(MR, m - i);
+			const double* ai = TA ? a + static_cast<std::size_t>(i) * lda : a + i;
+			tile_fn kernel = mr == MR && nr == NR ? full : TileTable<TA, TB>::kernels[mr - 1][nr - 1];
+			kernel(k, ai, lda, bj, ldb, cj + i, ldc);
+		}
+	}
+}
+
+bool transposed(char trans) {
+	return trans != 'N' && trans != 'n';
+}
+
+}  //anonymous namespace
+
+void gemm(char transa, char transb, int m, int n, int k, const double* a, int lda,
+		const double* b, int ldb, double* c, int ldc) {
+	bool ta = transposed(transa);
+	bool tb = transposed(transb);
+	if (ta) {
+		if (tb) gemm_tiles<true, true>(m, n, k, a, lda, b, ldb, c, ldc);
+		else gemm_tiles<true, false>(m, n, k, a, lda, b, ldb, c, ldc);
+	} else {
+		if (tb) gemm_tiles<false, true>(m, n, k, a, lda, b, ldb, c, ldc);
+		else gemm_tiles<false, false>(m, n, k, a, lda, b, ldb, c, ldc);
+	}
+}
+
+void set_max_work(std::size_t max_work) {
+	max_work_ = max_work;
+}
+
+std::size_t max_work() {
+	return max_work_;
+}
+
+} /* namespace small_gemm */
+} /* namespace sip */
@@ -0,0 +1,56 @@
+/*
+ * small_gemm.h
+ *
+ * Register blocked matrix multiply for the small matrices that arise when contracting
+ * blocks with small segment sizes.  For these, most of the time in dgemm and in the
+ * OpenMP transposes of tensor_block_contract_ is spent in setup rather than arithmetic.
+ *
+ * The result is computed in tiles of MR x NR elements.  The tile kernels are templates on
+ * the tile dimensions and on the layout of the operands, so the tile is held in registers
+ * and the loops over it are unrolled at compile time.  Edge tiles use the instantiations
+ * for the smaller dimensions.  On x86 cpus with AVX2 and FMA, full tiles use a version
+ * written with intrinsics, chosen at runtime as in block_kernels.  The operands are read
+ * in place, in the layout given by transa and transb, so no packing is needed, and no
+ * threads are used.
+ *
+ * ContractionPlan uses gemm instead of dgemm_ when the number of multiply-adds of a
+ * single matrix multiply, m*n*k, is at most max_work().  Such plans are usually strided
+ * gemm plans, which need no transposes.  Otherwise the transposes are done on one thread.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef SMALL_GEMM_H_
+#define SMALL_GEMM_H_
+
+#include <cstddef>
+
+namespace sip {
+namespace small_gemm {
+
+/** Tile dimensions */
+const int MR = 8;
+const int NR = 4;
+
+/** Default for max_work(), chosen with contraction_benchmark -z.  This covers rank 4 by
+ * rank 2 contractions with segment sizes up to 32.  Larger multiplies are left to dgemm_,
+ * which may be threaded. */
+const std::size_t DEFAULT_MAX_WORK = 32 * 32 * 32 * 32;
+
+/**
+ * c = op(a) * op(b), where op(x) is x if trans is 'N' or 'n' and x^T otherwise.
+ * Matrices are column major, op(a) is m x k, op(b) is k x n, and c is m x n.
+ * Same as dgemm_ with alpha = 1 and beta = 0.
+ */
+void gemm(char transa, char transb, int m, int n, int k, const double* a, int lda,
+		const double* b, int ldb, double* c, int ldc);
+
+/** Largest m*n*k for which contractions use gemm.  0 disables the small matrix path. */
+void set_max_work(std::size_t max_work);
+std::size_t max_work();
+
+} /* namespace small_gemm */
+} /* namespace sip */
+
+#endif /* SMALL_GEMM_H_ */
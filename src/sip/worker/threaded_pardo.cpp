@@ -0,0 +1,229 @@
+/*
+ * threaded_pardo.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "threaded_pardo.h"
+#include <algorithm>
+#include <sys/time.h>
+#include "op_table.h"
+#include "sip_tables.h"
+#include "block_id.h"
+#include "loop_manager.h"
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif //HAVE_MPI
+
+namespace sip {
+
+int ThreadedPardo::num_threads_ = 1;
+const int ThreadedPardo::NUM_BLOCK_LOCKS;
+
+ThreadedPardo::ThreadedPardo(const SipTables& sip_tables, const OpTable& op_table) :
+		eligible_(sip_tables.op_table_size(), false),
+		num_eligible_(0),
+		executions_(sip_tables.op_table_size(), 0),
+		iterations_(sip_tables.op_table_size(), 0),
+		seconds_(sip_tables.op_table_size(), 0.0),
+#ifdef HAVE_MPI
+		stats_(SIPMPIAttr::get_instance().company_communicator(), sip_tables.op_table_size())
+#else
+		stats_(sip_tables.op_table_size())
+#endif //HAVE_MPI
+{
+	for (int pc = 0; pc < op_table.size(); ++pc) {
+		if (op_table.opcode(pc) != pardo_op) continue;
+		int end_pc = op_table.arg0(pc);
+		if (check_body(sip_tables, op_table, pc, end_pc)) {
+			eligible_[pc] = true;
+			++num_eligible_;
+		}
+	}
+#ifdef _OPENMP
+	for (int i = 0; i < NUM_BLOCK_LOCKS; ++i) {
+		omp_init_lock(&block_locks_[i]);
+	}
+#endif //_OPENMP
+}
+
+ThreadedPardo::~ThreadedPardo() {
+#ifdef _OPENMP
+	for (int i = 0; i < NUM_BLOCK_LOCKS; ++i) {
+		omp_destroy_lock(&block_locks_[i]);
+	}
+#endif //_OPENMP
+}
+
+void ThreadedPardo::set_num_threads(int num_threads) {
+#ifdef _OPENMP
+	num_threads_ = std::max(1, std::min(num_threads, MAX_OMP_THREADS));
+#endif //_OPENMP
+}
+
+int ThreadedPardo::num_threads() {
+	return num_threads_;
+}
+
+bool ThreadedPardo::enabled(int pc, const LoopManager* loop) const {
+	return num_threads() > 1 && eligible_[pc] && loop->may_enumerate();
+}
+
+int ThreadedPardo::lock_block(const BlockId& id) {
+	std::size_t hash = id.array_id();
+	for (int i = 0; i < MAX_RANK; ++i) {
+		hash = hash * 31 + id.index_values(i);
+	}
+	int index = hash % NUM_BLOCK_LOCKS;
+#ifdef _OPENMP
+	omp_set_lock(&block_locks_[index]);
+#endif //_OPENMP
+	return index;
+}
+
+void ThreadedPardo::unlock_block(int index) {
+#ifdef _OPENMP
+	omp_unset_lock(&block_locks_[index]);
+#endif //_OPENMP
+}
+
+double ThreadedPardo::wall_time() {
+#ifdef HAVE_MPI
+	return MPI_Wtime();
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+#endif //HAVE_MPI
+}
+
+bool ThreadedPardo::is_allowed(opcode_t opcode) {
+	switch (opcode) {
+	case goto_op:
+	case jump_if_zero_op:
+	case do_op:
+	case enddo_op:
+	case exit_op:
+	case where_op:
+	case push_block_selector_op:
+	case int_load_value_op:
+	case int_load_literal_op:
+	case index_load_value_op:
+	case int_add_op:
+	case int_subtract_op:
+	case int_multiply_op:
+	case int_divide_op:
+	case int_equal_op:
+	case int_nequal_op:
+	case int_ge_op:
+	case int_le_op:
+	case int_gt_op:
+	case int_lt_op:
+	case int_neg_op:
+	case cast_to_int_op:
+	case scalar_load_value_op:
+	case scalar_add_op:
+	case scalar_subtract_op:
+	case scalar_multiply_op:
+	case scalar_divide_op:
+	case scalar_exp_op:
+	case scalar_eq_op:
+	case scalar_ne_op:
+	case scalar_ge_op:
+	case scalar_le_op:
+	case scalar_gt_op:
+	case scalar_lt_op:
+	case scalar_neg_op:
+	case scalar_sqrt_op:
+	case cast_to_scalar_op:
+	case idup_op:
+	case iswap_op:
+	case sswap_op:
+	case block_copy_op:
+	case block_permute_op:
+	case block_fill_op:
+	case block_scale_op:
+	case block_scale_assign_op:
+	case block_accumulate_scalar_op:
+	case block_add_op:
+	case block_subtract_op:
+	case block_contract_op:
+	case block_load_scalar_op:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/** Block instructions whose lhs array is given by arg1 of the instruction */
+bool ThreadedPardo::has_block_lhs(opcode_t opcode) {
+	switch (opcode) {
+	case block_copy_op:
+	case block_fill_op:
+	case block_scale_op:
+	case block_scale_assign_op:
+	case block_accumulate_scalar_op:
+	case block_add_op:
+	case block_subtract_op:
+	case block_contract_op:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ThreadedPardo::check_body(const SipTables& sip_tables, const OpTable& op_table,
+		int pardo_pc, int end_pc) const {
+	int depth = 0;  //nesting depth of do loops in the body
+	for (int pc = pardo_pc + 1; pc < end_pc; ++pc) {
+		opcode_t opcode = op_table.opcode(pc);
+		if (!is_allowed(opcode)) return false;
+		switch (opcode) {
+		case do_op:
+			++depth;
+			break;
+		case enddo_op:
+			--depth;
+			break;
+		case exit_op:  //exiting the pardo itself is not supported
+			if (depth == 0) return false;
+			break;
+		case goto_op:
+		case jump_if_zero_op: {
+			int target = op_table.arg0(pc);
+			if (target <= pardo_pc || target > end_pc) return false;
+		}
+			break;
+		default:
+			break;
+		}
+		if (opcode == push_block_selector_op || has_block_lhs(opcode)) {
+			int array_id = op_table.arg1(pc);
+			if (sip_tables.is_distributed(array_id) || sip_tables.is_served(array_id)
+					|| sip_tables.is_scalar(array_id))
+				return false;
+		}
+	}
+	return depth == 0;
+}
+
+#ifndef HAVE_MPI
+std::ostream& ThreadedPardo::Stats::gather_and_print_statistics(std::ostream& os,
+		ThreadedPardo* parent, const SipTables& sip_tables) {
+	os << "Worker threaded pardo, threads," << ThreadedPardo::num_threads()
+			<< ", eligible loops," << parent->num_eligible_ << std::endl;
+	os << "pc, line number, executions, iterations, seconds" << std::endl;
+	for (std::size_t pc = 0; pc < parent->executions_.size(); ++pc) {
+		if (parent->executions_[pc] == 0) continue;
+		os << pc << ',' << sip_tables.line_number(pc) << ',' << parent->executions_[pc] << ','
+				<< parent->iterations_[pc] << ',' << parent->seconds_[pc] << std::endl;
+	}
+	os << std::endl;
+	return os;
+}
+#endif //HAVE_MPI
+
+} /* namespace sip */
@@ -0,0 +1,181 @@
+/*
+ * threaded_pardo.h
+ *
+ * Support for executing the iterations of a pardo loop assigned to a worker on several
+ * threads.
+ *
+ * When the number of threads is greater than one, the iterations of an eligible pardo
+ * loop whose LoopManager hands them out up front are first enumerated by the worker's interpreter using the loop's LoopManager, then
+ * executed by a team of OpenMP threads, each with its own child Interpreter.  A child has
+ * its own pc, control, selector, and expression stacks, index values, copies of the scalars,
+ * and a private block map for the temp blocks created in its scope, whose data is allocated
+ * from the worker's block map.  Local arrays, static arrays, and contiguous local arrays
+ * belong to the worker's interpreter and are shared, as are its SialOps, ContractionEngine,
+ * PardoPrefetch, WhereClauseCache, and this object.
+ *
+ * A loop is eligible if its body only contains control flow that stays inside the body,
+ * stack and scalar arithmetic, and the block instructions copy, permute, fill, scale,
+ * scale_assign, accumulate_scalar, add, subtract, contract, and load_scalar, and the body
+ * does not refer to distributed or served arrays or write scalars.  In particular, bodies
+ * with MPI communication, super instructions, or print statements are not eligible and are
+ * executed one iteration at a time as usual.
+ *
+ * Lookups and allocations in the worker's block map hold the lock of that map only while
+ * the map is used.  An instruction whose lhs is a shared block also holds the block lock of
+ * the block (or, for static and contiguous local arrays, of the array) until it is complete,
+ * including the write back of static array blocks.  So instructions run concurrently unless
+ * they write the same shared block.  As in the MPI version, an iteration should not read
+ * shared blocks that other iterations of the loop write.
+ *
+ * The order in which the iterations execute is not defined, as in the MPI version.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef THREADED_PARDO_H_
+#define THREADED_PARDO_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "opcode.h"
+#include "counter.h"
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#include "timer.h"
+#endif //HAVE_MPI
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif //_OPENMP
+
+namespace sip {
+
+class SipTables;
+class OpTable;
+class BlockId;
+class LoopManager;
+
+class ThreadedPardo {
+public:
+	ThreadedPardo(const SipTables& sip_tables, const OpTable& op_table);
+	~ThreadedPardo();
+
+	/** Sets the number of threads used for eligible pardo loops, at most MAX_OMP_THREADS.
+	 * 1, the default, disables threaded execution.  Ignored if not built with OpenMP. */
+	static void set_num_threads(int num_threads);
+	static int num_threads();
+
+	/** true if the pardo loop whose pardo_op is at pc may execute on threads */
+	bool is_eligible(int pc) const { return eligible_[pc]; }
+
+	/** true if the pardo loop at pc, managed by loop, should execute on threads in this run.
+	 * Loops whose manager claims iterations as it goes, such as dynamic ones, do not. */
+	bool enabled(int pc, const LoopManager* loop) const;
+
+	std::size_t num_eligible_loops() const { return num_eligible_; }
+
+	/** Number of block locks.  Blocks whose ids hash to the same lock exclude each other. */
+	static const int NUM_BLOCK_LOCKS = 64;
+
+	/** Acquires the block lock of the block and returns its index */
+	int lock_block(const BlockId& id);
+	void unlock_block(int index);
+
+	/** Wall clock time in seconds, for timing the threaded executions */
+	static double wall_time();
+
+	/** Records one threaded execution of the pardo at pc */
+	void record(int pc, std::size_t iterations, double seconds) {
+		executions_[pc]++;
+		iterations_[pc] += iterations;
+		seconds_[pc] += seconds;
+	}
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os, const SipTables& sip_tables) {
+		stats_.gather_and_print_statistics(os, this, sip_tables);
+	}
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * Statistics are kept per pardo, at the pc of the pardo_op.  seconds_ is the wall time
+	 * spent executing the iterations on the threads.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_threaded_loops_;
+		MPICounterList iterations_;
+		MPITimerList seconds_;
+
+		Stats(const MPI_Comm& comm, std::size_t num_pcs) :
+				num_threaded_loops_(comm), iterations_(comm, num_pcs), seconds_(comm, num_pcs) {
+		}
+
+		void finalize(ThreadedPardo* parent) {
+			for (std::size_t pc = 0; pc < parent->executions_.size(); ++pc) {
+				num_threaded_loops_.inc(parent->executions_[pc]);
+				iterations_.inc(pc, parent->iterations_[pc]);
+				if (parent->executions_[pc] > 0) seconds_.inc(pc, parent->seconds_[pc]);
+			}
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, ThreadedPardo* parent,
+				const SipTables& sip_tables) {
+			finalize(parent);
+			iterations_.reduce();
+			seconds_.reduce();
+			num_threaded_loops_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker threaded pardo, threads," << ThreadedPardo::num_threads()
+						<< ", eligible loops," << parent->num_eligible_ << std::endl;
+				os << "num_threaded_loops_" << std::endl << num_threaded_loops_;
+				os << std::endl;
+				os << "Worker threaded pardo iterations_" << std::endl;
+				iterations_.print_op_table_stats(os, sip_tables);
+				os << "Worker threaded pardo seconds_" << std::endl;
+				seconds_.print_op_table_stats(os, sip_tables);
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		explicit Stats(std::size_t num_pcs) {}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, ThreadedPardo* parent,
+				const SipTables& sip_tables);
+	};
+#endif //HAVE_MPI
+
+private:
+	bool check_body(const SipTables& sip_tables, const OpTable& op_table, int pardo_pc,
+			int end_pc) const;
+	static bool is_allowed(opcode_t opcode);
+	static bool has_block_lhs(opcode_t opcode);
+
+	static int num_threads_;
+
+	std::vector<bool> eligible_;
+	std::size_t num_eligible_;
+
+#ifdef _OPENMP
+	omp_lock_t block_locks_[NUM_BLOCK_LOCKS];
+#endif //_OPENMP
+
+	std::vector<std::size_t> executions_;
+	std::vector<std::size_t> iterations_;
+	std::vector<double> seconds_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(ThreadedPardo);
+};
+
+} /* namespace sip */
+
+#endif /* THREADED_PARDO_H_ */
@@ -0,0 +1,186 @@
+/*
+ * where_clause_cache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "where_clause_cache.h"
+#include <algorithm>
+#include "array_constants.h"
+#include "op_table.h"
+#include "sip_tables.h"
+#include "data_manager.h"
+#include "memory_tracker.h"
+
+namespace sip {
+
+const std::size_t WhereClauseCache::DEFAULT_MAX_BYTES;
+std::size_t WhereClauseCache::max_bytes_ = WhereClauseCache::DEFAULT_MAX_BYTES;
+std::size_t WhereClauseCache::total_ints_ = 0;
+
+WhereClauseCache::WhereClauseCache(const SipTables& sip_tables, const OpTable& op_table) :
+		entries_(sip_tables.op_table_size()),
+		num_loops_(0),
+		num_recorded_(0),
+		num_hits_(0)
+#ifdef HAVE_MPI
+		, stats_(SIPMPIAttr::get_instance().company_communicator())
+#endif //HAVE_MPI
+{
+	for (int pc = 0; pc < op_table.size(); ++pc) {
+		if (op_table.opcode(pc) != pardo_op) continue;
+		analyze_where_clauses(op_table, pc);
+		if (entries_[pc].cacheable_) ++num_loops_;
+	}
+}
+
+WhereClauseCache::~WhereClauseCache() {
+	for (std::vector<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it) {
+		discard(*it);
+	}
+}
+
+void WhereClauseCache::set_max_bytes(std::size_t max_bytes) {
+	max_bytes_ = max_bytes;
+}
+
+std::size_t WhereClauseCache::max_bytes() {
+	return max_bytes_;
+}
+
+void WhereClauseCache::analyze_where_clauses(const OpTable& op_table, int pardo_pc) {
+	int end_pc = op_table.arg0(pardo_pc);
+	int num_indices = op_table.arg1(pardo_pc);
+	int num_where_clauses = op_table.arg2(pardo_pc);
+	const index_selector_t& pardo_indices = op_table.index_selectors(pardo_pc);
+	//without where clauses there is nothing to save
+	if (num_where_clauses == 0) return;
+
+	Entry entry;
+	int pc = pardo_pc + 1;
+	for (int where = 0; where < num_where_clauses; ++pc) {
+		if (pc >= end_pc) return;
+		switch (op_table.opcode(pc)) {
+		case int_load_literal_op:
+		case int_equal_op:
+		case int_nequal_op:
+		case int_ge_op:
+		case int_le_op:
+		case int_gt_op:
+		case int_lt_op:
+			break;
+		case index_load_value_op: {
+			int index_slot = op_table.arg0(pc);
+			if (std::find(pardo_indices + 0, pardo_indices + num_indices, index_slot)
+					== pardo_indices + num_indices
+					&& std::find(entry.input_indices_.begin(), entry.input_indices_.end(),
+							index_slot) == entry.input_indices_.end()) {
+				entry.input_indices_.push_back(index_slot);
+			}
+		}
+			break;
+		case int_load_value_op: {
+			int int_slot = op_table.arg0(pc);
+			if (std::find(entry.input_ints_.begin(), entry.input_ints_.end(), int_slot)
+					== entry.input_ints_.end()) {
+				entry.input_ints_.push_back(int_slot);
+			}
+		}
+			break;
+		case where_op:
+			++where;
+			break;
+		default:
+			return;  //depends on scalars or blocks
+		}
+	}
+	//the where clauses are evaluated once per point, so the body must not change them.
+	//Procedures called from the body may store ints as well, so bodies with calls are
+	//not cached.
+	for (int body_pc = pc; body_pc < end_pc; ++body_pc) {
+		if (op_table.opcode(body_pc) == call_op) return;
+		if (op_table.opcode(body_pc) == int_store_op
+				&& std::find(entry.input_ints_.begin(), entry.input_ints_.end(),
+						op_table.arg0(body_pc)) != entry.input_ints_.end()) return;
+	}
+	entry.cacheable_ = true;
+	entry.body_pc_ = pc;
+	entries_[pardo_pc] = entry;
+}
+
+void WhereClauseCache::get_inputs(const Entry& entry, const DataManager& data_manager,
+		std::vector<int>& values) const {
+	values.clear();
+	for (std::size_t i = 0; i < entry.input_indices_.size(); ++i) {
+		values.push_back(data_manager.index_value(entry.input_indices_[i]));
+	}
+	for (std::size_t i = 0; i < entry.input_ints_.size(); ++i) {
+		values.push_back(data_manager.int_value(entry.input_ints_[i]));
+	}
+}
+
+const WhereClauseCache::IterationList* WhereClauseCache::find(int pc,
+		const DataManager& data_manager) {
+	if (!cacheable(pc)) return NULL;
+	Entry& entry = entries_[pc];
+	if (!entry.valid_) return NULL;
+	get_inputs(entry, data_manager, current_inputs_);
+	if (current_inputs_ != entry.inputs_) return NULL;
+	num_hits_++;
+	return &entry.iterations_;
+}
+
+bool WhereClauseCache::begin_recording(int pc, const DataManager& data_manager) {
+	if (!cacheable(pc)) return false;
+	Entry& entry = entries_[pc];
+	discard(entry);
+	get_inputs(entry, data_manager, entry.inputs_);
+	entry.recording_ = true;
+	return true;
+}
+
+void WhereClauseCache::record(int pc, const int* index_values, int num_indices) {
+	Entry& entry = entries_[pc];
+	if (!entry.recording_) return;
+	if ((total_ints_ + num_indices) * sizeof(int) > max_bytes_) {
+		discard(entry);
+		return;
+	}
+	entry.iterations_.insert(entry.iterations_.end(), index_values,
+			index_values + num_indices);
+	total_ints_ += num_indices;
+	charge(entry);
+}
+
+void WhereClauseCache::end_recording(int pc) {
+	Entry& entry = entries_[pc];
+	if (!entry.recording_) return;
+	entry.recording_ = false;
+	entry.valid_ = true;
+	IterationList(entry.iterations_).swap(entry.iterations_);  //drop the unused capacity
+	charge(entry);
+	num_recorded_++;
+}
+
+void WhereClauseCache::discard(Entry& entry) {
+	entry.valid_ = false;
+	entry.recording_ = false;
+	total_ints_ -= entry.iterations_.size();
+	IterationList().swap(entry.iterations_);
+	charge(entry);
+}
+
+void WhereClauseCache::charge(Entry& entry) {
+	std::size_t doubles = (entry.iterations_.capacity() * sizeof(int) + sizeof(double) - 1)
+			/ sizeof(double);
+	if (doubles > entry.charged_) {
+		MemoryTracker::global->inc_allocated(doubles - entry.charged_);
+	} else if (doubles < entry.charged_) {
+		MemoryTracker::global->dec_allocated(entry.charged_ - doubles);
+	}
+	entry.charged_ = doubles;
+}
+
+} /* namespace sip */
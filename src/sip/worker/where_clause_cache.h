@@ -0,0 +1,175 @@
+/*
+ * where_clause_cache.h
+ *
+ * Cached iteration lists of pardo loops.
+ *
+ * A loop manager evaluates the where clauses of a pardo at every point of its index space,
+ * and iterative programs execute the same pardo many times.  If the where clauses of a pardo
+ * only compare int literals, index values and int variables, the iterations that satisfy them
+ * depend only on the values of the indices that are not indices of the pardo (those of
+ * enclosing do loops) and of the int variables they load, the inputs of the pardo.  So the
+ * loop manager records the index values of the iterations that satisfy the where clauses the
+ * first time the pardo is executed, and later executions with the same inputs walk the
+ * recorded list without evaluating the where clauses.  Since the pc after the where clauses
+ * is then known, body_pc gives it.  Pardos whose bodies store those int variables, or call
+ * procedures, which might store them, are not cached.
+ *
+ * The list of a pardo is only kept if the execution that recorded it completed.  The lists
+ * of all pardos share a budget of max_bytes(), and a recording that would exceed it is
+ * discarded.  A new recording replaces the list when the inputs change.  The lists are
+ * charged to the MemoryTracker.  A max_bytes() of 0 disables caching.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#ifndef WHERE_CLAUSE_CACHE_H_
+#define WHERE_CLAUSE_CACHE_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "sip.h"
+#include "counter.h"
+
+#ifdef HAVE_MPI
+#include "sip_mpi_attr.h"
+#endif //HAVE_MPI
+
+namespace sip {
+
+class SipTables;
+class OpTable;
+class DataManager;
+
+class WhereClauseCache {
+public:
+	/** The index values of the iterations of a pardo, num_indices per iteration */
+	typedef std::vector<int> IterationList;
+
+	static const std::size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+	WhereClauseCache(const SipTables& sip_tables, const OpTable& op_table);
+	~WhereClauseCache();
+
+	/** Sets the maximum number of bytes in the lists of all pardos.  0 disables
+	 * caching. */
+	static void set_max_bytes(std::size_t max_bytes);
+	static std::size_t max_bytes();
+
+	/** true if the iterations of the pardo whose pardo_op is at pc may be cached */
+	bool cacheable(int pc) const { return max_bytes_ > 0 && entries_[pc].cacheable_; }
+
+	/** The pc following the last where clause of a cacheable pardo */
+	int body_pc(int pc) const { return entries_[pc].body_pc_; }
+
+	/** The recorded iterations of the pardo at pc, or NULL if there are none for the
+	 * current values of its inputs */
+	const IterationList* find(int pc, const DataManager& data_manager);
+
+	/** Starts recording the iterations of the pardo at pc, discarding earlier ones.
+	 * Returns false, and does not record, if the pardo is not cacheable. */
+	bool begin_recording(int pc, const DataManager& data_manager);
+
+	/** Appends an iteration to the recording of the pardo at pc, if any */
+	void record(int pc, const int* index_values, int num_indices);
+
+	/** Keeps the recording of the pardo at pc, which must contain all its iterations */
+	void end_recording(int pc);
+
+	std::size_t num_loops() const { return num_loops_; }
+
+	/** Collective over the company communicator. */
+	void gather_and_print_statistics(std::ostream& os) {
+		stats_.gather_and_print_statistics(os, this);
+	}
+
+	/**
+	 * Encapsulates the statistics for this class.
+	 *
+	 * num_recorded_ counts the lists that were kept, and num_hits_ the executions of pardos
+	 * that used one.
+	 */
+#ifdef HAVE_MPI
+	struct Stats {
+		MPICounter num_recorded_;
+		MPICounter num_hits_;
+
+		explicit Stats(const MPI_Comm& comm) :
+				num_recorded_(comm), num_hits_(comm) {
+		}
+
+		void finalize(WhereClauseCache* parent) {
+			num_recorded_.inc(parent->num_recorded_);
+			num_hits_.inc(parent->num_hits_);
+		}
+
+		std::ostream& gather_and_print_statistics(std::ostream& os, WhereClauseCache* parent) {
+			finalize(parent);
+			num_recorded_.gather();
+			num_hits_.gather();
+			if (SIPMPIAttr::get_instance().is_company_master()) {
+				os << "Worker cached pardo iterations, max bytes," << WhereClauseCache::max_bytes()
+						<< ", loops," << parent->num_loops_ << std::endl;
+				os << "num_recorded_" << std::endl << num_recorded_;
+				os << "num_hits_" << std::endl << num_hits_;
+				os << std::endl;
+			}
+			return os;
+		}
+	};
+#else
+	struct Stats {
+		std::ostream& gather_and_print_statistics(std::ostream& os, WhereClauseCache* parent) {
+			os << "Worker cached pardo iterations, max bytes," << WhereClauseCache::max_bytes()
+					<< ", loops," << parent->num_loops_ << std::endl;
+			os << "num_recorded_," << parent->num_recorded_ << std::endl;
+			os << "num_hits_," << parent->num_hits_ << std::endl;
+			os << std::endl;
+			return os;
+		}
+	};
+#endif //HAVE_MPI
+
+private:
+	struct Entry {
+		Entry() : cacheable_(false), body_pc_(0), valid_(false), recording_(false),
+				charged_(0) {}
+		bool cacheable_;
+		int body_pc_;
+		std::vector<int> input_indices_;  //index slots that are not pardo indices
+		std::vector<int> input_ints_;     //int slots
+		std::vector<int> inputs_;         //their values when the list was recorded
+		bool valid_;
+		bool recording_;
+		IterationList iterations_;
+		std::size_t charged_;             //doubles charged to the MemoryTracker
+	};
+
+	void analyze_where_clauses(const OpTable& op_table, int pardo_pc);
+	/** Sets values to the current values of the inputs of the entry */
+	void get_inputs(const Entry& entry, const DataManager& data_manager,
+			std::vector<int>& values) const;
+	void discard(Entry& entry);
+	/** Charges the capacity of the list of the entry to the MemoryTracker */
+	void charge(Entry& entry);
+
+	static std::size_t max_bytes_;
+	/** Index values in the lists of all caches.  Only the worker's thread records lists. */
+	static std::size_t total_ints_;
+
+	/** pc of pardo_op -> its where clauses and list.  Not cacheable for other pcs. */
+	std::vector<Entry> entries_;
+	std::size_t num_loops_;
+	std::vector<int> current_inputs_;  //buffer for find
+
+	std::size_t num_recorded_;
+	std::size_t num_hits_;
+	Stats stats_;
+
+	DISALLOW_COPY_AND_ASSIGN(WhereClauseCache);
+};
+
+} /* namespace sip */
+
+#endif /* WHERE_CLAUSE_CACHE_H_ */
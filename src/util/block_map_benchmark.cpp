@@ -0,0 +1,160 @@
+/*
+ * block_map_benchmark.cpp
+ *
+ * Compares the lookup throughput of the per array block maps, BlockHashMap, with the
+ * std::map<BlockId, Block*> they replaced.
+ *
+ * For each size from 10^5 to the maximum, the blocks of a rank 4 array with that many
+ * blocks are inserted into both maps, and the maps are then searched for randomly chosen
+ * blocks, as get_block_for_reading etc. do.  Half of the searched ids are copies of the
+ * inserted ids, and half are constructed from their index values as the interpreter does.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "block_id.h"
+#include "block_hash_map.h"
+#include "rank_distribution.h"
+#include "sip_mpi_attr.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace {
+
+/** Segments per index, so that all sizes fit in a rank 4 array */
+const int num_segments = 64;
+
+double wall_time() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+}
+
+/** The index values of the n'th block */
+void block_indices(long n, sip::index_value_array_t& indices) {
+	for (int i = 0; i < MAX_RANK; ++i) {
+		indices[i] = sip::unused_index_value;
+	}
+	for (int i = 0; i < 4; ++i) {
+		indices[i] = 1 + n % num_segments;
+		n /= num_segments;
+	}
+}
+
+/** Times lookups of the ids in the order given by order, and adds the found values to sum */
+template <typename MAP>
+double time_lookups(const MAP& map, const std::vector<sip::BlockId>& ids,
+		const std::vector<long>& order, long& sum) {
+	double start = wall_time();
+	for (std::size_t k = 0; k < order.size(); ++k) {
+		long n = order[k];
+		typename MAP::const_iterator it;
+		if (k % 2 == 0) {
+			it = map.find(ids[n]);
+		} else {
+			sip::index_value_array_t indices;
+			block_indices(n, indices);
+			it = map.find(sip::BlockId(0, indices));
+		}
+		if (it != map.end()) sum += it->second;
+	}
+	return wall_time() - start;
+}
+
+template <typename MAP>
+double time_inserts(MAP& map, const std::vector<sip::BlockId>& ids) {
+	double start = wall_time();
+	for (std::size_t n = 0; n < ids.size(); ++n) {
+		map.insert(typename MAP::value_type(ids[n], n));
+	}
+	return wall_time() - start;
+}
+
+void print_usage(const std::string& program_name) {
+	std::cerr << "Usage : " << program_name << " -m <max number of blocks> -l <lookups>" << std::endl;
+	std::cerr << "\tDefaults are -m 10000000 -l 10000000" << std::endl;
+}
+
+}  //anonymous namespace
+
+int main(int argc, char* argv[]) {
+
+#ifdef HAVE_MPI
+	MPI_Init(&argc, &argv);
+	sip::SIPMPIAttr::set_rank_distribution(new sip::AllWorkerRankDistribution());
+#endif
+
+	long max_blocks = 10000000;
+	long num_lookups = 10000000;
+	const char *optString = "m:l:h?";
+	int c;
+	while ((c = getopt(argc, argv, optString)) != -1) {
+		switch (c) {
+		case 'm': max_blocks = std::atol(optarg); break;
+		case 'l': num_lookups = std::atol(optarg); break;
+		case 'h': case '?':
+		default:
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::cout << "blocks, std::map insert ns, BlockHashMap insert ns, "
+			<< "std::map lookup ns, BlockHashMap lookup ns, lookup speedup" << std::endl;
+	std::srand(1);
+	for (long num_blocks = 100000; num_blocks <= max_blocks; num_blocks *= 10) {
+		std::vector<sip::BlockId> ids;
+		ids.reserve(num_blocks);
+		for (long n = 0; n < num_blocks; ++n) {
+			sip::index_value_array_t indices;
+			block_indices(n, indices);
+			ids.push_back(sip::BlockId(0, indices));
+		}
+		std::vector<long> order(num_lookups);
+		for (long k = 0; k < num_lookups; ++k) {
+			order[k] = (static_cast<long>(std::rand()) * RAND_MAX + std::rand()) % num_blocks;
+		}
+
+		long map_sum = 0;
+		long hash_sum = 0;
+		double map_insert, map_lookup, hash_insert, hash_lookup;
+		{
+			std::map<sip::BlockId, long> map;
+			map_insert = time_inserts(map, ids);
+			map_lookup = time_lookups(map, ids, order, map_sum);
+		}
+		{
+			sip::BlockHashMap<long> map;
+			hash_insert = time_inserts(map, ids);
+			hash_lookup = time_lookups(map, ids, order, hash_sum);
+		}
+		if (map_sum != hash_sum) {
+			std::cout << num_blocks << ", lookups differ" << std::endl;
+			continue;
+		}
+		std::cout << num_blocks << ", " << std::setprecision(4)
+				<< 1.0e9 * map_insert / num_blocks << ", " << 1.0e9 * hash_insert / num_blocks
+				<< ", " << 1.0e9 * map_lookup / num_lookups << ", "
+				<< 1.0e9 * hash_lookup / num_lookups << ", " << map_lookup / hash_lookup
+				<< std::endl;
+	}
+
+#ifdef HAVE_MPI
+	MPI_Finalize();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * cache_policy_benchmark.cpp
+ *
+ * Compares the hit rates of the block replacement policies of the worker block cache,
+ * LRUArrayPolicy and LRUBlockPolicy, by replaying traces of the cache.
+ *
+ * A trace is written by each worker when aces4 is run with -k <prefix> (see
+ * CachedBlockMap::set_trace_file_prefix).  It lists the blocks put in the cache when they
+ * go out of scope, and the lookups of blocks that are not in the block map.  The replay
+ * keeps the cache within the given capacity by evicting blocks chosen by the policy, and a
+ * lookup that finds its block in the cache is a hit.  Only the cache is simulated, so the
+ * capacity is the memory left for cached blocks.
+ *
+ * Without -f, a synthetic trace is used.  It models a pardo over i,j that contracts a large
+ * array V[i,j,*] with a small array T[i] that is reused by every iteration, as the
+ * amplitude arrays of coupled cluster programs are, in a loop of several sweeps.  Then the
+ * same is done with an array W with half as many blocks as V, so a policy must also adapt
+ * to a new working set.
+ *
+ * With -t, the hit rates of LRUBlockPolicy are also given for other values of its
+ * insert_front_period and recent_touches, which is how their defaults were chosen.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "block_id.h"
+#include "id_block_map.h"
+#include "lru_array_policy.h"
+#include "lru_block_policy.h"
+#include "rank_distribution.h"
+#include "sip_mpi_attr.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace {
+
+/** Stands in for a Block.  Only the size is needed by the cache. */
+struct SimBlock {
+	explicit SimBlock(std::size_t size) : size_(size), data_(NULL) {}
+	std::size_t size() const { return size_; }
+	double* get_data() { return data_; }
+	std::size_t size_;
+	double* data_;
+};
+
+struct Event {
+	char type;  //'c' cache a block, 'l' look one up
+	sip::BlockId id;
+	std::size_t size;
+};
+
+struct Result {
+	std::size_t lookups;
+	std::size_t hits;
+	std::size_t evictions;
+};
+
+bool read_trace(const std::string& file_name, std::vector<Event>& trace) {
+	std::ifstream in(file_name.c_str());
+	if (!in.good()) return false;
+	Event event;
+	int array_id;
+	sip::index_value_array_t indices;
+	while (in >> event.type >> array_id) {
+		for (int i = 0; i < MAX_RANK; ++i) {
+			in >> indices[i];
+		}
+		event.size = 0;
+		if (event.type == 'c') in >> event.size;
+		event.id = sip::BlockId(array_id, indices);
+		trace.push_back(event);
+	}
+	return true;
+}
+
+void add_event(std::vector<Event>& trace, char type, int array_id, int i, int j, int k,
+		std::size_t size) {
+	sip::index_value_array_t indices;
+	for (int n = 0; n < MAX_RANK; ++n) {
+		indices[n] = sip::unused_index_value;
+	}
+	indices[0] = i;
+	indices[1] = j;
+	indices[2] = k;
+	Event event;
+	event.type = type;
+	event.id = sip::BlockId(array_id, indices);
+	event.size = size;
+	trace.push_back(event);
+}
+
+/** Each iteration (i,j) of the pardo uses T[i] and V[i,j,k] for k up to num_k, each block
+ * is looked up in the cache before use and cached at the end of the iteration. */
+void synthetic_sweeps(int segments, int num_k, int sweeps, int T, int V, std::vector<Event>& trace) {
+	const std::size_t t_size = 20 * 20;
+	const std::size_t v_size = 20 * 20 * 20;
+	for (int sweep = 0; sweep < sweeps; ++sweep) {
+		for (int i = 1; i <= segments; ++i) {
+			for (int j = 1; j <= segments; ++j) {
+				add_event(trace, 'l', T, i, 1, 1, 0);
+				for (int k = 1; k <= num_k; ++k) {
+					add_event(trace, 'l', V, i, j, k, 0);
+				}
+				add_event(trace, 'c', T, i, 1, 1, t_size);
+				for (int k = 1; k <= num_k; ++k) {
+					add_event(trace, 'c', V, i, j, k, v_size);
+				}
+			}
+		}
+	}
+}
+
+/** Sweeps over V, followed by sweeps over W, which has half as many blocks */
+void synthetic_trace(int segments, int sweeps, std::vector<Event>& trace) {
+	const int T = 0;
+	const int V = 1;
+	const int W = 2;
+	synthetic_sweeps(segments, segments, sweeps, T, V, trace);
+	synthetic_sweeps(segments, segments / 2, sweeps, T, W, trace);
+}
+
+/** LRUArrayPolicy does not track blocks, so there is nothing to release */
+void release(sip::LRUArrayPolicy<SimBlock>& policy, const sip::BlockId& id) {}
+void release(sip::LRUBlockPolicy<SimBlock>& policy, const sip::BlockId& id) { policy.release(id); }
+
+/** Replays the trace with the given policy of the cache, which must be empty */
+template <typename POLICY>
+Result replay(const std::vector<Event>& trace, sip::IdBlockMap<SimBlock>& cache,
+		POLICY& policy, std::size_t capacity) {
+	Result result = {0, 0, 0};
+	std::size_t used = 0;
+	for (std::size_t n = 0; n < trace.size(); ++n) {
+		const Event& event = trace[n];
+		if (event.type == 'l') {
+			result.lookups++;
+			SimBlock* block = cache.block(event.id);
+			if (block == NULL) continue;
+			result.hits++;
+			used -= block->size();
+			delete cache.get_and_remove_block(event.id);
+			release(policy, event.id);
+		} else {
+			if (event.size > capacity || cache.block(event.id) != NULL) continue;
+			while (used + event.size > capacity && policy.any_blocks_for_removal()) {
+				SimBlock* scratch;
+				sip::BlockId id = policy.get_next_block_for_removal(scratch);
+				SimBlock* block = cache.get_and_remove_block(id);
+				used -= block->size();
+				delete block;
+				result.evictions++;
+			}
+			cache.insert_block(event.id, new SimBlock(event.size));
+			policy.touch(event.id);
+			used += event.size;
+		}
+	}
+	return result;
+}
+
+Result replay_array_policy(const std::vector<Event>& trace, int num_arrays, std::size_t capacity) {
+	sip::IdBlockMap<SimBlock> cache(num_arrays);
+	sip::LRUArrayPolicy<SimBlock> policy(cache);
+	return replay(trace, cache, policy, capacity);
+}
+
+Result replay_block_policy(const std::vector<Event>& trace, int num_arrays, std::size_t capacity,
+		int insert_front_period = sip::LRUBlockPolicy<SimBlock>::INSERT_FRONT_PERIOD,
+		std::size_t recent_touches = sip::LRUBlockPolicy<SimBlock>::RECENT_TOUCHES) {
+	sip::IdBlockMap<SimBlock> cache(num_arrays);
+	sip::LRUBlockPolicy<SimBlock> policy(cache, insert_front_period, recent_touches);
+	return replay(trace, cache, policy, capacity);
+}
+
+double hit_rate(const Result& result) {
+	return result.lookups > 0 ? static_cast<double>(result.hits) / result.lookups : 0.0;
+}
+
+void print_usage(const std::string& program_name) {
+	std::cerr << "Usage : " << program_name << " -f <trace file> -s <segments> -n <sweeps> -t" << std::endl;
+	std::cerr << "\t-f replays a trace written by aces4 -k, otherwise a synthetic trace with "
+			<< "segments per index and sweeps over the pardo is used" << std::endl;
+	std::cerr << "\t-t also replays with other parameters of LRUBlockPolicy" << std::endl;
+	std::cerr << "\tDefaults are -s 12 -n 4" << std::endl;
+}
+
+}  //anonymous namespace
+
+int main(int argc, char* argv[]) {
+
+#ifdef HAVE_MPI
+	MPI_Init(&argc, &argv);
+	sip::SIPMPIAttr::set_rank_distribution(new sip::AllWorkerRankDistribution());
+#endif
+
+	std::string trace_file;
+	int segments = 12;
+	int sweeps = 4;
+	bool tune = false;
+	const char *optString = "f:s:n:th?";
+	int c;
+	while ((c = getopt(argc, argv, optString)) != -1) {
+		switch (c) {
+		case 'f': trace_file = optarg; break;
+		case 's': segments = std::atoi(optarg); break;
+		case 'n': sweeps = std::atoi(optarg); break;
+		case 't': tune = true; break;
+		case 'h': case '?':
+		default:
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<Event> trace;
+	if (trace_file.empty()) {
+		synthetic_trace(segments, sweeps, trace);
+		std::cout << "synthetic trace, segments " << segments << ", sweeps " << sweeps;
+	} else {
+		if (!read_trace(trace_file, trace)) {
+			std::cerr << "could not read " << trace_file << std::endl;
+			return 1;
+		}
+		std::cout << "trace " << trace_file;
+	}
+
+	//the footprint is the size of all the distinct blocks that are cached
+	int num_arrays = 0;
+	std::size_t footprint = 0;
+	std::set<sip::BlockId> distinct;
+	for (std::size_t n = 0; n < trace.size(); ++n) {
+		num_arrays = std::max(num_arrays, trace[n].id.array_id() + 1);
+		if (trace[n].type == 'c' && distinct.insert(trace[n].id).second) {
+			footprint += trace[n].size;
+		}
+	}
+	std::cout << ", events " << trace.size() << ", footprint MB "
+			<< footprint * sizeof(double) / (1024.0 * 1024.0) << std::endl;
+
+	std::cout << "capacity % of footprint, lookups, LRUArrayPolicy hit rate, "
+			<< "LRUBlockPolicy hit rate, LRUArrayPolicy evictions, LRUBlockPolicy evictions"
+			<< std::endl;
+	const int percents[] = {5, 10, 25, 50, 75, 100};
+	int num_percents = sizeof(percents) / sizeof(percents[0]);
+	for (int p = 0; p < num_percents; ++p) {
+		std::size_t capacity = footprint / 100 * percents[p];
+		Result array_result = replay_array_policy(trace, num_arrays, capacity);
+		Result block_result = replay_block_policy(trace, num_arrays, capacity);
+		std::cout << percents[p] << ", " << array_result.lookups << ", " << std::setprecision(4)
+				<< hit_rate(array_result) << ", " << hit_rate(block_result) << ", "
+				<< array_result.evictions << ", " << block_result.evictions << std::endl;
+	}
+
+	if (tune) {
+		//a period larger than the number of new blocks never inserts them at the front
+		const int periods[] = {1, 8, 32, 128, 1 << 30};
+		const std::size_t recents[] = {0, 16, 32, 64, 256, 1024};
+		int num_periods = sizeof(periods) / sizeof(periods[0]);
+		int num_recents = sizeof(recents) / sizeof(recents[0]);
+		std::cout << "LRUBlockPolicy hit rate at capacity % of footprint, insert_front_period, recent_touches";
+		for (int p = 0; p < num_percents; ++p) std::cout << ", " << percents[p];
+		std::cout << std::endl;
+		for (int i = 0; i < num_periods; ++i) {
+			for (int r = 0; r < num_recents; ++r) {
+				std::cout << periods[i] << ", " << recents[r];
+				for (int p = 0; p < num_percents; ++p) {
+					std::size_t capacity = footprint / 100 * percents[p];
+					Result result = replay_block_policy(trace, num_arrays, capacity, periods[i], recents[r]);
+					std::cout << ", " << std::setprecision(4) << hit_rate(result);
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+
+#ifdef HAVE_MPI
+	MPI_Finalize();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * contraction_benchmark.cpp
+ *
+ * Times the ContractionEngine on the block contractions that dominate rccsd_rhf.sialx,
+ * comparing the transpose + gemm path with the transpose free strided gemm path.
+ *
+ * Indices a,b,c are virtual, i,j,k,l occupied, and m,n,s,t AO indices.  Segment sizes
+ * are given on the command line.
+ *
+ * With -z, instead sweeps a single segment size used for all indices from 4 to 64, and
+ * compares the dgemm path with the register blocked small_gemm path.  This is the
+ * data used to choose small_gemm::DEFAULT_MAX_WORK.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include "config.h"
+#include "contraction_engine.h"
+#include "memory_tracker.h"
+#include "small_gemm.h"
+#include "tensor_ops_c_prototypes.h"
+#include "rank_distribution.h"
+#include "sip_mpi_attr.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace {
+
+struct BenchmarkCase {
+	const char* sial;  //the statement in rccsd_rhf.sialx
+	const char* d;
+	const char* l;
+	const char* r;
+};
+
+const BenchmarkCase cases[] = {
+	{"taibj[a,i,b,j] = Vaaai[a1,a,b,j]*t1a_old[a1,i]", "aibj", "cabj", "ci"},
+	{"tjbai[j,b,a,i] = Vaaai[b1,b,a,i]*t1a_old[b1,j]", "jbai", "cbai", "cj"},
+	{"T1aibj[a,i,b,j] = L3aibj[a,i1,b,j]*tmp_ii[i1,i]", "aibj", "akbj", "ki"},
+	{"T1aibj[a,i,b,j] = Laabj[a,a1,b,j]*t1a_old[a1,i]", "aibj", "acbj", "ci"},
+	{"Taixj[a,i,mu,j] = Tau_ab[a,i,b,j]*ca[mu,b]", "aimj", "aibj", "mb"},
+	{"Txixj[nu,i,mu,j] = Taixj[a,i,mu,j]*ca[nu,a]", "nimj", "aimj", "na"},
+	{"Tai[a,i] = Vaaai[a1,a,b,j]*L1aibj[a1,i,b,j]", "ai", "cabj", "cibj"},
+	{"T1aibj[a,i,b,j] = Tau_ab[a,i1,b,j1]*Wminj_ab[i1,i,j1,j]", "aibj", "akbl", "kilj"},
+	{"Yab[mu,i,nu,j] = aoint[lambda,mu,sigma,nu]*TAO_ab[lambda,i,sigma,j]", "minj", "smtn", "sitj"},
+};
+
+const int sweep_sizes[] = {4, 8, 12, 16, 20, 24, 32, 40, 48, 56, 64};
+
+/** Cases with more flops than this are skipped in the sweep */
+const double max_sweep_flops = 1.0e10;
+
+/** The operands of one case for given segment sizes */
+struct CaseData {
+	int lrank, rrank, drank;
+	sip::segment_size_array_t lshape, rshape, dshape;
+	std::size_t lsize, rsize, dsize;
+	int contraction_pattern[MAX_RANK * 2];
+	std::vector<double> l, r;
+};
+
+double wall_time() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1.0e-6 * tv.tv_usec;
+}
+
+int extent(char index, int virt, int occ, int ao) {
+	if (std::strchr("abc", index) != NULL) return virt;
+	if (std::strchr("ijkl", index) != NULL) return occ;
+	return ao;
+}
+
+void fill_shape(const char* indices, int virt, int occ, int ao,
+		sip::segment_size_array_t& shape, std::size_t& size) {
+	std::fill(shape + 0, shape + MAX_RANK, 1);
+	size = 1;
+	for (int i = 0; indices[i] != '\0'; ++i) {
+		shape[i] = extent(indices[i], virt, occ, ao);
+		size *= shape[i];
+	}
+}
+
+/** Fills in the shapes, contraction pattern, and random operands.  Returns false if the
+ * contraction pattern is not valid. */
+bool setup_case(const BenchmarkCase& bc, int virt, int occ, int ao, int seed, CaseData& data) {
+	data.lrank = std::strlen(bc.l);
+	data.rrank = std::strlen(bc.r);
+	data.drank = std::strlen(bc.d);
+	fill_shape(bc.l, virt, occ, ao, data.lshape, data.lsize);
+	fill_shape(bc.r, virt, occ, ao, data.rshape, data.rsize);
+	fill_shape(bc.d, virt, occ, ao, data.dshape, data.dsize);
+
+	std::vector<int> aces_pattern;
+	for (int i = 0; i < data.drank; ++i) aces_pattern.push_back(bc.d[i]);
+	for (int i = 0; i < data.lrank; ++i) aces_pattern.push_back(bc.l[i]);
+	for (int i = 0; i < data.rrank; ++i) aces_pattern.push_back(bc.r[i]);
+	int ierr = 0;
+	get_contraction_ptrn_(data.drank, data.lrank, data.rrank, &aces_pattern[0],
+			data.contraction_pattern, ierr);
+	if (ierr != 0) return false;
+
+	data.l.resize(data.lsize);
+	data.r.resize(data.rsize);
+	srand(seed);
+	for (std::size_t i = 0; i < data.lsize; ++i) data.l[i] = rand() / (double) RAND_MAX - 0.5;
+	for (std::size_t i = 0; i < data.rsize; ++i) data.r[i] = rand() / (double) RAND_MAX - 0.5;
+	return true;
+}
+
+/** Initializes the plan for the case.  The plan uses small_gemm if m*n*k <= max_work. */
+int init_plan(sip::ContractionPlan& plan, const CaseData& data, bool transpose_free,
+		std::size_t max_work) {
+	sip::small_gemm::set_max_work(max_work);
+	return plan.init(data.contraction_pattern, data.lrank, data.lshape, data.rrank,
+			data.rshape, data.drank, data.dshape, transpose_free);
+}
+
+double max_difference(const std::vector<double>& d0, const std::vector<double>& d1) {
+	double max_diff = 0.0;
+	for (std::size_t i = 0; i < d0.size(); ++i) {
+		max_diff = std::max(max_diff, std::fabs(d0[i] - d1[i]));
+	}
+	return max_diff;
+}
+
+/** Returns seconds per contraction */
+double time_plan(sip::ContractionEngine& engine, const sip::ContractionPlan& plan,
+		std::vector<double>& l, std::vector<double>& r, std::vector<double>& d, int reps) {
+	engine.contract(plan, &l[0], &r[0], &d[0]); //warm up, sizes the workspaces
+	double start = wall_time();
+	for (int i = 0; i < reps; ++i) {
+		engine.contract(plan, &l[0], &r[0], &d[0]);
+	}
+	return (wall_time() - start) / reps;
+}
+
+void print_usage(const std::string& program_name) {
+	std::cerr << "Usage : " << program_name << " -v <virtual segment size> -o <occupied segment size> "
+			<< "-a <AO segment size> -n <repetitions>" << std::endl;
+	std::cerr << "\tDefaults are -v 30 -o 15 -a 30 -n 20" << std::endl;
+	std::cerr << "\t-z sweeps segment sizes 4 to 64 comparing dgemm with small_gemm" << std::endl;
+}
+
+/** Times every case with segment size seg for all indices, with and without small_gemm.
+ * Repetitions are scaled so that each measurement does about the same work. */
+void sweep(sip::ContractionEngine& engine, int reps) {
+	std::cout << "segment size, statement, gemm (m;n;k), batch count, dgemm ms, dgemm GFlop/s, "
+			<< "small_gemm ms, small_gemm GFlop/s, speedup, max diff" << std::endl;
+	int num_cases = sizeof(cases) / sizeof(cases[0]);
+	int num_sizes = sizeof(sweep_sizes) / sizeof(sweep_sizes[0]);
+	for (int s = 0; s < num_sizes; ++s) {
+		int seg = sweep_sizes[s];
+		for (int n = 0; n < num_cases; ++n) {
+			const BenchmarkCase& bc = cases[n];
+			CaseData data;
+			sip::ContractionPlan blas_plan;
+			sip::ContractionPlan small_plan;
+			if (!setup_case(bc, seg, seg, seg, n, data)
+					|| init_plan(blas_plan, data, true, 0) != 0
+					|| init_plan(small_plan, data, true, std::numeric_limits<std::size_t>::max()) != 0) {
+				std::cout << seg << ", " << bc.sial << ", invalid contraction" << std::endl;
+				continue;
+			}
+			if (!small_plan.small_) continue;  //not a gemm
+			double flops = 2.0 * blas_plan.lld_ * blas_plan.lrd_ * blas_plan.lcd_;
+			if (flops > max_sweep_flops) continue;
+			int scaled_reps = std::max(1, static_cast<int>(reps * 2.0e7 / flops));
+			std::vector<double> d0(data.dsize), d1(data.dsize);
+			double blas_time = time_plan(engine, blas_plan, data.l, data.r, d0, scaled_reps);
+			double small_time = time_plan(engine, small_plan, data.l, data.r, d1, scaled_reps);
+			std::cout << seg << ", " << bc.sial << ", " << small_plan.m_ << ';' << small_plan.n_
+					<< ';' << small_plan.k_ << ", " << small_plan.batch_count_ << ", "
+					<< std::setprecision(4) << 1000.0 * blas_time << ", "
+					<< 1.0e-9 * flops / blas_time << ", " << 1000.0 * small_time << ", "
+					<< 1.0e-9 * flops / small_time << ", " << blas_time / small_time << ", "
+					<< max_difference(d0, d1) << std::endl;
+		}
+	}
+}
+
+}  //anonymous namespace
+
+int main(int argc, char* argv[]) {
+
+#ifdef HAVE_MPI
+	MPI_Init(&argc, &argv);
+	sip::SIPMPIAttr::set_rank_distribution(new sip::AllWorkerRankDistribution());
+#endif
+
+	int virt = 30;
+	int occ = 15;
+	int ao = 30;
+	int reps = 20;
+	bool do_sweep = false;
+	const char *optString = "v:o:a:n:zh?";
+	int c;
+	while ((c = getopt(argc, argv, optString)) != -1) {
+		switch (c) {
+		case 'v': virt = std::atoi(optarg); break;
+		case 'o': occ = std::atoi(optarg); break;
+		case 'a': ao = std::atoi(optarg); break;
+		case 'n': reps = std::atoi(optarg); break;
+		case 'z': do_sweep = true; break;
+		case 'h': case '?':
+		default:
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	sip::MemoryTracker::set_global_memory_tracker(new sip::MemoryTracker());
+	sip::ContractionEngine engine(0);
+
+	if (do_sweep) {
+		sweep(engine, reps);
+#ifdef HAVE_MPI
+		MPI_Finalize();
+#endif
+		return 0;
+	}
+
+	std::cout << "segment sizes (virtual, occupied, AO) = " << virt << ',' << occ << ','
+			<< ao << "  repetitions = " << reps << std::endl;
+	std::cout << "statement, gemm (m;n;k), transpose ms, transpose GFlop/s, "
+			<< "strided ms, strided GFlop/s, batch count, max diff" << std::endl;
+
+	int num_cases = sizeof(cases) / sizeof(cases[0]);
+	for (int n = 0; n < num_cases; ++n) {
+		const BenchmarkCase& bc = cases[n];
+		CaseData data;
+		sip::ContractionPlan transpose_plan;
+		sip::ContractionPlan strided_plan;
+		if (!setup_case(bc, virt, occ, ao, n, data)
+				|| init_plan(transpose_plan, data, false, 0) != 0
+				|| init_plan(strided_plan, data, true, 0) != 0) {
+			std::cout << bc.sial << ", invalid contraction" << std::endl;
+			continue;
+		}
+		std::vector<double>& l = data.l;
+		std::vector<double>& r = data.r;
+		std::vector<double> d0(data.dsize), d1(data.dsize);
+
+		double flops = 2.0 * transpose_plan.lld_ * transpose_plan.lrd_ * transpose_plan.lcd_;
+		double transpose_time = time_plan(engine, transpose_plan, l, r, d0, reps);
+		std::cout << bc.sial << ", " << transpose_plan.lld_ << ';' << transpose_plan.lrd_
+				<< ';' << transpose_plan.lcd_ << ", " << std::setprecision(4)
+				<< 1000.0 * transpose_time << ", " << 1.0e-9 * flops / transpose_time;
+		if (strided_plan.kernel_ == sip::ContractionPlan::strided_gemm_kernel) {
+			double strided_time = time_plan(engine, strided_plan, l, r, d1, reps);
+			double max_diff = max_difference(d0, d1);
+			std::cout << ", " << 1000.0 * strided_time << ", " << 1.0e-9 * flops / strided_time
+					<< ", " << strided_plan.batch_count_ << ", " << max_diff << std::endl;
+		} else {
+			std::cout << ", n/a, n/a, n/a, n/a" << std::endl;
+		}
+	}
+
+#ifdef HAVE_MPI
+	MPI_Finalize();
+#endif
+
+	return 0;
+}
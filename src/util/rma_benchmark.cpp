@@ -0,0 +1,290 @@
+/*
+ * rma_benchmark.cpp
+ *
+ * Compares the two-sided server protocol for blocks of distributed arrays with the
+ * one-sided operations used by RmaArrays.
+ *
+ * The last rank is the server, the others are workers.  For each block size, it measures
+ *   GET latency: one worker repeatedly gets a block.  Two-sided, the worker posts the
+ *       receive and sends the block id, and the server replies with the block.  One-sided,
+ *       the worker uses MPI_Rget.  If the worker is on the same node as the server, it also
+ *       copies the block directly from the server's shared memory, as RmaArrays does.
+ *   put_accumulate bandwidth: all workers accumulate blocks into the server.  Two-sided,
+ *       each put sends the block id followed immediately by the data, which the server
+ *       receives, accumulates, and acks; the acks are awaited at the end.  One-sided, the
+ *       workers use MPI_Raccumulate and MPI_Win_flush_all.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: agent
+ */
+
+#include <mpi.h>
+#include "sip_mpi_utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+const int GET_TAG = 1;
+const int PUT_ACCUMULATE_TAG = 2;
+const int DATA_TAG = 3;
+const int DONE_TAG = 4;
+const int HEADER_ELEMS = sip::SIPMPIUtils::BLOCKID_BUFF_ELEMS;
+
+const int block_sizes[] = {128, 1024, 8192, 65536, 524288};
+
+/**
+ * The server side of the two-sided protocol.  Replies to gets with the block and
+ * accumulates put_accumulate data into it until each worker has sent DONE.
+ */
+void serve(std::vector<double>& block, int num_workers) {
+	std::vector<double> temp(block.size());
+	int header[HEADER_ELEMS];
+	int done = 0;
+	while (done < num_workers) {
+		MPI_Status status;
+		MPI_Recv(header, HEADER_ELEMS, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD,
+				&status);
+		int source = status.MPI_SOURCE;
+		switch (status.MPI_TAG) {
+		case GET_TAG:
+			MPI_Send(&block.front(), block.size(), MPI_DOUBLE, source, GET_TAG, MPI_COMM_WORLD);
+			break;
+		case PUT_ACCUMULATE_TAG:
+			MPI_Recv(&temp.front(), temp.size(), MPI_DOUBLE, source, DATA_TAG, MPI_COMM_WORLD,
+					MPI_STATUS_IGNORE);
+			for (std::size_t i = 0; i < block.size(); ++i) block[i] += temp[i];
+			MPI_Send(0, 0, MPI_INT, source, DATA_TAG, MPI_COMM_WORLD);
+			break;
+		case DONE_TAG:
+			++done;
+			break;
+		}
+	}
+}
+
+void send_done(int server) {
+	int header[HEADER_ELEMS] = {0};
+	MPI_Send(header, HEADER_ELEMS, MPI_INT, server, DONE_TAG, MPI_COMM_WORLD);
+}
+
+/** Returns the time per get in seconds */
+double two_sided_get(std::vector<double>& block, int server, int reps) {
+	int header[HEADER_ELEMS] = {0};
+	double start = MPI_Wtime();
+	for (int i = 0; i < reps; ++i) {
+		MPI_Request request;
+		MPI_Irecv(&block.front(), block.size(), MPI_DOUBLE, server, GET_TAG, MPI_COMM_WORLD,
+				&request);
+		MPI_Send(header, HEADER_ELEMS, MPI_INT, server, GET_TAG, MPI_COMM_WORLD);
+		MPI_Wait(&request, MPI_STATUS_IGNORE);
+	}
+	return (MPI_Wtime() - start) / reps;
+}
+
+double one_sided_get(std::vector<double>& block, int server, MPI_Win win, int reps) {
+	double start = MPI_Wtime();
+	for (int i = 0; i < reps; ++i) {
+		MPI_Request request;
+		MPI_Rget(&block.front(), block.size(), MPI_DOUBLE, server, 0, block.size(), MPI_DOUBLE,
+				win, &request);
+		MPI_Wait(&request, MPI_STATUS_IGNORE);
+	}
+	return (MPI_Wtime() - start) / reps;
+}
+
+/** base is the server's memory, obtained with MPI_Win_shared_query */
+double shared_copy_get(std::vector<double>& block, const double* base, MPI_Win shared_win,
+		int reps) {
+	double start = MPI_Wtime();
+	for (int i = 0; i < reps; ++i) {
+		MPI_Win_sync(shared_win);
+		std::copy(base, base + block.size(), block.begin());
+	}
+	return (MPI_Wtime() - start) / reps;
+}
+
+/** Returns the elapsed time in seconds */
+double two_sided_put_accumulate(const std::vector<double>& block, int server, int num_puts) {
+	int header[HEADER_ELEMS] = {0};
+	std::vector<MPI_Request> requests(num_puts);
+	double start = MPI_Wtime();
+	for (int i = 0; i < num_puts; ++i) {
+		MPI_Send(header, HEADER_ELEMS, MPI_INT, server, PUT_ACCUMULATE_TAG, MPI_COMM_WORLD);
+		MPI_Isend(const_cast<double*>(&block.front()), block.size(), MPI_DOUBLE, server,
+				DATA_TAG, MPI_COMM_WORLD, &requests[i]);
+	}
+	MPI_Waitall(num_puts, &requests.front(), MPI_STATUSES_IGNORE);
+	for (int i = 0; i < num_puts; ++i) {
+		MPI_Recv(0, 0, MPI_INT, server, DATA_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	}
+	return MPI_Wtime() - start;
+}
+
+double one_sided_put_accumulate(const std::vector<double>& block, int server, MPI_Win win,
+		int num_puts) {
+	std::vector<MPI_Request> requests(num_puts);
+	double start = MPI_Wtime();
+	for (int i = 0; i < num_puts; ++i) {
+		MPI_Raccumulate(const_cast<double*>(&block.front()), block.size(), MPI_DOUBLE, server,
+				0, block.size(), MPI_DOUBLE, MPI_SUM, win, &requests[i]);
+	}
+	MPI_Waitall(num_puts, &requests.front(), MPI_STATUSES_IGNORE);
+	MPI_Win_flush_all(win);
+	return MPI_Wtime() - start;
+}
+
+/** Returns the maximum of elapsed over the workers, valid at worker 0 */
+double max_over_workers(double elapsed, MPI_Comm worker_comm) {
+	double max_elapsed = 0.0;
+	MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, worker_comm);
+	return max_elapsed;
+}
+
+void print_usage(const char* program_name) {
+	std::cerr << "Usage : mpirun -n <at least 2> " << program_name << " -n <reps> -b <puts>" << std::endl;
+	std::cerr << "\t -n : number of gets for the latency, default 1000" << std::endl;
+	std::cerr << "\t -b : number of put_accumulates per worker for the bandwidth, default 200" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+	MPI_Init(&argc, &argv);
+
+	int reps = 1000;
+	int num_puts = 200;
+	const char *optString = "n:b:h?";
+	int c;
+	while ((c = getopt(argc, argv, optString)) != -1) {
+		switch (c) {
+		case 'n': reps = std::atoi(optarg); break;
+		case 'b': num_puts = std::atoi(optarg); break;
+		case 'h': case '?':
+		default:
+			print_usage(argv[0]);
+			MPI_Finalize();
+			return 1;
+		}
+	}
+
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	if (size < 2) {
+		print_usage(argv[0]);
+		MPI_Finalize();
+		return 1;
+	}
+	int server = size - 1;
+	int num_workers = size - 1;
+	bool is_server = rank == server;
+	MPI_Comm worker_comm;
+	MPI_Comm_split(MPI_COMM_WORLD, is_server, rank, &worker_comm);
+
+	int num_sizes = sizeof(block_sizes) / sizeof(block_sizes[0]);
+	int max_size = *std::max_element(block_sizes, block_sizes + num_sizes);
+
+	//the server exposes one block of the largest size, shared with its node
+	MPI_Comm node_comm;
+	MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+	MPI_Group world_group, node_group;
+	MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+	MPI_Comm_group(node_comm, &node_group);
+	int server_node_rank;
+	MPI_Group_translate_ranks(world_group, 1, &server, node_group, &server_node_rank);
+	double* base = NULL;
+	MPI_Aint window_bytes = is_server ? max_size * sizeof(double) : 0;
+	MPI_Win shared_win;
+	MPI_Win_allocate_shared(window_bytes, sizeof(double), MPI_INFO_NULL, node_comm, &base,
+			&shared_win);
+	std::fill(base, base + (is_server ? max_size : 0), 0.0);
+	MPI_Win win;
+	MPI_Win_create(base, window_bytes, sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &win);
+	const double* server_base = NULL;
+	if (!is_server) {
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, shared_win);
+		if (server_node_rank != MPI_UNDEFINED) {
+			MPI_Aint size;
+			int disp_unit;
+			double* ptr;
+			MPI_Win_shared_query(shared_win, server_node_rank, &size, &disp_unit, &ptr);
+			server_base = ptr;
+		}
+	}
+
+	if (rank == 0) {
+		std::cout << "workers = " << num_workers << "  gets = " << reps
+				<< "  put_accumulates per worker = " << num_puts << std::endl;
+		std::cout << "block doubles, two-sided get us, one-sided get us, shared copy get us, "
+				<< "two-sided put_accumulate MB/s, one-sided put_accumulate MB/s" << std::endl;
+	}
+
+	for (int n = 0; n < num_sizes; ++n) {
+		std::vector<double> block(block_sizes[n], 1.0);
+		double two_sided_get_time = 0.0, one_sided_get_time = 0.0, shared_get_time = 0.0;
+		double two_sided_put_time = 0.0, one_sided_put_time = 0.0;
+
+		//two-sided get latency, from worker 0
+		MPI_Barrier(MPI_COMM_WORLD);
+		if (is_server) {
+			serve(block, num_workers);
+		} else {
+			if (rank == 0) two_sided_get_time = two_sided_get(block, server, reps);
+			send_done(server);
+		}
+
+		//two-sided put_accumulate bandwidth, from all workers
+		MPI_Barrier(MPI_COMM_WORLD);
+		if (is_server) {
+			serve(block, num_workers);
+		} else {
+			double elapsed = two_sided_put_accumulate(block, server, num_puts);
+			send_done(server);
+			two_sided_put_time = max_over_workers(elapsed, worker_comm);
+		}
+
+		//one-sided get latency
+		MPI_Barrier(MPI_COMM_WORLD);
+		if (rank == 0) one_sided_get_time = one_sided_get(block, server, win, reps);
+		if (rank == 0 && server_base != NULL)
+			shared_get_time = shared_copy_get(block, server_base, shared_win, reps);
+
+		//one-sided put_accumulate bandwidth
+		MPI_Barrier(MPI_COMM_WORLD);
+		if (!is_server) {
+			double elapsed = one_sided_put_accumulate(block, server, win, num_puts);
+			one_sided_put_time = max_over_workers(elapsed, worker_comm);
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+
+		if (rank == 0) {
+			double megabytes = 1.0e-6 * num_workers * num_puts * block.size() * sizeof(double);
+			std::cout << block.size() << ", " << 1.0e6 * two_sided_get_time << ", "
+					<< 1.0e6 * one_sided_get_time << ", ";
+			if (server_base != NULL) std::cout << 1.0e6 * shared_get_time;
+			else std::cout << "remote";
+			std::cout << ", " << megabytes / two_sided_put_time
+					<< ", " << megabytes / one_sided_put_time << std::endl;
+		}
+	}
+
+	if (!is_server) {
+		MPI_Win_unlock_all(win);
+		MPI_Win_unlock_all(shared_win);
+	}
+	MPI_Win_free(&win);
+	MPI_Win_free(&shared_win);
+	MPI_Group_free(&world_group);
+	MPI_Group_free(&node_group);
+	MPI_Comm_free(&node_comm);
+	MPI_Comm_free(&worker_comm);
+	MPI_Finalize();
+	return 0;
+}
@@ -325,6 +325,14 @@ double* TestControllerParallel::local_block(const std::string& name,
 	}
 }
 
+bool TestControllerParallel::has_block(const std::string& name,
+		const std::vector<int> indices) {
+	int array_slot = sip_tables_->array_slot(name);
+	int rank = sip_tables_->array_rank(array_slot);
+	sip::BlockId id(array_slot, rank, indices);
+	return worker_->data_manager_.block_manager_.block_map_.block(id) != NULL;
+}
+
 #ifdef HAVE_MPI
 bool TestControllerParallel::runServer() {
 	if (this_test_enabled_) {
@@ -76,6 +76,8 @@ public:
 	int int_value(const std::string& name);
 	double scalar_value(const std::string& name);
 	double* local_block(const std::string& name, const std::vector<int>indices);
+	/** Whether the worker holds the block, in its block map or its cache */
+	bool has_block(const std::string& name, const std::vector<int>indices);
 	double* static_array(const std::string& name);
 	void print_timers(std::ostream& out);
 
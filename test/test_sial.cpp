@@ -1069,7 +1069,163 @@ TEST(Sial,pardo_with_where){
 
 }
 
-TEST(Sial,put_accumulate_stress){
+/* Runs a program whose first pardo adds 1 to every element of the block of each
+ * iteration of a distributed array x, and checks that each iteration ran exactly once
+ * across the workers. */
+void pardo_exactly_once_test(const std::string& job){
+    int norb = 4;
+    int segs[] = {2,3,2,1};
+    if (attr->global_rank() == 0) {
+        init_setup(job.c_str());
+        set_constant("norb", norb);
+        std::string tmp = job + ".siox";
+        const char* nm = tmp.c_str();
+        add_sial_program(nm);
+        set_aoindex_info(4, segs);
+        finalize_setup();
+    }
+    std::stringstream output;
+
+    TestControllerParallel controller(job, true, VERBOSE_TEST, "", output);
+    controller.initSipTables();
+    controller.run();
+
+    if (attr->global_rank() == 0) {
+    	int num_iters = norb * norb * norb;
+    	int seg_sum = 2 + 3 + 2 + 1;
+    	int num_elements = seg_sum * seg_sum * seg_sum;
+    	EXPECT_EQ(num_iters, int(controller.worker_->scalar_value("total")));
+    	EXPECT_DOUBLE_EQ(num_elements, controller.worker_->scalar_value("sum"));
+    	EXPECT_DOUBLE_EQ(num_elements, controller.worker_->scalar_value("sum_sq"));
+    }
+}
+
+TEST(Sial,pardo_loop_dynamic){
+    pardo_exactly_once_test("pardo_loop_dynamic");
+}
+
+TEST(Sial,pardo_loop_weighted){
+    pardo_exactly_once_test("pardo_loop_weighted");
+}
+
+/** A dynamic pardo whose body may run on threads must still hand out its iterations
+ * across the workers, each exactly once. */
+TEST(Sial,pardo_loop_dynamic_threaded){
+    std::string job("pardo_loop_dynamic_threaded");
+    int norb = 4;
+    int segs[] = {2,3,2,1};
+    if (attr->global_rank() == 0) {
+        init_setup(job.c_str());
+        set_constant("norb", norb);
+        std::string tmp = job + ".siox";
+        const char* nm = tmp.c_str();
+        add_sial_program(nm);
+        set_aoindex_info(4, segs);
+        finalize_setup();
+    }
+    std::stringstream output;
+
+    sip::ThreadedPardo::set_num_threads(2);
+    TestControllerParallel controller(job, true, VERBOSE_TEST, "", output);
+    controller.initSipTables();
+    controller.run();
+    sip::ThreadedPardo::set_num_threads(1);
+
+    if (attr->global_rank() == 0) {
+    	int seg_sum = 2 + 3 + 2 + 1;
+    	int num_elements = seg_sum * seg_sum * seg_sum;
+    	EXPECT_DOUBLE_EQ(num_elements, controller.worker_->scalar_value("sum"));
+    	EXPECT_DOUBLE_EQ(num_elements, controller.worker_->scalar_value("sum_sq"));
+    }
+}
+
+/** Blocks of an array that no worker writes in a section stay at the workers after the
+ * barrier, and are dropped by all workers if any of them writes the array.  Needs two
+ * workers to check the latter, see the test_sial_two_workers test. */
+TEST(Sial,cached_blocks_across_barrier){
+    std::string job("cached_blocks_across_barrier");
+    int norb = 4;
+    int segs[] = {2,3,2,1};
+    if (attr->global_rank() == 0) {
+        init_setup(job.c_str());
+        set_constant("norb", norb);
+        std::string tmp = job + ".siox";
+        const char* nm = tmp.c_str();
+        add_sial_program(nm);
+        set_aoindex_info(4, segs);
+        finalize_setup();
+    }
+    std::stringstream output;
+
+    TestControllerParallel controller(job, true, VERBOSE_TEST, "", output);
+    controller.initSipTables();
+    controller.run();
+
+    if (attr->is_worker()) {
+    	int seg_sum = 2 + 3 + 2 + 1;
+    	int num_elements = seg_sum * seg_sum;
+    	EXPECT_DOUBLE_EQ(num_elements + segs[0] * segs[0], controller.worker_->scalar_value("y_sum"));
+    	//x was last read two sections ago
+    	for (int i = 1; i <= norb; ++i) {
+    		for (int j = 1; j <= norb; ++j) {
+    			std::vector<int> indices;
+    			indices.push_back(i);
+    			indices.push_back(j);
+    			EXPECT_TRUE(controller.has_block("x", indices));
+    		}
+    	}
+    }
+    barrier();
+}
+
+/** Runs put_accumulate_then_get with the given bytes per server for one-sided arrays */
+void put_accumulate_then_get_test(std::size_t rma_bytes){
+    std::string job("put_accumulate_then_get");
+    int norb = 4;
+    int segs[] = {2,3,2,1};
+    if (attr->global_rank() == 0) {
+        init_setup(job.c_str());
+        set_constant("norb", norb);
+        std::string tmp = job + ".siox";
+        const char* nm = tmp.c_str();
+        add_sial_program(nm);
+        set_aoindex_info(4, segs);
+        finalize_setup();
+    }
+    std::stringstream output;
+
+#ifdef HAVE_MPI
+    sip::RmaArrays::set_max_bytes(rma_bytes);
+#endif
+    TestControllerParallel controller(job, true, VERBOSE_TEST, "", output);
+    controller.initSipTables();
+    controller.run();
+#ifdef HAVE_MPI
+    sip::RmaArrays::set_max_bytes(0);
+#endif
+
+    if (attr->global_rank() == 0) {
+    	int seg_sum = 2 + 3 + 2 + 1;
+    	int num_elements = seg_sum * seg_sum;
+    	EXPECT_DOUBLE_EQ(9.0 * num_elements, controller.worker_->scalar_value("get_sq"));
+    	EXPECT_DOUBLE_EQ(25.0 * num_elements, controller.worker_->scalar_value("y_sq"));
+    }
+}
+
+TEST(Sial,put_accumulate_then_get){
+    put_accumulate_then_get_test(0);
+}
+
+#ifdef HAVE_MPI
+/** x and y are one-sided arrays.  The servers run on the same node as the workers, so the
+ * gets copy the blocks directly through the shared window. */
+TEST(Sial,put_accumulate_then_get_one_sided){
+    put_accumulate_then_get_test(64 * 1024 * 1024);
+}
+#endif
+
+/** Runs put_accumulate_stress with the given number of helper threads per server */
+void put_accumulate_stress_test(int num_helper_threads){
     std::string job("put_accumulate_stress");
     int norb = 4;
     int kmax = 20;
@@ -1086,9 +1242,15 @@ TEST(Sial,put_accumulate_stress){
     }
     std::stringstream output;
 
+#ifdef HAVE_MPI
+    sip::SIPServer::set_num_helper_threads(num_helper_threads);
+#endif
     TestControllerParallel controller(job, true, VERBOSE_TEST, "", output);
     controller.initSipTables();
     controller.run();
+#ifdef HAVE_MPI
+    sip::SIPServer::set_num_helper_threads(0);
+#endif
 
 //    std::cerr << "finished run, checking results" << std::endl << std::flush;
 
@@ -1127,6 +1289,20 @@ TEST(Sial,put_accumulate_stress){
 
 }
 
+TEST(Sial,put_accumulate_stress){
+    put_accumulate_stress_test(0);
+}
+
+#ifdef HAVE_MPI
+/** The helper threads only need MPI_THREAD_FUNNELED */
+TEST(Sial,put_accumulate_stress_server_helpers){
+    int provided;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_FUNNELED) return;
+    put_accumulate_stress_test(2);
+}
+#endif
+
 TEST(Sip,decreasing_segs){
 
 	    std::string job("decreasing_segs");
@@ -1460,7 +1636,9 @@ int main(int argc, char **argv) {
     //    signal(SIGABRT, bt_sighandler);
 
 #ifdef HAVE_MPI
-    MPI_Init(&argc, &argv);
+    //the threads of pardos and the helper threads of servers make no MPI calls
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
     int num_procs;
     sip::SIPMPIUtils::check_err(MPI_Comm_size(MPI_COMM_WORLD, &num_procs), __LINE__,__FILE__);
 
@@ -10,12 +10,29 @@
 
 #include "gtest/gtest.h"
 
+#include "sip.h"
+#include "io_utils.h"
+#include "op_table.h"
+#include "fused_block_ops.h"
+#include "block_hash_map.h"
+#include "lru_block_policy.h"
+#include "block.h"
+#include "block_kernels.h"
+
 
 #ifdef HAVE_MPI
 #include "array_file.h"
 #include "chunk_manager.h"
 #include "mpi.h"
 #include "chunk.h"
+#include "barrier_support.h"
+#include "sip_mpi_utils.h"
+#include "async_acks.h"
+#include "server_block.h"
+#include "job_control.h"
+#include "put_accumulate_combiner.h"
+#include "memory_tracker.h"
+#include "data_distribution.h"
 #endif
 
 
@@ -1318,6 +1335,877 @@
 //
 //
 
+/** Builds an op table from (opcode, lhs array) pairs.  All entries use the same selector,
+ * so consecutive block instructions with the same array have the same lhs. */
+void make_op_table(const std::vector<std::pair<sip::opcode_t, int> >& ops, sip::OpTable& op_table) {
+	std::vector<int> ints;
+	ints.push_back(ops.size());
+	for (std::size_t pc = 0; pc < ops.size(); ++pc) {
+		ints.push_back(ops[pc].first);
+		ints.push_back(ops[pc].second);  //arg0
+		ints.push_back(0);  //arg1
+		ints.push_back(0);  //arg2
+		for (int i = 0; i < MAX_RANK; ++i) {
+			ints.push_back(i < 2 ? 1 : sip::unused_index_value);
+		}
+		ints.push_back(pc + 1);  //line number
+	}
+	setup::BinaryInputByteStream stream(reinterpret_cast<char*>(&ints.front()),
+			ints.size() * sizeof(int));
+	sip::OpTable::read(op_table, stream);
+}
+
+/** An op table with a run of block instructions on array 1 at pc 0 */
+void make_fusable_op_table(sip::OpTable& op_table) {
+	std::vector<std::pair<sip::opcode_t, int> > ops;
+	ops.push_back(std::make_pair(sip::block_copy_op, 1));
+	ops.push_back(std::make_pair(sip::push_block_selector_op, 0));
+	ops.push_back(std::make_pair(sip::block_scale_op, 1));
+	ops.push_back(std::make_pair(sip::block_add_op, 1));
+	ops.push_back(std::make_pair(sip::block_subtract_op, 1));
+	ops.push_back(std::make_pair(sip::sip_barrier_op, 0));
+	make_op_table(ops, op_table);
+}
+
+TEST(SipUnit,FusedBlockOpsRuns){
+	std::vector<std::pair<sip::opcode_t, int> > ops;
+	ops.push_back(std::make_pair(sip::block_copy_op, 1));         //0 run on array 1
+	ops.push_back(std::make_pair(sip::push_block_selector_op, 0));
+	ops.push_back(std::make_pair(sip::block_scale_op, 1));
+	ops.push_back(std::make_pair(sip::scalar_load_value_op, 0));
+	ops.push_back(std::make_pair(sip::block_add_op, 1));
+	ops.push_back(std::make_pair(sip::sip_barrier_op, 0));        //5 ends the run
+	ops.push_back(std::make_pair(sip::block_copy_op, 1));         //6 lhs differs from the next one
+	ops.push_back(std::make_pair(sip::block_scale_op, 2));        //7 run on array 2
+	ops.push_back(std::make_pair(sip::block_fill_op, 2));
+	sip::OpTable op_table;
+	make_op_table(ops, op_table);
+
+	sip::FusedBlockOps fused(op_table);
+	EXPECT_EQ(2, fused.num_runs());
+	EXPECT_EQ(5, fused.run_end(0));
+	EXPECT_EQ(-1, fused.run_end(2));
+	EXPECT_EQ(-1, fused.run_end(5));
+	EXPECT_EQ(-1, fused.run_end(6));
+	EXPECT_EQ(9, fused.run_end(7));
+}
+
+/** The operations of a run evaluated together give the same result as the instructions
+ * executed one at a time.  The values and factors are exact in binary, so the results must
+ * be identical.  The size is not a multiple of the tile size. */
+TEST(SipUnit,FusedBlockOpsSameAsUnfused){
+	const std::size_t n = 2085;
+	std::vector<double> s(n), t(n), u(n), fused_d(n), unfused_d(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		s[i] = 1 + i % 7;
+		t[i] = 0.25 * i;
+		u[i] = 3.0 - i % 5;
+	}
+
+	//the instructions one at a time, each making a pass over the block
+	double* d = &unfused_d.front();
+	for (std::size_t i = 0; i < n; ++i) d[i] = s[i];                 //d = s
+	for (std::size_t i = 0; i < n; ++i) d[i] *= 0.5;                 //d *= 0.5
+	for (std::size_t i = 0; i < n; ++i) d[i] = d[i] + t[i];          //d = d + t
+	for (std::size_t i = 0; i < n; ++i) d[i] = d[i] - u[i];          //d = d - u
+	for (std::size_t i = 0; i < n; ++i) d[i] += 2.0;                 //d += 2.0
+	for (std::size_t i = 0; i < n; ++i) d[i] = t[i] + 2.0 * d[i];    //d = t + 2.0 * d
+	for (std::size_t i = 0; i < n; ++i) d[i] = -0.25 * d[i];         //d = -0.25 * d
+	for (std::size_t i = 0; i < n; ++i) d[i] = d[i] - 0.5 * u[i];    //d = d - 0.5 * u
+
+	sip::OpTable op_table;
+	make_fusable_op_table(op_table);
+	sip::FusedBlockOps fused(op_table);
+	d = &fused_d.front();
+	fused.begin_run(0);
+	EXPECT_TRUE(fused.in_run());
+	fused.scale_and_copy(d, &s.front(), n, 1.0);
+	fused.scale(d, n, 0.5);
+	fused.combine(d, d, &t.front(), n, 1.0);
+	fused.combine(d, d, &u.front(), n, -1.0);
+	fused.increment(d, n, 2.0);
+	fused.combine(d, &t.front(), d, n, 2.0);
+	fused.scale_and_copy(d, d, n, -0.25);
+	fused.combine(d, d, &u.front(), n, -0.5);
+	//nothing is evaluated before the end of the run
+	EXPECT_EQ(0.0, fused_d[0]);
+	fused.end_run();
+	EXPECT_FALSE(fused.in_run());
+
+	for (std::size_t i = 0; i < n; ++i) {
+		EXPECT_DOUBLE_EQ(unfused_d[i], fused_d[i]);
+	}
+}
+
+/** A fill followed by updates, and a combine with neither operand the destination */
+TEST(SipUnit,FusedBlockOpsFillSameAsUnfused){
+	const std::size_t n = 1500;
+	std::vector<double> t(n), u(n), fused_d(n, -7.0), unfused_d(n, -7.0);
+	for (std::size_t i = 0; i < n; ++i) {
+		t[i] = 0.5 * i;
+		u[i] = i % 3;
+	}
+
+	double* d = &unfused_d.front();
+	for (std::size_t i = 0; i < n; ++i) d[i] = 3.0;                  //d = 3.0
+	for (std::size_t i = 0; i < n; ++i) d[i] = d[i] + t[i];          //d = d + t
+	for (std::size_t i = 0; i < n; ++i) d[i] = t[i] - u[i];          //d = t - u
+	for (std::size_t i = 0; i < n; ++i) d[i] *= 4.0;                 //d *= 4.0
+
+	sip::OpTable op_table;
+	make_fusable_op_table(op_table);
+	sip::FusedBlockOps fused(op_table);
+	d = &fused_d.front();
+	fused.begin_run(0);
+	fused.fill(d, n, 3.0);
+	fused.combine(d, d, &t.front(), n, 1.0);
+	fused.combine(d, &t.front(), &u.front(), n, -1.0);
+	fused.scale(d, n, 4.0);
+	fused.end_run();
+
+	for (std::size_t i = 0; i < n; ++i) {
+		EXPECT_DOUBLE_EQ(unfused_d[i], fused_d[i]);
+	}
+}
+
+/** When the destination changes, the operations on the previous destination are evaluated
+ * first, so later operations that read it see the updated values. */
+TEST(SipUnit,FusedBlockOpsChangeOfDestination){
+	const std::size_t n = 1100;
+	std::vector<double> t(n), fused_a(n), fused_b(n), unfused_a(n), unfused_b(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		t[i] = i;
+	}
+
+	double* a = &unfused_a.front();
+	double* b = &unfused_b.front();
+	for (std::size_t i = 0; i < n; ++i) a[i] = 2.0 * t[i];           //a = 2.0 * t
+	for (std::size_t i = 0; i < n; ++i) a[i] += 1.0;                 //a += 1.0
+	for (std::size_t i = 0; i < n; ++i) b[i] = a[i] + t[i];          //b = a + t
+	for (std::size_t i = 0; i < n; ++i) a[i] = a[i] - b[i];          //a = a - b
+
+	sip::OpTable op_table;
+	make_fusable_op_table(op_table);
+	sip::FusedBlockOps fused(op_table);
+	a = &fused_a.front();
+	b = &fused_b.front();
+	fused.begin_run(0);
+	fused.scale_and_copy(a, &t.front(), n, 2.0);
+	fused.increment(a, n, 1.0);
+	fused.combine(b, a, &t.front(), n, 1.0);
+	fused.combine(a, a, b, n, -1.0);
+	fused.end_run();
+
+	for (std::size_t i = 0; i < n; ++i) {
+		EXPECT_DOUBLE_EQ(unfused_a[i], fused_a[i]);
+		EXPECT_DOUBLE_EQ(unfused_b[i], fused_b[i]);
+	}
+}
+
+TEST(SipUnit,BlockKernelsThreaded){
+	std::size_t n = sip::block_kernels::PARALLEL_THRESHOLD + 13;  //not a multiple of a chunk
+	std::vector<double> data(n);
+	std::vector<double> to_add(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		data[i] = i;
+		to_add[i] = 2.0 * i + 1.0;
+	}
+	int num_threads = sip::block_kernels::num_threads();
+	sip::block_kernels::set_num_threads(3);
+	sip::block_kernels::accumulate_scaled(&data[0], &to_add[0], n, -1.0);
+	sip::block_kernels::scale(&data[0], n, 2.0);
+	sip::block_kernels::increment(&data[0], n, 2.0);
+	sip::block_kernels::set_num_threads(num_threads);
+	for (std::size_t i = 0; i < n; ++i) {
+		ASSERT_DOUBLE_EQ(-2.0 * i, data[i]);  //2 * (i - (2i + 1)) + 2
+	}
+}
+
+/** A block id of array_id with index values first, first + 1, ... and unused ones after rank */
+sip::BlockId make_test_block_id(int array_id, int rank, int first = 1) {
+	sip::index_value_array_t index_values;
+	std::fill(index_values, index_values + MAX_RANK, sip::unused_index_value);
+	for (int i = 0; i < rank; ++i) index_values[i] = first + i;
+	return sip::BlockId(array_id, index_values);
+}
+
+TEST(SipUnit,BlockHashMapInsertFind){
+	sip::BlockHashMap<int> map;
+	EXPECT_TRUE(map.empty());
+	EXPECT_TRUE(map.find(make_test_block_id(1, 2)) == map.end());
+	for (int a = 1; a <= 3; ++a) {
+		std::pair<sip::BlockHashMap<int>::iterator, bool> inserted =
+				map.insert(std::make_pair(make_test_block_id(a, 2), a));
+		EXPECT_TRUE(inserted.second);
+		EXPECT_EQ(a, inserted.first->second);
+	}
+	//ids with the same index values and different arrays are different keys
+	EXPECT_EQ(3u, map.size());
+	std::pair<sip::BlockHashMap<int>::iterator, bool> again =
+			map.insert(std::make_pair(make_test_block_id(2, 2), 20));
+	EXPECT_FALSE(again.second);
+	EXPECT_EQ(2, again.first->second);
+	EXPECT_EQ(3u, map.size());
+	for (int a = 1; a <= 3; ++a) {
+		EXPECT_EQ(1u, map.count(make_test_block_id(a, 2)));
+		EXPECT_EQ(a, map.find(make_test_block_id(a, 2))->second);
+	}
+	EXPECT_EQ(0u, map.count(make_test_block_id(1, 3)));
+	EXPECT_EQ(0u, map.count(make_test_block_id(4, 2)));
+
+	//index values too large to pack, and a contiguous local id, use hashed keys
+	sip::BlockId large = make_test_block_id(1, 2, 1 << sip::BlockId::PACKED_BITS);
+	sip::index_value_array_t lower;
+	sip::index_value_array_t upper;
+	std::fill(lower, lower + MAX_RANK, sip::unused_index_value);
+	std::fill(upper, upper + MAX_RANK, sip::unused_index_value);
+	lower[0] = 1;
+	upper[0] = 3;
+	sip::BlockId contiguous(1, lower, upper);
+	map[large] = 7;
+	map[contiguous] = 8;
+	EXPECT_EQ(5u, map.size());
+	EXPECT_EQ(7, map[large]);
+	EXPECT_EQ(8, map.find(contiguous)->second);
+	EXPECT_EQ(0u, map.count(make_test_block_id(1, 2, (1 << sip::BlockId::PACKED_BITS) + 1)));
+
+	map.clear();
+	EXPECT_TRUE(map.empty());
+	EXPECT_EQ(0u, map.count(large));
+}
+
+TEST(SipUnit,BlockHashMapGrowAndErase){
+	const int n = 1000;
+	sip::BlockHashMap<int> map;
+	for (int i = 0; i < n; ++i) {
+		map[make_test_block_id(i % 3 + 1, 2, i)] = i;
+	}
+	EXPECT_EQ(static_cast<std::size_t>(n), map.size());
+	for (int i = 0; i < n; ++i) {
+		sip::BlockHashMap<int>::iterator it = map.find(make_test_block_id(i % 3 + 1, 2, i));
+		ASSERT_TRUE(it != map.end());
+		EXPECT_EQ(i, it->second);
+	}
+	//erasing moves later entries of a probe sequence back, which must stay reachable
+	for (int i = 0; i < n; i += 2) {
+		EXPECT_EQ(1u, map.erase(make_test_block_id(i % 3 + 1, 2, i)));
+	}
+	EXPECT_EQ(0u, map.erase(make_test_block_id(1, 2, 0)));
+	EXPECT_EQ(static_cast<std::size_t>(n / 2), map.size());
+	for (int i = 0; i < n; ++i) {
+		EXPECT_EQ(static_cast<std::size_t>(i % 2), map.count(make_test_block_id(i % 3 + 1, 2, i)));
+	}
+	//erase through an iterator, then reinsert
+	map.erase(map.find(make_test_block_id(2, 2, 1)));
+	EXPECT_EQ(0u, map.count(make_test_block_id(2, 2, 1)));
+	EXPECT_TRUE(map.insert(std::make_pair(make_test_block_id(2, 2, 1), 1)).second);
+	EXPECT_EQ(static_cast<std::size_t>(n / 2), map.size());
+}
+
+TEST(SipUnit,BlockHashMapIteration){
+	const int n = 100;
+	sip::BlockHashMap<int> map;
+	for (int i = 0; i < n; ++i) {
+		map[make_test_block_id(1, 2, i)] = i;
+	}
+	long sum = 0;
+	int count = 0;
+	for (sip::BlockHashMap<int>::iterator it = map.begin(); it != map.end(); ++it) {
+		it->second *= 2;
+	}
+	const sip::BlockHashMap<int>& const_map = map;
+	for (sip::BlockHashMap<int>::const_iterator it = const_map.begin(); it != const_map.end();
+			it++) {
+		EXPECT_EQ(2 * it->first.index_values(0), it->second);
+		sum += it->second;
+		++count;
+	}
+	EXPECT_EQ(n, count);
+	EXPECT_EQ(n * (n - 1), sum);
+
+	//an iterator converts to a const_iterator referring to the same entry
+	sip::BlockHashMap<int>::iterator it = map.find(make_test_block_id(1, 2, 5));
+	sip::BlockHashMap<int>::const_iterator cit = it;
+	EXPECT_TRUE(cit == const_map.find(make_test_block_id(1, 2, 5)));
+	EXPECT_EQ(10, cit->second);
+	EXPECT_TRUE(const_map.find(make_test_block_id(1, 2, n)) == const_map.end());
+
+	sip::BlockHashMap<int> empty;
+	EXPECT_TRUE(empty.begin() == empty.end());
+}
+
+/** Inserts a block without data for each id into the map */
+void insert_test_blocks(sip::IdBlockMap<sip::Block>& block_map, const sip::BlockId* ids,
+		int num_ids) {
+	for (int i = 0; i < num_ids; ++i) {
+		block_map.insert_block(ids[i], new sip::Block(sip::BlockShape(), NULL));
+	}
+}
+
+TEST(SipUnit,LRUBlockPolicyTouchAndRelease){
+	sip::BlockId b1 = make_test_block_id(0, 2, 1);
+	sip::BlockId b2 = make_test_block_id(0, 2, 3);
+	sip::BlockId b3 = make_test_block_id(0, 2, 5);
+	sip::BlockId b4 = make_test_block_id(0, 2, 7);  //not in the map
+	sip::BlockId b5 = make_test_block_id(0, 2, 9);
+	sip::BlockId ids[] = {b1, b2, b3, b5};
+	sip::IdBlockMap<sip::Block> block_map(1);
+	insert_test_blocks(block_map, ids, 4);
+	sip::LRUBlockPolicy<sip::Block> policy(block_map);
+
+	//new blocks go to the least recently used end, touched ones to the other
+	policy.touch(b1);
+	policy.touch(b2);
+	policy.touch(b3);
+	policy.touch(b2);
+	policy.touch(b1);
+	EXPECT_EQ(3u, policy.size());
+	sip::Block* block = NULL;
+	EXPECT_EQ(b3, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(block_map.block(b3), block);
+	//a released block is no longer offered for removal
+	policy.release(b2);
+	EXPECT_EQ(1u, policy.size());
+	EXPECT_EQ(b1, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(0u, policy.size());
+	EXPECT_FALSE(policy.any_blocks_for_removal());
+	EXPECT_THROW(policy.get_next_block_for_removal(block), std::out_of_range);
+
+	//blocks in the ghost list are recently used when touched again
+	policy.touch(b1);
+	policy.touch(b2);
+	policy.touch(b5);
+	//a block that is not in the map is not evictable
+	policy.touch(b4);
+	EXPECT_EQ(4u, policy.size());
+	EXPECT_TRUE(policy.any_blocks_for_removal());
+	EXPECT_EQ(3u, policy.size());
+	EXPECT_EQ(b5, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(b1, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(b2, policy.get_next_block_for_removal(block));
+	EXPECT_FALSE(policy.any_blocks_for_removal());
+}
+
+TEST(SipUnit,LRUBlockPolicyRemoveAllBlocksForArray){
+	sip::BlockId a0 = make_test_block_id(0, 2, 1);
+	sip::BlockId a1 = make_test_block_id(0, 2, 3);
+	sip::BlockId c0 = make_test_block_id(1, 2, 1);
+	sip::BlockId c1 = make_test_block_id(1, 2, 3);
+	sip::BlockId ids[] = {a0, c0, a1, c1};
+	sip::IdBlockMap<sip::Block> block_map(2);
+	insert_test_blocks(block_map, ids, 4);
+	sip::LRUBlockPolicy<sip::Block> policy(block_map);
+	for (int k = 0; k < 2; ++k) {
+		for (int i = 0; i < 4; ++i) policy.touch(ids[i]);
+	}
+	policy.release(a1);
+	policy.remove_all_blocks_for_array(0);
+	EXPECT_EQ(2u, policy.size());
+	//a1 was also removed from the ghost list, so it is new when touched again
+	policy.touch(a1);
+	sip::Block* block = NULL;
+	EXPECT_EQ(a1, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(c0, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(c1, policy.get_next_block_for_removal(block));
+	EXPECT_FALSE(policy.any_blocks_for_removal());
+	policy.remove_all_blocks_for_array(0);  //nothing left
+	policy.remove_all_blocks_for_array(5);  //never seen
+	EXPECT_EQ(0u, policy.size());
+}
+
+TEST(SipUnit,LRUBlockPolicyVictims){
+	sip::BlockId x = make_test_block_id(0, 2, 1);
+	sip::BlockId y1 = make_test_block_id(1, 2, 1);
+	sip::BlockId y2 = make_test_block_id(1, 2, 3);
+	sip::BlockId ids[] = {x, y1, y2};
+	sip::IdBlockMap<sip::Block> block_map(2);
+	insert_test_blocks(block_map, ids, 3);
+	sip::LRUBlockPolicy<sip::Block> policy(block_map);
+	policy.touch(x);
+	policy.touch(x);
+	policy.touch(y1);
+	//y1 is at the least recently used end, but array 0 is no longer used
+	for (std::size_t i = 0; i <= sip::LRUBlockPolicy<sip::Block>::RECENT_TOUCHES; ++i) {
+		policy.touch(y2);
+	}
+	sip::Block* block = NULL;
+	EXPECT_EQ(x, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(y1, policy.get_next_block_for_removal(block));
+	EXPECT_EQ(y2, policy.get_next_block_for_removal(block));
+
+	//every INSERT_FRONT_PERIOD'th new block is recently used
+	const int n = sip::LRUBlockPolicy<sip::Block>::INSERT_FRONT_PERIOD;
+	std::vector<sip::BlockId> more;
+	sip::IdBlockMap<sip::Block> more_map(1);
+	sip::LRUBlockPolicy<sip::Block> more_policy(more_map);
+	for (int i = 0; i < n; ++i) {
+		more.push_back(make_test_block_id(0, 2, 2 * i + 1));
+		more_map.insert_block(more.back(), new sip::Block(sip::BlockShape(), NULL));
+		more_policy.touch(more.back());
+	}
+	for (int i = n - 2; i >= 0; --i) {
+		EXPECT_EQ(more[i], more_policy.get_next_block_for_removal(block));
+	}
+	EXPECT_EQ(more[n - 1], more_policy.get_next_block_for_removal(block));
+}
+
+#ifdef HAVE_MPI
+
+TEST(SipUnit,EagerPutTags){
+	sip::BarrierSupport barrier_support;
+	sip::SIPMPIConstants::MessageType_t type;
+	int transaction;
+
+	int put_tag = barrier_support.make_mpi_tag_for_PUT_EAGER();
+	sip::BarrierSupport::decode_tag(put_tag, type, transaction);
+	EXPECT_EQ(sip::SIPMPIConstants::PUT_EAGER, type);
+	EXPECT_EQ(13, type);
+	EXPECT_EQ(0, transaction);
+
+	int accumulate_tag = barrier_support.make_mpi_tag_for_PUT_ACCUMULATE_EAGER();
+	sip::BarrierSupport::decode_tag(accumulate_tag, type, transaction);
+	EXPECT_EQ(sip::SIPMPIConstants::PUT_ACCUMULATE_EAGER, type);
+	EXPECT_EQ(14, type);
+	EXPECT_EQ(1, transaction);
+
+	EXPECT_NE(put_tag, accumulate_tag);
+	EXPECT_EQ("PUT_EAGER", sip::SIPMPIConstants::messageTypeToName(
+			sip::SIPMPIConstants::PUT_EAGER));
+	EXPECT_EQ("PUT_ACCUMULATE_EAGER", sip::SIPMPIConstants::messageTypeToName(
+			sip::SIPMPIConstants::PUT_ACCUMULATE_EAGER));
+}
+
+TEST(SipUnit,EagerPutBuffRoundTrip){
+	EXPECT_EQ(0u, sip::SIPMPIUtils::EAGER_PUT_HEADER_BYTES % sizeof(double));
+	EXPECT_GE(static_cast<std::size_t>(sip::SIPMPIUtils::EAGER_PUT_HEADER_BYTES),
+			sip::SIPMPIUtils::BLOCKID_BUFF_ELEMS * sizeof(int));
+
+	const std::size_t n = sip::SIPMPIUtils::EAGER_PUT_MAX_DOUBLES;
+	std::vector<double> data(n);
+	for (std::size_t i = 0; i < n; ++i) data[i] = 0.5 * i - 3.0;
+	sip::BlockId id = make_test_block_id(3, 4);
+	char* buff = sip::SIPMPIUtils::encode_eager_put_buff(id, 17, 5, &data.front(), n);
+
+	sip::BlockId decoded_id;
+	int pc = -1;
+	int section = -1;
+	const double* decoded = sip::SIPMPIUtils::decode_eager_put_buff(buff, decoded_id, pc,
+			section);
+	EXPECT_EQ(id, decoded_id);
+	EXPECT_EQ(17, pc);
+	EXPECT_EQ(5, section);
+	EXPECT_EQ(0u, reinterpret_cast<std::size_t>(decoded) % sizeof(double));
+	for (std::size_t i = 0; i < n; ++i) {
+		EXPECT_EQ(data[i], decoded[i]);
+	}
+	delete[] buff;
+}
+
+/** Rank 0 sends an eager put and an eager put_accumulate to rank 1, which receives
+ * them as the server does. */
+TEST(SipUnit,EagerPutMessages){
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	if (size < 2) return;
+
+	const std::size_t put_size = 7;
+	const std::size_t accumulate_size = sip::SIPMPIUtils::EAGER_PUT_MAX_DOUBLES;
+	sip::BlockId put_id = make_test_block_id(2, 2);
+	sip::BlockId accumulate_id = make_test_block_id(4, 3);
+	if (rank == 0) {
+		sip::BarrierSupport barrier_support;
+		sip::AsyncSends sends;
+		std::vector<double> put_data(put_size, 2.5);
+		std::vector<double> accumulate_data(accumulate_size, -1.0);
+
+		int tag = barrier_support.make_mpi_tag_for_PUT_EAGER();
+		char* buff = sip::SIPMPIUtils::encode_eager_put_buff(put_id, 11, 1,
+				&put_data.front(), put_size);
+		MPI_Request request;
+		std::size_t bytes = sip::SIPMPIUtils::eager_put_bytes(put_size);
+		EXPECT_EQ(MPI_SUCCESS, MPI_Isend(buff, static_cast<int>(bytes), MPI_BYTE, 1, tag, MPI_COMM_WORLD,
+				&request));
+		sends.add(request, buff, bytes);
+		EXPECT_LE(sends.pending_bytes(), bytes);
+
+		tag = barrier_support.make_mpi_tag_for_PUT_ACCUMULATE_EAGER();
+		buff = sip::SIPMPIUtils::encode_eager_put_buff(accumulate_id, 12, 1,
+				&accumulate_data.front(), accumulate_size);
+		bytes = sip::SIPMPIUtils::eager_put_bytes(accumulate_size);
+		EXPECT_EQ(MPI_SUCCESS, MPI_Isend(buff, static_cast<int>(bytes), MPI_BYTE, 1, tag, MPI_COMM_WORLD,
+				&request));
+		sends.add(request, buff, bytes);
+
+		sends.wait_all();
+		EXPECT_EQ(0u, sends.pending_bytes());
+	} else if (rank == 1) {
+		sip::SIPMPIConstants::MessageType_t expected[2] = {
+				sip::SIPMPIConstants::PUT_EAGER, sip::SIPMPIConstants::PUT_ACCUMULATE_EAGER };
+		for (int m = 0; m < 2; ++m) {
+			MPI_Status status;
+			EXPECT_EQ(MPI_SUCCESS, MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
+			sip::SIPMPIConstants::MessageType_t type;
+			int transaction;
+			sip::BarrierSupport::decode_tag(status.MPI_TAG, type, transaction);
+			EXPECT_EQ(expected[m], type);
+			EXPECT_EQ(m, transaction);
+
+			int bytes;
+			MPI_Get_count(&status, MPI_BYTE, &bytes);
+			std::vector<char> buff(bytes);
+			EXPECT_EQ(MPI_SUCCESS, MPI_Recv(&buff.front(), bytes, MPI_BYTE, 0, status.MPI_TAG,
+					MPI_COMM_WORLD, &status));
+			std::size_t num_doubles = (bytes - sip::SIPMPIUtils::EAGER_PUT_HEADER_BYTES)
+					/ sizeof(double);
+			sip::BlockId id;
+			int pc, section;
+			const double* data = sip::SIPMPIUtils::decode_eager_put_buff(&buff.front(), id,
+					pc, section);
+			EXPECT_EQ(1, section);
+			if (m == 0) {
+				EXPECT_EQ(put_id, id);
+				EXPECT_EQ(11, pc);
+				EXPECT_EQ(put_size, num_doubles);
+				for (std::size_t i = 0; i < std::min(put_size, num_doubles); ++i) {
+					EXPECT_EQ(2.5, data[i]);
+				}
+			} else {
+				EXPECT_EQ(accumulate_id, id);
+				EXPECT_EQ(12, pc);
+				EXPECT_EQ(accumulate_size, num_doubles);
+				for (std::size_t i = 0; i < std::min(accumulate_size, num_doubles); ++i) {
+					EXPECT_EQ(-1.0, data[i]);
+				}
+			}
+		}
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/** The data of a contribution removed from a PutAccumulateCombiner */
+const double* contribution_data(const sip::PutAccumulateCombiner::Contribution& contribution) {
+	return reinterpret_cast<const double*>(
+			contribution.buffer_ + sip::SIPMPIUtils::EAGER_PUT_HEADER_BYTES);
+}
+
+TEST(SipUnit,PutAccumulateCombiner){
+	if (sip::MemoryTracker::global == NULL) {
+		sip::MemoryTracker::set_global_memory_tracker(new sip::MemoryTracker());
+	}
+	std::size_t allocated = sip::MemoryTracker::global->get_allocated_bytes();
+	std::size_t max_bytes = sip::PutAccumulateCombiner::max_bytes();
+	const std::size_t n = 4;
+	sip::PutAccumulateCombiner::set_max_bytes(2 * n * sizeof(double));
+	{
+		sip::PutAccumulateCombiner combiner;
+		sip::PutAccumulateCombiner::ContributionList removed;
+		sip::BlockId id0 = make_test_block_id(1, 1);
+		sip::BlockId id1 = make_test_block_id(1, 2);
+		sip::BlockId id2 = make_test_block_id(2, 2);
+		double a[n] = {1.0, 2.0, 3.0, 4.0};
+		double b[n] = {10.0, 20.0, 30.0, 40.0};
+
+		//contributions to the same block are summed
+		EXPECT_TRUE(combiner.add(id0, a, n, 5, removed));
+		EXPECT_TRUE(combiner.add(id0, b, n, 6, removed));
+		EXPECT_TRUE(combiner.add(id1, a, n, 7, removed));
+		EXPECT_TRUE(removed.empty());
+		EXPECT_EQ(2u, combiner.num_blocks());
+		EXPECT_EQ(2 * n * sizeof(double), combiner.bytes());
+		EXPECT_EQ(allocated + 2 * n * sizeof(double),
+				sip::MemoryTracker::global->get_allocated_bytes());
+
+		//the oldest block is evicted to make room
+		EXPECT_TRUE(combiner.add(id2, b, n, 8, removed));
+		ASSERT_EQ(1u, removed.size());
+		EXPECT_EQ(id0, removed[0].id_);
+		EXPECT_EQ(n, removed[0].size_);
+		EXPECT_EQ(6, removed[0].pc_);
+		for (std::size_t i = 0; i < n; ++i) {
+			EXPECT_DOUBLE_EQ(a[i] + b[i], contribution_data(removed[0])[i]);
+		}
+		delete [] removed[0].buffer_;
+		removed.clear();
+
+		//a single block is removed before another operation on it
+		EXPECT_FALSE(combiner.remove_block(id0, removed));
+		EXPECT_TRUE(removed.empty());
+		EXPECT_TRUE(combiner.remove_block(id1, removed));
+		ASSERT_EQ(1u, removed.size());
+		EXPECT_EQ(id1, removed[0].id_);
+		EXPECT_DOUBLE_EQ(a[3], contribution_data(removed[0])[3]);
+		EXPECT_EQ(1u, combiner.num_blocks());
+		delete [] removed[0].buffer_;
+		removed.clear();
+
+		//a block larger than max_bytes is not combined
+		double big[3 * n] = {0.0};
+		EXPECT_FALSE(combiner.add(id0, big, 3 * n, 9, removed));
+
+		EXPECT_TRUE(combiner.add(id1, a, n, 10, removed));
+		combiner.remove_array(2, removed);
+		ASSERT_EQ(1u, removed.size());
+		EXPECT_EQ(id2, removed[0].id_);
+		combiner.remove_all(removed);
+		ASSERT_EQ(2u, removed.size());
+		EXPECT_EQ(id1, removed[1].id_);
+		EXPECT_EQ(0u, combiner.num_blocks());
+		EXPECT_EQ(0u, combiner.bytes());
+		for (std::size_t i = 0; i < removed.size(); ++i) delete [] removed[i].buffer_;
+		removed.clear();
+
+		sip::PutAccumulateCombiner::set_max_bytes(0);
+		EXPECT_FALSE(combiner.add(id0, a, n, 11, removed));
+	}
+	EXPECT_EQ(allocated, sip::MemoryTracker::global->get_allocated_bytes());
+	sip::PutAccumulateCombiner::set_max_bytes(max_bytes);
+}
+
+/** Sizes in bytes of blocks of an array with uneven segments */
+std::vector<double> uneven_block_bytes(std::size_t num_blocks) {
+	std::vector<double> bytes;
+	for (std::size_t n = 0; n < num_blocks; ++n) {
+		bytes.push_back((n % 7 + 1) * (n % 3 + 1) * 64 * sizeof(double));
+	}
+	return bytes;
+}
+
+/** Checks that each block has one server slot and a distinct position there, and returns
+ * the bytes at each slot, divided by the weight of the slot if there is one per slot */
+std::vector<double> check_placement(const std::vector<double>& block_bytes, int num_servers,
+		const std::vector<double>& weights, const sip::DataDistribution::Placement& placement) {
+	std::vector<double> loads(num_servers, 0.0);
+	std::vector<std::vector<bool> > positions(num_servers,
+			std::vector<bool>(block_bytes.size(), false));
+	EXPECT_EQ(block_bytes.size(), placement.server_slot_.size());
+	EXPECT_EQ(block_bytes.size(), placement.position_.size());
+	for (std::size_t n = 0; n < block_bytes.size(); ++n) {
+		int slot = placement.server_slot_[n];
+		unsigned int position = placement.position_[n];
+		EXPECT_LT(slot, num_servers);
+		EXPECT_LT(position, placement.max_blocks_at_server_);
+		EXPECT_FALSE(positions[slot][position]);
+		positions[slot][position] = true;
+		loads[slot] += weights.size() == static_cast<std::size_t>(num_servers) ?
+				block_bytes[n] / weights[slot] : block_bytes[n];
+	}
+	return loads;
+}
+
+TEST(SipUnit,DataDistributionBalancedPlacement){
+	int num_servers = 5;
+	std::vector<double> bytes = uneven_block_bytes(103);
+	std::vector<double> no_weights;
+	sip::DataDistribution::Placement placement;
+	sip::DataDistribution::place_blocks(bytes, num_servers, 3, no_weights, placement);
+	std::vector<double> loads = check_placement(bytes, num_servers, no_weights, placement);
+	//each block goes to the least loaded server, so the loads differ by at most a block
+	double largest_block = *std::max_element(bytes.begin(), bytes.end());
+	EXPECT_LE(*std::max_element(loads.begin(), loads.end())
+			- *std::min_element(loads.begin(), loads.end()), largest_block);
+	//the first block goes to the slot given by the rotation
+	EXPECT_EQ(3, placement.server_slot_[0]);
+}
+
+TEST(SipUnit,DataDistributionProfiledPlacement){
+	int num_servers = 4;
+	std::vector<double> bytes = uneven_block_bytes(97);
+	std::vector<double> weights;
+	weights.push_back(2.0);
+	weights.push_back(1.0);
+	weights.push_back(1.0);
+	weights.push_back(0.5);
+	sip::DataDistribution::Placement placement;
+	sip::DataDistribution::place_blocks(bytes, num_servers, 0, weights, placement);
+	std::vector<double> loads = check_placement(bytes, num_servers, weights, placement);
+	double largest_block = *std::max_element(bytes.begin(), bytes.end());
+	EXPECT_LE(*std::max_element(loads.begin(), loads.end())
+			- *std::min_element(loads.begin(), loads.end()), largest_block / 0.5);
+	//a busy server gets fewer bytes
+	std::vector<double> no_weights;
+	std::vector<double> raw = check_placement(bytes, num_servers, no_weights, placement);
+	EXPECT_LT(raw[3], raw[0]);
+
+	//without a weight for each server, the placement is the balanced one
+	sip::DataDistribution::Placement balanced;
+	sip::DataDistribution::place_blocks(bytes, num_servers, 0, no_weights, balanced);
+	weights.pop_back();
+	sip::DataDistribution::Placement fallback;
+	sip::DataDistribution::place_blocks(bytes, num_servers, 0, weights, fallback);
+	EXPECT_EQ(balanced.server_slot_, fallback.server_slot_);
+	EXPECT_EQ(balanced.position_, fallback.position_);
+}
+
+/** Collective.  Without GETs in the previous program there is no profile */
+TEST(SipUnit,DataDistributionProfileFallback){
+	sip::SIPMPIAttr& attr = sip::SIPMPIAttr::get_instance();
+	sip::DataDistribution::Mode mode = sip::DataDistribution::mode();
+	sip::DataDistribution::set_mode(sip::DataDistribution::profiled_mode);
+	sip::DataDistribution::update_profile(0);
+	EXPECT_TRUE(sip::DataDistribution::server_weights().empty());
+
+	sip::DataDistribution::update_profile(attr.is_server() ? 10 : 0);
+	ASSERT_EQ(static_cast<std::size_t>(attr.num_servers()),
+			sip::DataDistribution::server_weights().size());
+	for (int i = 0; i < attr.num_servers(); ++i) {
+		//all servers handled the same number of GETs
+		EXPECT_DOUBLE_EQ(1.0, sip::DataDistribution::server_weights()[i]);
+	}
+
+	sip::DataDistribution::update_profile(0);
+	EXPECT_TRUE(sip::DataDistribution::server_weights().empty());
+	sip::DataDistribution::set_mode(mode);
+}
+
+TEST(SipUnit,GetBatchTag){
+	//the message type is stored in NUM_MESSAGE_TYPE_BITS bits
+	EXPECT_LE(static_cast<int>(sip::SIPMPIConstants::LAST_MESSAGE_TYPE),
+			1 << sip::BarrierSupport::NUM_MESSAGE_TYPE_BITS);
+
+	sip::BarrierSupport barrier_support;
+	sip::SIPMPIConstants::MessageType_t type;
+	int transaction;
+	barrier_support.make_mpi_tag_for_GET_BATCH();
+	int tag = barrier_support.make_mpi_tag_for_GET_BATCH();
+	sip::BarrierSupport::decode_tag(tag, type, transaction);
+	EXPECT_EQ(sip::SIPMPIConstants::GET_BATCH, type);
+	EXPECT_EQ(15, type);
+	EXPECT_EQ(1, transaction);
+	EXPECT_EQ("GET_BATCH", sip::SIPMPIConstants::messageTypeToName(
+			sip::SIPMPIConstants::GET_BATCH));
+}
+
+TEST(SipUnit,GetBatchEntryRoundTrip){
+	std::vector<int> buff(2 * sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK);
+	sip::BlockId id0 = make_test_block_id(1, 2);
+	sip::BlockId id1 = make_test_block_id(6, MAX_RANK);
+	sip::SIPMPIUtils::encode_get_batch_entry(&buff[0], id0, 21, 3, 1001);
+	sip::SIPMPIUtils::encode_get_batch_entry(
+			&buff[sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK], id1, 22, 3, 1002);
+
+	sip::BlockId id;
+	int pc, section, reply_tag;
+	sip::SIPMPIUtils::decode_get_batch_entry(&buff[0], id, pc, section, reply_tag);
+	EXPECT_EQ(id0, id);
+	EXPECT_EQ(21, pc);
+	EXPECT_EQ(3, section);
+	EXPECT_EQ(1001, reply_tag);
+	sip::SIPMPIUtils::decode_get_batch_entry(
+			&buff[sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK], id, pc, section, reply_tag);
+	EXPECT_EQ(id1, id);
+	EXPECT_EQ(22, pc);
+	EXPECT_EQ(3, section);
+	EXPECT_EQ(1002, reply_tag);
+}
+
+/** Rank 0 sends a GET_BATCH for several blocks to rank 1, which replies to each get with
+ * the tag given in the batch, as the server does. */
+TEST(SipUnit,GetBatchMessage){
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	if (size < 2) return;
+
+	const int num_blocks = sip::SIPMPIUtils::MAX_GET_BATCH;
+	const int block_size = 10;
+	if (rank == 0) {
+		sip::BarrierSupport barrier_support;
+		std::vector<double> data(num_blocks * block_size, 0.0);
+		std::vector<MPI_Request> requests(num_blocks);
+		std::vector<int> send_buff(num_blocks * sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK);
+		//as in SialOpsParallel, the replies are posted before the batch is sent
+		for (int b = 0; b < num_blocks; ++b) {
+			int get_tag = barrier_support.make_mpi_tag_for_GET();
+			MPI_Irecv(&data[b * block_size], block_size, MPI_DOUBLE, 1, get_tag,
+					MPI_COMM_WORLD, &requests[b]);
+			sip::SIPMPIUtils::encode_get_batch_entry(
+					&send_buff[b * sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK],
+					make_test_block_id(b + 1, 2), 30 + b, 0, get_tag);
+		}
+		int tag = barrier_support.make_mpi_tag_for_GET_BATCH();
+		EXPECT_EQ(MPI_SUCCESS, MPI_Send(&send_buff.front(), send_buff.size(), MPI_INT, 1, tag,
+				MPI_COMM_WORLD));
+		MPI_Waitall(num_blocks, &requests.front(), MPI_STATUSES_IGNORE);
+		for (int b = 0; b < num_blocks; ++b) {
+			for (int i = 0; i < block_size; ++i) {
+				EXPECT_EQ(b + 1 + 0.5 * i, data[b * block_size + i]);
+			}
+		}
+	} else if (rank == 1) {
+		MPI_Status status;
+		EXPECT_EQ(MPI_SUCCESS, MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
+		sip::SIPMPIConstants::MessageType_t type;
+		int transaction;
+		sip::BarrierSupport::decode_tag(status.MPI_TAG, type, transaction);
+		EXPECT_EQ(sip::SIPMPIConstants::GET_BATCH, type);
+		int count;
+		MPI_Get_count(&status, MPI_INT, &count);
+		EXPECT_EQ(num_blocks * sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK, count);
+		std::vector<int> buff(count);
+		MPI_Recv(&buff.front(), count, MPI_INT, 0, status.MPI_TAG, MPI_COMM_WORLD, &status);
+		int b = 0;
+		for (int pos = 0; pos < count; pos += sip::SIPMPIUtils::GET_BATCH_ELEMS_PER_BLOCK, ++b) {
+			sip::BlockId id;
+			int pc, section, reply_tag;
+			sip::SIPMPIUtils::decode_get_batch_entry(&buff[pos], id, pc, section, reply_tag);
+			EXPECT_EQ(make_test_block_id(b + 1, 2), id);
+			EXPECT_EQ(30 + b, pc);
+			EXPECT_EQ(sip::SIPMPIConstants::GET,
+					sip::BarrierSupport::extract_message_type(reply_tag));
+			std::vector<double> reply(block_size);
+			for (int i = 0; i < block_size; ++i) reply[i] = id.array_id() + 0.5 * i;
+			MPI_Send(&reply.front(), block_size, MPI_DOUBLE, 0, reply_tag, MPI_COMM_WORLD);
+		}
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+}
+
+namespace sip {
+/** Creates server blocks the way DiskBackedBlockMap::create_block does */
+class TestServerBlocks {
+public:
+	static ServerBlock* create(ChunkManager& manager, std::size_t size) {
+		int chunk_number;
+		Chunk::offset_val_t offset;
+		manager.assign_block_data_from_chunk(size, true, chunk_number, offset);
+		ServerBlock* block = new ServerBlock(size, &manager, chunk_number, offset);
+		manager.chunk(chunk_number)->add_server_block(block);
+		return block;
+	}
+};
+} /* namespace sip */
+
+TEST(SipUnit,LRUBlockPolicyServerBlocks){
+	if (sip::JobControl::global == NULL) {
+		sip::JobControl::set_global_job_control(new sip::JobControl(sip::JobControl::make_job_id()));
+	}
+	const std::size_t block_size = 4;
+	sip::ArrayFile file(2 * block_size, "lru_block_policy_test", MPI_COMM_WORLD);
+	sip::ChunkManager manager(2 * block_size, &file);
+	sip::IdBlockMap<sip::ServerBlock> block_map(1);
+	std::vector<sip::BlockId> ids;
+	for (int i = 0; i < 4; ++i) {
+		ids.push_back(make_test_block_id(0, 2, 2 * i + 1));
+		block_map.insert_block(ids.back(), sip::TestServerBlocks::create(manager, block_size));
+	}
+	sip::LRUBlockPolicy<sip::ServerBlock> policy(block_map);
+	for (int k = 0; k < 2; ++k) {
+		for (int i = 0; i < 4; ++i) policy.touch(ids[i]);
+	}
+	//the first two blocks are in the first chunk, and are emptied out with it
+	manager.delete_chunk_data(manager.chunk(0));
+	sip::ServerBlock* block = NULL;
+	EXPECT_EQ(ids[2], policy.get_next_block_for_removal(block));
+	EXPECT_EQ(block_map.block(ids[2]), block);
+	EXPECT_EQ(1u, policy.size());
+	EXPECT_EQ(ids[3], policy.get_next_block_for_removal(block));
+	EXPECT_FALSE(policy.any_blocks_for_removal());
+	manager.delete_chunk_data_all();
+}
+
+#endif //HAVE_MPI
+
 int main(int argc, char **argv) {
 
 #ifdef HAVE_MPI